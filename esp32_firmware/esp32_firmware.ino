@@ -31,15 +31,43 @@ Add * - Image/pattern/sequence management
 // ESP-NOW multi-poi sync
 #include "src/espnow_sync.h"
 
+// DDP / Art-Net / E1.31 pixel streams from lighting software
+#include "src/pixel_ingest.h"
+
+// OSC control from live performance controllers
+#include "src/osc_server.h"
+
+// Images kept in flash so they can be sent again after a Teensy reboot
+#include "src/asset_store.h"
+
+// Per-column hashes of uploaded images, so edits are sent as patches
+#include "src/column_delta.h"
+
 // Forward declarations for PlatformIO compilation
 void setupWiFi();
 void setupWebServer();
 void checkTeensyConnection();
+bool requestTeensyCapabilities();
+bool requestSlotMap(uint8_t* active, size_t len);
+void downscaleRgb(uint8_t* rgb, uint16_t width, uint16_t height, uint16_t newWidth, uint16_t newHeight);
 void handleRoot();
 void handleStatus();
 void handleSetMode();
 void handleSetBrightness();
 void handleSetFrameRate();
+void handleSetDuty();
+void handleSetOutput();
+void handleDutyPower();
+void handleGovernor();
+void handleRotation();
+void handleLiveRecorder();
+void handleLinkStats();
+void handleTasks();
+void handleIngest();
+void handleOsc();
+void handleStorage();
+void handleReadback();
+void handleBatch();
 void handlePowerMode();
 void handleUploadPattern();
 void handleUploadImage();
@@ -48,12 +76,26 @@ void handleSDList();
 void handleSDDelete();
 void handleSDInfo();
 void handleSDLoad();
+void handleSDWriter();
+void handleShowLoad();
+void handleSDPlay();
+void handleSDCache();
 void handleManifest();
 void handleServiceWorker();
 void handleNotFound();
 void sendFile(const char* path, const char* contentType);
 void sendTeensyCommand(uint8_t cmd, uint8_t dataLen);
+void sendTeensyLongCommand(uint8_t cmd, uint32_t dataLen);
+void flushQueuedControls();
+void drainTeensySerial();
+void applySdLoadEvent(const uint8_t* buf);
+void applyShowLoadEvent(const uint8_t* buf);
+void queueControl(uint8_t flag);
+void queuePattern(JsonVariantConst pattern);
+void queuePatternRecord(const uint8_t* record);
+void flushPendingControls();
 bool readTeensyResponse(uint8_t expectedMarker, uint8_t* buffer, size_t maxLen, size_t& bytesRead, unsigned long timeout = 500);
+bool readTeensyFrame(uint8_t expectedMarker, uint8_t* buffer, size_t len, unsigned long timeout = 500);
 
 // Sync function declarations (legacy HTTP sync)
 void handleSyncStatus();
@@ -73,6 +115,22 @@ void performSync(String peerId);
 String getDeviceId();
 void loadDeviceConfig();
 void saveDeviceConfig();
+void loadIngestConfig();
+void saveIngestConfig();
+void forwardIngestColumn(const uint8_t* rgb, size_t len);
+void onIngestStreamStart(IngestSource source);
+void loadOscConfig();
+void saveOscConfig();
+bool routeOscMessage(const OscMessage& msg);
+void handleAssets();
+void handleAssetsLocked();
+bool sendAssetToTeensy(const AssetEntry& e);
+void restoreAssets();
+void queueAssetPut(uint16_t width, uint16_t height, const uint8_t* rgb, size_t len);
+void serviceAssetPut();
+bool sendColumnPatch(uint8_t slot, uint16_t width, uint16_t height, const uint8_t* rgb);
+bool sendProgressiveImage(uint8_t slot, uint16_t width, uint16_t height, const uint8_t* rgb);
+void handleUploadStats();
 
 // ESP-NOW multi-poi sync declarations
 void setupESPNowSync();
@@ -98,13 +156,35 @@ const char* password = "povpoi123";
 #define SERIAL_RX_PIN 16  // DO NOT CHANGE: Teensy serial link
 static_assert(SERIAL_TX_PIN == 17, "SERIAL_TX_PIN must remain 17 for Teensy serial link");
 static_assert(SERIAL_RX_PIN == 16, "SERIAL_RX_PIN must remain 16 for Teensy serial link");
-const uint8_t kMaxPatternIndex = 17;
+const uint8_t kMaxPatternIndex = 20;
 
 // Image dimension limits
-// Updated to match Teensy PSRAM capabilities: 400px width, 64px height (2x32 LEDs)
+// Size of the upload buffer here. What the Teensy actually stores comes from
+// the capability handshake (teensyCaps); uploads are fitted to that.
 #define MAX_IMAGE_WIDTH 400
 #define MAX_IMAGE_HEIGHT 64
 
+// Teensy capabilities, reported by 0x16 when the link comes up
+#define TEENSY_ENCODING_RAW_RGB     0x01
+#define TEENSY_ENCODING_SLOT_RGB    0x02
+#define TEENSY_ENCODING_COLUMN_DICT 0x04
+#define TEENSY_ENCODING_COLUMN_PATCH 0x08
+#define TEENSY_ENCODING_PROGRESSIVE 0x10
+struct TeensyCapabilities {
+  bool valid;
+  bool stale;             // Free slots/columns changed since the last handshake
+  uint8_t protocolVersion;
+  uint16_t maxImages;
+  uint16_t freeSlots;
+  uint16_t maxWidth;
+  uint16_t maxHeight;     // Rows stored per image (LED count)
+  uint8_t psramMb;
+  uint8_t encodings;      // TEENSY_ENCODING_* bits
+  bool sdPresent;
+  uint32_t maxFrameBytes;
+  uint32_t freeColumns;
+} teensyCaps;
+
 // Sync Configuration
 #define AUTO_SYNC_ENABLED false
 #define AUTO_SYNC_INTERVAL 30000  // 30 seconds
@@ -158,6 +238,83 @@ int peerCount = 0;
 ESPNowSync espNowSync;
 bool _syncCommandInProgress = false;  // Prevents echo loops when applying peer commands
 
+// UDP pixel ingest; serviced by the link task, which owns the UART
+PixelIngest pixelIngest;
+bool ingestAutoLive = true;  // Switch to live mode when a stream starts
+
+// OSC control; parsed in the link task, which queues the changes directly
+#define OSC_SCENES 8
+struct OscScene {
+  bool saved;
+  uint8_t mode;
+  uint8_t index;
+  uint8_t brightness;
+  uint8_t frameRate;
+};
+OscServer oscServer;
+OscScene oscScenes[OSC_SCENES];
+uint8_t oscPattern[9] = { 0, 0, 255, 0, 0, 0, 0, 255, 50 };  // Last pattern set over OSC
+
+// Flash asset store; every image sent to the Teensy is kept here and sent
+// again (newest first) whenever the link to the Teensy comes up, to the
+// slots the Teensy reports empty (0x1A slot map)
+#define ASSET_RESTORE_MAX 8
+#define ASSET_RESTORE_RETRY_MS 1000  // Link check interval while a restore waits
+AssetStore assetStore;
+enum AssetRestoreState : uint8_t {
+  RESTORE_IDLE,
+  RESTORE_WAITING,   // Waiting for the Teensy link
+  RESTORE_DONE
+};
+struct AssetRestore {
+  uint8_t state;
+  uint8_t assets;          // In the last restore
+  uint8_t sent;
+  uint8_t failed;
+  uint8_t skipped;         // The Teensy still held an image in the slot
+  bool all;                // Next restore ignores the slot map (POST /api/assets)
+  uint32_t bytes;
+  uint32_t linkUpMs;       // millis() when the link came up
+  uint32_t transferMs;     // First asset sent to last asset ACKed
+  uint32_t bootToRestoredMs;  // First restore since boot; 0 until it finishes
+} assetRestore;
+
+// Uploads are kept in the store by the house task, off the link lock: the
+// upload handler copies the image into one of two PSRAM buffers and the
+// house task writes it to flash. A newer upload replaces one still waiting.
+// assetMutex guards assetStore and is taken before the link lock.
+struct AssetPut {
+  uint8_t* buffer[2];
+  uint16_t width[2];
+  uint16_t height[2];
+  uint32_t len[2];
+  int8_t pending;          // Buffer waiting for the house task, -1 if none
+  int8_t writing;          // Buffer being written, -1 if none
+  uint32_t replaced;       // Uploads superseded before they were written
+} assetPut = { { nullptr, nullptr }, {}, {}, {}, -1, -1, 0 };
+portMUX_TYPE assetPutMux = portMUX_INITIALIZER_UNLOCKED;
+SemaphoreHandle_t assetMutex = nullptr;
+struct AssetLock {
+  AssetLock() { xSemaphoreTake(assetMutex, portMAX_DELAY); }
+  ~AssetLock() { xSemaphoreGive(assetMutex); }
+};
+
+// Column hashes of the images last sent to each slot. An edited image is
+// sent as its changed columns (0x41) when the Teensy supports it.
+ColumnDelta columnDelta;
+
+// Progressive uploads (0x42): new images go column-major, every 8th column
+// first and then the gaps, a few columns per frame, and the Teensy shows the
+// partial image from the first frame on
+#define PROGRESSIVE_FRAME_COLUMNS 16
+struct ProgressiveStats {
+  uint32_t uploads;
+  uint32_t failed;         // Fell back to a plain upload
+  uint32_t lastBytes;
+  uint32_t lastCoarseMs;   // Teensy: begin until every 8th column was shown
+  uint32_t lastTotalMs;    // Teensy: begin until the image was committed
+} progressiveStats;
+
 // System state
 struct SystemState {
   uint8_t currentMode;
@@ -165,6 +322,10 @@ struct SystemState {
   uint8_t brightness;
   uint8_t frameRate;
   uint8_t cachedFrameDelay;  // Cached value: 1000 / frameRate
+  uint8_t dutyCycle;  // Column on-time percent (100 = no blanking)
+  bool hdrOutput;     // Teensy dims via APA102 global current instead of RGB scaling
+  bool hdrDither;     // Temporal dithering in the HDR output stage
+  uint8_t hdrGammaX10;
   bool connected;
   unsigned long lastSync;
   unsigned long lastDiscovery;
@@ -173,6 +334,191 @@ struct SystemState {
   uint8_t imageCount;  // Number of uploaded images (tracked locally)
 } state;
 
+// Control coalescing
+// Sliders post a value per step and one dashboard action used to take
+// several requests. Mode, brightness, frame rate, duty and the last pattern
+// edit are therefore queued here (the values themselves live in state) and
+// sent from loop() as one 0x17 batch frame at most every CONTROL_FLUSH_MS,
+// so a value superseded before the flush never reaches the UART or the
+// radio. Any other Teensy command flushes the queue first to keep order.
+#define CONTROL_FLUSH_MS 40
+#define PENDING_PATTERN    0x01
+#define PENDING_MODE       0x02
+#define PENDING_BRIGHTNESS 0x04
+#define PENDING_FRAMERATE  0x08
+#define PENDING_DUTY       0x10
+// OSC changes are for live performance and go out after OSC_FLUSH_MS
+// instead; that still merges a burst of fader messages into one frame.
+#define OSC_FLUSH_MS 5
+struct PendingControls {
+  uint8_t flags;            // PENDING_* bits
+  uint8_t pattern[9];       // index type r1 g1 b1 r2 g2 b2 speed
+  bool urgent;              // Something from OSC is waiting
+  uint8_t source;           // ControlSource of the oldest waiting change
+  int64_t firstRequestUs;   // When the request behind it arrived
+  unsigned long lastFlush;
+  uint32_t queued;          // Updates accepted
+  uint32_t coalesced;       // Updates replaced by a later one before sending
+  uint32_t frames;          // Batch frames sent
+} pendingControls;
+
+// Request-to-Teensy latency of queued controls, per path: from the moment
+// the HTTP task or the OSC reader picked up the request to the estimated
+// moment the last byte of its batch frame left the UART. The Teensy
+// applies a batch as soon as it is complete.
+enum ControlSource : uint8_t {
+  CONTROL_HTTP = 0,
+  CONTROL_OSC = 1,
+  CONTROL_OTHER = 2
+};
+struct ControlLatency {
+  uint32_t count;
+  uint64_t totalUs;
+  uint32_t worstUs;
+};
+ControlLatency controlLatency[2];
+uint8_t controlSource = CONTROL_OTHER;   // Set by whoever is handling a request
+int64_t controlRequestUs = 0;
+
+// SD load events
+// The Teensy loads SD images in the background and pushes an 0xC4 event
+// when done. Events are picked out of bytes the ESP32 would otherwise
+// discard: in drainTeensySerial() before each request, and from loop()
+// while a load is outstanding. GET /api/sd/load asks again (0x27) if one
+// was missed.
+#define SD_LOAD_EVENT_LEN 30      // Payload bytes of an 0xC4 frame
+#define SD_LOAD_EVENT_TIMEOUT_MS 10000
+struct SdLoadResult {
+  bool valid;
+  uint8_t status;          // 0 idle, 1 loading, 2 done, 3 not found, 4 bad file, 5 no space
+  uint8_t slot;
+  bool shown;
+  uint16_t width;
+  uint16_t height;
+  uint32_t readUs;
+  uint32_t commitUs;
+  uint32_t totalUs;
+  uint16_t passes;
+  uint8_t format;          // .pov version read (1 raw, 2 compressed)
+  uint32_t decodeUs;
+  uint32_t fileBytes;
+} sdLoadResult;
+bool sdLoadPending = false;
+unsigned long sdLoadRequestedAt = 0;
+
+// Show bundle loads (0x28) report the same way with an 0xC6 event
+#define SHOW_LOAD_EVENT_LEN 25    // Payload bytes of an 0xC6 frame
+#define SHOW_LOAD_EVENT_TIMEOUT_MS 60000
+struct ShowLoadResult {
+  bool valid;
+  uint8_t status;          // Same codes as SdLoadResult
+  uint16_t assetsDone;
+  uint16_t assetCount;
+  uint16_t images;
+  uint32_t bytes;
+  uint32_t readUs;
+  uint32_t applyUs;
+  uint32_t totalUs;
+  uint16_t passes;
+} showLoadResult;
+bool showLoadPending = false;
+unsigned long showLoadRequestedAt = 0;
+
+// Task layout
+// Work that loop() used to do in turn runs in four FreeRTOS tasks, so a
+// slow step (an mDNS query, a peer sync over HTTP, a capability handshake)
+// only delays its own task. The WiFi, lwIP and BLE stacks run on core 0
+// at higher priorities than any of these:
+//   link   core 1, prio 4,  2 ms  BLE bridge, peer commands, OSC, UDP pixel
+//                                 ingest, control flush, SD/show events
+//   http   core 1, prio 3,  2 ms  web server
+//   sync   core 0, prio 2, 10 ms  ESP-NOW heartbeats and time sync
+//   house  core 0, prio 1, 100 ms Teensy status check, peer discovery, auto-sync
+// The Teensy UART and the state shared with the web handlers (state,
+// pendingControls, teensyCaps, peers, load results) belong to whoever holds
+// linkMutex. It is recursive because handlers call helpers that lock too.
+// ESP-NOW receive callbacks run in the WiFi task; they post LinkMessages to
+// linkQueue and the link task applies them, instead of writing the UART
+// from a second task. GET /api/tasks reports each task's CPU share and
+// worst latencies.
+#define TASK_LINK_CORE 1
+#define TASK_LINK_PRIORITY 4
+#define TASK_LINK_PERIOD_MS 2
+#define TASK_LINK_STACK 6144
+#define TASK_HTTP_CORE 1
+#define TASK_HTTP_PRIORITY 3
+#define TASK_HTTP_PERIOD_MS 2
+#define TASK_HTTP_STACK 8192
+#define TASK_SYNC_CORE 0
+#define TASK_SYNC_PRIORITY 2
+#define TASK_SYNC_PERIOD_MS 10
+#define TASK_SYNC_STACK 4096
+#define TASK_HOUSE_CORE 0
+#define TASK_HOUSE_PRIORITY 1
+#define TASK_HOUSE_PERIOD_MS 100
+#define TASK_HOUSE_STACK 8192
+#define LINK_QUEUE_DEPTH 16
+
+SemaphoreHandle_t linkMutex = nullptr;
+
+// Holds linkMutex for a scope; records the wait in the caller's stats
+struct LinkLock {
+  LinkLock();
+  ~LinkLock() { xSemaphoreGiveRecursive(linkMutex); }
+};
+
+enum LinkMessageType : uint8_t {
+  LINK_PEER_MODE,
+  LINK_PEER_PATTERN,      // data: index type r1 g1 b1 r2 g2 b2 speed
+  LINK_PEER_BRIGHTNESS,
+  LINK_PEER_FRAMERATE,
+  LINK_PEER_SYNC_TIME     // value: offset in ms
+};
+struct LinkMessage {
+  uint8_t type;           // LinkMessageType
+  uint8_t data[9];
+  int32_t value;
+  int64_t queuedUs;       // For the queue latency in the link task's stats
+};
+QueueHandle_t linkQueue = nullptr;
+uint32_t linkQueueDropped = 0;
+uint8_t linkQueuePeak = 0;
+
+struct TaskStats {
+  const char* name;
+  void (*body)();
+  uint8_t core;
+  uint8_t priority;
+  uint16_t periodMs;
+  uint32_t stackBytes;
+  QueueHandle_t wake;     // Wakes the task early when a message arrives
+  TaskHandle_t handle;
+  // Since taskWindowStartUs; written by the task, read under taskStatsMux
+  uint32_t runs;
+  uint64_t busyUs;
+  uint32_t worstRunUs;    // Longest single pass
+  uint32_t worstLateUs;   // Latest start after the pass was due (1 ms tick)
+  uint32_t worstLockUs;   // Longest wait for linkMutex
+  uint32_t passLockUs;    // Lock waits in the current pass, not counted as busy
+};
+void linkTaskBody();
+void httpTaskBody();
+void syncTaskBody();
+void houseTaskBody();
+void startTasks();
+void runTask(void* arg);
+void postLinkMessage(LinkMessage& msg);
+void applyLinkMessage(const LinkMessage& msg);
+TaskStats tasks[] = {
+  { "link", linkTaskBody, TASK_LINK_CORE, TASK_LINK_PRIORITY, TASK_LINK_PERIOD_MS, TASK_LINK_STACK },
+  { "http", httpTaskBody, TASK_HTTP_CORE, TASK_HTTP_PRIORITY, TASK_HTTP_PERIOD_MS, TASK_HTTP_STACK },
+  { "sync", syncTaskBody, TASK_SYNC_CORE, TASK_SYNC_PRIORITY, TASK_SYNC_PERIOD_MS, TASK_SYNC_STACK },
+  { "house", houseTaskBody, TASK_HOUSE_CORE, TASK_HOUSE_PRIORITY, TASK_HOUSE_PERIOD_MS, TASK_HOUSE_STACK },
+};
+#define TASK_COUNT (sizeof(tasks) / sizeof(tasks[0]))
+portMUX_TYPE taskStatsMux = portMUX_INITIALIZER_UNLOCKED;
+int64_t taskWindowStartUs = 0;
+
 void setup() {
   // Initialize Serial for debugging
   Serial.begin(115200);
@@ -181,6 +527,9 @@ void setup() {
   
   // Initialize Teensy Serial
   TEENSY_SERIAL.begin(SERIAL_BAUD, SERIAL_8N1, SERIAL_RX_PIN, SERIAL_TX_PIN);
+  linkMutex = xSemaphoreCreateRecursiveMutex();
+  linkQueue = xQueueCreate(LINK_QUEUE_DEPTH, sizeof(LinkMessage));
+  assetMutex = xSemaphoreCreateMutex();
   
   // Initialize SPIFFS for web files
   if (!SPIFFS.begin(true)) {
@@ -188,6 +537,14 @@ void setup() {
     return;
   }
   Serial.println("SPIFFS Mounted");
+
+  if (assetStore.begin()) {
+    Serial.printf("Asset store: %u images, %u of %u KB used\n", assetStore.count(),
+                  (unsigned)(assetStore.usedBytes() / 1024), (unsigned)(assetStore.totalBytes() / 1024));
+    if (assetStore.count() > 0) assetRestore.state = RESTORE_WAITING;
+  } else {
+    Serial.println("Asset store mount failed (is partitions.csv flashed?)");
+  }
   
   // Load device configuration
   loadDeviceConfig();
@@ -199,6 +556,8 @@ void setup() {
   // Initialize BLE Bridge (before WiFi to avoid conflicts)
   #ifdef BLE_ENABLED
   bleBridge = new BLEBridge(&TEENSY_SERIAL);
+  bleBridge->setLinkLock(linkMutex);
+  bleBridge->setBeforeWrite(flushQueuedControls);
   bleBridge->setup();
   Serial.println("BLE Bridge initialized");
   #endif
@@ -209,6 +568,17 @@ void setup() {
   // Initialize ESP-NOW multi-poi sync (must be after WiFi init)
   setupESPNowSync();
 
+  // Listen for DDP, Art-Net and E1.31 pixel streams
+  loadIngestConfig();
+  pixelIngest.onColumn(forwardIngestColumn);
+  pixelIngest.onStreamStart(onIngestStreamStart);
+  pixelIngest.begin(deviceConfig.deviceName.c_str());
+
+  // Listen for OSC control messages
+  loadOscConfig();
+  oscServer.onMessage(routeOscMessage);
+  oscServer.begin(oscServer.port());
+
   // Initialize web server
   setupWebServer();
 
@@ -230,6 +600,10 @@ void setup() {
   state.brightness = 128;
   state.frameRate = 50;
   state.cachedFrameDelay = 1000 / 50;  // Pre-calculate frame delay
+  state.dutyCycle = 100;
+  state.hdrOutput = false;
+  state.hdrDither = true;
+  state.hdrGammaX10 = 22;
   state.connected = false;
   state.lastSync = 0;
   state.lastDiscovery = 0;
@@ -240,50 +614,274 @@ void setup() {
   Serial.println("ESP32 Nebula Poi Controller Ready!");
   Serial.print("IP Address: ");
   Serial.println(WiFi.softAPIP());
+
+  startTasks();
 }
 
 void loop() {
-  // Handle BLE communications
+  // Everything runs in the tasks started by setup()
+  vTaskDelete(NULL);
+}
+
+// ============================================================================
+// TASKS
+// ============================================================================
+
+void startTasks() {
+  taskWindowStartUs = esp_timer_get_time();
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    if (tasks[i].body == linkTaskBody) tasks[i].wake = linkQueue;
+    xTaskCreatePinnedToCore(runTask, tasks[i].name, tasks[i].stackBytes, &tasks[i],
+                            tasks[i].priority, &tasks[i].handle, tasks[i].core);
+  }
+  Serial.printf("[TASK] Started %u tasks\n", (unsigned)TASK_COUNT);
+}
+
+TaskStats* currentTaskStats() {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    if (tasks[i].handle == self) return &tasks[i];
+  }
+  return nullptr;
+}
+
+LinkLock::LinkLock() {
+  int64_t start = esp_timer_get_time();
+  xSemaphoreTakeRecursive(linkMutex, portMAX_DELAY);
+  uint32_t waited = (uint32_t)(esp_timer_get_time() - start);
+  TaskStats* t = currentTaskStats();
+  if (!t) return;
+  t->passLockUs += waited;
+  if (waited > t->worstLockUs) t->worstLockUs = waited;
+}
+
+// Web handlers run under linkMutex only once the request has been read, and
+// their response is written after it is released, so a slow client holds up
+// neither the link task nor the Teensy. reply() stands in for server.send()
+// in handlers registered through linked().
+struct DeferredReply {
+  bool active;    // A linked() handler is running
+  bool pending;
+  int code;
+  const char* type;
+  String body;
+};
+DeferredReply deferredReply = {};
+int64_t httpRequestUs = 0;  // When the request line of the request being handled was read
+
+// Registered before every other handler, so the server asks it about each
+// request right after reading the request line, before the headers and
+// body; it only notes the time, as OSC packets are timed when read
+class RequestStamp : public RequestHandler {
+ public:
+  bool canHandle(HTTPMethod method, String uri) override {
+    httpRequestUs = esp_timer_get_time();
+    return false;
+  }
+};
+RequestStamp requestStamp;
+
+void reply(int code, const char* type, const String& body) {
+  if (!deferredReply.active) {
+    server.send(code, type, body);
+    return;
+  }
+  deferredReply.pending = true;
+  deferredReply.code = code;
+  deferredReply.type = type;
+  deferredReply.body = body;
+}
+
+void sendDeferredReply() {
+  if (!deferredReply.pending) return;
+  deferredReply.pending = false;
+  server.send(deferredReply.code, deferredReply.type, deferredReply.body);
+  deferredReply.body = String();
+}
+
+std::function<void()> linked(void (*handler)()) {
+  return [handler]() {
+    {
+      LinkLock lock;
+      controlSource = CONTROL_HTTP;
+      controlRequestUs = httpRequestUs;
+      deferredReply.active = true;
+      handler();
+      deferredReply.active = false;
+      controlSource = CONTROL_OTHER;
+    }
+    sendDeferredReply();
+  };
+}
+
+// Runs a task's body once per period. Passes are timed from their start, so
+// an overrun is followed by the next pass at once rather than a burst.
+void runTask(void* arg) {
+  TaskStats* t = (TaskStats*)arg;
+  int64_t periodUs = (int64_t)t->periodMs * 1000;
+  int64_t dueUs = esp_timer_get_time();
+  for (;;) {
+    int64_t startUs = esp_timer_get_time();
+    t->passLockUs = 0;
+    t->body();
+    int64_t endUs = esp_timer_get_time();
+
+    uint32_t runUs = (uint32_t)(endUs - startUs);
+    uint32_t lateUs = startUs > dueUs ? (uint32_t)(startUs - dueUs) : 0;
+    portENTER_CRITICAL(&taskStatsMux);
+    t->runs++;
+    t->busyUs += runUs > t->passLockUs ? runUs - t->passLockUs : 0;
+    if (runUs > t->worstRunUs) t->worstRunUs = runUs;
+    if (lateUs > t->worstLateUs) t->worstLateUs = lateUs;
+    portEXIT_CRITICAL(&taskStatsMux);
+
+    dueUs = startUs + periodUs;
+    int64_t waitUs = dueUs - esp_timer_get_time();
+    TickType_t ticks = waitUs > 0 ? pdMS_TO_TICKS((waitUs + 999) / 1000) : 0;
+    if (t->wake) {
+      LinkMessage peek;
+      if (xQueuePeek(t->wake, &peek, ticks) == pdTRUE) dueUs = esp_timer_get_time();
+    } else if (ticks > 0) {
+      vTaskDelay(ticks);
+    } else {
+      taskYIELD();
+    }
+  }
+}
+
+void linkTaskBody() {
+  LinkLock lock;
+
   #ifdef BLE_ENABLED
   if (bleBridge) {
     bleBridge->loop();
   }
   #endif
-  
+
+  // Commands from paired peers, in arrival order
+  LinkMessage msg;
+  while (xQueueReceive(linkQueue, &msg, 0) == pdTRUE) {
+    uint32_t waitedUs = (uint32_t)(esp_timer_get_time() - msg.queuedUs);
+    TaskStats* t = currentTaskStats();
+    if (t && waitedUs > t->worstLateUs) t->worstLateUs = waitedUs;
+    applyLinkMessage(msg);
+  }
+
+  // Control messages from OSC controllers join the batch below
+  oscServer.loop();
+  controlSource = CONTROL_OTHER;
+
+  // Read UDP pixel packets and forward the columns that are due
+  pixelIngest.loop();
+
+  // Pick up the completion event of a background SD image or show load
+  if (sdLoadPending || showLoadPending) {
+    drainTeensySerial();
+    if (sdLoadPending && millis() - sdLoadRequestedAt > SD_LOAD_EVENT_TIMEOUT_MS) {
+      sdLoadPending = false;  // Missed; GET /api/sd/load asks the Teensy
+    }
+    if (showLoadPending && millis() - showLoadRequestedAt > SHOW_LOAD_EVENT_TIMEOUT_MS) {
+      showLoadPending = false;  // Missed; GET /api/show/load asks the Teensy
+    }
+  }
+
+  // Send queued control changes as one batch frame
+  uint32_t flushMs = pendingControls.urgent ? OSC_FLUSH_MS : CONTROL_FLUSH_MS;
+  if (pendingControls.flags && millis() - pendingControls.lastFlush >= flushMs) {
+    flushPendingControls();
+  }
+}
+
+void httpTaskBody() {
+  // Reading requests and writing responses happen without linkMutex; the
+  // handlers take it themselves (see linked())
   server.handleClient();
+}
 
-  // ESP-NOW sync loop (heartbeats, time sync, peer timeouts)
+void syncTaskBody() {
+  // Heartbeats, time sync and peer timeouts. ESPNowSync serialises this
+  // against the receive callback and the senders on other tasks itself.
   espNowSync.loop();
+}
 
-  // Check Teensy connection periodically
+void houseTaskBody() {
+  // Check Teensy connection periodically; sooner while stored images wait
+  // for the link, so they are back on the Teensy soon after boot
   static unsigned long lastCheck = 0;
-  if (millis() - lastCheck > 5000) {
+  static bool checked = false;
+  unsigned long checkMs = assetRestore.state == RESTORE_WAITING ? ASSET_RESTORE_RETRY_MS : 5000;
+  if (!checked || millis() - lastCheck > checkMs) {
+    checked = true;
     lastCheck = millis();
+    LinkLock lock;
     checkTeensyConnection();
     // Keep sync heartbeat state up to date
     espNowSync.setLocalState(state.currentMode, state.currentIndex,
                              state.brightness,
                              state.frameRate > 0 ? 1000 / state.frameRate : 20);
   }
-  
+
+  // Keep the last upload in flash, then send stored images again once the
+  // link is up (takes the lock per image)
+  serviceAssetPut();
+  if (assetRestore.state == RESTORE_WAITING && state.connected) {
+    restoreAssets();
+  }
+
   // Periodic peer discovery
   if (millis() - state.lastDiscovery > PEER_DISCOVERY_INTERVAL) {
     state.lastDiscovery = millis();
     discoverPeers();
   }
-  
+
   // Auto-sync if enabled
-  if (deviceConfig.autoSync && peerCount > 0 && 
-      millis() - state.lastSync > deviceConfig.syncInterval) {
+  if (deviceConfig.autoSync && millis() - state.lastSync > deviceConfig.syncInterval) {
     state.lastSync = millis();
     // Auto-sync with first available peer
-    for (int i = 0; i < peerCount; i++) {
-      if (peers[i].online) {
-        Serial.println("Auto-syncing with peer: " + peers[i].deviceName);
-        performSync(peers[i].deviceId);
-        break;
+    String peerId;
+    {
+      LinkLock lock;
+      for (int i = 0; i < peerCount; i++) {
+        if (peers[i].online) {
+          Serial.println("Auto-syncing with peer: " + peers[i].deviceName);
+          peerId = peers[i].deviceId;
+          break;
+        }
       }
     }
+    if (peerId.length() > 0) performSync(peerId);
+  }
+}
+
+// Hands a peer command to the link task; called from the WiFi task
+void postLinkMessage(LinkMessage& msg) {
+  msg.queuedUs = esp_timer_get_time();
+  if (xQueueSend(linkQueue, &msg, 0) != pdTRUE) {
+    linkQueueDropped++;
+    return;
+  }
+  uint8_t used = (uint8_t)uxQueueMessagesWaiting(linkQueue);
+  if (used > linkQueuePeak) linkQueuePeak = used;
+}
+
+void applyLinkMessage(const LinkMessage& msg) {
+  const uint8_t* d = msg.data;
+  switch (msg.type) {
+    case LINK_PEER_MODE:
+      applyModeToTeensy(d[0], d[1]);
+      break;
+    case LINK_PEER_PATTERN:
+      applyPatternToTeensy(d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8]);
+      break;
+    case LINK_PEER_BRIGHTNESS:
+      applyBrightnessToTeensy(d[0]);
+      break;
+    case LINK_PEER_FRAMERATE:
+      applyFrameRateToTeensy(d[0]);
+      break;
+    case LINK_PEER_SYNC_TIME:
+      applySyncTimeToTeensy(msg.value);
+      break;
   }
 }
 
@@ -330,32 +928,59 @@ void setupWiFi() {
 }
 
 void setupWebServer() {
+  // Handlers that touch the Teensy or shared state are wrapped in linked();
+  // the others take linkMutex around just the part that needs it
+  server.addHandler(&requestStamp);
+
   // Main page
   server.on("/", HTTP_GET, handleRoot);
   
   // API endpoints
-  server.on("/api/status", HTTP_GET, handleStatus);
-  server.on("/api/mode", HTTP_POST, handleSetMode);
-  server.on("/api/brightness", HTTP_POST, handleSetBrightness);
-  server.on("/api/framerate", HTTP_POST, handleSetFrameRate);
-  server.on("/api/power/mode", HTTP_POST, handlePowerMode);
-  server.on("/api/pattern", HTTP_POST, handleUploadPattern);
+  server.on("/api/status", HTTP_GET, linked(handleStatus));
+  server.on("/api/mode", HTTP_POST, linked(handleSetMode));
+  server.on("/api/brightness", HTTP_POST, linked(handleSetBrightness));
+  server.on("/api/framerate", HTTP_POST, linked(handleSetFrameRate));
+  server.on("/api/duty", HTTP_POST, linked(handleSetDuty));
+  server.on("/api/output", HTTP_POST, linked(handleSetOutput));
+  server.on("/api/duty/power", HTTP_GET, linked(handleDutyPower));
+  server.on("/api/duty/power", HTTP_POST, linked(handleDutyPower));
+  server.on("/api/governor", HTTP_GET, linked(handleGovernor));
+  server.on("/api/governor", HTTP_POST, linked(handleGovernor));
+  server.on("/api/rotation", HTTP_GET, linked(handleRotation));
+  server.on("/api/rotation", HTTP_POST, linked(handleRotation));
+  server.on("/api/link", HTTP_GET, linked(handleLinkStats));
+  server.on("/api/tasks", HTTP_GET, linked(handleTasks));
+  server.on("/api/ingest", HTTP_GET, linked(handleIngest));
+  server.on("/api/ingest", HTTP_POST, linked(handleIngest));
+  server.on("/api/osc", HTTP_GET, linked(handleOsc));
+  server.on("/api/osc", HTTP_POST, linked(handleOsc));
+  server.on("/api/storage", HTTP_GET, linked(handleStorage));
+  server.on("/api/assets", HTTP_GET, handleAssets);
+  server.on("/api/assets", HTTP_POST, handleAssets);
+  server.on("/api/upload", HTTP_GET, linked(handleUploadStats));
+  server.on("/api/readback", HTTP_GET, handleReadback);
+  server.on("/api/batch", HTTP_GET, linked(handleBatch));
+  server.on("/api/batch", HTTP_POST, linked(handleBatch));
+  server.on("/api/power/mode", HTTP_POST, linked(handlePowerMode));
+  server.on("/api/pattern", HTTP_POST, linked(handleUploadPattern));
   server.on("/api/image", HTTP_POST, 
     []() { 
       // Final response sent in handleUploadImage after upload completes
     },
-    handleUploadImage);
-  server.on("/api/live", HTTP_POST, handleLiveFrame);
+    linked(handleUploadImage));
+  server.on("/api/live", HTTP_POST, linked(handleLiveFrame));
+  server.on("/api/live/record", HTTP_GET, linked(handleLiveRecorder));
+  server.on("/api/live/record", HTTP_POST, linked(handleLiveRecorder));
   
   // Sync API endpoints
-  server.on("/api/sync/status", HTTP_GET, handleSyncStatus);
+  server.on("/api/sync/status", HTTP_GET, linked(handleSyncStatus));
   server.on("/api/sync/discover", HTTP_POST, handleSyncDiscover);
   server.on("/api/sync/execute", HTTP_POST, handleSyncExecute);
-  server.on("/api/sync/data", HTTP_GET, handleSyncData);
+  server.on("/api/sync/data", HTTP_GET, linked(handleSyncData));
   server.on("/api/sync/push", HTTP_POST, handleSyncPush);
   
   // Device configuration endpoints
-  server.on("/api/device/config", HTTP_GET, handleDeviceConfig);
+  server.on("/api/device/config", HTTP_GET, linked(handleDeviceConfig));
   server.on("/api/device/config", HTTP_POST, handleDeviceConfigUpdate);
   
   // WiFi network (STA) configuration - connect to existing network for web UI access
@@ -365,17 +990,24 @@ void setupWebServer() {
   server.on("/api/wifi/disconnect", HTTP_POST, handleWifiDisconnect);
 
   // ESP-NOW multi-poi sync endpoints
-  server.on("/api/multipoi/status", HTTP_GET, handleMultiPoiStatus);
-  server.on("/api/multipoi/pair", HTTP_POST, handleMultiPoiPair);
-  server.on("/api/multipoi/unpair", HTTP_POST, handleMultiPoiUnpair);
-  server.on("/api/multipoi/syncmode", HTTP_POST, handleMultiPoiSyncMode);
-  server.on("/api/multipoi/peercmd", HTTP_POST, handleMultiPoiPeerCmd);
+  server.on("/api/multipoi/status", HTTP_GET, linked(handleMultiPoiStatus));
+  server.on("/api/multipoi/pair", HTTP_POST, linked(handleMultiPoiPair));
+  server.on("/api/multipoi/unpair", HTTP_POST, linked(handleMultiPoiUnpair));
+  server.on("/api/multipoi/syncmode", HTTP_POST, linked(handleMultiPoiSyncMode));
+  server.on("/api/multipoi/peercmd", HTTP_POST, linked(handleMultiPoiPeerCmd));
   
   // SD card management endpoints
-  server.on("/api/sd/list", HTTP_GET, handleSDList);
-  server.on("/api/sd/info", HTTP_GET, handleSDInfo);
-  server.on("/api/sd/delete", HTTP_POST, handleSDDelete);
-  server.on("/api/sd/load", HTTP_POST, handleSDLoad);
+  server.on("/api/sd/list", HTTP_GET, linked(handleSDList));
+  server.on("/api/sd/info", HTTP_GET, linked(handleSDInfo));
+  server.on("/api/sd/delete", HTTP_POST, linked(handleSDDelete));
+  server.on("/api/sd/load", HTTP_GET, linked(handleSDLoad));
+  server.on("/api/sd/load", HTTP_POST, linked(handleSDLoad));
+  server.on("/api/sd/writer", HTTP_GET, linked(handleSDWriter));
+  server.on("/api/show/load", HTTP_GET, linked(handleShowLoad));
+  server.on("/api/show/load", HTTP_POST, linked(handleShowLoad));
+  server.on("/api/sd/play", HTTP_POST, linked(handleSDPlay));
+  server.on("/api/sd/cache", HTTP_GET, linked(handleSDCache));
+  server.on("/api/sd/cache", HTTP_POST, linked(handleSDCache));
   
   // PWA support
   server.on("/manifest.json", HTTP_GET, handleManifest);
@@ -610,6 +1242,7 @@ static const char rootPage[] PROGMEM = R"rawliteral(
                         <option value="2" selected>Pattern Display</option>
                         <option value="3">Sequence</option>
                         <option value="4">Live Mode</option>
+                        <option value="5">SD Cache</option>
                     </select>
                 </div>
                 <div class="ctrl">
@@ -621,7 +1254,7 @@ static const char rootPage[] PROGMEM = R"rawliteral(
                     </div>
                 </div>
                 <div style="padding:10px;background:#1e293b;border-radius:8px;font-size:12px;color:#64748b;margin-top:4px">
-                    Images: 0=Smiley, 1=Rainbow, 2=Heart | Patterns: 0-17 | Sequences: 0=Demo Mix
+                    Images: 0=Smiley, 1=Rainbow, 2=Heart | Patterns: 0-20 | Sequences: 0=Demo Mix
                 </div>
             </div>
 
@@ -636,6 +1269,14 @@ static const char rootPage[] PROGMEM = R"rawliteral(
                     <label>Frame Rate <span id="framerate-value">50</span> FPS</label>
                     <input type="range" id="framerate" min="10" max="250" value="50" oninput="updateFrameRate(this.value)">
                 </div>
+                <div class="ctrl">
+                    <label>Column Duty <span id="duty-value">100</span>%</label>
+                    <input type="range" id="duty" min="5" max="100" value="100" oninput="updateDuty(this.value)">
+                </div>
+                <div style="display:flex;gap:8px;align-items:center">
+                    <button class="btn btn-slate" style="padding:6px 12px;flex-shrink:0" onclick="measureDutyPower()">Measure Current</button>
+                    <div id="duty-power" style="font-size:11px;color:#64748b">Shorter duty = sharper columns, less current</div>
+                </div>
             </div>
 
             <!-- Power Mode -->
@@ -670,6 +1311,9 @@ static const char rootPage[] PROGMEM = R"rawliteral(
                     <button class="pbtn" data-pattern="10" onclick="setPattern(10)">Plasma</button>
                     <button class="pbtn" data-pattern="16" onclick="setPattern(16)">Split Spin</button>
                     <button class="pbtn" data-pattern="17" onclick="setPattern(17)">Theater Chase</button>
+                    <button class="pbtn" data-pattern="18" onclick="setPattern(18)">Fireworks</button>
+                    <button class="pbtn" data-pattern="19" onclick="setPattern(19)">Rain</button>
+                    <button class="pbtn" data-pattern="20" onclick="setPattern(20)">Sparks</button>
                 </div>
             </div>
 
@@ -930,7 +1574,7 @@ static const char rootPage[] PROGMEM = R"rawliteral(
                     <div style="color:#06b6d4">#define NUM_LEDS 32</div>
                     <div style="color:#06b6d4">CRGB leds[NUM_LEDS];</div>
                     <div style="color:#a855f7">FastLED.addLeds&lt;APA102, 11, 13&gt;(leds, NUM_LEDS);</div>
-                    <div style="color:#475569">// Modes: 0=Idle 1=Image 2=Pattern 3=Sequence 4=Live</div>
+                    <div style="color:#475569">// Modes: 0=Idle 1=Image 2=Pattern 3=Sequence 4=Live 5=SD</div>
                     <div style="color:#475569">// Patterns: 0-10 Basic | 11-15 Audio | 16-17 Advanced</div>
                 </div>
             </div>
@@ -948,7 +1592,7 @@ static const char rootPage[] PROGMEM = R"rawliteral(
     let currentMode=2,currentPattern=0,brightness=128,originalImageAspectRatio=1.0;
     let currentSyncMode='mirror',syncPeers=[];
     let genType='organic',colorSeed=Math.random();
-    const MODES=['Idle','Image','Pattern','Sequence','Live'];
+    const MODES=['Idle','Image','Pattern','Sequence','Live','SD Cache'];
 
     // ===== Tab Navigation =====
     document.querySelectorAll('.nav-tab').forEach(tab=>{
@@ -1012,6 +1656,7 @@ static const char rootPage[] PROGMEM = R"rawliteral(
             document.getElementById('brightness-value').textContent=brightness;
             document.getElementById('framerate').value=d.framerate;
             document.getElementById('framerate-value').textContent=d.framerate;
+            if(d.duty!==undefined){document.getElementById('duty').value=d.duty;document.getElementById('duty-value').textContent=d.duty}
             if(d.mode===2){currentPattern=d.index;updatePatternActiveState()}
             updateLEDPreviewFromStatus(d.mode,d.index);
             if(d.powerMode!==undefined){
@@ -1082,6 +1727,25 @@ static const char rootPage[] PROGMEM = R"rawliteral(
         document.getElementById('fps-display').textContent=v;
         fetch('/api/framerate',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify({framerate:v})});
     }
+    function updateDuty(value){
+        var v=parseInt(value);if(isNaN(v))return;v=Math.max(5,Math.min(100,v));
+        document.getElementById('duty-value').textContent=v;
+        fetch('/api/duty',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify({duty:v})});
+    }
+    async function measureDutyPower(){
+        const el=document.getElementById('duty-power');
+        try{
+            let r=await(await fetch('/api/duty/power',{method:'POST'})).json();
+            if(r.state==='unavailable'){el.textContent='INA219 not detected';return}
+            el.textContent='Measuring...';
+            for(let i=0;i<10&&r.state!=='done';i++){
+                await new Promise(res=>setTimeout(res,500));
+                r=await(await fetch('/api/duty/power')).json();
+            }
+            if(r.state!=='done'){el.textContent='Measurement timed out';return}
+            el.textContent='100%: '+r.fullDutyMa+' mA | '+r.duty+'%: '+r.dutyMa+' mA (saved '+(r.savedPercent||0)+'%)';
+        }catch(e){el.textContent='Measurement failed'}
+    }
 
     // ===== Image Navigation =====
     async function prevImage(){
@@ -1692,13 +2356,29 @@ void handleStatus() {
   doc["index"] = state.currentIndex;
   doc["brightness"] = state.brightness;
   doc["framerate"] = state.frameRate;
+  doc["duty"] = state.dutyCycle;
+  doc["hdr"] = state.hdrOutput;
   doc["sdCardPresent"] = state.sdCardPresent;
   doc["powerMode"] = state.powerMode;
-  doc["count"] = state.imageCount > 0 ? state.imageCount : 10;  // Default: Teensy MAX_IMAGES without PSRAM
+  if (teensyCaps.valid) {
+    doc["count"] = teensyCaps.maxImages;
+    JsonObject teensy = doc["teensy"].to<JsonObject>();
+    teensy["protocol"] = teensyCaps.protocolVersion;
+    teensy["maxImages"] = teensyCaps.maxImages;
+    teensy["freeSlots"] = teensyCaps.freeSlots;
+    teensy["maxWidth"] = teensyCaps.maxWidth;
+    teensy["maxHeight"] = teensyCaps.maxHeight;
+    teensy["psramMb"] = teensyCaps.psramMb;
+    teensy["encodings"] = teensyCaps.encodings;
+    teensy["maxFrameBytes"] = teensyCaps.maxFrameBytes;
+    teensy["freeColumns"] = teensyCaps.freeColumns;
+  } else {
+    doc["count"] = state.imageCount > 0 ? state.imageCount : 10;  // Default: Teensy MAX_IMAGES without PSRAM
+  }
   
   String response;
   serializeJson(doc, response);
-  server.send(200, "application/json", response);
+  reply(200, "application/json", response);
 }
 
 void handleSetMode() {
@@ -1707,7 +2387,7 @@ void handleSetMode() {
 
     JsonDocument doc;
     if (deserializeJson(doc, body)) {
-      server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      reply(400, "application/json", "{\"error\":\"Invalid JSON\"}");
       return;
     }
     if (doc["mode"].is<int>()) {
@@ -1717,20 +2397,12 @@ void handleSetMode() {
       state.currentIndex = doc["index"].as<uint8_t>();
     }
     
-    // Send command to Teensy
-    sendTeensyCommand(0x01, 2);
-    TEENSY_SERIAL.write(state.currentMode);
-    TEENSY_SERIAL.write(state.currentIndex);
-    TEENSY_SERIAL.write(0xFE);
+    // Sent to the Teensy and peers with the next batch
+    queueControl(PENDING_MODE);
 
-    // Broadcast to paired peers via ESP-NOW (mirror mode)
-    if (!_syncCommandInProgress) {
-      espNowSync.broadcastModeChange(state.currentMode, state.currentIndex);
-    }
-
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
+    reply(200, "application/json", "{\"status\":\"ok\"}");
   } else {
-    server.send(400, "application/json", "{\"error\":\"No data\"}");
+    reply(400, "application/json", "{\"error\":\"No data\"}");
   }
 }
 
@@ -1739,25 +2411,16 @@ void handleSetBrightness() {
     String body = server.arg("plain");
     JsonDocument doc;
     if (deserializeJson(doc, body) || !doc["brightness"].is<int>()) {
-      server.send(400, "application/json", "{\"error\":\"Invalid data\"}");
+      reply(400, "application/json", "{\"error\":\"Invalid data\"}");
       return;
     }
     state.brightness = doc["brightness"].as<uint8_t>();
+    queueControl(PENDING_BRIGHTNESS);
 
-    // Send command to Teensy
-    sendTeensyCommand(0x06, 1);
-    TEENSY_SERIAL.write(state.brightness);
-    TEENSY_SERIAL.write(0xFE);
-
-    // Broadcast to paired peers via ESP-NOW (mirror mode)
-    if (!_syncCommandInProgress) {
-      espNowSync.broadcastBrightness(state.brightness);
-    }
-
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
+    reply(200, "application/json", "{\"status\":\"ok\"}");
     return;
   }
-  server.send(400, "application/json", "{\"error\":\"Invalid data\"}");
+  reply(400, "application/json", "{\"error\":\"Invalid data\"}");
 }
 
 void handleSetFrameRate() {
@@ -1765,144 +2428,1102 @@ void handleSetFrameRate() {
     String body = server.arg("plain");
     JsonDocument doc;
     if (deserializeJson(doc, body) || !doc["framerate"].is<int>()) {
-      server.send(400, "application/json", "{\"error\":\"Invalid data\"}");
+      reply(400, "application/json", "{\"error\":\"Invalid data\"}");
       return;
     }
     state.frameRate = doc["framerate"].as<uint8_t>();
     state.cachedFrameDelay = 1000 / max((uint8_t)1, state.frameRate);  // Update cache
+    queueControl(PENDING_FRAMERATE);
 
-    // Send command to Teensy
-    sendTeensyCommand(0x07, 1);
-    TEENSY_SERIAL.write(state.cachedFrameDelay);
-    TEENSY_SERIAL.write(0xFE);
+    reply(200, "application/json", "{\"status\":\"ok\"}");
+    return;
+  }
+  reply(400, "application/json", "{\"error\":\"Invalid data\"}");
+}
 
-    // Broadcast to paired peers via ESP-NOW (mirror mode)
-    if (!_syncCommandInProgress) {
-      espNowSync.broadcastFrameRate(state.cachedFrameDelay);
+void handleSetDuty() {
+  if (server.hasArg("plain")) {
+    String body = server.arg("plain");
+    JsonDocument doc;
+    if (deserializeJson(doc, body) || !doc["duty"].is<int>()) {
+      reply(400, "application/json", "{\"error\":\"Invalid data\"}");
+      return;
     }
+    state.dutyCycle = constrain(doc["duty"].as<int>(), 5, 100);
+    queueControl(PENDING_DUTY);
 
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
+    reply(200, "application/json", "{\"status\":\"ok\"}");
     return;
   }
-  server.send(400, "application/json", "{\"error\":\"Invalid data\"}");
+  reply(400, "application/json", "{\"error\":\"Invalid data\"}");
 }
 
-void handlePowerMode() {
-  if (server.hasArg("plain")) {
-    String body = server.arg("plain");
-    int idx = body.indexOf("\"mode\":");
-    if (idx != -1) {
-      int start = idx + 7;
-      while (start < (int)body.length() && (body[start] == ' ' || body[start] == '"')) start++;
-      String modeStr = body.substring(start);
-      modeStr = modeStr.substring(0, modeStr.indexOf('"'));
+// Selects the Teensy output stage: HDR (5-bit global current + PWM LUTs)
+// with optional temporal dithering and gamma, or plain FastLED scaling.
+void handleSetOutput() {
+  JsonDocument doc;
+  if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain"))) {
+    reply(400, "application/json", "{\"error\":\"Invalid data\"}");
+    return;
+  }
+  state.hdrOutput = doc["hdr"] | state.hdrOutput;
+  state.hdrDither = doc["dither"] | state.hdrDither;
+  if (doc["gamma"].is<float>()) {
+    state.hdrGammaX10 = constrain((int)(doc["gamma"].as<float>() * 10.0f + 0.5f), 10, 30);
+  }
 
-      uint8_t cpuMhz = 160;
-      uint8_t fpsLimit = 60;
-      uint8_t brightnessLimit = 255;
+  sendTeensyCommand(0x0C, 3);
+  TEENSY_SERIAL.write(state.hdrOutput ? (uint8_t)1 : (uint8_t)0);
+  TEENSY_SERIAL.write(state.hdrDither ? (uint8_t)1 : (uint8_t)0);
+  TEENSY_SERIAL.write(state.hdrGammaX10);
+  TEENSY_SERIAL.write(0xFE);
 
-      if (modeStr == "performance") {
-        state.powerMode = 0;
-        cpuMhz = 240; fpsLimit = 120; brightnessLimit = 255;
-      } else if (modeStr == "balanced") {
-        state.powerMode = 1;
-        cpuMhz = 160; fpsLimit = 60; brightnessLimit = 255;
-      } else if (modeStr == "powersave") {
-        state.powerMode = 2;
-        cpuMhz = 80; fpsLimit = 30; brightnessLimit = 150;
-      } else if (modeStr == "ultrasave") {
-        state.powerMode = 3;
-        cpuMhz = 80; fpsLimit = 15; brightnessLimit = 80;  // 80 MHz is minimum with WiFi active
-      } else {
-        server.send(400, "application/json", "{\"error\":\"Unknown mode\"}");
-        return;
-      }
+  JsonDocument response;
+  response["status"] = "ok";
+  response["hdr"] = state.hdrOutput;
+  response["dither"] = state.hdrDither;
+  response["gamma"] = state.hdrGammaX10 / 10.0;
+  String body;
+  serializeJson(response, body);
+  reply(200, "application/json", body);
+}
 
-      setCpuFrequencyMhz(cpuMhz);
+// GET reports the last duty-cycle current measurement, POST starts a new
+// A/B run on the Teensy (~3 s: 100% duty, then the configured duty).
+void handleDutyPower() {
+  static const char* const kMeasureStates[] = {
+    "idle", "measuring", "measuring", "done", "unavailable"
+  };
+
+  bool start = (server.method() == HTTP_POST);
+  drainTeensySerial();
+  sendTeensyCommand(0x11, 1);
+  TEENSY_SERIAL.write(start ? (uint8_t)1 : (uint8_t)0);
+  TEENSY_SERIAL.write(0xFE);
 
-      state.frameRate = fpsLimit;
-      state.cachedFrameDelay = 1000 / max((uint8_t)1, state.frameRate);
-      sendTeensyCommand(0x07, 1);
-      TEENSY_SERIAL.write(state.cachedFrameDelay);
+  // Response: 0xFF 0xBC duty state full_mA(2) duty_mA(2) last_mA(2) target 0xFE
+  uint8_t buf[9];
+  if (!readTeensyFrame(0xBC, buf, sizeof(buf))) {
+    reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+    return;
+  }
+
+  uint16_t fullMa = ((uint16_t)buf[2] << 8) | buf[3];
+  uint16_t dutyMa = ((uint16_t)buf[4] << 8) | buf[5];
+  uint16_t lastMa = ((uint16_t)buf[6] << 8) | buf[7];
+
+  JsonDocument doc;
+  doc["duty"] = buf[0];
+  doc["target"] = buf[8] == 1 ? "governor" : "duty";
+  doc["state"] = kMeasureStates[buf[1] < 5 ? buf[1] : 4];
+  doc["fullDutyMa"] = fullMa;
+  doc["dutyMa"] = dutyMa;
+  doc["lastMa"] = lastMa;
+  if (buf[1] == 3 && fullMa > 0) {
+    doc["savedMa"] = (int)fullMa - (int)dutyMa;
+    doc["savedPercent"] = ((int)fullMa - (int)dutyMa) * 100 / (int)fullMa;
+  }
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
+
+// GET reports the Teensy power governor (ARM clock, render load, sleep
+// share) together with the last A/B current measurement. POST turns the
+// governor on/off and, with "measure": true, starts a governor A/B run
+// (~3 s: governor bypassed, then governed).
+void handleGovernor() {
+  static const char* const kMeasureStates[] = {
+    "idle", "measuring", "measuring", "done", "unavailable"
+  };
+
+  bool measure = false;
+  if (server.method() == HTTP_POST) {
+    JsonDocument doc;
+    if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain"))) {
+      reply(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      return;
+    }
+    if (doc["enabled"].is<bool>()) {
+      drainTeensySerial();
+      sendTeensyCommand(0x0D, 1);
+      TEENSY_SERIAL.write(doc["enabled"].as<bool>() ? (uint8_t)1 : (uint8_t)0);
       TEENSY_SERIAL.write(0xFE);
-      if (!_syncCommandInProgress) {
-        espNowSync.broadcastFrameRate(state.cachedFrameDelay);
+      // Wait for the ACK (0xFF 0xAA 0x0D 0xFE) before reading back
+      uint8_t ack;
+      if (!readTeensyFrame(0xAA, &ack, 1, 100) || ack != 0x0D) {
+        reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+        return;
       }
+    }
+    measure = doc["measure"] | false;
+  }
 
-      if (brightnessLimit < state.brightness) {
-        state.brightness = brightnessLimit;
-        sendTeensyCommand(0x06, 1);
-        TEENSY_SERIAL.write(state.brightness);
-        TEENSY_SERIAL.write(0xFE);
-        if (!_syncCommandInProgress) {
-          espNowSync.broadcastBrightness(state.brightness);
-        }
-      }
+  drainTeensySerial();
+  sendTeensyCommand(0x14, 0);
+  TEENSY_SERIAL.write(0xFE);
 
-      server.send(200, "application/json", "{\"status\":\"ok\",\"cpuMhz\":" + String(cpuMhz) + ",\"fpsLimit\":" + String(fpsLimit) + "}");
-      return;
+  // Response: 0xFF 0xC0 enabled active clock_mhz(2) load_pct sleep_pct strip_dark 0xFE
+  uint8_t gov[7];
+  if (!readTeensyFrame(0xC0, gov, sizeof(gov))) {
+    reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+    return;
+  }
+
+  sendTeensyCommand(0x11, 1);
+  TEENSY_SERIAL.write(measure ? (uint8_t)2 : (uint8_t)0);
+  TEENSY_SERIAL.write(0xFE);
+
+  // Response: 0xFF 0xBC duty state full_mA(2) duty_mA(2) last_mA(2) target 0xFE
+  uint8_t pwr[9];
+  if (!readTeensyFrame(0xBC, pwr, sizeof(pwr))) {
+    reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+    return;
+  }
+
+  JsonDocument doc;
+  doc["enabled"] = gov[0] != 0;
+  doc["active"] = gov[1] != 0;
+  doc["clockMhz"] = ((uint16_t)gov[2] << 8) | gov[3];
+  doc["loadPercent"] = gov[4];
+  doc["sleepPercent"] = gov[5];
+  doc["stripDark"] = gov[6] != 0;
+
+  JsonObject power = doc["measurement"].to<JsonObject>();
+  power["state"] = kMeasureStates[pwr[1] < 5 ? pwr[1] : 4];
+  power["target"] = pwr[8] == 1 ? "governor" : "duty";
+  power["lastMa"] = ((uint16_t)pwr[6] << 8) | pwr[7];
+  if (pwr[1] == 3 && pwr[8] == 1) {
+    uint16_t bypassedMa = ((uint16_t)pwr[2] << 8) | pwr[3];
+    uint16_t governedMa = ((uint16_t)pwr[4] << 8) | pwr[5];
+    power["bypassedMa"] = bypassedMa;
+    power["governedMa"] = governedMa;
+    if (bypassedMa > 0) {
+      power["savedMa"] = (int)bypassedMa - (int)governedMa;
+      power["savedPercent"] = ((int)bypassedMa - (int)governedMa) * 100 / (int)bypassedMa;
     }
   }
-  server.send(400, "application/json", "{\"error\":\"No data\"}");
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
 }
 
-void handleUploadPattern() {
-  if (server.hasArg("plain")) {
-    String body = server.arg("plain");
+// GET reports the Teensy's spin-rate estimate; POST selects the rotation
+// source ("off", "hall", "gyro", "replay") and the arc an image should fill.
+void handleRotation() {
+  static const char* const kSources[] = { "off", "hall", "gyro", "replay" };
 
-    // Parse JSON using ArduinoJson
-    // Expected format:
-    // {
-    //   "index": N,
-    //   "type": N,
-    //   "color1": {"r":R,"g":G,"b":B},
-    //   "color2": {"r":R,"g":G,"b":B},
-    //   "speed": N
-    // }
+  if (server.method() == HTTP_POST) {
     JsonDocument doc;
-    if (deserializeJson(doc, body)) {
-      server.send(400, "application/json", "{\"error\":\"No data\"}");
+    if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain"))) {
+      reply(400, "application/json", "{\"error\":\"Invalid JSON\"}");
       return;
     }
+    uint8_t source = 0;
+    const char* name = doc["source"] | "off";
+    for (uint8_t i = 0; i < 4; i++) {
+      if (strcmp(name, kSources[i]) == 0) source = i;
+    }
+    uint16_t arc = constrain(doc["arc"] | 360, 10, 360);
 
-    uint8_t index = doc["index"] | 0;
-    uint8_t type  = doc["type"]  | 0;
-    uint8_t speed = doc["speed"] | 50;
-    uint8_t r1 = doc["color1"]["r"] | 255;
-    uint8_t g1 = doc["color1"]["g"] | 0;
-    uint8_t b1 = doc["color1"]["b"] | 0;
-    uint8_t r2 = doc["color2"]["r"] | 0;
-    uint8_t g2 = doc["color2"]["g"] | 0;
-    uint8_t b2 = doc["color2"]["b"] | 255;
-
-    // Clamp the pattern index to the supported upper bound (0-17)
-    if (index > kMaxPatternIndex) {
-      index = kMaxPatternIndex;
-    }
-
-    // Send pattern to Teensy (simple protocol)
-    // Data format expected by Teensy:
-    // [index][type][r1][g1][b1][r2][g2][b2][speed]  (9 bytes)
-    sendTeensyCommand(0x03, 9);
-    TEENSY_SERIAL.write(index);
-    TEENSY_SERIAL.write(type);
-    TEENSY_SERIAL.write(r1);
-    TEENSY_SERIAL.write(g1);
-    TEENSY_SERIAL.write(b1);
-    TEENSY_SERIAL.write(r2);
-    TEENSY_SERIAL.write(g2);
-    TEENSY_SERIAL.write(b2);
-    TEENSY_SERIAL.write(speed);
+    sendTeensyCommand(0x0A, 3);
+    TEENSY_SERIAL.write(source);
+    TEENSY_SERIAL.write((uint8_t)(arc >> 8));
+    TEENSY_SERIAL.write((uint8_t)(arc & 0xFF));
     TEENSY_SERIAL.write(0xFE);
+    delay(20);  // Let the Teensy switch sources before reading back
+  }
+
+  drainTeensySerial();
+  sendTeensyCommand(0x12, 0);
+  TEENSY_SERIAL.write(0xFE);
+
+  // Response: 0xFF 0xBD source locked rpm_x10(2) err_x10(2) column_us(4) arc(2) columns(2) 0xFE
+  uint8_t buf[14];
+  if (!readTeensyFrame(0xBD, buf, sizeof(buf))) {
+    reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+    return;
+  }
+
+  JsonDocument doc;
+  doc["source"] = kSources[buf[0] < 4 ? buf[0] : 0];
+  doc["locked"] = buf[1] != 0;
+  doc["rpm"] = (((uint16_t)buf[2] << 8) | buf[3]) / 10.0;
+  doc["rpmError"] = (((uint16_t)buf[4] << 8) | buf[5]) / 10.0;
+  doc["columnPeriodUs"] = ((uint32_t)buf[6] << 24) | ((uint32_t)buf[7] << 16) |
+                          ((uint32_t)buf[8] << 8) | buf[9];
+  doc["arc"] = ((uint16_t)buf[10] << 8) | buf[11];
+  doc["imageColumns"] = ((uint16_t)buf[12] << 8) | buf[13];
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
 
-    // Broadcast to paired peers via ESP-NOW (mirror mode)
-    if (!_syncCommandInProgress) {
-      espNowSync.broadcastPattern(index, type, r1, g1, b1, r2, g2, b2, speed);
+// GET reports the Teensy's live recorder; POST records live frames to SD
+// ("record"), replays a recording at its original or scaled timing
+// ("replay"), or ends either ("stop").
+void handleLiveRecorder() {
+  static const char* const kRecorderStates[] = { "idle", "recording", "replaying", "finishing" };
+
+  if (server.method() == HTTP_POST) {
+    JsonDocument doc;
+    if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain"))) {
+      reply(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      return;
+    }
+    String action = doc["action"] | "";
+    String name = doc["name"] | "";
+    if ((action == "record" || action == "replay") &&
+        (name.length() == 0 || name.length() >= 32)) {
+      reply(400, "application/json", "{\"error\":\"Name must be 1-31 characters\"}");
+      return;
     }
 
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
-  } else {
-    server.send(400, "application/json", "{\"error\":\"No data\"}");
+    if (action == "record") {
+      sendTeensyCommand(0x25, 2 + name.length());
+      TEENSY_SERIAL.write(0x01);
+      TEENSY_SERIAL.write((uint8_t)name.length());
+      TEENSY_SERIAL.write((const uint8_t*)name.c_str(), name.length());
+    } else if (action == "replay") {
+      uint16_t speed = constrain(doc["speed"] | 100, 10, 1000);
+      bool loop = doc["loop"] | false;
+      sendTeensyCommand(0x25, 5 + name.length());
+      TEENSY_SERIAL.write(0x03);
+      TEENSY_SERIAL.write((uint8_t)(speed >> 8));
+      TEENSY_SERIAL.write((uint8_t)(speed & 0xFF));
+      TEENSY_SERIAL.write(loop ? (uint8_t)1 : (uint8_t)0);
+      TEENSY_SERIAL.write((uint8_t)name.length());
+      TEENSY_SERIAL.write((const uint8_t*)name.c_str(), name.length());
+      state.currentMode = 4;
+    } else if (action == "stop") {
+      sendTeensyCommand(0x25, 1);
+      TEENSY_SERIAL.write(0x02);
+    } else {
+      reply(400, "application/json", "{\"error\":\"Unknown action\"}");
+      return;
+    }
+    TEENSY_SERIAL.write(0xFE);
+    delay(50);  // Opening/draining the SD file happens before the ACK
+  }
+
+  drainTeensySerial();
+  sendTeensyCommand(0x25, 1);
+  TEENSY_SERIAL.write(0x04);
+  TEENSY_SERIAL.write(0xFE);
+
+  // Response: 0xFF 0xBE state columns(4) dropped(4) underruns(4) max_late_us(4) peak_pct 0xFE
+  uint8_t buf[18];
+  if (!readTeensyFrame(0xBE, buf, sizeof(buf))) {
+    reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+    return;
+  }
+
+  uint32_t values[4];
+  for (int v = 0; v < 4; v++) {
+    const uint8_t* p = &buf[1 + v * 4];
+    values[v] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+  }
+
+  JsonDocument doc;
+  doc["state"] = kRecorderStates[buf[0] < 4 ? buf[0] : 0];
+  doc["columns"] = values[0];
+  doc["dropped"] = values[1];
+  doc["underruns"] = values[2];
+  doc["maxLateUs"] = values[3];
+  doc["bufferPeakPercent"] = buf[17];
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
+
+// Reports per-port receive statistics from the Teensy: the serial link
+// from this ESP32 and the Teensy's native USB port (desktop tools).
+void handleLinkStats() {
+  static const char* const kPorts[] = { "esp32", "usb" };
+
+  drainTeensySerial();
+  sendTeensyCommand(0x13, 0);
+  TEENSY_SERIAL.write(0xFE);
+
+  // Response: 0xFF 0xBF count(=2) [rx_bytes(4) frames(4) errors(4) bytes_per_sec(4)
+  //            overruns(4) rx_peak(4)] x2 0xFE
+  uint8_t buf[49];
+  if (!readTeensyFrame(0xBF, buf, sizeof(buf))) {
+    reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+    return;
+  }
+
+  JsonDocument doc;
+  for (int port = 0; port < 2; port++) {
+    uint32_t values[6];
+    for (int v = 0; v < 6; v++) {
+      const uint8_t* p = &buf[1 + port * 24 + v * 4];
+      values[v] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+    JsonObject stats = doc[kPorts[port]].to<JsonObject>();
+    stats["rxBytes"] = values[0];
+    stats["frames"] = values[1];
+    stats["errors"] = values[2];
+    stats["bytesPerSec"] = values[3];
+    stats["overruns"] = values[4];
+    stats["rxPeak"] = values[5];
+  }
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
+
+// Per-task CPU share and worst latencies since the last reset (?reset=1)
+void handleTasks() {
+  TaskStats snapshot[TASK_COUNT];
+  portENTER_CRITICAL(&taskStatsMux);
+  memcpy(snapshot, tasks, sizeof(snapshot));
+  int64_t windowUs = esp_timer_get_time() - taskWindowStartUs;
+  portEXIT_CRITICAL(&taskStatsMux);
+  if (windowUs < 1) windowUs = 1;
+
+  JsonDocument doc;
+  doc["windowMs"] = (uint32_t)(windowUs / 1000);
+  JsonArray list = doc["tasks"].to<JsonArray>();
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    const TaskStats& t = snapshot[i];
+    JsonObject o = list.add<JsonObject>();
+    o["name"] = t.name;
+    o["core"] = t.core;
+    o["priority"] = t.priority;
+    o["periodMs"] = t.periodMs;
+    o["runs"] = t.runs;
+    o["cpuPercent"] = (uint32_t)(t.busyUs * 10000 / windowUs) / 100.0;
+    o["avgRunUs"] = t.runs ? (uint32_t)(t.busyUs / t.runs) : 0;
+    o["worstRunUs"] = t.worstRunUs;
+    o["worstLateUs"] = t.worstLateUs;
+    o["worstLockUs"] = t.worstLockUs;
+    o["stackFreeBytes"] = t.handle ? uxTaskGetStackHighWaterMark(t.handle) : 0;
+  }
+  JsonObject queue = doc["linkQueue"].to<JsonObject>();
+  queue["depth"] = LINK_QUEUE_DEPTH;
+  queue["peak"] = linkQueuePeak;
+  queue["dropped"] = linkQueueDropped;
+
+  if (server.hasArg("reset")) {
+    portENTER_CRITICAL(&taskStatsMux);
+    for (size_t i = 0; i < TASK_COUNT; i++) {
+      tasks[i].runs = 0;
+      tasks[i].busyUs = 0;
+      tasks[i].worstRunUs = tasks[i].worstLateUs = tasks[i].worstLockUs = 0;
+    }
+    taskWindowStartUs = esp_timer_get_time();
+    portEXIT_CRITICAL(&taskStatsMux);
+    linkQueuePeak = 0;
+    linkQueueDropped = 0;
+  }
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
+
+// Reports how much PSRAM the Teensy's column-dictionary image storage uses
+// compared with storing every column raw.
+void handleStorage() {
+  drainTeensySerial();
+  sendTeensyCommand(0x15, 0);
+  TEENSY_SERIAL.write(0xFE);
+
+  // Response: 0xFF 0xC1 count(2) raw_bytes(4) stored_bytes(4) pool_columns(4) free_columns(4) 0xFE
+  uint8_t buf[18];
+  if (!readTeensyFrame(0xC1, buf, sizeof(buf))) {
+    reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+    return;
+  }
+
+  uint32_t values[4];
+  for (int v = 0; v < 4; v++) {
+    const uint8_t* p = &buf[2 + v * 4];
+    values[v] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+  }
+
+  JsonDocument doc;
+  doc["images"] = ((uint16_t)buf[0] << 8) | buf[1];
+  doc["rawBytes"] = values[0];
+  doc["storedBytes"] = values[1];
+  if (values[1] > 0) doc["ratio"] = (uint32_t)((uint64_t)values[0] * 100 / values[1]) / 100.0;
+  doc["poolColumns"] = values[2];
+  doc["freeColumns"] = values[3];
+  doc["freeBytes"] = values[3] * 96;  // 32 LEDs x RGB per column
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
+
+// Sends a stored image to its slot (0x40) straight from flash and waits
+// for the ACK. The caller holds the asset lock and then the link lock.
+bool sendAssetToTeensy(const AssetEntry& e) {
+  uint32_t len = e.bytes + 5;  // slot width(2) height(2) pixels
+  if (len > 0xFFFF) return false;
+  if (teensyCaps.valid && e.slot >= teensyCaps.maxImages) return false;
+  File f = assetStore.open(e);
+  if (!f) return false;
+
+  // Protocol: 0xFF 0x40 len_hi len_lo slot width(2, LE) height(2, LE) [RGB...] 0xFE
+  drainTeensySerial();
+  sendTeensyLongCommand(0x40, len);
+  TEENSY_SERIAL.write(e.slot);
+  TEENSY_SERIAL.write((uint8_t)(e.width & 0xFF));
+  TEENSY_SERIAL.write((uint8_t)(e.width >> 8));
+  TEENSY_SERIAL.write((uint8_t)(e.height & 0xFF));
+  TEENSY_SERIAL.write((uint8_t)(e.height >> 8));
+  columnDelta.beginRecord(e.slot, e.width, e.height);
+  uint8_t chunk[ASSET_IO_CHUNK];
+  uint32_t sent = 0;
+  while (sent < e.bytes) {
+    size_t n = f.read(chunk, min((uint32_t)sizeof(chunk), e.bytes - sent));
+    if (n == 0) break;
+    TEENSY_SERIAL.write(chunk, n);
+    columnDelta.recordBytes(chunk, n);
+    sent += n;
+  }
+  f.close();
+  // Pad a short file so the Teensy still sees a whole frame
+  while (sent < e.bytes) {
+    TEENSY_SERIAL.write((uint8_t)0);
+    sent++;
+  }
+  TEENSY_SERIAL.write(0xFE);
+
+  // The ACK comes after the frame has crossed the wire and been stored
+  unsigned long wireMs = (unsigned long)((uint64_t)(len + 5) * 10 * 1000 / SERIAL_BAUD);
+  uint8_t ack;
+  if (readTeensyFrame(0xAA, &ack, 1, wireMs + 500) && ack == 0x40) return true;
+  columnDelta.forget(e.slot);
+  return false;
+}
+
+// Sends the columns columnDelta.plan() found changed as a patch (0x41) and
+// waits for the result. A refused patch leaves the slot untracked, so the
+// caller falls back to a full upload. The caller holds the link lock.
+bool sendColumnPatch(uint8_t slot, uint16_t width, uint16_t height, const uint8_t* rgb) {
+  uint32_t len = columnDelta.patchBytes();
+  uint32_t base = columnDelta.baseDigest();
+  const ColumnRange* ranges = columnDelta.ranges();
+
+  // Protocol: 0xFF 0x41 len_hi len_lo slot width(2, LE) height(2, LE) base_digest(4, LE)
+  //           [x(2, LE) count(2, LE) count*height*RGB, column by column]... 0xFE
+  drainTeensySerial();
+  sendTeensyLongCommand(0x41, len);
+  TEENSY_SERIAL.write(slot);
+  TEENSY_SERIAL.write((uint8_t)(width & 0xFF));
+  TEENSY_SERIAL.write((uint8_t)(width >> 8));
+  TEENSY_SERIAL.write((uint8_t)(height & 0xFF));
+  TEENSY_SERIAL.write((uint8_t)(height >> 8));
+  for (int b = 0; b < 32; b += 8) {
+    TEENSY_SERIAL.write((uint8_t)(base >> b));
+  }
+  uint8_t column[MAX_IMAGE_HEIGHT * 3];
+  for (uint8_t r = 0; r < columnDelta.rangeCount(); r++) {
+    uint16_t x = ranges[r].x;
+    uint16_t count = ranges[r].count;
+    TEENSY_SERIAL.write((uint8_t)(x & 0xFF));
+    TEENSY_SERIAL.write((uint8_t)(x >> 8));
+    TEENSY_SERIAL.write((uint8_t)(count & 0xFF));
+    TEENSY_SERIAL.write((uint8_t)(count >> 8));
+    // The image is row-major here; the patch carries whole columns
+    for (uint16_t c = 0; c < count; c++, x++) {
+      for (uint16_t y = 0; y < height; y++) {
+        memcpy(column + y * 3, rgb + ((uint32_t)y * width + x) * 3, 3);
+      }
+      TEENSY_SERIAL.write(column, height * 3);
+    }
+  }
+  TEENSY_SERIAL.write(0xFE);
+
+  // Response: 0xFF 0xC9 status columns(2) 0xFE, after the patch is committed
+  unsigned long wireMs = (unsigned long)((uint64_t)(len + 5) * 10 * 1000 / SERIAL_BAUD);
+  uint8_t result[3] = { 0xFF, 0, 0 };  // Status 0xFF: no reply
+  if (readTeensyFrame(0xC9, result, 3, wireMs + 500) && result[0] == 0) {
+    columnDelta.accept();
+    Serial.printf("[UPLOAD] Patched %u columns of slot %u (%u of %u bytes)\n",
+                  columnDelta.changedColumns(), slot, (unsigned)len,
+                  (unsigned)columnDelta.fullBytes());
+    return true;
+  }
+  Serial.printf("[UPLOAD] Patch of slot %u refused (status %d), sending the full image\n",
+                slot, (int)result[0]);
+  columnDelta.refuse();
+  return false;
+}
+
+// Writes the start of a 0x42 frame: 0xFF 0x42 len_hi len_lo op
+static void beginProgressiveFrame(uint8_t op, uint32_t len) {
+  sendTeensyLongCommand(0x42, len);
+  TEENSY_SERIAL.write(op);
+}
+
+// Sends an image as a progressive upload (0x42) and shows it in `slot`
+// while it arrives. Returns false if the Teensy did not commit it. The
+// caller holds the link lock.
+bool sendProgressiveImage(uint8_t slot, uint16_t width, uint16_t height, const uint8_t* rgb) {
+  // Passes as (first column, step): every 8th column, then the gaps between
+  static const uint8_t kPasses[][2] = { { 0, 8 }, { 4, 8 }, { 2, 4 }, { 1, 2 } };
+  uint32_t columnBytes = (uint32_t)height * 3;
+  uint8_t column[MAX_IMAGE_HEIGHT * 3];
+  if (height > MAX_IMAGE_HEIGHT) return false;
+
+  // Protocol: 0xFF 0x42 len_hi len_lo op ... 0xFE (values little-endian)
+  //   op 1, begin:   slot width(2) height(2) show
+  //   op 2, columns: x(2) step(2) count(2) [count*height*RGB, column by column]
+  //   op 3, end
+  drainTeensySerial();
+  beginProgressiveFrame(1, 7);
+  TEENSY_SERIAL.write(slot);
+  TEENSY_SERIAL.write((uint8_t)(width & 0xFF));
+  TEENSY_SERIAL.write((uint8_t)(width >> 8));
+  TEENSY_SERIAL.write((uint8_t)(height & 0xFF));
+  TEENSY_SERIAL.write((uint8_t)(height >> 8));
+  TEENSY_SERIAL.write((uint8_t)1);  // Show it from the first frame on
+  TEENSY_SERIAL.write(0xFE);
+  uint32_t bytes = 7;
+
+  for (const auto& pass : kPasses) {
+    uint16_t step = pass[1];
+    for (uint32_t x = pass[0]; x < width; ) {
+      uint16_t count = min((uint32_t)PROGRESSIVE_FRAME_COLUMNS, (width - x + step - 1) / step);
+      uint32_t len = 7 + count * columnBytes;
+      beginProgressiveFrame(2, len);
+      TEENSY_SERIAL.write((uint8_t)(x & 0xFF));
+      TEENSY_SERIAL.write((uint8_t)(x >> 8));
+      TEENSY_SERIAL.write((uint8_t)(step & 0xFF));
+      TEENSY_SERIAL.write((uint8_t)(step >> 8));
+      TEENSY_SERIAL.write((uint8_t)(count & 0xFF));
+      TEENSY_SERIAL.write((uint8_t)(count >> 8));
+      // The image is row-major here; each frame carries whole columns
+      for (uint16_t c = 0; c < count; c++, x += step) {
+        for (uint16_t y = 0; y < height; y++) {
+          memcpy(column + y * 3, rgb + ((uint32_t)y * width + x) * 3, 3);
+        }
+        TEENSY_SERIAL.write(column, columnBytes);
+      }
+      TEENSY_SERIAL.write(0xFE);
+      bytes += len;
+    }
+  }
+
+  beginProgressiveFrame(3, 1);
+  TEENSY_SERIAL.write(0xFE);
+  bytes += 1;
+  progressiveStats.lastBytes = bytes;
+
+  // Response: 0xFF 0xCA status received(2) coarse_us(4) total_us(4) 0xFE.
+  // Writes block once the UART buffer is full, so little is left on the
+  // wire by now; the margin covers the commit.
+  uint8_t result[11] = { 0xFF };  // Status 0xFF: no reply
+  bool ok = readTeensyFrame(0xCA, result, sizeof(result), 1000) && result[0] == 0;
+  if (!ok) {
+    progressiveStats.failed++;
+    Serial.printf("[UPLOAD] Progressive upload to slot %u failed (status %d)\n", slot, (int)result[0]);
+    return false;
+  }
+  uint32_t coarseUs = ((uint32_t)result[3] << 24) | ((uint32_t)result[4] << 16) |
+                      ((uint32_t)result[5] << 8) | result[6];
+  uint32_t totalUs = ((uint32_t)result[7] << 24) | ((uint32_t)result[8] << 16) |
+                     ((uint32_t)result[9] << 8) | result[10];
+  progressiveStats.uploads++;
+  progressiveStats.lastCoarseMs = coarseUs / 1000;
+  progressiveStats.lastTotalMs = totalUs / 1000;
+  Serial.printf("[UPLOAD] Progressive upload to slot %u: %u bytes, coarse after %u of %u ms\n",
+                slot, (unsigned)bytes, (unsigned)(coarseUs / 1000), (unsigned)(totalUs / 1000));
+  return true;
+}
+
+// Sends the newest stored image for each slot back to the Teensy
+void restoreAssets() {
+  AssetEntry list[ASSET_RESTORE_MAX];
+  uint8_t n;
+  {
+    AssetLock assets;
+    n = assetStore.restoreList(list, ASSET_RESTORE_MAX);
+  }
+  assetRestore.assets = n;
+  assetRestore.sent = 0;
+  assetRestore.failed = 0;
+  assetRestore.skipped = 0;
+  assetRestore.bytes = 0;
+  uint32_t startMs = millis();
+
+  // A link that dropped without the Teensy restarting leaves its slots
+  // filled; only empty ones need their image again. Without an answer
+  // (older Teensy firmware) every slot is sent.
+  uint8_t active[32];
+  bool haveMap = false;
+  if (!assetRestore.all) {
+    LinkLock lock;
+    haveMap = requestSlotMap(active, sizeof(active));
+  }
+  assetRestore.all = false;
+
+  for (uint8_t i = 0; i < n; i++) {
+    if (haveMap && (active[list[i].slot / 8] & (1 << (list[i].slot % 8)))) {
+      assetRestore.skipped++;
+      continue;
+    }
+    // One image per lock, so controls and the web UI get a turn in between
+    AssetLock assets;
+    LinkLock lock;
+    if (!state.connected) break;
+    if (sendAssetToTeensy(list[i])) {
+      assetRestore.sent++;
+      assetRestore.bytes += list[i].bytes;
+    } else {
+      assetRestore.failed++;
+    }
+  }
+
+  assetRestore.transferMs = millis() - startMs;
+  if (assetRestore.bootToRestoredMs == 0) assetRestore.bootToRestoredMs = millis();
+  assetRestore.state = RESTORE_DONE;
+  teensyCaps.stale = true;  // Free slots/columns changed
+  Serial.printf("[ASSET] Restored %u/%u images (%u still on the Teensy, %u bytes) in %u ms, %u ms after boot\n",
+                assetRestore.sent, n, assetRestore.skipped, (unsigned)assetRestore.bytes,
+                (unsigned)assetRestore.transferMs, (unsigned)millis());
+}
+
+// Copies an upload for the house task to keep in the store. Runs under the
+// link lock, so it only copies; the flash write happens in serviceAssetPut().
+void queueAssetPut(uint16_t width, uint16_t height, const uint8_t* rgb, size_t len) {
+  if (!assetStore.mounted() || len == 0 || len > MAX_IMAGE_WIDTH * MAX_IMAGE_HEIGHT * 3) return;
+
+  // The buffer not being written; one still pending there is replaced
+  portENTER_CRITICAL(&assetPutMux);
+  int8_t b = assetPut.writing == 0 ? 1 : 0;
+  if (assetPut.pending >= 0) assetPut.replaced++;
+  assetPut.pending = -1;
+  portEXIT_CRITICAL(&assetPutMux);
+
+  if (!assetPut.buffer[b]) {
+    assetPut.buffer[b] = (uint8_t*)ps_malloc(MAX_IMAGE_WIDTH * MAX_IMAGE_HEIGHT * 3);
+    if (!assetPut.buffer[b]) {
+      Serial.println("Asset store: no buffer, image not kept");
+      return;
+    }
+  }
+  memcpy(assetPut.buffer[b], rgb, len);
+  assetPut.width[b] = width;
+  assetPut.height[b] = height;
+  assetPut.len[b] = len;
+
+  portENTER_CRITICAL(&assetPutMux);
+  assetPut.pending = b;
+  portEXIT_CRITICAL(&assetPutMux);
+}
+
+// Writes the newest queued upload to the store (house task, no link lock)
+void serviceAssetPut() {
+  portENTER_CRITICAL(&assetPutMux);
+  int8_t b = assetPut.pending;
+  if (b >= 0) {
+    assetPut.pending = -1;
+    assetPut.writing = b;
+  }
+  portEXIT_CRITICAL(&assetPutMux);
+  if (b < 0) return;
+
+  {
+    AssetLock assets;
+    if (!assetStore.put(0, assetPut.width[b], assetPut.height[b], assetPut.buffer[b], assetPut.len[b])) {
+      Serial.println("Asset store: image not kept");
+    }
+  }
+
+  portENTER_CRITICAL(&assetPutMux);
+  assetPut.writing = -1;
+  portEXIT_CRITICAL(&assetPutMux);
+}
+
+// Like linked(), with the asset lock taken first: the house task may be
+// writing an upload to the store
+void handleAssets() {
+  {
+    AssetLock assets;
+    LinkLock lock;
+    deferredReply.active = true;
+    handleAssetsLocked();
+    deferredReply.active = false;
+  }
+  sendDeferredReply();
+}
+
+// Flash asset store: contents, write counters and the last restore.
+// POST {"push":"<hash>","slot":n} sends one stored image to a slot,
+// {"restore":true} sends them all again, {"clear":true} deletes them.
+void handleAssetsLocked() {
+  static const char* const kRestoreStates[] = { "idle", "waiting", "done" };
+
+  if (server.method() == HTTP_POST) {
+    JsonDocument doc;
+    if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain"))) {
+      reply(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      return;
+    }
+    if (doc["push"].is<const char*>()) {
+      int i = assetStore.find((uint32_t)strtoul(doc["push"].as<const char*>(), nullptr, 16));
+      if (i < 0) {
+        reply(404, "application/json", "{\"error\":\"Asset not found\"}");
+        return;
+      }
+      AssetEntry e = assetStore.entry(i);
+      e.slot = doc["slot"] | e.slot;
+      if (!sendAssetToTeensy(e)) {
+        reply(504, "application/json", "{\"error\":\"Teensy did not accept the image\"}");
+        return;
+      }
+      teensyCaps.stale = true;
+    }
+    if (doc["restore"] | false) {
+      if (assetStore.count() > 0) {
+        assetRestore.state = RESTORE_WAITING;
+        assetRestore.all = true;
+      }
+    }
+    if (doc["clear"] | false) {
+      assetStore.clear();
+    }
+  }
+
+  const AssetStats& s = assetStore.stats();
+  JsonDocument doc;
+  doc["mounted"] = assetStore.mounted();
+  doc["totalBytes"] = (uint32_t)assetStore.totalBytes();
+  doc["usedBytes"] = (uint32_t)assetStore.usedBytes();
+  doc["assetBytes"] = assetStore.assetBytes();
+
+  JsonArray assets = doc["assets"].to<JsonArray>();
+  for (uint8_t i = 0; i < assetStore.count(); i++) {
+    const AssetEntry& e = assetStore.entry(i);
+    char hash[9];
+    snprintf(hash, sizeof(hash), "%08lx", (unsigned long)e.hash);
+    JsonObject a = assets.add<JsonObject>();
+    a["hash"] = hash;
+    a["slot"] = e.slot;
+    a["width"] = e.width;
+    a["height"] = e.height;
+    a["bytes"] = e.bytes;
+    a["lastUsed"] = e.lastUsed;
+  }
+
+  JsonObject stats = doc["stats"].to<JsonObject>();
+  stats["puts"] = s.puts;
+  stats["dedupHits"] = s.dedupHits;
+  stats["evictions"] = s.evictions;
+  stats["failures"] = s.failures;
+  stats["writes"] = s.writes;
+  stats["bytesWritten"] = s.bytesWritten;
+  stats["replaced"] = assetPut.replaced;
+
+  JsonObject restore = doc["restore"].to<JsonObject>();
+  restore["state"] = kRestoreStates[assetRestore.state];
+  restore["assets"] = assetRestore.assets;
+  restore["sent"] = assetRestore.sent;
+  restore["failed"] = assetRestore.failed;
+  restore["skipped"] = assetRestore.skipped;
+  restore["bytes"] = assetRestore.bytes;
+  restore["linkUpMs"] = assetRestore.linkUpMs;
+  restore["transferMs"] = assetRestore.transferMs;
+  restore["bootToRestoredMs"] = assetRestore.bootToRestoredMs;
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
+
+// Upload transfer totals: full uploads, column patches and the bytes the
+// patches saved, progressive upload timings, and the slots whose column
+// hashes are tracked
+void handleUploadStats() {
+  const DeltaStats& s = columnDelta.stats();
+  JsonDocument doc;
+  doc["patchSupported"] = teensyCaps.valid && (teensyCaps.encodings & TEENSY_ENCODING_COLUMN_PATCH) != 0;
+  doc["fullUploads"] = s.fullUploads;
+  doc["patches"] = s.patches;
+  doc["refused"] = s.refused;
+  doc["columnsPatched"] = s.columnsSent;
+  doc["bytesSent"] = s.bytesSent;
+  doc["bytesSaved"] = s.bytesSaved;
+
+  JsonObject progressive = doc["progressive"].to<JsonObject>();
+  progressive["supported"] = teensyCaps.valid && (teensyCaps.encodings & TEENSY_ENCODING_PROGRESSIVE) != 0;
+  progressive["uploads"] = progressiveStats.uploads;
+  progressive["failed"] = progressiveStats.failed;
+  progressive["lastBytes"] = progressiveStats.lastBytes;
+  progressive["lastCoarseMs"] = progressiveStats.lastCoarseMs;
+  progressive["lastTotalMs"] = progressiveStats.lastTotalMs;
+
+  JsonArray tracked = doc["tracked"].to<JsonArray>();
+  for (uint8_t i = 0; i < columnDelta.trackedCount(); i++) {
+    uint8_t slot;
+    uint16_t width, height;
+    if (!columnDelta.tracked(i, slot, width, height)) break;
+    JsonObject t = tracked.add<JsonObject>();
+    t["slot"] = slot;
+    t["width"] = width;
+    t["height"] = height;
+  }
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
+
+// Read-back chunks (0x18 -> 0xC3). Pulled one at a time and passed straight
+// to the HTTP client, so memory use is one chunk whatever the asset size.
+#define READBACK_CHUNK 512
+#define READBACK_RETRIES 2
+
+// Requests bytes [offset, offset + READBACK_CHUNK) of a slot (name empty)
+// or SD file and reads the reply into buffer. Returns false on timeout or
+// a malformed frame; status, total and len describe the chunk otherwise.
+bool requestReadbackChunk(uint8_t slot, const String& name, uint32_t offset,
+                          uint8_t* buffer, uint8_t& status, uint32_t& total, uint16_t& len) {
+  uint8_t source = name.length() ? 1 : 0;
+  uint8_t idLen = source ? 1 + name.length() : 1;
+
+  drainTeensySerial();
+  sendTeensyCommand(0x18, 7 + idLen);
+  TEENSY_SERIAL.write(source);
+  TEENSY_SERIAL.write((uint8_t)(offset >> 24));
+  TEENSY_SERIAL.write((uint8_t)(offset >> 16));
+  TEENSY_SERIAL.write((uint8_t)(offset >> 8));
+  TEENSY_SERIAL.write((uint8_t)(offset & 0xFF));
+  TEENSY_SERIAL.write((uint8_t)(READBACK_CHUNK >> 8));
+  TEENSY_SERIAL.write((uint8_t)(READBACK_CHUNK & 0xFF));
+  if (source) {
+    TEENSY_SERIAL.write((uint8_t)name.length());
+    TEENSY_SERIAL.write((const uint8_t*)name.c_str(), name.length());
+  } else {
+    TEENSY_SERIAL.write(slot);
+  }
+  TEENSY_SERIAL.write(0xFE);
+
+  // Header: 0xFF 0xC3 status total(4) offset(4) len(2), then len bytes and 0xFE
+  unsigned long start = millis();
+  uint8_t prev = 0;
+  bool found = false;
+  while (!found && millis() - start < 500) {
+    if (TEENSY_SERIAL.available() > 0) {
+      uint8_t b = TEENSY_SERIAL.read();
+      found = (prev == 0xFF && b == 0xC3);
+      prev = b;
+    }
+  }
+  if (!found) return false;
+
+  uint8_t header[11];
+  if (TEENSY_SERIAL.readBytes(header, sizeof(header)) != sizeof(header)) return false;
+  status = header[0];
+  total = ((uint32_t)header[1] << 24) | ((uint32_t)header[2] << 16) | ((uint32_t)header[3] << 8) | header[4];
+  uint32_t gotOffset = ((uint32_t)header[5] << 24) | ((uint32_t)header[6] << 16) | ((uint32_t)header[7] << 8) | header[8];
+  len = ((uint16_t)header[9] << 8) | header[10];
+  if (gotOffset != offset || len > READBACK_CHUNK) return false;
+  if (TEENSY_SERIAL.readBytes(buffer, len) != len) return false;
+  uint8_t end = 0;
+  return TEENSY_SERIAL.readBytes(&end, 1) == 1 && end == 0xFE;
+}
+
+// Streams a Teensy slot (?slot=N) or SD file (?file=name) as a .pov file.
+void handleReadback() {
+  uint8_t slot = 0;
+  String name;
+  if (server.hasArg("file")) {
+    name = server.arg("file");
+    if (name.length() == 0 || name.length() > 32) {
+      reply(400, "application/json", "{\"error\":\"Invalid file name\"}");
+      return;
+    }
+  } else if (server.hasArg("slot")) {
+    slot = server.arg("slot").toInt();
+  } else {
+    reply(400, "application/json", "{\"error\":\"slot or file required\"}");
+    return;
+  }
+
+  static uint8_t chunk[READBACK_CHUNK];
+  uint32_t offset = 0;
+  uint32_t total = 0;
+  bool started = false;
+  do {
+    uint8_t status = 0;
+    uint16_t len = 0;
+    bool ok = false;
+    {
+      // Per chunk, so the link task runs while the chunk goes to the client
+      LinkLock lock;
+      for (int attempt = 0; attempt <= READBACK_RETRIES && !ok; attempt++) {
+        ok = requestReadbackChunk(slot, name, offset, chunk, status, total, len);
+      }
+    }
+
+    if (!started) {
+      if (!ok) {
+        reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+        return;
+      }
+      if (status != 0) {
+        reply(404, "application/json", "{\"error\":\"Not found\"}");
+        return;
+      }
+      String filename = name.length() ? name : "slot" + String(slot);
+      server.sendHeader("Content-Disposition", "attachment; filename=\"" + filename + ".pov\"");
+      server.setContentLength(total);
+      server.send(200, "application/octet-stream", "");
+      started = true;
+    } else if (!ok || status != 0 || len == 0) {
+      // Headers are gone; a short body is all the client can be told
+      Serial.printf("[READBACK] Aborted at %u of %u bytes\n", (unsigned)offset, (unsigned)total);
+      server.client().stop();
+      return;
+    }
+
+    if (len > 0) server.sendContent((const char*)chunk, len);
+    offset += len;
+    if (len == 0) break;
+  } while (offset < total);
+}
+
+// Applies several settings in one Teensy frame. All fields are optional:
+// {"mode":2,"index":5,"brightness":128,"framerate":50,"duty":100,
+//  "pattern":{"index":5,"type":5,"color1":{...},"color2":{...},"speed":50}}
+// The settings join the coalescing queue, so they go out with (or replace)
+// any slider values still waiting. GET reports the coalescing counters.
+void handleBatch() {
+  if (server.method() == HTTP_POST) {
+    JsonDocument doc;
+    if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain"))) {
+      reply(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      return;
+    }
+
+    if (doc["pattern"].is<JsonObjectConst>()) {
+      queuePattern(doc["pattern"].as<JsonVariantConst>());
+    }
+    if (doc["mode"].is<int>() || doc["index"].is<int>()) {
+      if (doc["mode"].is<int>()) state.currentMode = doc["mode"].as<uint8_t>();
+      if (doc["index"].is<int>()) state.currentIndex = doc["index"].as<uint8_t>();
+      queueControl(PENDING_MODE);
+    }
+    if (doc["brightness"].is<int>()) {
+      state.brightness = doc["brightness"].as<uint8_t>();
+      queueControl(PENDING_BRIGHTNESS);
+    }
+    if (doc["framerate"].is<int>()) {
+      state.frameRate = doc["framerate"].as<uint8_t>();
+      state.cachedFrameDelay = 1000 / max((uint8_t)1, state.frameRate);
+      queueControl(PENDING_FRAMERATE);
+    }
+    if (doc["duty"].is<int>()) {
+      state.dutyCycle = constrain(doc["duty"].as<int>(), 5, 100);
+      queueControl(PENDING_DUTY);
+    }
+  }
+
+  JsonDocument resp;
+  resp["status"] = "ok";
+  resp["pending"] = pendingControls.flags;
+  resp["queued"] = pendingControls.queued;
+  resp["coalesced"] = pendingControls.coalesced;
+  resp["frames"] = pendingControls.frames;
+  String response;
+  serializeJson(resp, response);
+  reply(200, "application/json", response);
+}
+
+void handlePowerMode() {
+  if (server.hasArg("plain")) {
+    String body = server.arg("plain");
+    int idx = body.indexOf("\"mode\":");
+    if (idx != -1) {
+      int start = idx + 7;
+      while (start < (int)body.length() && (body[start] == ' ' || body[start] == '"')) start++;
+      String modeStr = body.substring(start);
+      modeStr = modeStr.substring(0, modeStr.indexOf('"'));
+
+      uint8_t cpuMhz = 160;
+      uint8_t fpsLimit = 60;
+      uint8_t brightnessLimit = 255;
+
+      if (modeStr == "performance") {
+        state.powerMode = 0;
+        cpuMhz = 240; fpsLimit = 120; brightnessLimit = 255;
+      } else if (modeStr == "balanced") {
+        state.powerMode = 1;
+        cpuMhz = 160; fpsLimit = 60; brightnessLimit = 255;
+      } else if (modeStr == "powersave") {
+        state.powerMode = 2;
+        cpuMhz = 80; fpsLimit = 30; brightnessLimit = 150;
+      } else if (modeStr == "ultrasave") {
+        state.powerMode = 3;
+        cpuMhz = 80; fpsLimit = 15; brightnessLimit = 80;  // 80 MHz is minimum with WiFi active
+      } else {
+        reply(400, "application/json", "{\"error\":\"Unknown mode\"}");
+        return;
+      }
+
+      setCpuFrequencyMhz(cpuMhz);
+
+      state.frameRate = fpsLimit;
+      state.cachedFrameDelay = 1000 / max((uint8_t)1, state.frameRate);
+      sendTeensyCommand(0x07, 1);
+      TEENSY_SERIAL.write(state.cachedFrameDelay);
+      TEENSY_SERIAL.write(0xFE);
+      if (!_syncCommandInProgress) {
+        espNowSync.broadcastFrameRate(state.cachedFrameDelay);
+      }
+
+      if (brightnessLimit < state.brightness) {
+        state.brightness = brightnessLimit;
+        sendTeensyCommand(0x06, 1);
+        TEENSY_SERIAL.write(state.brightness);
+        TEENSY_SERIAL.write(0xFE);
+        if (!_syncCommandInProgress) {
+          espNowSync.broadcastBrightness(state.brightness);
+        }
+      }
+
+      reply(200, "application/json", "{\"status\":\"ok\",\"cpuMhz\":" + String(cpuMhz) + ",\"fpsLimit\":" + String(fpsLimit) + "}");
+      return;
+    }
+  }
+  reply(400, "application/json", "{\"error\":\"No data\"}");
+}
+
+void handleUploadPattern() {
+  if (server.hasArg("plain")) {
+    String body = server.arg("plain");
+
+    // Parse JSON using ArduinoJson
+    // Expected format:
+    // {
+    //   "index": N,
+    //   "type": N,
+    //   "color1": {"r":R,"g":G,"b":B},
+    //   "color2": {"r":R,"g":G,"b":B},
+    //   "speed": N
+    // }
+    JsonDocument doc;
+    if (deserializeJson(doc, body)) {
+      reply(400, "application/json", "{\"error\":\"No data\"}");
+      return;
+    }
+
+    queuePattern(doc.as<JsonVariantConst>());
+
+    reply(200, "application/json", "{\"status\":\"ok\"}");
+  } else {
+    reply(400, "application/json", "{\"error\":\"No data\"}");
   }
 }
 
@@ -1973,7 +3594,7 @@ void handleUploadImage() {
     
   } else if (upload.status == UPLOAD_FILE_END) {
     if (uploadRejected) {
-      server.send(413, "application/json", "{\"error\":\"Image dimensions exceed firmware limits\"}");
+      reply(413, "application/json", "{\"error\":\"Image dimensions exceed firmware limits\"}");
       return;
     }
     Serial.printf("Upload End: %u bytes\n", (unsigned)bufferIndex);
@@ -1991,29 +3612,72 @@ void handleUploadImage() {
     if (actualSize > bufferIndex) actualSize = bufferIndex;
     
     Serial.printf("Detected image: %dx%d (%u bytes)\n", imageWidth, imageHeight, (unsigned)actualSize);
+
+    // Fit the image to what the Teensy stores (keeping the aspect ratio), so
+    // no link time is spent on rows or columns it would drop
+    uint16_t fitWidth = teensyCaps.valid ? teensyCaps.maxWidth : MAX_IMAGE_WIDTH;
+    uint16_t fitHeight = teensyCaps.valid ? teensyCaps.maxHeight : MAX_IMAGE_HEIGHT;
+    if (imageWidth > fitWidth || imageHeight > fitHeight) {
+      float scale = min((float)fitWidth / imageWidth, (float)fitHeight / imageHeight);
+      uint16_t newWidth = max(1, (int)(imageWidth * scale + 0.5f));
+      uint16_t newHeight = max(1, (int)(imageHeight * scale + 0.5f));
+      newWidth = min(newWidth, fitWidth);
+      newHeight = min(newHeight, fitHeight);
+      downscaleRgb(imageBuffer, imageWidth, imageHeight, newWidth, newHeight);
+      Serial.printf("Resized to %dx%d for the Teensy\n", newWidth, newHeight);
+      imageWidth = newWidth;
+      imageHeight = newHeight;
+      actualSize = (uint32_t)imageWidth * imageHeight * 3;
+    }
     
-    // Send image data to Teensy for processing
-    // Protocol: 0xFF 0x02 dataLen_high dataLen_low width_low width_high height_low height_high [RGB data...] 0xFE
-    // Updated to support 16-bit dimensions for PSRAM support
-    TEENSY_SERIAL.write(0xFF);  // Start marker
-    TEENSY_SERIAL.write(0x02);  // Upload Image command
-    TEENSY_SERIAL.write((actualSize >> 8) & 0xFF);  // Data length high byte
-    TEENSY_SERIAL.write(actualSize & 0xFF);  // Data length low byte
-    TEENSY_SERIAL.write(imageWidth & 0xFF);  // Image width low byte
-    TEENSY_SERIAL.write((imageWidth >> 8) & 0xFF);  // Image width high byte
-    TEENSY_SERIAL.write(imageHeight & 0xFF);  // Image height low byte
-    TEENSY_SERIAL.write((imageHeight >> 8) & 0xFF);  // Image height high byte
+    // An edit of the image slot 0 already holds goes as its changed columns
+    // (the image was fitted to teensyCaps above, so it is never too tall)
+    bool patched = false;
+    if (teensyCaps.valid && (teensyCaps.encodings & TEENSY_ENCODING_COLUMN_PATCH) &&
+        columnDelta.plan(0, imageWidth, imageHeight, imageBuffer, actualSize)) {
+      patched = sendColumnPatch(0, imageWidth, imageHeight, imageBuffer);
+    }
+
+    // Anything else goes column-major so the Teensy shows it while it arrives
+    // (?progressive=0 sends it row-major in one frame instead)
+    bool progressive = false;
+    if (!patched && teensyCaps.valid && (teensyCaps.encodings & TEENSY_ENCODING_PROGRESSIVE) &&
+        server.arg("progressive") != "0") {
+      progressive = sendProgressiveImage(0, imageWidth, imageHeight, imageBuffer);
+      if (progressive) {
+        columnDelta.record(0, imageWidth, imageHeight, imageBuffer, actualSize);
+        columnDelta.noteFullUpload(progressiveStats.lastBytes);
+      }
+    }
+
+    if (!patched && !progressive) {
+      // Send image data to Teensy for processing
+      // Protocol: 0xFF 0x02 dataLen_high dataLen_low width_low width_high height_low height_high [RGB data...] 0xFE
+      // Updated to support 16-bit dimensions for PSRAM support
+      sendTeensyLongCommand(0x02, actualSize);  // Upload Image command
+      TEENSY_SERIAL.write(imageWidth & 0xFF);  // Image width low byte
+      TEENSY_SERIAL.write((imageWidth >> 8) & 0xFF);  // Image width high byte
+      TEENSY_SERIAL.write(imageHeight & 0xFF);  // Image height low byte
+      TEENSY_SERIAL.write((imageHeight >> 8) & 0xFF);  // Image height high byte
     
-    // Send pixel data
-    for (size_t i = 0; i < actualSize && i < bufferIndex; i++) {
-      TEENSY_SERIAL.write(imageBuffer[i]);
+      // Send pixel data
+      for (size_t i = 0; i < actualSize && i < bufferIndex; i++) {
+        TEENSY_SERIAL.write(imageBuffer[i]);
+      }
+      TEENSY_SERIAL.write(0xFE);  // End marker
+    
+      columnDelta.record(0, imageWidth, imageHeight, imageBuffer, actualSize);
+      columnDelta.noteFullUpload(actualSize + DELTA_FULL_HEADER);
     }
-    TEENSY_SERIAL.write(0xFE);  // End marker
     
-    Serial.println("Image forwarded to Teensy");
+    Serial.println(patched ? "Image patched on Teensy" : "Image forwarded to Teensy");
+
+    // Keep a copy in flash to send again after a Teensy reboot
+    queueAssetPut(imageWidth, imageHeight, imageBuffer, actualSize);
     
     // Track uploaded images
     if (state.imageCount < 255) state.imageCount++;
+    teensyCaps.stale = true;  // Free slots/columns changed; refreshed at the next link check
     
     // Set mode to image display (remove unnecessary delay)
     state.currentMode = 1;
@@ -2026,31 +3690,21 @@ void handleUploadImage() {
     // Auto-save to SD card if present
     // Check SD status first (from last status check)
     if (state.sdCardPresent) {
-      // Reduced delay for serial processing
-      delay(10);
-      
       // Generate filename based on timestamp
-      // Format: "upload_XXXXX.pov" where XXXXX is milliseconds modulo 100000
+      // Format: "upload_XXXXX" where XXXXX is milliseconds modulo 100000;
+      // the Teensy adds the .pov extension
       uint32_t timestamp = millis() % 100000;
       char filename[32];
-      snprintf(filename, sizeof(filename), "upload_%05lu.pov", timestamp);
+      snprintf(filename, sizeof(filename), "upload_%05lu", (unsigned long)timestamp);
       uint8_t filenameLen = strlen(filename);
       
-      // Calculate total data length: filename_len + filename + width + height + image_data
-      uint16_t totalDataLen = 1 + filenameLen + 2 + actualSize;
-      
-      // Send SD save command (simple protocol)
-      // Format: 0xFF 0x20 dataLen [filename_len][filename][width][height][RGB_data...] 0xFE
-      sendTeensyCommand(0x20, totalDataLen);
+      // The Teensy snapshots the slot just uploaded (0x02 stores to slot 0)
+      // and writes the file in the background between columns
+      // Format: 0xFF 0x20 dataLen [filename_len][filename][slot] 0xFE
+      sendTeensyCommand(0x20, 1 + filenameLen + 1);
       TEENSY_SERIAL.write(filenameLen);
       TEENSY_SERIAL.write((const uint8_t*)filename, filenameLen);
-      TEENSY_SERIAL.write(imageWidth);
-      TEENSY_SERIAL.write(imageHeight);
-      
-      // Send pixel data
-      for (uint16_t i = 0; i < actualSize && i < bufferIndex; i++) {
-        TEENSY_SERIAL.write(imageBuffer[i]);
-      }
+      TEENSY_SERIAL.write((uint8_t)0);
       TEENSY_SERIAL.write(0xFE);
       
       Serial.print("Auto-saving image to SD: ");
@@ -2059,10 +3713,30 @@ void handleUploadImage() {
       Serial.println("SD card not present - skipping auto-save");
     }
     
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
+    JsonDocument doc;
+    doc["status"] = "ok";
+    if (patched) {
+      doc["transfer"] = "patch";
+      doc["bytesSent"] = columnDelta.patchBytes();
+      doc["bytesSaved"] = columnDelta.fullBytes() - columnDelta.patchBytes();
+      doc["columns"] = columnDelta.changedColumns();
+    } else if (progressive) {
+      doc["transfer"] = "progressive";
+      doc["bytesSent"] = progressiveStats.lastBytes;
+      doc["bytesSaved"] = 0;
+      doc["coarseMs"] = progressiveStats.lastCoarseMs;
+      doc["totalMs"] = progressiveStats.lastTotalMs;
+    } else {
+      doc["transfer"] = "full";
+      doc["bytesSent"] = actualSize + DELTA_FULL_HEADER;
+      doc["bytesSaved"] = 0;
+    }
+    String response;
+    serializeJson(doc, response);
+    reply(200, "application/json", response);
   } else if (upload.status == UPLOAD_FILE_ABORTED) {
     Serial.println("Upload aborted");
-    server.send(500, "application/json", "{\"error\":\"Upload aborted\"}");
+    reply(500, "application/json", "{\"error\":\"Upload aborted\"}");
   }
 }
 
@@ -2087,18 +3761,286 @@ void handleLiveFrame() {
         led++;
       }
     }
-
-    // Send live frame command to Teensy
-    sendTeensyCommand(0x05, ledCount * 3);  // 32 LEDs * 3 bytes
-    for (int i = 0; i < ledCount * 3; i++) {
-      TEENSY_SERIAL.write(rgb[i]);
+
+    // Send live frame command to Teensy
+    sendTeensyCommand(0x05, ledCount * 3);  // 32 LEDs * 3 bytes
+    for (int i = 0; i < ledCount * 3; i++) {
+      TEENSY_SERIAL.write(rgb[i]);
+    }
+    TEENSY_SERIAL.write(0xFE);
+    
+    reply(200, "application/json", "{\"status\":\"ok\"}");
+  } else {
+    reply(400, "application/json", "{\"error\":\"No data\"}");
+  }
+}
+
+// Sends a column played out of the ingest jitter buffer as a live frame
+void forwardIngestColumn(const uint8_t* rgb, size_t len) {
+  sendTeensyCommand(0x05, len);
+  TEENSY_SERIAL.write(rgb, len);
+  TEENSY_SERIAL.write(0xFE);
+}
+
+void onIngestStreamStart(IngestSource source) {
+  Serial.printf("Pixel stream started (source %u)\n", source);
+  if (ingestAutoLive && state.currentMode != 4) {
+    state.currentMode = 4;
+    state.currentIndex = 0;
+    queueControl(PENDING_MODE);
+  }
+}
+
+// GET reports the UDP ingest settings and stream statistics; POST changes
+// the settings (kept across reboots) or, with "reset", clears the counters.
+void handleIngest() {
+  static const char* const kSources[] = { "none", "ddp", "artnet", "e131" };
+
+  if (server.method() == HTTP_POST) {
+    JsonDocument doc;
+    if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain"))) {
+      reply(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      return;
+    }
+    if (doc["enabled"].is<bool>()) {
+      pixelIngest.setEnabled(doc["enabled"].as<bool>());
+    }
+    if (doc["artnetUniverse"].is<int>() || doc["e131Universe"].is<int>()) {
+      pixelIngest.setUniverses(doc["artnetUniverse"] | pixelIngest.artnetUniverse(),
+                               doc["e131Universe"] | pixelIngest.e131Universe());
+    }
+    if (doc["address"].is<int>()) {
+      pixelIngest.setAddress(doc["address"].as<uint16_t>());
+    }
+    if (doc["jitterMs"].is<int>() || doc["depth"].is<int>()) {
+      pixelIngest.setJitter(doc["jitterMs"] | pixelIngest.jitterMs(),
+                            doc["depth"] | pixelIngest.depth());
+    }
+    if (doc["autoLive"].is<bool>()) {
+      ingestAutoLive = doc["autoLive"].as<bool>();
+    }
+    if (doc["reset"] | false) {
+      pixelIngest.resetStats();
+    }
+    saveIngestConfig();
+  }
+
+  const IngestStats& s = pixelIngest.stats();
+  JsonDocument doc;
+  doc["enabled"] = pixelIngest.enabled();
+  doc["autoLive"] = ingestAutoLive;
+  doc["artnetUniverse"] = pixelIngest.artnetUniverse();
+  doc["e131Universe"] = pixelIngest.e131Universe();
+  doc["address"] = pixelIngest.address();
+  doc["jitterMs"] = pixelIngest.jitterMs();
+  doc["depth"] = pixelIngest.depth();
+  doc["source"] = kSources[pixelIngest.source()];
+
+  JsonObject stats = doc["stats"].to<JsonObject>();
+  stats["packets"] = s.packets;
+  stats["frames"] = s.frames;
+  stats["fps"] = s.fps;
+  stats["rxFps"] = s.rxFps;
+  stats["lost"] = s.lost;
+  uint32_t expected = s.lost + s.streamPackets;
+  stats["lossPercent"] = expected ? (uint32_t)((uint64_t)s.lost * 10000 / expected) / 100.0 : 0;
+  stats["late"] = s.late;
+  stats["duplicates"] = s.duplicates;
+  stats["overflows"] = s.overflows;
+  stats["malformed"] = s.malformed;
+  stats["ignored"] = s.ignored;
+  stats["depthPeak"] = s.depthPeak;
+  stats["worstHoldUs"] = s.worstHoldUs;
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
+
+// 0-255 from an integer argument, or from a 0.0-1.0 float (a fader)
+uint8_t oscLevel(const OscMessage& msg, uint8_t n) {
+  if (msg.isFloat(n)) return (uint8_t)(constrain(msg.floatArg(n), 0.0f, 1.0f) * 255 + 0.5f);
+  return (uint8_t)constrain(msg.intArg(n), 0, 255);
+}
+
+void recallOscScene(uint8_t n) {
+  if (n >= OSC_SCENES || !oscScenes[n].saved) return;
+  const OscScene& scene = oscScenes[n];
+  state.currentMode = scene.mode;
+  state.currentIndex = scene.index;
+  state.brightness = scene.brightness;
+  state.frameRate = scene.frameRate;
+  state.cachedFrameDelay = 1000 / max((uint8_t)1, state.frameRate);
+  queueControl(PENDING_MODE);
+  queueControl(PENDING_BRIGHTNESS);
+  queueControl(PENDING_FRAMERATE);
+}
+
+void saveOscScene(uint8_t n) {
+  if (n >= OSC_SCENES) return;
+  oscScenes[n] = { true, state.currentMode, state.currentIndex, state.brightness, state.frameRate };
+  saveOscConfig();
+}
+
+// Routes one OSC message; runs in the link task. Changes are queued like
+// HTTP ones but flushed within OSC_FLUSH_MS.
+//   /poi/mode i [i]            mode, optional index
+//   /poi/index i
+//   /poi/brightness i|f        0-255, or 0.0-1.0
+//   /poi/speed i|f             frame rate 1-255, or 0.0-1.0
+//   /poi/pattern i i r g b r g b speed     whole pattern config
+//   /poi/pattern/type i, /poi/pattern/speed i|f,
+//   /poi/pattern/color1 r g b, /poi/pattern/color2 r g b
+//                              edit the last pattern set over OSC
+//   /poi/scene i, /poi/scene/<n>             recall a scene
+//   /poi/scene/save i, /poi/scene/save/<n>   store mode, brightness, speed
+//   /poi/ping [i]              send what is queued, reply /poi/pong i
+// Button controls send 1 on press and 0 on release; releases are ignored
+// by the /<n> scene addresses.
+bool routeOscMessage(const OscMessage& msg) {
+  controlSource = CONTROL_OSC;
+  controlRequestUs = oscServer.packetUs();
+  if (strncmp(msg.address, "/poi/", 5) != 0) return false;
+  const char* a = msg.address + 5;
+
+  if (strcmp(a, "ping") == 0) {
+    if (pendingControls.flags) flushPendingControls();
+    oscServer.reply("/poi/pong", msg.intArg(0));
+    return true;
+  }
+
+  if (strncmp(a, "scene", 5) == 0) {
+    const char* rest = a + 5;
+    bool save = strncmp(rest, "/save", 5) == 0;
+    if (save) rest += 5;
+    int n;
+    if (*rest == '\0') {
+      if (msg.argc == 0) return true;
+      n = msg.intArg(0);
+    } else if (rest[0] == '/' && isdigit((unsigned char)rest[1])) {
+      if (msg.argc > 0 && msg.floatArg(0) == 0) return true;  // Button release
+      n = atoi(rest + 1);
+    } else {
+      return false;
+    }
+    if (n < 0 || n >= OSC_SCENES) return true;
+    if (save) saveOscScene(n);
+    else recallOscScene(n);
+    return true;
+  }
+
+  if (msg.argc == 0) {
+    // Every other address carries its value
+    return strcmp(a, "mode") == 0 || strcmp(a, "index") == 0 || strcmp(a, "brightness") == 0 ||
+           strcmp(a, "speed") == 0 || strncmp(a, "pattern", 7) == 0;
+  }
+
+  if (strcmp(a, "mode") == 0) {
+    state.currentMode = (uint8_t)msg.intArg(0);
+    if (msg.argc > 1) state.currentIndex = (uint8_t)msg.intArg(1);
+    queueControl(PENDING_MODE);
+  } else if (strcmp(a, "index") == 0) {
+    state.currentIndex = (uint8_t)msg.intArg(0);
+    queueControl(PENDING_MODE);
+  } else if (strcmp(a, "brightness") == 0) {
+    state.brightness = oscLevel(msg, 0);
+    queueControl(PENDING_BRIGHTNESS);
+  } else if (strcmp(a, "speed") == 0) {
+    if (msg.isFloat(0)) {
+      state.frameRate = 1 + (uint8_t)(constrain(msg.floatArg(0), 0.0f, 1.0f) * 254 + 0.5f);
+    } else {
+      state.frameRate = (uint8_t)constrain(msg.intArg(0), 1, 255);
+    }
+    state.cachedFrameDelay = 1000 / max((uint8_t)1, state.frameRate);
+    queueControl(PENDING_FRAMERATE);
+  } else if (strcmp(a, "pattern") == 0) {
+    oscPattern[0] = (uint8_t)constrain(msg.intArg(0), 0, kMaxPatternIndex);
+    if (msg.argc > 1) oscPattern[1] = (uint8_t)msg.intArg(1);
+    for (uint8_t k = 2; k < 9 && k < msg.argc; k++) oscPattern[k] = oscLevel(msg, k);
+    queuePatternRecord(oscPattern);
+  } else if (strcmp(a, "pattern/type") == 0) {
+    oscPattern[1] = (uint8_t)msg.intArg(0);
+    queuePatternRecord(oscPattern);
+  } else if (strcmp(a, "pattern/speed") == 0) {
+    oscPattern[8] = oscLevel(msg, 0);
+    queuePatternRecord(oscPattern);
+  } else if (strcmp(a, "pattern/color1") == 0 || strcmp(a, "pattern/color2") == 0) {
+    uint8_t* color = &oscPattern[a[13] == '1' ? 2 : 5];
+    for (uint8_t k = 0; k < 3 && k < msg.argc; k++) color[k] = oscLevel(msg, k);
+    queuePatternRecord(oscPattern);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// GET reports OSC settings, counters, saved scenes and the control latency
+// of the HTTP and OSC paths; POST changes the settings or, with "reset",
+// clears the counters and latencies.
+void handleOsc() {
+  static const char* const kPaths[] = { "http", "osc" };
+
+  if (server.method() == HTTP_POST) {
+    JsonDocument doc;
+    if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain"))) {
+      reply(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      return;
+    }
+    if (doc["port"].is<int>()) {
+      int port = doc["port"].as<int>();
+      if (port < 1024 || port > 65535 || port == INGEST_DDP_PORT ||
+          port == INGEST_ARTNET_PORT || port == INGEST_E131_PORT) {
+        reply(400, "application/json", "{\"error\":\"Invalid port\"}");
+        return;
+      }
+      oscServer.setPort(port);
+    }
+    if (doc["enabled"].is<bool>()) {
+      oscServer.setEnabled(doc["enabled"].as<bool>());
     }
-    TEENSY_SERIAL.write(0xFE);
-    
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
-  } else {
-    server.send(400, "application/json", "{\"error\":\"No data\"}");
+    if (doc["reset"] | false) {
+      oscServer.resetStats();
+      memset(controlLatency, 0, sizeof(controlLatency));
+    }
+    saveOscConfig();
+  }
+
+  const OscStats& s = oscServer.stats();
+  JsonDocument doc;
+  doc["enabled"] = oscServer.enabled();
+  doc["port"] = oscServer.port();
+
+  JsonObject stats = doc["stats"].to<JsonObject>();
+  stats["packets"] = s.packets;
+  stats["messages"] = s.messages;
+  stats["bundles"] = s.bundles;
+  stats["unknown"] = s.unknown;
+  stats["malformed"] = s.malformed;
+  stats["replies"] = s.replies;
+
+  JsonObject latency = doc["latency"].to<JsonObject>();
+  for (int i = 0; i < 2; i++) {
+    const ControlLatency& l = controlLatency[i];
+    JsonObject path = latency[kPaths[i]].to<JsonObject>();
+    path["count"] = l.count;
+    path["avgUs"] = l.count ? (uint32_t)(l.totalUs / l.count) : 0;
+    path["worstUs"] = l.worstUs;
   }
+
+  JsonArray scenes = doc["scenes"].to<JsonArray>();
+  for (int i = 0; i < OSC_SCENES; i++) {
+    if (!oscScenes[i].saved) continue;
+    JsonObject o = scenes.add<JsonObject>();
+    o["scene"] = i;
+    o["mode"] = oscScenes[i].mode;
+    o["index"] = oscScenes[i].index;
+    o["brightness"] = oscScenes[i].brightness;
+    o["framerate"] = oscScenes[i].frameRate;
+  }
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
 }
 
 bool readTeensyResponse(uint8_t expectedMarker, uint8_t* buffer, size_t maxLen, size_t& bytesRead, unsigned long timeout) {
@@ -2131,9 +4073,37 @@ bool readTeensyResponse(uint8_t expectedMarker, uint8_t* buffer, size_t maxLen,
   return false;
 }
 
+// Read a fixed-length response frame: 0xFF marker [len bytes] 0xFE.
+// Unlike readTeensyResponse() the payload may contain 0xFE (binary values).
+bool readTeensyFrame(uint8_t expectedMarker, uint8_t* buffer, size_t len, unsigned long timeout) {
+  unsigned long start = millis();
+  uint8_t prev = 0;
+  bool found = false;
+
+  // Wait for start marker followed by the expected response marker
+  while (!found && millis() - start < timeout) {
+    if (TEENSY_SERIAL.available() > 0) {
+      uint8_t b = TEENSY_SERIAL.read();
+      found = (prev == 0xFF && b == expectedMarker);
+      prev = b;
+    }
+  }
+  if (!found) return false;
+
+  size_t got = 0;
+  while (millis() - start < timeout) {
+    if (TEENSY_SERIAL.available() > 0) {
+      uint8_t b = TEENSY_SERIAL.read();
+      if (got == len) return b == 0xFE;
+      buffer[got++] = b;
+    }
+  }
+  return false;
+}
+
 void handleSDList() {
   if (!state.sdCardPresent) {
-    server.send(200, "application/json", "{\"error\":\"SD card not present\",\"files\":[]}");
+    reply(200, "application/json", "{\"error\":\"SD card not present\",\"files\":[]}");
     return;
   }
   
@@ -2168,12 +4138,12 @@ void handleSDList() {
       
       String response;
       serializeJson(doc, response);
-      server.send(200, "application/json", response);
+      reply(200, "application/json", response);
       return;
     }
   }
   
-  server.send(200, "application/json", "{\"error\":\"Failed to read response\",\"files\":[]}");
+  reply(200, "application/json", "{\"error\":\"Failed to read response\",\"files\":[]}");
 }
 
 void handleSDInfo() {
@@ -2204,12 +4174,12 @@ void handleSDInfo() {
       
       String response;
       serializeJson(doc, response);
-      server.send(200, "application/json", response);
+      reply(200, "application/json", response);
       return;
     }
   }
   
-  server.send(200, "application/json", "{\"error\":\"Failed to read response\"}");
+  reply(200, "application/json", "{\"error\":\"Failed to read response\"}");
 }
 
 void handleSDDelete() {
@@ -2219,7 +4189,7 @@ void handleSDDelete() {
     // Parse JSON: {"filename":"name.pov"}
     JsonDocument doc;
     if (deserializeJson(doc, body) || !doc["filename"].is<const char*>()) {
-      server.send(400, "application/json", "{\"error\":\"Missing filename\"}");
+      reply(400, "application/json", "{\"error\":\"Missing filename\"}");
       return;
     }
 
@@ -2234,48 +4204,259 @@ void handleSDDelete() {
     TEENSY_SERIAL.write((const uint8_t*)filename.c_str(), filenameLen);
     TEENSY_SERIAL.write(0xFE);
 
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
+    reply(200, "application/json", "{\"status\":\"ok\"}");
   } else {
-    server.send(400, "application/json", "{\"error\":\"No data\"}");
+    reply(400, "application/json", "{\"error\":\"No data\"}");
   }
 }
 
+// POST {"filename":"name","slot":0,"show":true} starts a background load on
+// the Teensy and returns at once; the old content keeps playing until the
+// new image is committed, and with show it is displayed from the next
+// column. GET reports the result and timing of the last load.
 void handleSDLoad() {
-  if (server.hasArg("plain")) {
-    String body = server.arg("plain");
+  static const char* const kLoadStates[] = { "idle", "loading", "done", "not_found", "bad_file", "no_space" };
 
-    // Parse JSON: {"filename":"name.pov"}
+  if (server.method() == HTTP_POST) {
     JsonDocument doc;
-    if (deserializeJson(doc, body) || !doc["filename"].is<const char*>()) {
-      server.send(400, "application/json", "{\"error\":\"Missing filename\"}");
+    if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain")) ||
+        !doc["filename"].is<const char*>()) {
+      reply(400, "application/json", "{\"error\":\"Missing filename\"}");
       return;
     }
 
     String filename = doc["filename"].as<String>();
     uint8_t filenameLen = filename.length();
     if (filenameLen > 63) filenameLen = 63;
+    uint8_t slot = doc["slot"] | 0;
+    bool show = doc["show"] | true;
 
-    // Send load command
-    // Protocol: 0xFF 0x24 dataLen [filenameLen][filename...][imgIndex] 0xFE
-    sendTeensyCommand(0x24, 1 + filenameLen + 1);
+    // Protocol: 0xFF 0x24 dataLen [filenameLen][filename...][imgIndex][show] 0xFE
+    sendTeensyCommand(0x24, 1 + filenameLen + 2);
     TEENSY_SERIAL.write(filenameLen);
     TEENSY_SERIAL.write((const uint8_t*)filename.c_str(), filenameLen);
-    TEENSY_SERIAL.write((uint8_t)0);  // load into image slot 0
+    TEENSY_SERIAL.write(slot);
+    TEENSY_SERIAL.write((uint8_t)(show ? 1 : 0));
     TEENSY_SERIAL.write(0xFE);
+    columnDelta.forget(slot);
+    sdLoadPending = true;
+    sdLoadRequestedAt = millis();
+
+    JsonDocument resp;
+    resp["status"] = "loading";
+    resp["slot"] = slot;
+    String response;
+    serializeJson(resp, response);
+    reply(202, "application/json", response);
+    return;
+  }
 
-    // Switch to image mode after loading
-    delay(100);
-    state.currentMode = 1;
-    state.currentIndex = 0;
-    sendTeensyCommand(0x01, 2);
-    TEENSY_SERIAL.write(state.currentMode);
-    TEENSY_SERIAL.write(state.currentIndex);
+  if (!sdLoadPending) {
+    drainTeensySerial();
+    sendTeensyCommand(0x27, 0);
+    TEENSY_SERIAL.write(0xFE);
+    uint8_t buf[SD_LOAD_EVENT_LEN];
+    if (readTeensyFrame(0xC4, buf, sizeof(buf))) {
+      applySdLoadEvent(buf);
+    }
+  }
+
+  JsonDocument doc;
+  if (sdLoadPending) {
+    doc["state"] = "loading";
+  } else if (!sdLoadResult.valid) {
+    reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+    return;
+  } else {
+    doc["state"] = sdLoadResult.status < 6 ? kLoadStates[sdLoadResult.status] : "unknown";
+    doc["slot"] = sdLoadResult.slot;
+    doc["shown"] = sdLoadResult.shown;
+    doc["width"] = sdLoadResult.width;
+    doc["height"] = sdLoadResult.height;
+    doc["readUs"] = sdLoadResult.readUs;
+    doc["commitUs"] = sdLoadResult.commitUs;
+    doc["totalUs"] = sdLoadResult.totalUs;
+    doc["passes"] = sdLoadResult.passes;
+    doc["format"] = sdLoadResult.format;
+    doc["decodeUs"] = sdLoadResult.decodeUs;
+    doc["fileBytes"] = sdLoadResult.fileBytes;
+  }
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
+
+// Loads a show bundle (/poi_shows/<name>.show on the Teensy's SD card):
+// images, patterns, sequences and settings in one sequential read.
+void handleShowLoad() {
+  static const char* const kLoadStates[] = { "idle", "loading", "done", "not_found", "bad_file", "no_space" };
+
+  if (server.method() == HTTP_POST) {
+    JsonDocument doc;
+    if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain")) ||
+        !doc["name"].is<const char*>()) {
+      reply(400, "application/json", "{\"error\":\"Missing name\"}");
+      return;
+    }
+
+    String name = doc["name"].as<String>();
+    uint8_t nameLen = name.length();
+    if (nameLen > 32) nameLen = 32;
+
+    // Protocol: 0xFF 0x28 dataLen [op=1][nameLen][name...] 0xFE
+    sendTeensyCommand(0x28, 2 + nameLen);
+    TEENSY_SERIAL.write(0x01);
+    TEENSY_SERIAL.write(nameLen);
+    TEENSY_SERIAL.write((const uint8_t*)name.c_str(), nameLen);
+    TEENSY_SERIAL.write(0xFE);
+    columnDelta.forgetAll();  // A show replaces the image library
+    showLoadPending = true;
+    showLoadRequestedAt = millis();
+
+    reply(202, "application/json", "{\"status\":\"loading\"}");
+    return;
+  }
+
+  if (!showLoadPending) {
+    drainTeensySerial();
+    sendTeensyCommand(0x28, 1);
+    TEENSY_SERIAL.write(0x02);
     TEENSY_SERIAL.write(0xFE);
+    uint8_t buf[SHOW_LOAD_EVENT_LEN];
+    if (readTeensyFrame(0xC6, buf, sizeof(buf))) {
+      applyShowLoadEvent(buf);
+    }
+  }
 
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
+  JsonDocument doc;
+  if (showLoadPending) {
+    doc["state"] = "loading";
+  } else if (!showLoadResult.valid) {
+    reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+    return;
   } else {
-    server.send(400, "application/json", "{\"error\":\"No data\"}");
+    doc["state"] = showLoadResult.status < 6 ? kLoadStates[showLoadResult.status] : "unknown";
+    doc["assetsDone"] = showLoadResult.assetsDone;
+    doc["assetCount"] = showLoadResult.assetCount;
+    doc["images"] = showLoadResult.images;
+    doc["bytes"] = showLoadResult.bytes;
+    doc["readUs"] = showLoadResult.readUs;
+    doc["applyUs"] = showLoadResult.applyUs;
+    doc["totalUs"] = showLoadResult.totalUs;
+    doc["passes"] = showLoadResult.passes;
+  }
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
+
+// Plays a .pov file straight from the Teensy's SD card through its page
+// cache (mode 5), without loading it into a slot.
+void handleSDPlay() {
+  JsonDocument doc;
+  if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain")) ||
+      !doc["filename"].is<const char*>()) {
+    reply(400, "application/json", "{\"error\":\"Missing filename\"}");
+    return;
+  }
+  String filename = doc["filename"].as<String>();
+  uint8_t filenameLen = filename.length();
+  if (filenameLen > 32) filenameLen = 32;
+
+  // Protocol: 0xFF 0x29 dataLen [op=1][filenameLen][filename...] 0xFE
+  sendTeensyCommand(0x29, 2 + filenameLen);
+  TEENSY_SERIAL.write(0x01);
+  TEENSY_SERIAL.write(filenameLen);
+  TEENSY_SERIAL.write((const uint8_t*)filename.c_str(), filenameLen);
+  TEENSY_SERIAL.write(0xFE);
+  state.currentMode = 5;
+
+  reply(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// GET: page cache statistics. POST {"budget": blocks} limits the blocks in
+// use (0 = whole pool); {"flush": true} drops everything cached.
+void handleSDCache() {
+  if (server.method() == HTTP_POST) {
+    JsonDocument doc;
+    if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain"))) {
+      reply(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      return;
+    }
+    if (doc["flush"] | false) {
+      sendTeensyCommand(0x29, 1);
+      TEENSY_SERIAL.write(0x04);
+      TEENSY_SERIAL.write(0xFE);
+    }
+    if (doc["budget"].is<int>()) {
+      uint16_t budget = doc["budget"].as<uint16_t>();
+      sendTeensyCommand(0x29, 3);
+      TEENSY_SERIAL.write(0x03);
+      TEENSY_SERIAL.write((uint8_t)(budget >> 8));
+      TEENSY_SERIAL.write((uint8_t)(budget & 0xFF));
+      TEENSY_SERIAL.write(0xFE);
+    }
+  }
+
+  drainTeensySerial();
+  sendTeensyCommand(0x29, 1);
+  TEENSY_SERIAL.write(0x02);
+  TEENSY_SERIAL.write(0xFE);
+
+  // Response: 0xFF 0xC7 files used(2) budget(2) block_columns hits(4)
+  //           misses(4) readaheads(4) evictions(4) miss_max_us(4) 0xFE
+  uint8_t buf[26];
+  if (!readTeensyFrame(0xC7, buf, sizeof(buf))) {
+    reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+    return;
+  }
+
+  static const char* const kCounters[] = { "hits", "misses", "readaheads", "evictions", "missMaxUs" };
+  JsonDocument doc;
+  doc["files"] = buf[0];
+  doc["blocksUsed"] = ((uint16_t)buf[1] << 8) | buf[2];
+  doc["blocksBudget"] = ((uint16_t)buf[3] << 8) | buf[4];
+  doc["blockColumns"] = buf[5];
+  for (int v = 0; v < 5; v++) {
+    const uint8_t* p = &buf[6 + v * 4];
+    doc[kCounters[v]] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+  }
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
+}
+
+// Reports the Teensy's background SD writer: queued saves, step latency
+// percentiles and how many columns a write step delayed (should stay 0).
+void handleSDWriter() {
+  static const char* const kFields[] = {
+    "done", "failed", "bytes", "steps", "p50Us", "p90Us", "p99Us", "maxUs",
+    "delayedColumns", "deferrals"
+  };
+
+  drainTeensySerial();
+  sendTeensyCommand(0x26, 0);
+  TEENSY_SERIAL.write(0xFE);
+
+  // Response: 0xFF 0xC5 queued done(4) failed(4) bytes(4) steps(4) p50(4)
+  //           p90(4) p99(4) max(4) delayed_columns(4) deferrals(4) 0xFE
+  uint8_t buf[41];
+  if (!readTeensyFrame(0xC5, buf, sizeof(buf))) {
+    reply(504, "application/json", "{\"error\":\"Teensy did not respond\"}");
+    return;
+  }
+
+  JsonDocument doc;
+  doc["queued"] = buf[0];
+  for (int v = 0; v < 10; v++) {
+    const uint8_t* p = &buf[1 + v * 4];
+    doc[kFields[v]] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
   }
+
+  String response;
+  serializeJson(doc, response);
+  reply(200, "application/json", response);
 }
 
 void handleManifest() {
@@ -2303,7 +4484,7 @@ void handleManifest() {
   ]
 })rawliteral";
   
-  server.send(200, "application/json", manifest);
+  reply(200, "application/json", manifest);
 }
 
 void handleServiceWorker() {
@@ -2387,12 +4568,303 @@ void sendFile(const char* path, const char* contentType) {
   }
 }
 
+// Every frame to the Teensy starts here or in sendTeensyLongCommand() (BLE
+// writes call flushQueuedControls() too): queued controls go first so the
+// Teensy sees changes in request order
+void flushQueuedControls() {
+  if (pendingControls.flags) flushPendingControls();
+}
+
 void sendTeensyCommand(uint8_t cmd, uint8_t dataLen) {
+  flushQueuedControls();
+
   TEENSY_SERIAL.write(0xFF);  // Start marker
   TEENSY_SERIAL.write(cmd);
   TEENSY_SERIAL.write(dataLen);
 }
 
+// Start of a frame with a 16-bit length (0x02 and 0x40-0x4F)
+void sendTeensyLongCommand(uint8_t cmd, uint32_t dataLen) {
+  flushQueuedControls();
+
+  TEENSY_SERIAL.write(0xFF);  // Start marker
+  TEENSY_SERIAL.write(cmd);
+  TEENSY_SERIAL.write((uint8_t)((dataLen >> 8) & 0xFF));
+  TEENSY_SERIAL.write((uint8_t)(dataLen & 0xFF));
+}
+
+// Discards pending input before a request, keeping any event frames in it
+void drainTeensySerial() {
+  static uint8_t event[SD_LOAD_EVENT_LEN];  // The longer of the two events
+  static uint8_t marker = 0;
+  static int got = -1;     // -1 while looking for FF C4 / FF C6
+  static uint8_t prev = 0;
+  while (TEENSY_SERIAL.available()) {
+    uint8_t b = TEENSY_SERIAL.read();
+    int len = marker == 0xC4 ? SD_LOAD_EVENT_LEN : SHOW_LOAD_EVENT_LEN;
+    if (got < 0) {
+      if (prev == 0xFF && (b == 0xC4 || b == 0xC6)) {
+        marker = b;
+        got = 0;
+      }
+      prev = b;
+    } else if (got < len) {
+      event[got++] = b;
+    } else {
+      if (b == 0xFE) {
+        if (marker == 0xC4) applySdLoadEvent(event);
+        else applyShowLoadEvent(event);
+      }
+      got = -1;
+      prev = 0;
+    }
+  }
+}
+
+void applySdLoadEvent(const uint8_t* buf) {
+  sdLoadResult.valid = true;
+  sdLoadResult.status = buf[0];
+  sdLoadResult.slot = buf[1];
+  sdLoadResult.shown = buf[2] != 0;
+  sdLoadResult.width = ((uint16_t)buf[3] << 8) | buf[4];
+  sdLoadResult.height = ((uint16_t)buf[5] << 8) | buf[6];
+  uint32_t* longs[3] = { &sdLoadResult.readUs, &sdLoadResult.commitUs, &sdLoadResult.totalUs };
+  for (int v = 0; v < 3; v++) {
+    const uint8_t* p = &buf[7 + v * 4];
+    *longs[v] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+  }
+  sdLoadResult.passes = ((uint16_t)buf[19] << 8) | buf[20];
+  sdLoadResult.format = buf[21];
+  uint32_t* tail[2] = { &sdLoadResult.decodeUs, &sdLoadResult.fileBytes };
+  for (int v = 0; v < 2; v++) {
+    const uint8_t* p = &buf[22 + v * 4];
+    *tail[v] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+  }
+
+  if (sdLoadResult.status == 1) return;  // Still loading (reply to 0x27)
+  sdLoadPending = false;
+  if (sdLoadResult.shown) {
+    state.currentMode = 1;
+    state.currentIndex = sdLoadResult.slot;
+  }
+  teensyCaps.stale = true;  // Free slots/columns changed
+  Serial.printf("[SD] Load into slot %u: status %u, %ux%u in %u us\n",
+                sdLoadResult.slot, sdLoadResult.status, sdLoadResult.width,
+                sdLoadResult.height, (unsigned)sdLoadResult.totalUs);
+}
+
+void applyShowLoadEvent(const uint8_t* buf) {
+  showLoadResult.valid = true;
+  showLoadResult.status = buf[0];
+  uint16_t* shorts[3] = { &showLoadResult.assetsDone, &showLoadResult.assetCount, &showLoadResult.images };
+  for (int v = 0; v < 3; v++) {
+    *shorts[v] = ((uint16_t)buf[1 + v * 2] << 8) | buf[2 + v * 2];
+  }
+  uint32_t* longs[4] = { &showLoadResult.bytes, &showLoadResult.readUs, &showLoadResult.applyUs, &showLoadResult.totalUs };
+  for (int v = 0; v < 4; v++) {
+    const uint8_t* p = &buf[7 + v * 4];
+    *longs[v] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+  }
+  showLoadResult.passes = ((uint16_t)buf[23] << 8) | buf[24];
+
+  if (showLoadResult.status == 1) return;  // Still loading (report request)
+  showLoadPending = false;
+  teensyCaps.stale = true;  // Free slots/columns changed
+  Serial.printf("[SD] Show load: status %u, %u/%u assets, %u bytes in %u us\n",
+                showLoadResult.status, showLoadResult.assetsDone, showLoadResult.assetCount,
+                (unsigned)showLoadResult.bytes, (unsigned)showLoadResult.totalUs);
+}
+
+void queueControl(uint8_t flag) {
+  if (pendingControls.flags & flag) pendingControls.coalesced++;
+  if (!pendingControls.flags) {
+    pendingControls.source = controlSource;
+    pendingControls.firstRequestUs = controlRequestUs;
+  }
+  if (controlSource == CONTROL_OSC) pendingControls.urgent = true;
+  pendingControls.flags |= flag;
+  pendingControls.queued++;
+}
+
+// Queues a pattern config ({"index","type","color1","color2","speed"}).
+// An edit to a different pattern slot than the one waiting is not a
+// replacement, so the waiting one is sent first.
+void queuePattern(JsonVariantConst pattern) {
+  uint8_t index = pattern["index"] | 0;
+  // Clamp the pattern index to the supported upper bound (0-20)
+  if (index > kMaxPatternIndex) {
+    index = kMaxPatternIndex;
+  }
+
+  uint8_t p[9];
+  p[0] = index;
+  p[1] = pattern["type"] | 0;
+  p[2] = pattern["color1"]["r"] | 255;
+  p[3] = pattern["color1"]["g"] | 0;
+  p[4] = pattern["color1"]["b"] | 0;
+  p[5] = pattern["color2"]["r"] | 0;
+  p[6] = pattern["color2"]["g"] | 0;
+  p[7] = pattern["color2"]["b"] | 255;
+  p[8] = pattern["speed"] | 50;
+  queuePatternRecord(p);
+}
+
+// Queues a pattern record (index type r1 g1 b1 r2 g2 b2 speed)
+void queuePatternRecord(const uint8_t* record) {
+  if ((pendingControls.flags & PENDING_PATTERN) && pendingControls.pattern[0] != record[0]) {
+    flushPendingControls();
+  }
+  memcpy(pendingControls.pattern, record, 9);
+  queueControl(PENDING_PATTERN);
+}
+
+// Sends everything queued as one 0x17 frame of [cmd][len][data] records
+// (pattern before mode, so a mode that selects the pattern shows the new
+// config) and mirrors each setting to paired peers once.
+void flushPendingControls() {
+  uint8_t flags = pendingControls.flags;
+  pendingControls.flags = 0;  // Cleared first: sendTeensyCommand() below must not recurse
+  pendingControls.urgent = false;
+  pendingControls.lastFlush = millis();
+  if (!flags) return;
+
+  uint8_t frame[32];
+  uint8_t len = 0;
+  if (flags & PENDING_PATTERN) {
+    frame[len++] = 0x03;
+    frame[len++] = 9;
+    memcpy(&frame[len], pendingControls.pattern, 9);
+    len += 9;
+  }
+  if (flags & PENDING_MODE) {
+    frame[len++] = 0x01;
+    frame[len++] = 2;
+    frame[len++] = state.currentMode;
+    frame[len++] = state.currentIndex;
+  }
+  if (flags & PENDING_BRIGHTNESS) {
+    frame[len++] = 0x06;
+    frame[len++] = 1;
+    frame[len++] = state.brightness;
+  }
+  if (flags & PENDING_FRAMERATE) {
+    frame[len++] = 0x07;
+    frame[len++] = 1;
+    frame[len++] = state.cachedFrameDelay;
+  }
+  if (flags & PENDING_DUTY) {
+    frame[len++] = 0x09;
+    frame[len++] = 1;
+    frame[len++] = state.dutyCycle;
+  }
+
+  sendTeensyCommand(0x17, len);
+  TEENSY_SERIAL.write(frame, len);
+  TEENSY_SERIAL.write(0xFE);
+  pendingControls.frames++;
+
+  if (pendingControls.source != CONTROL_OTHER) {
+    // Writes return once the bytes are buffered; add their time on the wire
+    uint32_t wireUs = (uint32_t)(len + 4) * 10 * 1000000UL / SERIAL_BAUD;
+    uint32_t latencyUs = (uint32_t)(esp_timer_get_time() - pendingControls.firstRequestUs) + wireUs;
+    ControlLatency& l = controlLatency[pendingControls.source];
+    l.count++;
+    l.totalUs += latencyUs;
+    if (latencyUs > l.worstUs) l.worstUs = latencyUs;
+  }
+
+  // Broadcast to paired peers via ESP-NOW (mirror mode)
+  if (!_syncCommandInProgress) {
+    const uint8_t* p = pendingControls.pattern;
+    if (flags & PENDING_PATTERN) {
+      espNowSync.broadcastPattern(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], p[8]);
+    }
+    if (flags & PENDING_MODE) espNowSync.broadcastModeChange(state.currentMode, state.currentIndex);
+    if (flags & PENDING_BRIGHTNESS) espNowSync.broadcastBrightness(state.brightness);
+    if (flags & PENDING_FRAMERATE) espNowSync.broadcastFrameRate(state.cachedFrameDelay);
+  }
+}
+
+// Asks the Teensy which slots hold an image (0x1A -> 0xCB); one bit per
+// slot, slot n in bit n%8 of active[n/8]
+bool requestSlotMap(uint8_t* active, size_t len) {
+  drainTeensySerial();
+  sendTeensyCommand(0x1A, 0);
+  TEENSY_SERIAL.write(0xFE);
+
+  // Response: 0xFF 0xCB slots(2) active(32) 0xFE
+  uint8_t buf[34];
+  if (!readTeensyFrame(0xCB, buf, sizeof(buf))) return false;
+  memcpy(active, &buf[2], min(len, (size_t)32));
+  return true;
+}
+
+// Asks the Teensy what it can store (0x16 -> 0xC2). Called when the link
+// comes up; uploads and /api/status use the result.
+bool requestTeensyCapabilities() {
+  drainTeensySerial();
+  sendTeensyCommand(0x16, 0);
+  TEENSY_SERIAL.write(0xFE);
+
+  // Response: 0xFF 0xC2 version max_images(2) free_slots(2) max_width(2) max_height(2)
+  //           psram_mb encodings sd_present max_frame(4) free_columns(4) 0xFE
+  uint8_t buf[20];
+  if (!readTeensyFrame(0xC2, buf, sizeof(buf))) {
+    Serial.println("[LINK] Teensy capability handshake failed");
+    teensyCaps.valid = false;
+    return false;
+  }
+
+  teensyCaps.protocolVersion = buf[0];
+  teensyCaps.maxImages = ((uint16_t)buf[1] << 8) | buf[2];
+  teensyCaps.freeSlots = ((uint16_t)buf[3] << 8) | buf[4];
+  teensyCaps.maxWidth = ((uint16_t)buf[5] << 8) | buf[6];
+  teensyCaps.maxHeight = ((uint16_t)buf[7] << 8) | buf[8];
+  teensyCaps.psramMb = buf[9];
+  teensyCaps.encodings = buf[10];
+  teensyCaps.sdPresent = buf[11] != 0;
+  teensyCaps.maxFrameBytes = ((uint32_t)buf[12] << 24) | ((uint32_t)buf[13] << 16) |
+                             ((uint32_t)buf[14] << 8) | buf[15];
+  teensyCaps.freeColumns = ((uint32_t)buf[16] << 24) | ((uint32_t)buf[17] << 16) |
+                           ((uint32_t)buf[18] << 8) | buf[19];
+  teensyCaps.valid = true;
+  teensyCaps.stale = false;
+  state.sdCardPresent = teensyCaps.sdPresent;
+
+  Serial.printf("[LINK] Teensy protocol v%u: %u slots (%u free), %ux%u max, %u MB PSRAM, encodings 0x%02X\n",
+                teensyCaps.protocolVersion, teensyCaps.maxImages, teensyCaps.freeSlots,
+                teensyCaps.maxWidth, teensyCaps.maxHeight, teensyCaps.psramMb, teensyCaps.encodings);
+  return true;
+}
+
+// Box-filters a row-major RGB image down to newWidth x newHeight in place.
+// Safe in place because every output pixel's source box starts at or after
+// the output's own index when shrinking.
+void downscaleRgb(uint8_t* rgb, uint16_t width, uint16_t height, uint16_t newWidth, uint16_t newHeight) {
+  for (uint16_t y = 0; y < newHeight; y++) {
+    uint32_t y0 = (uint32_t)y * height / newHeight;
+    uint32_t y1 = max(y0 + 1, (uint32_t)(y + 1) * height / newHeight);
+    for (uint16_t x = 0; x < newWidth; x++) {
+      uint32_t x0 = (uint32_t)x * width / newWidth;
+      uint32_t x1 = max(x0 + 1, (uint32_t)(x + 1) * width / newWidth);
+      uint32_t sum[3] = { 0, 0, 0 };
+      for (uint32_t sy = y0; sy < y1; sy++) {
+        const uint8_t* row = rgb + (sy * width) * 3;
+        for (uint32_t sx = x0; sx < x1; sx++) {
+          sum[0] += row[sx * 3];
+          sum[1] += row[sx * 3 + 1];
+          sum[2] += row[sx * 3 + 2];
+        }
+      }
+      uint32_t n = (y1 - y0) * (x1 - x0);
+      uint8_t* out = rgb + ((uint32_t)y * newWidth + x) * 3;
+      out[0] = (sum[0] + n / 2) / n;
+      out[1] = (sum[1] + n / 2) / n;
+      out[2] = (sum[2] + n / 2) / n;
+    }
+  }
+}
+
 void checkTeensyConnection() {
   static bool lastConnected = false;
   static unsigned long lastDisconnectLog = 0;
@@ -2416,16 +4888,24 @@ void checkTeensyConnection() {
         state.connected = true;
         if (!lastConnected) {
           Serial.println("[LINK] Teensy connection established");
+          // The Teensy may have restarted and lost its images
+          assetRestore.linkUpMs = millis();
+          if (assetStore.count() > 0) assetRestore.state = RESTORE_WAITING;
         }
         lastConnected = true;
+        // Handshake once per connection (retried at the next check if it
+        // fails) and again after uploads changed the free space
+        if (!teensyCaps.valid || teensyCaps.stale) requestTeensyCapabilities();
         return;
       }
     }
   }
   state.connected = false;
   state.sdCardPresent = false;
+  teensyCaps.valid = false;
   if (lastConnected) {
     Serial.println("[LINK] Teensy connection lost");
+    columnDelta.forgetAll();  // The Teensy may have restarted with empty slots
     lastConnected = false;
     lastDisconnectLog = millis();
   } else if (millis() - lastDisconnectLog > 15000) {
@@ -2448,27 +4928,33 @@ void setupESPNowSync() {
   }
 
   // Register callbacks - these fire when a paired peer sends us a command
+  // They run in the WiFi task, so the commands go to the link task as messages
   espNowSync.onModeChange([](uint8_t mode, uint8_t index) {
-    applyModeToTeensy(mode, index);
+    LinkMessage msg = { LINK_PEER_MODE, { mode, index } };
+    postLinkMessage(msg);
   });
 
   espNowSync.onPattern([](uint8_t idx, uint8_t type,
                           uint8_t r1, uint8_t g1, uint8_t b1,
                           uint8_t r2, uint8_t g2, uint8_t b2,
                           uint8_t speed) {
-    applyPatternToTeensy(idx, type, r1, g1, b1, r2, g2, b2, speed);
+    LinkMessage msg = { LINK_PEER_PATTERN, { idx, type, r1, g1, b1, r2, g2, b2, speed } };
+    postLinkMessage(msg);
   });
 
   espNowSync.onBrightness([](uint8_t brightness) {
-    applyBrightnessToTeensy(brightness);
+    LinkMessage msg = { LINK_PEER_BRIGHTNESS, { brightness } };
+    postLinkMessage(msg);
   });
 
   espNowSync.onFrameRate([](uint8_t frameDelay) {
-    applyFrameRateToTeensy(frameDelay);
+    LinkMessage msg = { LINK_PEER_FRAMERATE, { frameDelay } };
+    postLinkMessage(msg);
   });
 
   espNowSync.onSyncTime([](int32_t offsetMs) {
-    applySyncTimeToTeensy(offsetMs);
+    LinkMessage msg = { LINK_PEER_SYNC_TIME, {}, offsetMs };
+    postLinkMessage(msg);
   });
 
   espNowSync.onPeerUpdate([](const SyncPeer* peer) {
@@ -2483,8 +4969,15 @@ void setupESPNowSync() {
 // The _syncCommandInProgress flag prevents the web handler broadcasts
 // from echoing the command back to the peer that sent it.
 
-void applyModeToTeensy(uint8_t mode, uint8_t index) {
+// Local controls still queued are sent (and mirrored) before the flag is
+// set; flushed under it they would never reach the peers
+void beginPeerCommand() {
+  flushQueuedControls();
   _syncCommandInProgress = true;
+}
+
+void applyModeToTeensy(uint8_t mode, uint8_t index) {
+  beginPeerCommand();
   state.currentMode = mode;
   state.currentIndex = index;
   sendTeensyCommand(0x01, 2);
@@ -2499,7 +4992,7 @@ void applyPatternToTeensy(uint8_t idx, uint8_t type,
                           uint8_t r1, uint8_t g1, uint8_t b1,
                           uint8_t r2, uint8_t g2, uint8_t b2,
                           uint8_t speed) {
-  _syncCommandInProgress = true;
+  beginPeerCommand();
   sendTeensyCommand(0x03, 9);
   TEENSY_SERIAL.write(idx);
   TEENSY_SERIAL.write(type);
@@ -2525,7 +5018,7 @@ void applyPatternToTeensy(uint8_t idx, uint8_t type,
 }
 
 void applyBrightnessToTeensy(uint8_t brightness) {
-  _syncCommandInProgress = true;
+  beginPeerCommand();
   state.brightness = brightness;
   sendTeensyCommand(0x06, 1);
   TEENSY_SERIAL.write(brightness);
@@ -2535,7 +5028,7 @@ void applyBrightnessToTeensy(uint8_t brightness) {
 }
 
 void applyFrameRateToTeensy(uint8_t frameDelay) {
-  _syncCommandInProgress = true;
+  beginPeerCommand();
   // Update both frameRate and cached delay
   if (frameDelay > 0) {
     state.frameRate = 1000 / frameDelay;
@@ -2581,33 +5074,31 @@ void handleMultiPoiStatus() {
   doc["autoPair"] = espNowSync.getAutoPair();
 
   JsonArray peers = doc["peers"].to<JsonArray>();
-  for (int i = 0; i < espNowSync.getPeerCount(); i++) {
-    const SyncPeer* peer = espNowSync.getPeer(i);
-    if (!peer) continue;
-    
+  SyncPeer peer;
+  for (int i = 0; espNowSync.getPeer(i, peer); i++) {
     JsonObject peerObj = peers.add<JsonObject>();
     char peerMac[18];
     snprintf(peerMac, sizeof(peerMac), "%02X:%02X:%02X:%02X:%02X:%02X",
-      peer->mac[0], peer->mac[1], peer->mac[2],
-      peer->mac[3], peer->mac[4], peer->mac[5]);
+      peer.mac[0], peer.mac[1], peer.mac[2],
+      peer.mac[3], peer.mac[4], peer.mac[5]);
     
-    peerObj["name"] = peer->name;
+    peerObj["name"] = peer.name;
     peerObj["mac"] = peerMac;
-    peerObj["state"] = peer->state;
-    peerObj["online"] = peer->online;
-    peerObj["mode"] = peer->currentMode;
-    peerObj["index"] = peer->currentIndex;
-    peerObj["brightness"] = peer->brightness;
+    peerObj["state"] = peer.state;
+    peerObj["online"] = peer.online;
+    peerObj["mode"] = peer.currentMode;
+    peerObj["index"] = peer.currentIndex;
+    peerObj["brightness"] = peer.brightness;
   }
 
   String response;
   serializeJson(doc, response);
-  server.send(200, "application/json", response);
+  reply(200, "application/json", response);
 }
 
 void handleMultiPoiPair() {
   espNowSync.startPairing();
-  server.send(200, "application/json", "{\"status\":\"ok\",\"message\":\"Pair request broadcast\"}");
+  reply(200, "application/json", "{\"status\":\"ok\",\"message\":\"Pair request broadcast\"}");
 }
 
 void handleMultiPoiUnpair() {
@@ -2617,25 +5108,25 @@ void handleMultiPoiUnpair() {
     if (deserializeJson(doc, body) == DeserializationError::Ok && doc["index"].is<int>()) {
       int peerIdx = doc["index"].as<int>();
       espNowSync.unpairPeer(peerIdx);
-      server.send(200, "application/json", "{\"status\":\"ok\"}");
+      reply(200, "application/json", "{\"status\":\"ok\"}");
       return;
     }
   }
   // No index specified - unpair all
   espNowSync.unpairAll();
-  server.send(200, "application/json", "{\"status\":\"ok\",\"message\":\"All peers unpaired\"}");
+  reply(200, "application/json", "{\"status\":\"ok\",\"message\":\"All peers unpaired\"}");
 }
 
 void handleMultiPoiSyncMode() {
   if (!server.hasArg("plain")) {
-    server.send(400, "application/json", "{\"error\":\"No data\"}");
+    reply(400, "application/json", "{\"error\":\"No data\"}");
     return;
   }
 
   String body = server.arg("plain");
   JsonDocument doc;
   if (deserializeJson(doc, body) || doc["mode"].isNull()) {
-    server.send(400, "application/json", "{\"error\":\"Missing mode\"}");
+    reply(400, "application/json", "{\"error\":\"Missing mode\"}");
     return;
   }
 
@@ -2657,11 +5148,11 @@ void handleMultiPoiSyncMode() {
   } else if (isIndependent) {
     espNowSync.setSyncMode(SYNC_INDEPENDENT);
   } else {
-    server.send(400, "application/json", "{\"error\":\"Invalid mode (use mirror or independent)\"}");
+    reply(400, "application/json", "{\"error\":\"Invalid mode (use mirror or independent)\"}");
     return;
   }
 
-  server.send(200, "application/json",
+  reply(200, "application/json",
     "{\"status\":\"ok\",\"syncMode\":\"" +
     String(espNowSync.getSyncMode() == SYNC_MIRROR ? "mirror" : "independent") + "\"}");
 }
@@ -2673,25 +5164,25 @@ void handleMultiPoiPeerCmd() {
   //       {"peer": 0, "cmd": "brightness", "brightness": 200}
   //       {"peer": 0, "cmd": "framerate", "framerate": 60}
   if (!server.hasArg("plain")) {
-    server.send(400, "application/json", "{\"error\":\"No data\"}");
+    reply(400, "application/json", "{\"error\":\"No data\"}");
     return;
   }
 
   String body = server.arg("plain");
   JsonDocument doc;
   if (deserializeJson(doc, body)) {
-    server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+    reply(400, "application/json", "{\"error\":\"Invalid JSON\"}");
     return;
   }
 
   int peerIdx = doc["peer"] | -1;
   if (peerIdx == -1) {
-    server.send(400, "application/json", "{\"error\":\"Missing peer index\"}");
+    reply(400, "application/json", "{\"error\":\"Missing peer index\"}");
     return;
   }
 
   if (!doc["cmd"].is<const char*>()) {
-    server.send(400, "application/json", "{\"error\":\"Missing cmd\"}");
+    reply(400, "application/json", "{\"error\":\"Missing cmd\"}");
     return;
   }
   String cmd = doc["cmd"].as<String>();
@@ -2723,11 +5214,11 @@ void handleMultiPoiPeerCmd() {
     espNowSync.sendPeerFrameRate(peerIdx, frameDelay);
   }
   else {
-    server.send(400, "application/json", "{\"error\":\"Unknown cmd\"}");
+    reply(400, "application/json", "{\"error\":\"Unknown cmd\"}");
     return;
   }
 
-  server.send(200, "application/json", "{\"status\":\"ok\"}");
+  reply(200, "application/json", "{\"status\":\"ok\"}");
 }
 
 // ============================================================================
@@ -2776,6 +5267,50 @@ void saveDeviceConfig() {
   preferences.end();
 }
 
+// UDP ingest settings share the "povpoi" namespace
+void loadIngestConfig() {
+  preferences.begin("povpoi", false);
+  pixelIngest.setEnabled(preferences.getBool("ing_on", true));
+  pixelIngest.setUniverses(preferences.getUShort("ing_artu", 0),
+                           preferences.getUShort("ing_e131u", 1));
+  pixelIngest.setAddress(preferences.getUShort("ing_addr", 1));
+  pixelIngest.setJitter(preferences.getUShort("ing_jit", 20),
+                        preferences.getUChar("ing_depth", 2));
+  ingestAutoLive = preferences.getBool("ing_live", true);
+  preferences.end();
+}
+
+void saveIngestConfig() {
+  preferences.begin("povpoi", false);
+  preferences.putBool("ing_on", pixelIngest.enabled());
+  preferences.putUShort("ing_artu", pixelIngest.artnetUniverse());
+  preferences.putUShort("ing_e131u", pixelIngest.e131Universe());
+  preferences.putUShort("ing_addr", pixelIngest.address());
+  preferences.putUShort("ing_jit", pixelIngest.jitterMs());
+  preferences.putUChar("ing_depth", pixelIngest.depth());
+  preferences.putBool("ing_live", ingestAutoLive);
+  preferences.end();
+}
+
+// OSC settings and scenes share the "povpoi" namespace
+void loadOscConfig() {
+  preferences.begin("povpoi", false);
+  oscServer.setEnabled(preferences.getBool("osc_on", true));
+  oscServer.setPort(preferences.getUShort("osc_port", OSC_DEFAULT_PORT));
+  if (preferences.getBytesLength("osc_scenes") == sizeof(oscScenes)) {
+    preferences.getBytes("osc_scenes", oscScenes, sizeof(oscScenes));
+  }
+  preferences.end();
+}
+
+void saveOscConfig() {
+  preferences.begin("povpoi", false);
+  preferences.putBool("osc_on", oscServer.enabled());
+  preferences.putUShort("osc_port", oscServer.port());
+  preferences.putBytes("osc_scenes", oscScenes, sizeof(oscScenes));
+  preferences.end();
+}
+
 // Get device ID
 String getDeviceId() {
   return deviceConfig.deviceId;
@@ -2785,8 +5320,10 @@ String getDeviceId() {
 void discoverPeers() {
   Serial.println("Discovering peers...");
   
+  // The query takes seconds; only the update below needs the link lock
   int n = MDNS.queryService("povpoi", "tcp");
   Serial.printf("Found %d POV Poi devices\n", n);
+  LinkLock lock;
   
   for (int i = 0; i < n && peerCount < MAX_PEERS; i++) {
     String peerId = MDNS.txt(i, "deviceId");
@@ -2836,28 +5373,47 @@ void discoverPeers() {
 
 // Perform sync with peer device
 void performSync(String peerId) {
-  // Find peer
-  PeerDevice* peer = nullptr;
-  for (int i = 0; i < peerCount; i++) {
-    if (peers[i].deviceId == peerId) {
-      peer = &peers[i];
-      break;
+  // Copy what the requests need under the link lock; the HTTP round trips
+  // then run without it
+  String ipAddress;
+  String syncData;
+  {
+    LinkLock lock;
+    PeerDevice* peer = nullptr;
+    for (int i = 0; i < peerCount; i++) {
+      if (peers[i].deviceId == peerId) {
+        peer = &peers[i];
+        break;
+      }
     }
+
+    if (peer == nullptr || !peer->online) {
+      Serial.println("Peer not found or offline");
+      return;
+    }
+
+    Serial.printf("Syncing with %s (%s)...\n", peer->deviceName.c_str(), peer->ipAddress.c_str());
+    ipAddress = peer->ipAddress;
+
+    // Build sync data JSON (simplified - just settings for now)
+    syncData = "{";
+    syncData += "\"deviceId\":\"" + deviceConfig.deviceId + "\",";
+    syncData += "\"deviceName\":\"" + deviceConfig.deviceName + "\",";
+    syncData += "\"settings\":{";
+    syncData += "\"brightness\":" + String(state.brightness) + ",";
+    syncData += "\"framerate\":" + String(state.frameRate) + ",";
+    syncData += "\"mode\":" + String(state.currentMode) + ",";
+    syncData += "\"index\":" + String(state.currentIndex) + ",";
+    syncData += "\"timestamp\":" + String(millis());
+    syncData += "}}";
   }
   
-  if (peer == nullptr || !peer->online) {
-    Serial.println("Peer not found or offline");
-    return;
-  }
-  
-  Serial.printf("Syncing with %s (%s)...\n", peer->deviceName.c_str(), peer->ipAddress.c_str());
-  
   // Create HTTP client
   HTTPClient http;
   WiFiClient client;
   
   // Get peer's data
-  String url = "http://" + peer->ipAddress + "/api/sync/data";
+  String url = "http://" + ipAddress + "/api/sync/data";
   http.begin(client, url);
   
   int httpCode = http.GET();
@@ -2867,22 +5423,10 @@ void performSync(String peerId) {
     
     // Push our data to peer
     http.end();
-    url = "http://" + peer->ipAddress + "/api/sync/push";
+    url = "http://" + ipAddress + "/api/sync/push";
     http.begin(client, url);
     http.addHeader("Content-Type", "application/json");
     
-    // Build sync data JSON (simplified - just settings for now)
-    String syncData = "{";
-    syncData += "\"deviceId\":\"" + deviceConfig.deviceId + "\",";
-    syncData += "\"deviceName\":\"" + deviceConfig.deviceName + "\",";
-    syncData += "\"settings\":{";
-    syncData += "\"brightness\":" + String(state.brightness) + ",";
-    syncData += "\"framerate\":" + String(state.frameRate) + ",";
-    syncData += "\"mode\":" + String(state.currentMode) + ",";
-    syncData += "\"index\":" + String(state.currentIndex) + ",";
-    syncData += "\"timestamp\":" + String(millis());
-    syncData += "}}";
-    
     httpCode = http.POST(syncData);
     if (httpCode == HTTP_CODE_OK) {
       Serial.println("Successfully synced with peer");
@@ -2918,7 +5462,7 @@ void handleSyncStatus() {
   }
   
   json += "]}";
-  server.send(200, "application/json", json);
+  reply(200, "application/json", json);
 }
 
 // Handle peer discovery request
@@ -2926,27 +5470,30 @@ void handleSyncDiscover() {
   discoverPeers();
   
   String json = "{";
-  json += "\"status\":\"ok\",";
-  json += "\"peersFound\":" + String(peerCount) + ",";
-  json += "\"peers\":[";
-  
-  for (int i = 0; i < peerCount; i++) {
-    if (i > 0) json += ",";
-    json += "{";
-    json += "\"deviceId\":\"" + peers[i].deviceId + "\",";
-    json += "\"deviceName\":\"" + peers[i].deviceName + "\",";
-    json += "\"ipAddress\":\"" + peers[i].ipAddress + "\"";
-    json += "}";
+  {
+    LinkLock lock;
+    json += "\"status\":\"ok\",";
+    json += "\"peersFound\":" + String(peerCount) + ",";
+    json += "\"peers\":[";
+    
+    for (int i = 0; i < peerCount; i++) {
+      if (i > 0) json += ",";
+      json += "{";
+      json += "\"deviceId\":\"" + peers[i].deviceId + "\",";
+      json += "\"deviceName\":\"" + peers[i].deviceName + "\",";
+      json += "\"ipAddress\":\"" + peers[i].ipAddress + "\"";
+      json += "}";
+    }
   }
   
   json += "]}";
-  server.send(200, "application/json", json);
+  reply(200, "application/json", json);
 }
 
 // Handle sync execution request
 void handleSyncExecute() {
   if (!server.hasArg("plain")) {
-    server.send(400, "application/json", "{\"error\":\"No data\"}");
+    reply(400, "application/json", "{\"error\":\"No data\"}");
     return;
   }
 
@@ -2955,15 +5502,18 @@ void handleSyncExecute() {
   // Parse peer ID using ArduinoJson
   JsonDocument doc;
   if (deserializeJson(doc, body) || !doc["peerId"].is<const char*>()) {
-    server.send(400, "application/json", "{\"error\":\"Missing peerId\"}");
+    reply(400, "application/json", "{\"error\":\"Missing peerId\"}");
     return;
   }
 
   String peerId = doc["peerId"].as<String>();
   
-  // Perform sync
+  // Perform sync (takes the link lock for the parts that need it)
   performSync(peerId);
-  state.lastSync = millis();
+  {
+    LinkLock lock;
+    state.lastSync = millis();
+  }
   
   String json = "{";
   json += "\"status\":\"ok\",";
@@ -2973,7 +5523,7 @@ void handleSyncExecute() {
   json += "\"settingsUpdated\":true";
   json += "}";
   
-  server.send(200, "application/json", json);
+  reply(200, "application/json", json);
 }
 
 // Handle sync data request (GET)
@@ -3006,7 +5556,10 @@ void handleSyncData() {
   json += "{\"id\":14,\"name\":\"Center Burst\"},";
   json += "{\"id\":15,\"name\":\"Audio Sparkle\"},";
   json += "{\"id\":16,\"name\":\"Split Spin\"},";
-  json += "{\"id\":17,\"name\":\"Theater Chase\"}";
+  json += "{\"id\":17,\"name\":\"Theater Chase\"},";
+  json += "{\"id\":18,\"name\":\"Fireworks\"},";
+  json += "{\"id\":19,\"name\":\"Rain\"},";
+  json += "{\"id\":20,\"name\":\"Sparks\"}";
   json += "],";
 
   json += "\"settings\":{";
@@ -3017,13 +5570,13 @@ void handleSyncData() {
   json += "\"timestamp\":" + String(millis());
   json += "}}";
   
-  server.send(200, "application/json", json);
+  reply(200, "application/json", json);
 }
 
 // Handle sync push request (POST)
 void handleSyncPush() {
   if (!server.hasArg("plain")) {
-    server.send(400, "application/json", "{\"error\":\"No data\"}");
+    reply(400, "application/json", "{\"error\":\"No data\"}");
     return;
   }
   
@@ -3040,7 +5593,7 @@ void handleSyncPush() {
   json += "\"message\":\"Sync data received\"";
   json += "}";
   
-  server.send(200, "application/json", json);
+  reply(200, "application/json", json);
 }
 
 // Handle device configuration request (GET)
@@ -3053,13 +5606,13 @@ void handleDeviceConfig() {
   json += "\"syncInterval\":" + String(deviceConfig.syncInterval);
   json += "}";
   
-  server.send(200, "application/json", json);
+  reply(200, "application/json", json);
 }
 
 // Handle device configuration update (POST)
 void handleDeviceConfigUpdate() {
   if (!server.hasArg("plain")) {
-    server.send(400, "application/json", "{\"error\":\"No data\"}");
+    reply(400, "application/json", "{\"error\":\"No data\"}");
     return;
   }
 
@@ -3068,21 +5621,25 @@ void handleDeviceConfigUpdate() {
   // Parse and update configuration using ArduinoJson
   JsonDocument doc;
   if (deserializeJson(doc, body)) {
-    server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+    reply(400, "application/json", "{\"error\":\"Invalid JSON\"}");
     return;
   }
 
-  if (doc["deviceName"].is<const char*>()) {
-    deviceConfig.deviceName = doc["deviceName"].as<String>();
-  }
-  if (doc["syncGroup"].is<const char*>()) {
-    deviceConfig.syncGroup = doc["syncGroup"].as<String>();
-  }
-  if (doc["autoSync"].is<bool>()) {
-    deviceConfig.autoSync = doc["autoSync"].as<bool>();
+  {
+    // The house task reads the config for auto-sync
+    LinkLock lock;
+    if (doc["deviceName"].is<const char*>()) {
+      deviceConfig.deviceName = doc["deviceName"].as<String>();
+    }
+    if (doc["syncGroup"].is<const char*>()) {
+      deviceConfig.syncGroup = doc["syncGroup"].as<String>();
+    }
+    if (doc["autoSync"].is<bool>()) {
+      deviceConfig.autoSync = doc["autoSync"].as<bool>();
+    }
   }
 
-  // Save configuration
+  // Save configuration (a flash write; only this handler changes the config)
   saveDeviceConfig();
 
   String json = "{";
@@ -3090,7 +5647,7 @@ void handleDeviceConfigUpdate() {
   json += "\"message\":\"Configuration updated\"";
   json += "}";
 
-  server.send(200, "application/json", json);
+  reply(200, "application/json", json);
 }
 
 // Save WiFi STA credentials to Preferences and optionally start connection
@@ -3119,7 +5676,7 @@ void handleWifiStatus() {
 
   String json;
   serializeJson(doc, json);
-  server.send(200, "application/json", json);
+  reply(200, "application/json", json);
 }
 
 // GET /api/wifi/scan - Scan for nearby WiFi networks (async, non-blocking)
@@ -3133,7 +5690,7 @@ void handleWifiScan() {
     doc["scanning"] = true;
     String json;
     serializeJson(doc, json);
-    server.send(200, "application/json", json);
+    reply(200, "application/json", json);
     return;
   }
 
@@ -3143,7 +5700,7 @@ void handleWifiScan() {
     doc["scanning"] = true;
     String json;
     serializeJson(doc, json);
-    server.send(200, "application/json", json);
+    reply(200, "application/json", json);
     return;
   }
 
@@ -3162,20 +5719,20 @@ void handleWifiScan() {
 
   String json;
   serializeJson(doc, json);
-  server.send(200, "application/json", json);
+  reply(200, "application/json", json);
 }
 
 // POST /api/wifi/connect - Save SSID/password and connect to network (body: {"ssid":"...", "password":"..."})
 void handleWifiConnect() {
   if (!server.hasArg("plain")) {
-    server.send(400, "application/json", "{\"error\":\"No data\"}");
+    reply(400, "application/json", "{\"error\":\"No data\"}");
     return;
   }
 
   String body = server.arg("plain");
   JsonDocument doc;
   if (deserializeJson(doc, body) || !doc["ssid"].is<const char*>()) {
-    server.send(400, "application/json", "{\"error\":\"Missing ssid\"}");
+    reply(400, "application/json", "{\"error\":\"Missing ssid\"}");
     return;
   }
 
@@ -3183,7 +5740,7 @@ void handleWifiConnect() {
   newSsid.trim();
 
   if (newSsid.length() == 0) {
-    server.send(400, "application/json", "{\"error\":\"SSID cannot be empty\"}");
+    reply(400, "application/json", "{\"error\":\"SSID cannot be empty\"}");
     return;
   }
 
@@ -3197,7 +5754,7 @@ void handleWifiConnect() {
   json += "\"message\":\"Connecting to network. Check /api/wifi/status for result.\"";
   json += "}";
 
-  server.send(200, "application/json", json);
+  reply(200, "application/json", json);
 }
 
 // POST /api/wifi/disconnect - Disconnect from STA and clear saved credentials
@@ -3215,5 +5772,5 @@ void handleWifiDisconnect() {
   json += "\"message\":\"Disconnected and credentials cleared\"";
   json += "}";
   
-  server.send(200, "application/json", json);
+  reply(200, "application/json", json);
 }
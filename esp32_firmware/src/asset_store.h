@@ -0,0 +1,289 @@
+/*
+ * Flash Asset Store
+ *
+ * Keeps the images sent to the Teensy in a LittleFS partition ("assets",
+ * see partitions.csv), so they can be sent again after the Teensy restarts
+ * without the phone uploading them again. The Teensy holds images in RAM
+ * and loses them on every reboot.
+ *
+ * Assets are keyed by a hash of their size and pixels and stored as
+ * /<hash>.rgb (row-major RGB). The index, /index.bin, records for each
+ * asset its size, the Teensy slot it was last sent to and when it was last
+ * used. The least recently used assets are evicted past ASSET_MAX_ENTRIES
+ * or the byte budget.
+ *
+ * Writes are kept to what changed, because flash sectors wear out:
+ *   - an image that is already stored is not written again (only its
+ *     index entry moves to the front)
+ *   - the index is rewritten only when an entry changed
+ *   - files are written under a temporary name and renamed when complete,
+ *     so a power cut never leaves half an asset under a valid name
+ * LittleFS spreads the block writes over the partition itself. Writes and
+ * bytes written are counted for the life of the store.
+ */
+
+#ifndef ASSET_STORE_H
+#define ASSET_STORE_H
+
+#include <LittleFS.h>
+
+#define ASSET_PARTITION "assets"
+#define ASSET_MOUNT_PATH "/assets"
+#define ASSET_MAX_ENTRIES 32
+#define ASSET_BUDGET_PCT 75          // Share of the partition assets may use
+#define ASSET_INDEX_PATH "/index.bin"
+#define ASSET_INDEX_MAGIC 0x31534150 // "PAS1"
+#define ASSET_IO_CHUNK 512
+
+struct AssetEntry {
+  uint32_t hash;
+  uint16_t width;
+  uint16_t height;
+  uint32_t bytes;
+  uint32_t lastUsed;    // Store sequence number of the last put
+  uint8_t slot;         // Teensy slot it was last sent to
+  uint8_t reserved[3];
+};
+
+struct AssetStats {
+  uint32_t puts;
+  uint32_t dedupHits;   // Puts of an image already stored
+  uint32_t evictions;
+  uint32_t failures;    // Puts that could not be written
+  uint32_t writes;      // Files written, for the life of the store
+  uint32_t bytesWritten;
+};
+
+class AssetStore {
+public:
+  // Mounts the partition (formatting it if it has no file system) and
+  // loads the index, dropping entries whose file is missing
+  bool begin() {
+    _mounted = LittleFS.begin(true, ASSET_MOUNT_PATH, 4, ASSET_PARTITION);
+    if (!_mounted) return false;
+    loadIndex();
+    return true;
+  }
+
+  bool mounted() const { return _mounted; }
+  uint8_t count() const { return _count; }
+  const AssetEntry& entry(uint8_t i) const { return _entries[i]; }
+  const AssetStats& stats() const { return _stats; }
+  size_t totalBytes() const { return _mounted ? LittleFS.totalBytes() : 0; }
+  size_t usedBytes() const { return _mounted ? LittleFS.usedBytes() : 0; }
+
+  uint32_t assetBytes() const {
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < _count; i++) sum += _entries[i].bytes;
+    return sum;
+  }
+
+  static uint32_t hashImage(uint16_t width, uint16_t height, const uint8_t* rgb, size_t len) {
+    // FNV-1a over the dimensions and pixels
+    uint32_t h = 2166136261u;
+    uint8_t dims[4] = { (uint8_t)width, (uint8_t)(width >> 8), (uint8_t)height, (uint8_t)(height >> 8) };
+    for (int i = 0; i < 4; i++) h = (h ^ dims[i]) * 16777619u;
+    for (size_t i = 0; i < len; i++) h = (h ^ rgb[i]) * 16777619u;
+    return h;
+  }
+
+  // Records an image sent to `slot`; returns false if it could not be stored
+  bool put(uint8_t slot, uint16_t width, uint16_t height, const uint8_t* rgb, size_t len) {
+    if (!_mounted || len == 0) return false;
+    _stats.puts++;
+    uint32_t hash = hashImage(width, height, rgb, len);
+
+    int found = find(hash);
+    if (found >= 0 && _entries[found].bytes == len && LittleFS.exists(assetPath(hash))) {
+      _stats.dedupHits++;
+      AssetEntry& e = _entries[found];
+      // Nothing to write if it is already the newest asset for this slot
+      if (e.slot == slot && e.lastUsed == _seq) return true;
+      e.slot = slot;
+      e.lastUsed = ++_seq;
+      return saveIndex();
+    }
+    if (found >= 0) removeEntry(found);  // Hash collision or lost file
+
+    // Make room first, so the write does not fail halfway on a full partition
+    uint32_t budget = (uint32_t)((uint64_t)LittleFS.totalBytes() * ASSET_BUDGET_PCT / 100);
+    if (len > budget) {
+      _stats.failures++;
+      return false;
+    }
+    while (_count > 0 && (_count >= ASSET_MAX_ENTRIES || assetBytes() + len > budget)) {
+      evictOldest();
+    }
+
+    if (!writeFile(hash, rgb, len)) {
+      _stats.failures++;
+      return false;
+    }
+    AssetEntry& e = _entries[_count++];
+    memset(&e, 0, sizeof(e));
+    e.hash = hash;
+    e.width = width;
+    e.height = height;
+    e.bytes = (uint32_t)len;
+    e.slot = slot;
+    e.lastUsed = ++_seq;
+    return saveIndex();
+  }
+
+  int find(uint32_t hash) const {
+    for (uint8_t i = 0; i < _count; i++) {
+      if (_entries[i].hash == hash) return i;
+    }
+    return -1;
+  }
+
+  // Opens an asset's pixels for reading (closed by the caller)
+  File open(const AssetEntry& e) const {
+    return LittleFS.open(assetPath(e.hash), FILE_READ);
+  }
+
+  // The newest asset for each slot, newest first, so the image uploaded
+  // last is back on the Teensy first. Returns how many were written to out.
+  uint8_t restoreList(AssetEntry* out, uint8_t max) const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+      const AssetEntry& e = _entries[i];
+      int same = -1;
+      for (uint8_t j = 0; j < n; j++) {
+        if (out[j].slot == e.slot) same = j;
+      }
+      if (same >= 0) {
+        if (e.lastUsed > out[same].lastUsed) out[same] = e;
+      } else if (n < max) {
+        out[n++] = e;
+      }
+    }
+    // Insertion sort by lastUsed, newest first (n is small)
+    for (uint8_t i = 1; i < n; i++) {
+      AssetEntry e = out[i];
+      int j = i - 1;
+      while (j >= 0 && out[j].lastUsed < e.lastUsed) {
+        out[j + 1] = out[j];
+        j--;
+      }
+      out[j + 1] = e;
+    }
+    return n;
+  }
+
+  // Deletes every asset; the lifetime write counters are kept
+  void clear() {
+    if (!_mounted) return;
+    while (_count > 0) {
+      LittleFS.remove(assetPath(_entries[_count - 1].hash));
+      _count--;
+    }
+    saveIndex();
+  }
+
+private:
+  bool _mounted = false;
+  AssetEntry _entries[ASSET_MAX_ENTRIES];
+  uint8_t _count = 0;
+  uint32_t _seq = 0;
+  AssetStats _stats = {};
+
+  struct IndexHeader {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t writes;
+    uint32_t bytesWritten;
+    uint8_t count;
+    uint8_t reserved[3];
+  };
+
+  static String assetPath(uint32_t hash) {
+    char path[16];
+    snprintf(path, sizeof(path), "/%08lx.rgb", (unsigned long)hash);
+    return String(path);
+  }
+
+  // Writes `len` bytes under a temporary name, then renames it into place
+  bool writeFile(uint32_t hash, const uint8_t* data, size_t len) {
+    String path = assetPath(hash);
+    return writeAtomic(path.c_str(), data, len, nullptr, 0);
+  }
+
+  bool writeAtomic(const char* path, const uint8_t* data, size_t len,
+                   const uint8_t* tail, size_t tailLen) {
+    String tmp = String(path) + ".tmp";
+    File f = LittleFS.open(tmp, FILE_WRITE);
+    if (!f) return false;
+    size_t done = 0;
+    while (done < len) {
+      size_t n = min((size_t)ASSET_IO_CHUNK, len - done);
+      if (f.write(data + done, n) != n) break;
+      done += n;
+    }
+    bool ok = done == len && (tailLen == 0 || f.write(tail, tailLen) == tailLen);
+    f.close();
+    if (ok) {
+      LittleFS.remove(path);
+      ok = LittleFS.rename(tmp, path);
+    }
+    if (!ok) {
+      LittleFS.remove(tmp);
+      return false;
+    }
+    _stats.writes++;
+    _stats.bytesWritten += len + tailLen;
+    return true;
+  }
+
+  void removeEntry(uint8_t i) {
+    LittleFS.remove(assetPath(_entries[i].hash));
+    _entries[i] = _entries[--_count];
+  }
+
+  void evictOldest() {
+    uint8_t oldest = 0;
+    for (uint8_t i = 1; i < _count; i++) {
+      if (_entries[i].lastUsed < _entries[oldest].lastUsed) oldest = i;
+    }
+    removeEntry(oldest);
+    _stats.evictions++;
+  }
+
+  void loadIndex() {
+    _count = 0;
+    _seq = 0;
+    File f = LittleFS.open(ASSET_INDEX_PATH, FILE_READ);
+    if (!f) return;
+    IndexHeader header;
+    if (f.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        header.magic != ASSET_INDEX_MAGIC) {
+      f.close();
+      return;
+    }
+    _seq = header.seq;
+    _stats.writes = header.writes;
+    _stats.bytesWritten = header.bytesWritten;
+    uint8_t n = min(header.count, (uint8_t)ASSET_MAX_ENTRIES);
+    for (uint8_t i = 0; i < n; i++) {
+      AssetEntry e;
+      if (f.read((uint8_t*)&e, sizeof(e)) != sizeof(e)) break;
+      if (LittleFS.exists(assetPath(e.hash))) _entries[_count++] = e;
+    }
+    f.close();
+  }
+
+  bool saveIndex() {
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = ASSET_INDEX_MAGIC;
+    header.seq = _seq;
+    // Count this write too, so the stored totals include it
+    header.writes = _stats.writes + 1;
+    header.bytesWritten = _stats.bytesWritten + sizeof(header) + _count * sizeof(AssetEntry);
+    header.count = _count;
+    return writeAtomic(ASSET_INDEX_PATH, (const uint8_t*)&header, sizeof(header),
+                       (const uint8_t*)_entries, _count * sizeof(AssetEntry));
+  }
+};
+
+#endif // ASSET_STORE_H
@@ -9,6 +9,9 @@
 
 BLEBridge::BLEBridge(HardwareSerial* serial) {
     teensySerial = serial;
+    linkLock = nullptr;
+    beforeWrite = nullptr;
+    disconnectedAt = 0;
     pServer = nullptr;
     pRxCharacteristic = nullptr;
     pTxCharacteristic = nullptr;
@@ -63,11 +66,17 @@ void BLEBridge::setup() {
 
 void BLEBridge::loop() {
     // Handle connection/disconnection events
+    if (deviceConnected) disconnectedAt = 0;
+    // Give the bluetooth stack 500 ms to prepare, without blocking the caller
     if (!deviceConnected && oldDeviceConnected) {
-        delay(500); // Give the bluetooth stack time to prepare
-        pServer->startAdvertising(); // Restart advertising
-        Serial.println("BLE: Restarting advertising");
-        oldDeviceConnected = deviceConnected;
+        if (disconnectedAt == 0) {
+            disconnectedAt = millis() | 1;
+        } else if (millis() - disconnectedAt >= 500) {
+            pServer->startAdvertising(); // Restart advertising
+            Serial.println("BLE: Restarting advertising");
+            oldDeviceConnected = deviceConnected;
+            disconnectedAt = 0;
+        }
     }
     
     if (deviceConnected && !oldDeviceConnected) {
@@ -198,7 +207,7 @@ void BLEBridge::translateBLEtoInternalProtocol(uint8_t* cmd, size_t length) {
                 packet[5] = 0xFE;
                 
                 Serial.println("BLE: Mapped SET_PATTERN_SLOT to SetMode(2, slot)");
-                teensySerial->write(packet, 6);
+                writeTeensy(packet, 6);
                 return;
             }
             break;
@@ -215,7 +224,7 @@ void BLEBridge::translateBLEtoInternalProtocol(uint8_t* cmd, size_t length) {
                 packet[5] = 0xFE;
                 
                 Serial.println("BLE: Mapped SET_PATTERN_ALL to SetMode(2, 255)");
-                teensySerial->write(packet, 6);
+                writeTeensy(packet, 6);
                 return;
             }
             break;
@@ -235,7 +244,7 @@ void BLEBridge::translateBLEtoInternalProtocol(uint8_t* cmd, size_t length) {
                 packet[5] = 0xFE;
                 
                 Serial.println("BLE: Mapped START_SEQUENCER to SetMode(3, seq_idx)");
-                teensySerial->write(packet, 6);
+                writeTeensy(packet, 6);
                 return;
             }
             break;
@@ -268,7 +277,14 @@ void BLEBridge::translateBLEtoInternalProtocol(uint8_t* cmd, size_t length) {
     }
     Serial.println();
     
-    teensySerial->write(packet, packetLen);
+    writeTeensy(packet, packetLen);
+}
+
+void BLEBridge::writeTeensy(const uint8_t* data, size_t length) {
+    if (linkLock) xSemaphoreTakeRecursive(linkLock, portMAX_DELAY);
+    if (beforeWrite) beforeWrite();
+    teensySerial->write(data, length);
+    if (linkLock) xSemaphoreGiveRecursive(linkLock);
 }
 
 bool BLEBridge::isConnected() {
@@ -42,6 +42,9 @@ private:
     bool deviceConnected;
     bool oldDeviceConnected;
     HardwareSerial* teensySerial;
+    SemaphoreHandle_t linkLock;          // Taken around UART writes, if set
+    void (*beforeWrite)();               // Called under linkLock before each write, if set
+    unsigned long disconnectedAt;
     
     // Command buffer for BLE protocol (0xD0...0xD1)
     static const int BLE_CMD_BUFFER_SIZE = 1024;
@@ -86,6 +89,12 @@ private:
 public:
     BLEBridge(HardwareSerial* serial);
     void setup();
+    // Writes from the BLE callbacks take this mutex so they do not interleave
+    // with frames from other tasks
+    void setLinkLock(SemaphoreHandle_t lock) { linkLock = lock; }
+    // Runs before each write, e.g. to send controls the firmware has queued
+    // so the Teensy sees them in order
+    void setBeforeWrite(void (*hook)()) { beforeWrite = hook; }
     void loop();
     void onBLEDataReceived(uint8_t* data, size_t length);
     bool isConnected();
@@ -94,6 +103,7 @@ public:
 private:
     void processBLECommand(uint8_t* cmd, size_t length);
     void translateBLEtoInternalProtocol(uint8_t* cmd, size_t length);
+    void writeTeensy(const uint8_t* data, size_t length);
 };
 
 #endif // BLE_BRIDGE_H
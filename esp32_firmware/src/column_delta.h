@@ -0,0 +1,245 @@
+/*
+ * Column Delta Tracker
+ *
+ * Remembers a hash of every column of the images last sent to a few Teensy
+ * slots, so re-sending an edited image can carry only the columns that
+ * changed (0x41) instead of the whole image.
+ *
+ * Images arrive row-major, so each column's hash is built up row by row:
+ * one FNV-1a state per column, fed the column's pixel from every row. This
+ * also works on a stream (an asset read from flash in chunks).
+ *
+ * plan() compares a new image with what the slot holds and collects the
+ * changed columns as ranges. It declines when the slot is not tracked at
+ * that size, when there are too many ranges, or when the patch would not
+ * be much smaller than a full upload. The patch names the image it was made
+ * against with a digest of the old column hashes. The Teensy checks that
+ * digest, so a slot changed some other way (SD load, BLE upload, reboot)
+ * is refused rather than patched wrongly.
+ */
+
+#ifndef COLUMN_DELTA_H
+#define COLUMN_DELTA_H
+
+#include <Arduino.h>
+
+#define DELTA_TRACKED_SLOTS 4
+#define DELTA_MAX_WIDTH 400
+#define DELTA_MAX_RANGES 64
+#define DELTA_PATCH_PCT 75          // Patch only below this share of a full upload
+#define DELTA_PATCH_HEADER 9        // slot width(2) height(2) base_digest(4)
+#define DELTA_RANGE_HEADER 4        // x(2) count(2)
+#define DELTA_FULL_HEADER 4         // 0x02: width(2) height(2)
+
+struct ColumnRange {
+  uint16_t x;
+  uint16_t count;
+};
+
+struct DeltaStats {
+  uint32_t patches;       // Patches the Teensy applied
+  uint32_t fullUploads;
+  uint32_t refused;       // Patches the Teensy refused (a full upload followed)
+  uint32_t columnsSent;   // Columns carried by applied patches
+  uint32_t bytesSent;     // Frame bytes of all uploads and patches
+  uint32_t bytesSaved;    // Full-upload bytes minus patch bytes, for applied patches
+};
+
+class ColumnDelta {
+public:
+  // Starts recording the columns of an image being sent to `slot`
+  void beginRecord(uint8_t slot, uint16_t width, uint16_t height) {
+    _recording = nullptr;
+    forget(slot);
+    if (width == 0 || width > DELTA_MAX_WIDTH || height == 0) return;
+    Tracked* t = freeEntry();
+    t->valid = false;  // Until the whole image has been seen
+    t->slot = slot;
+    t->width = width;
+    t->height = height;
+    t->lastUsed = ++_clock;
+    for (uint16_t x = 0; x < width; x++) t->hashes[x] = kFnvBasis;
+    _recording = t;
+    _recordPos = 0;
+  }
+
+  // Feeds the next bytes of the row-major RGB image being recorded
+  void recordBytes(const uint8_t* data, size_t len) {
+    if (!_recording) return;
+    hashBytes(_recording->hashes, _recording->width, _recordPos, data, len);
+    _recordPos += len;
+    _recording->valid = _recordPos >= (uint32_t)_recording->width * _recording->height * 3;
+  }
+
+  void record(uint8_t slot, uint16_t width, uint16_t height, const uint8_t* rgb, size_t len) {
+    beginRecord(slot, width, height);
+    recordBytes(rgb, len);
+    _recording = nullptr;
+  }
+
+  void forget(uint8_t slot) {
+    for (uint8_t i = 0; i < DELTA_TRACKED_SLOTS; i++) {
+      if (_tracked[i].valid && _tracked[i].slot == slot) _tracked[i].valid = false;
+    }
+  }
+
+  void forgetAll() {
+    for (uint8_t i = 0; i < DELTA_TRACKED_SLOTS; i++) _tracked[i].valid = false;
+    _recording = nullptr;
+  }
+
+  // Compares an image with what `slot` holds. Returns true if a patch is
+  // worth sending; ranges(), baseDigest() and patchBytes() then describe it.
+  bool plan(uint8_t slot, uint16_t width, uint16_t height, const uint8_t* rgb, size_t len) {
+    _planned = nullptr;
+    Tracked* t = find(slot);
+    if (!t || t->width != width || t->height != height || len < (uint32_t)width * height * 3) {
+      return false;
+    }
+
+    for (uint16_t x = 0; x < width; x++) _scratch[x] = kFnvBasis;
+    hashBytes(_scratch, width, 0, rgb, (size_t)width * height * 3);
+
+    _rangeCount = 0;
+    _changed = 0;
+    for (uint16_t x = 0; x < width; x++) {
+      if (_scratch[x] == t->hashes[x]) continue;
+      _changed++;
+      if (_rangeCount > 0 && _ranges[_rangeCount - 1].x + _ranges[_rangeCount - 1].count == x) {
+        _ranges[_rangeCount - 1].count++;
+      } else if (_rangeCount < DELTA_MAX_RANGES) {
+        _ranges[_rangeCount++] = { x, 1 };
+      } else {
+        return false;  // Scattered edits: a full upload is simpler
+      }
+    }
+
+    _patchBytes = DELTA_PATCH_HEADER + _rangeCount * DELTA_RANGE_HEADER +
+                  (uint32_t)_changed * height * 3;
+    _fullBytes = DELTA_FULL_HEADER + (uint32_t)width * height * 3;
+    if (_patchBytes * 100 >= _fullBytes * DELTA_PATCH_PCT || _patchBytes > 0xFFFF) return false;
+
+    _baseDigest = kFnvBasis;
+    for (uint16_t x = 0; x < width; x++) {
+      for (int b = 0; b < 32; b += 8) _baseDigest = (_baseDigest ^ ((t->hashes[x] >> b) & 0xFF)) * kFnvPrime;
+    }
+    _planned = t;
+    return true;
+  }
+
+  const ColumnRange* ranges() const { return _ranges; }
+  uint8_t rangeCount() const { return _rangeCount; }
+  uint16_t changedColumns() const { return _changed; }
+  uint32_t baseDigest() const { return _baseDigest; }
+  uint32_t patchBytes() const { return _patchBytes; }   // Payload of the 0x41 frame
+  uint32_t fullBytes() const { return _fullBytes; }     // Payload of the 0x02 upload it replaces
+
+  // The Teensy applied the planned patch: the slot now holds the new image
+  void accept() {
+    if (!_planned) return;
+    memcpy(_planned->hashes, _scratch, _planned->width * sizeof(uint32_t));
+    _planned->lastUsed = ++_clock;
+    _stats.patches++;
+    _stats.columnsSent += _changed;
+    _stats.bytesSent += _patchBytes;
+    _stats.bytesSaved += _fullBytes - _patchBytes;
+    _planned = nullptr;
+  }
+
+  // The Teensy refused the planned patch
+  void refuse() {
+    if (!_planned) return;
+    _stats.refused++;
+    _stats.bytesSent += _patchBytes;
+    _planned->valid = false;
+    _planned = nullptr;
+  }
+
+  void noteFullUpload(uint32_t bytes) {
+    _stats.fullUploads++;
+    _stats.bytesSent += bytes;
+  }
+
+  const DeltaStats& stats() const { return _stats; }
+  void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+  uint8_t trackedCount() const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < DELTA_TRACKED_SLOTS; i++) n += _tracked[i].valid ? 1 : 0;
+    return n;
+  }
+
+  // Slot and size of the i-th tracked image (i < trackedCount())
+  bool tracked(uint8_t i, uint8_t& slot, uint16_t& width, uint16_t& height) const {
+    for (uint8_t j = 0; j < DELTA_TRACKED_SLOTS; j++) {
+      if (!_tracked[j].valid) continue;
+      if (i-- == 0) {
+        slot = _tracked[j].slot;
+        width = _tracked[j].width;
+        height = _tracked[j].height;
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  static const uint32_t kFnvBasis = 2166136261u;
+  static const uint32_t kFnvPrime = 16777619u;
+
+  struct Tracked {
+    bool valid;
+    uint8_t slot;
+    uint16_t width;
+    uint16_t height;
+    uint32_t lastUsed;
+    uint32_t hashes[DELTA_MAX_WIDTH];
+  };
+
+  Tracked _tracked[DELTA_TRACKED_SLOTS] = {};
+  Tracked* _recording = nullptr;
+  uint32_t _recordPos = 0;
+  Tracked* _planned = nullptr;
+  uint32_t _scratch[DELTA_MAX_WIDTH];
+  ColumnRange _ranges[DELTA_MAX_RANGES];
+  uint8_t _rangeCount = 0;
+  uint16_t _changed = 0;
+  uint32_t _baseDigest = 0;
+  uint32_t _patchBytes = 0;
+  uint32_t _fullBytes = 0;
+  uint32_t _clock = 0;
+  DeltaStats _stats = {};
+
+  // Byte `pos` of a row-major image belongs to column (pos / 3) % width
+  static void hashBytes(uint32_t* hashes, uint16_t width, uint32_t pos, const uint8_t* data, size_t len) {
+    uint32_t pixel = pos / 3;
+    uint16_t x = pixel % width;
+    uint8_t channel = pos % 3;
+    for (size_t i = 0; i < len; i++) {
+      hashes[x] = (hashes[x] ^ data[i]) * kFnvPrime;
+      if (++channel == 3) {
+        channel = 0;
+        if (++x == width) x = 0;
+      }
+    }
+  }
+
+  Tracked* find(uint8_t slot) {
+    for (uint8_t i = 0; i < DELTA_TRACKED_SLOTS; i++) {
+      if (_tracked[i].valid && _tracked[i].slot == slot) return &_tracked[i];
+    }
+    return nullptr;
+  }
+
+  // An unused entry, or the least recently used one
+  Tracked* freeEntry() {
+    Tracked* oldest = &_tracked[0];
+    for (uint8_t i = 0; i < DELTA_TRACKED_SLOTS; i++) {
+      if (!_tracked[i].valid) return &_tracked[i];
+      if (_tracked[i].lastUsed < oldest->lastUsed) oldest = &_tracked[i];
+    }
+    return oldest;
+  }
+};
+
+#endif // COLUMN_DELTA_H
@@ -17,6 +17,8 @@
 
 #include <esp_now.h>
 #include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 // Protocol constants
 #define SYNC_MAGIC_0 0x4E  // 'N' for Nebula
@@ -134,7 +136,7 @@ public:
                  _onModeChange(nullptr), _onPattern(nullptr),
                  _onBrightness(nullptr), _onFrameRate(nullptr),
                  _onSyncTime(nullptr), _onPeerUpdate(nullptr),
-                 _autoPairEnabled(true), _timeOffset(0) {
+                 _autoPairEnabled(true), _timeOffset(0), _mutex(nullptr) {
     memset(_peers, 0, sizeof(_peers));
     memset(_localMac, 0, sizeof(_localMac));
     _localName[0] = '\0';
@@ -142,6 +144,10 @@ public:
 
   // Initialize ESP-NOW (call after WiFi.mode() is set)
   bool begin(const char* deviceName) {
+    // The peer table and sequence number are shared by the WiFi task's
+    // receive callback and every task that sends; see Guard below.
+    if (!_mutex) _mutex = xSemaphoreCreateRecursiveMutex();
+
     strncpy(_localName, deviceName, sizeof(_localName) - 1);
     _localName[sizeof(_localName) - 1] = '\0';
 
@@ -183,6 +189,7 @@ public:
 
   // Main loop - call from Arduino loop()
   void loop() {
+    Guard guard(_mutex);
     unsigned long now = millis();
 
     // Send heartbeat every 2 seconds
@@ -201,6 +208,7 @@ public:
 
   // Set sync mode
   void setSyncMode(SyncMode mode) {
+    Guard guard(_mutex);
     _syncMode = mode;
     Serial.printf("[SYNC] Sync mode: %s\n", mode == SYNC_MIRROR ? "MIRROR" : "INDEPENDENT");
   }
@@ -209,6 +217,7 @@ public:
 
   // Start pairing discovery (broadcast pair request)
   void startPairing() {
+    Guard guard(_mutex);
     Serial.println("[SYNC] Broadcasting pair request...");
 
     PairPayload payload;
@@ -225,6 +234,7 @@ public:
 
   // Unpair all peers
   void unpairAll() {
+    Guard guard(_mutex);
     for (int i = 0; i < _peerCount; i++) {
       if (_peers[i].state == PEER_PAIRED) {
         // Send unpair notification
@@ -240,6 +250,7 @@ public:
 
   // Unpair a specific peer by index
   void unpairPeer(int index) {
+    Guard guard(_mutex);
     if (index < 0 || index >= _peerCount) return;
     if (_peers[index].state == PEER_PAIRED) {
       sendMessage(_peers[index].mac, MSG_UNPAIR, nullptr, 0);
@@ -258,6 +269,7 @@ public:
   // These are the functions the main firmware calls when user changes settings
 
   void broadcastModeChange(uint8_t mode, uint8_t index) {
+    Guard guard(_mutex);
     if (_syncMode != SYNC_MIRROR || !hasPairedPeer()) return;
     ModePayload payload = { mode, index };
     broadcastToPeers(MSG_SET_MODE, (uint8_t*)&payload, sizeof(payload));
@@ -267,18 +279,21 @@ public:
                         uint8_t r1, uint8_t g1, uint8_t b1,
                         uint8_t r2, uint8_t g2, uint8_t b2,
                         uint8_t speed) {
+    Guard guard(_mutex);
     if (_syncMode != SYNC_MIRROR || !hasPairedPeer()) return;
     PatternPayload payload = { idx, type, r1, g1, b1, r2, g2, b2, speed };
     broadcastToPeers(MSG_SET_PATTERN, (uint8_t*)&payload, sizeof(payload));
   }
 
   void broadcastBrightness(uint8_t brightness) {
+    Guard guard(_mutex);
     if (_syncMode != SYNC_MIRROR || !hasPairedPeer()) return;
     BrightnessPayload payload = { brightness };
     broadcastToPeers(MSG_SET_BRIGHTNESS, (uint8_t*)&payload, sizeof(payload));
   }
 
   void broadcastFrameRate(uint8_t frameDelay) {
+    Guard guard(_mutex);
     if (_syncMode != SYNC_MIRROR || !hasPairedPeer()) return;
     FrameRatePayload payload = { frameDelay };
     broadcastToPeers(MSG_SET_FRAMERATE, (uint8_t*)&payload, sizeof(payload));
@@ -286,6 +301,7 @@ public:
 
   // Send command to a specific peer (for independent mode)
   void sendPeerModeChange(int peerIndex, uint8_t mode, uint8_t index) {
+    Guard guard(_mutex);
     if (peerIndex < 0 || peerIndex >= _peerCount) return;
     if (_peers[peerIndex].state != PEER_PAIRED) return;
     ModePayload payload = { mode, index };
@@ -296,6 +312,7 @@ public:
                        uint8_t r1, uint8_t g1, uint8_t b1,
                        uint8_t r2, uint8_t g2, uint8_t b2,
                        uint8_t speed) {
+    Guard guard(_mutex);
     if (peerIndex < 0 || peerIndex >= _peerCount) return;
     if (_peers[peerIndex].state != PEER_PAIRED) return;
     PatternPayload payload = { idx, type, r1, g1, b1, r2, g2, b2, speed };
@@ -303,6 +320,7 @@ public:
   }
 
   void sendPeerBrightness(int peerIndex, uint8_t brightness) {
+    Guard guard(_mutex);
     if (peerIndex < 0 || peerIndex >= _peerCount) return;
     if (_peers[peerIndex].state != PEER_PAIRED) return;
     BrightnessPayload payload = { brightness };
@@ -310,6 +328,7 @@ public:
   }
 
   void sendPeerFrameRate(int peerIndex, uint8_t frameDelay) {
+    Guard guard(_mutex);
     if (peerIndex < 0 || peerIndex >= _peerCount) return;
     if (_peers[peerIndex].state != PEER_PAIRED) return;
     FrameRatePayload payload = { frameDelay };
@@ -327,15 +346,20 @@ public:
   // Getters
   int getPeerCount() const { return _peerCount; }
   bool hasPairedPeer() const {
+    Guard guard(_mutex);
     for (int i = 0; i < _peerCount; i++) {
       if (_peers[i].state == PEER_PAIRED && _peers[i].online) return true;
     }
     return false;
   }
 
-  const SyncPeer* getPeer(int index) const {
-    if (index < 0 || index >= _peerCount) return nullptr;
-    return &_peers[index];
+  // Copies peer `index` out; the table can be compacted by another task
+  // as soon as the lock is released, so no pointer into it is handed out.
+  bool getPeer(int index, SyncPeer& out) const {
+    Guard guard(_mutex);
+    if (index < 0 || index >= _peerCount) return false;
+    out = _peers[index];
+    return true;
   }
 
   int32_t getTimeOffset() const { return _timeOffset; }
@@ -347,12 +371,14 @@ public:
   const char* getLocalName() const { return _localName; }
 
   void setLocalName(const char* name) {
+    Guard guard(_mutex);
     strncpy(_localName, name, sizeof(_localName) - 1);
     _localName[sizeof(_localName) - 1] = '\0';
   }
 
   // Set local state for heartbeat reporting
   void setLocalState(uint8_t mode, uint8_t index, uint8_t brightness, uint8_t frameDelay) {
+    Guard guard(_mutex);
     _localMode = mode;
     _localIndex = index;
     _localBrightness = brightness;
@@ -362,6 +388,19 @@ public:
 private:
   static ESPNowSync* _instance;
 
+  // Holds _mutex for a scope. Recursive, because public senders call each
+  // other (loop -> hasPairedPeer). Callbacks run under it, so they must not
+  // block on other locks; the firmware's only queue messages or log.
+  struct Guard {
+    SemaphoreHandle_t m;
+    explicit Guard(SemaphoreHandle_t mutex) : m(mutex) {
+      if (m) xSemaphoreTakeRecursive(m, portMAX_DELAY);
+    }
+    ~Guard() {
+      if (m) xSemaphoreGiveRecursive(m);
+    }
+  };
+
   SyncPeer _peers[MAX_SYNC_PEERS];
   int _peerCount;
   SyncMode _syncMode;
@@ -372,6 +411,7 @@ private:
   char _localName[32];
   int32_t _timeOffset;  // Offset to align with peer's millis()
   bool _autoPairEnabled;
+  SemaphoreHandle_t _mutex;
 
   // Local state for heartbeat
   uint8_t _localMode = 0;
@@ -498,6 +538,7 @@ private:
   // Handle incoming message
   void handleMessage(const uint8_t* mac, const uint8_t* data, int len) {
     if (len < 4) return;
+    Guard guard(_mutex);
     if (data[0] != SYNC_MAGIC_0 || data[1] != SYNC_MAGIC_1) return;
 
     uint8_t msgType = data[2];
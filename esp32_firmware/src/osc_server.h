@@ -0,0 +1,280 @@
+/*
+ * OSC Server
+ *
+ * Open Sound Control over UDP for live controllers (TouchOSC, Lemur,
+ * Max/MSP, lighting desks). A message is an address string, a type tag
+ * string and big-endian arguments, all padded to 4 bytes; a bundle is
+ * "#bundle", a time tag and size-prefixed elements, which may be bundles
+ * themselves. Bundle elements are dispatched on arrival: time tags are
+ * not scheduled.
+ *
+ * The server only parses. Each message goes to the message callback with
+ * its numeric arguments decoded as both int and float, so a handler can
+ * accept either a 0-255 integer or a 0.0-1.0 fader. The callback returns
+ * false for addresses it does not route, which are counted as unknown.
+ * Addresses are matched by the callback; OSC address patterns (* ? [])
+ * are not expanded.
+ */
+
+#ifndef OSC_SERVER_H
+#define OSC_SERVER_H
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <float.h>
+#include <math.h>
+#include "esp_timer.h"
+
+#define OSC_DEFAULT_PORT 8000
+#define OSC_MAX_PACKET 512
+#define OSC_MAX_ARGS 9
+#define OSC_MAX_PACKETS_PER_LOOP 8
+#define OSC_MAX_BUNDLE_DEPTH 4
+
+struct OscMessage {
+  const char* address;
+  uint8_t argc;                  // Arguments decoded (at most OSC_MAX_ARGS)
+  char types[OSC_MAX_ARGS];
+  int32_t ints[OSC_MAX_ARGS];    // i and h as is, f and d truncated (clamped), T 1, F 0
+  float floats[OSC_MAX_ARGS];    // f and d as is, i and h converted, T 1, F 0
+
+  bool isFloat(uint8_t n) const { return n < argc && (types[n] == 'f' || types[n] == 'd'); }
+  int32_t intArg(uint8_t n, int32_t fallback = 0) const { return n < argc ? ints[n] : fallback; }
+  float floatArg(uint8_t n, float fallback = 0) const { return n < argc ? floats[n] : fallback; }
+};
+
+struct OscStats {
+  uint32_t packets;
+  uint32_t messages;
+  uint32_t bundles;
+  uint32_t unknown;     // Addresses the callback did not route
+  uint32_t malformed;   // Packets that failed to parse (the rest of the packet is skipped)
+  uint32_t replies;
+};
+
+class OscServer {
+public:
+  typedef bool (*MessageCallback)(const OscMessage& msg);
+
+  void begin(uint16_t port) {
+    _port = port;
+    _udp.begin(port);
+    _started = true;
+  }
+
+  // Reopens the socket if it is already listening
+  void setPort(uint16_t port) {
+    if (port == _port || !_started) {
+      _port = port;
+      return;
+    }
+    _udp.stop();
+    begin(port);
+  }
+
+  void onMessage(MessageCallback cb) { _onMessage = cb; }
+  void setEnabled(bool enabled) { _enabled = enabled; }
+  bool enabled() const { return _enabled; }
+  uint16_t port() const { return _port; }
+  const OscStats& stats() const { return _stats; }
+  void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+  // When the packet being dispatched was read (esp_timer microseconds)
+  int64_t packetUs() const { return _packetUs; }
+
+  // Reads and dispatches waiting packets; call every few ms
+  void loop() {
+    if (!_started) return;
+    for (int i = 0; i < OSC_MAX_PACKETS_PER_LOOP; i++) {
+      int size = _udp.parsePacket();
+      if (size <= 0) break;
+      _packetUs = esp_timer_get_time();
+      _stats.packets++;
+      if (!_enabled || size > OSC_MAX_PACKET || (size & 3)) {
+        if (_enabled) _stats.malformed++;
+        _udp.flush();
+        continue;
+      }
+      int got = _udp.read(_packet, size);
+      if (got != size || !dispatch(_packet, size, 0)) _stats.malformed++;
+    }
+  }
+
+  // Answers the sender of the packet being dispatched with one int argument
+  void reply(const char* address, int32_t value) {
+    uint8_t out[64];
+    size_t len = strlen(address);
+    if (len + 12 > sizeof(out)) return;
+    memset(out, 0, sizeof(out));
+    memcpy(out, address, len);
+    size_t pos = padded(len + 1);
+    out[pos] = ',';
+    out[pos + 1] = 'i';
+    pos += 4;
+    writeBE32(&out[pos], (uint32_t)value);
+    pos += 4;
+    _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
+    _udp.write(out, pos);
+    _udp.endPacket();
+    _stats.replies++;
+  }
+
+private:
+  WiFiUDP _udp;
+  bool _started = false;
+  bool _enabled = true;
+  uint16_t _port = OSC_DEFAULT_PORT;
+  MessageCallback _onMessage = nullptr;
+  uint8_t _packet[OSC_MAX_PACKET];
+  int64_t _packetUs = 0;
+  OscStats _stats = {};
+
+  static size_t padded(size_t n) { return (n + 3) & ~(size_t)3; }
+
+  // Truncates a finite float argument, clamped to the int32_t range (an
+  // out-of-range conversion is undefined)
+  static int32_t toInt(double v) {
+    if (v >= 2147483647.0) return INT32_MAX;
+    if (v <= -2147483648.0) return INT32_MIN;
+    return (int32_t)v;
+  }
+
+  static uint32_t readBE32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+  }
+
+  static void writeBE32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+  }
+
+  // Offset just past the padded string at `pos`, or 0 if it is not terminated
+  static size_t skipString(const uint8_t* p, size_t len, size_t pos) {
+    for (size_t i = pos; i < len; i++) {
+      if (p[i] == 0) return padded(i + 1);
+    }
+    return 0;
+  }
+
+  bool dispatch(const uint8_t* p, size_t len, uint8_t depth) {
+    if (len >= 16 && memcmp(p, "#bundle", 8) == 0) {
+      if (depth >= OSC_MAX_BUNDLE_DEPTH) return false;
+      _stats.bundles++;
+      size_t pos = 16;  // "#bundle\0" and the time tag
+      while (pos < len) {
+        if (pos + 4 > len) return false;
+        uint32_t size = readBE32(&p[pos]);
+        pos += 4;
+        if (size == 0 || size > len - pos || (size & 3)) return false;
+        if (!dispatch(&p[pos], size, depth + 1)) return false;
+        pos += size;
+      }
+      return true;
+    }
+    return parseMessage(p, len);
+  }
+
+  bool parseMessage(const uint8_t* p, size_t len) {
+    if (len < 4 || p[0] != '/') return false;
+    size_t pos = skipString(p, len, 0);
+    if (pos == 0 || pos > len) return false;
+
+    OscMessage msg;
+    msg.address = (const char*)p;
+    msg.argc = 0;
+
+    // Type tags are optional in OSC 1.0; without them there are no arguments
+    if (pos < len) {
+      if (p[pos] != ',') return false;
+      const char* tags = (const char*)&p[pos + 1];
+      pos = skipString(p, len, pos);
+      if (pos == 0 || pos > len) return false;
+
+      for (const char* t = tags; *t; t++) {
+        int32_t i = 0;
+        float f = 0;
+        switch (*t) {
+          case 'i':
+            if (pos + 4 > len) return false;
+            i = (int32_t)readBE32(&p[pos]);
+            f = (float)i;
+            pos += 4;
+            break;
+          case 'f': {
+            if (pos + 4 > len) return false;
+            uint32_t bits = readBE32(&p[pos]);
+            memcpy(&f, &bits, 4);
+            if (!isfinite(f)) return false;
+            i = toInt(f);
+            pos += 4;
+            break;
+          }
+          case 'h':
+          case 'd': {
+            if (pos + 8 > len) return false;
+            uint64_t bits = ((uint64_t)readBE32(&p[pos]) << 32) | readBE32(&p[pos + 4]);
+            if (*t == 'h') {
+              i = (int32_t)(int64_t)bits;
+              f = (float)(int64_t)bits;
+            } else {
+              double d;
+              memcpy(&d, &bits, 8);
+              if (!isfinite(d)) return false;
+              f = (float)constrain(d, -(double)FLT_MAX, (double)FLT_MAX);
+              i = toInt(d);
+            }
+            pos += 8;
+            break;
+          }
+          case 'T':
+            i = 1;
+            f = 1;
+            break;
+          case 'F':
+          case 'N':
+          case 'I':
+            break;
+          case 't':
+            if (pos + 8 > len) return false;
+            pos += 8;
+            break;
+          case 'c':
+          case 'r':
+          case 'm':
+            if (pos + 4 > len) return false;
+            pos += 4;
+            break;
+          case 's':
+          case 'S':
+            pos = skipString(p, len, pos);
+            if (pos == 0 || pos > len) return false;
+            break;
+          case 'b': {
+            if (pos + 4 > len) return false;
+            uint32_t size = readBE32(&p[pos]);
+            if (size > len - pos - 4) return false;
+            pos += 4 + padded(size);
+            if (pos > len) return false;
+            break;
+          }
+          default:
+            return false;  // Unknown tag: the argument size is unknown too
+        }
+        if (msg.argc < OSC_MAX_ARGS) {
+          msg.types[msg.argc] = *t;
+          msg.ints[msg.argc] = i;
+          msg.floats[msg.argc] = f;
+          msg.argc++;
+        }
+      }
+    }
+
+    _stats.messages++;
+    if (!_onMessage || !_onMessage(msg)) _stats.unknown++;
+    return true;
+  }
+};
+
+#endif // OSC_SERVER_H
@@ -0,0 +1,489 @@
+/*
+ * DDP / Art-Net / E1.31 Pixel Ingest
+ *
+ * Lets lighting and VJ software drive live mode over UDP. The poi looks like
+ * one 32-pixel RGB fixture (96 channels); every frame the software sends
+ * becomes the next live column on the Teensy.
+ *
+ *   DDP     port 4048   pixel data from byte offset 0, frame ends on PUSH
+ *   Art-Net port 6454   ArtDmx on one universe from a start address;
+ *                       ArtPoll is answered so consoles can find the node
+ *   E1.31   port 5568   data on one universe, unicast or multicast
+ *                       (239.255.<hi>.<lo>); preview packets are ignored
+ *
+ * Frames go through a small jitter buffer ordered by the packet sequence
+ * number. A frame is played out once it has waited `jitterMs` or when more
+ * than `depth` frames are queued, so reordered packets are put back in
+ * order. Frames older than the last one played are dropped as late.
+ * Sequence gaps count as lost packets until the packet turns up. Packet
+ * data is read straight into its buffer slot and handed to the column
+ * callback from there.
+ *
+ * One source at a time: the first protocol to deliver a frame owns the
+ * stream until it has been quiet for INGEST_STREAM_TIMEOUT_MS.
+ */
+
+#ifndef PIXEL_INGEST_H
+#define PIXEL_INGEST_H
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+#define INGEST_DDP_PORT 4048
+#define INGEST_ARTNET_PORT 6454
+#define INGEST_E131_PORT 5568
+#define INGEST_PIXELS 32
+#define INGEST_FRAME_BYTES (INGEST_PIXELS * 3)
+#define INGEST_SLOTS 8
+#define INGEST_MAX_PACKETS_PER_LOOP 8
+#define INGEST_MAX_PLAYOUT_PER_LOOP 2
+#define INGEST_STREAM_TIMEOUT_MS 2000
+
+// DDP header: flags seq type id offset(4) length(2) [timecode(4)]
+#define DDP_HEADER_BYTES 10
+#define DDP_FLAG_VERSION_MASK 0xC0
+#define DDP_FLAG_VERSION_1 0x40
+#define DDP_FLAG_TIMECODE 0x10
+#define DDP_FLAG_QUERY 0x02
+#define DDP_FLAG_PUSH 0x01
+#define DDP_ID_STATUS_FIRST 246   // 246-255: control, config and status
+
+// Art-Net: "Art-Net\0" opcode(LE) ...
+#define ARTNET_OP_POLL 0x2000
+#define ARTNET_OP_POLL_REPLY 0x2100
+#define ARTNET_OP_DMX 0x5000
+#define ARTNET_DMX_HEADER_BYTES 18
+#define ARTNET_POLL_REPLY_BYTES 239
+
+// E1.31 (sACN) data packet up to the DMX start code
+#define E131_HEADER_BYTES 126
+#define E131_OPTION_PREVIEW 0x80
+#define E131_OPTION_TERMINATED 0x40
+
+enum IngestSource : uint8_t {
+  INGEST_NONE = 0,
+  INGEST_DDP = 1,
+  INGEST_ARTNET = 2,
+  INGEST_E131 = 3
+};
+
+struct IngestStats {
+  uint32_t packets;       // Datagrams read on any port
+  uint32_t streamPackets; // Packets of the stream that carried a sequence number
+  uint32_t frames;        // Columns forwarded
+  uint32_t lost;          // Sequence numbers never received
+  uint32_t late;          // Frames that arrived after their turn
+  uint32_t duplicates;
+  uint32_t overflows;     // Frames played early because the buffer was full
+  uint32_t malformed;
+  uint32_t ignored;       // Other universes, or a second source while one streams
+  uint16_t fps;           // Frames forwarded in the last full second
+  uint16_t rxFps;         // Frames received in the last full second
+  uint8_t depthPeak;      // Most frames buffered at once
+  uint32_t worstHoldUs;   // Longest time a frame spent in the buffer
+};
+
+class PixelIngest {
+public:
+  typedef void (*ColumnCallback)(const uint8_t* rgb, size_t len);
+  typedef void (*StreamCallback)(IngestSource source);
+
+  // Opens the three UDP ports; call after WiFi is up
+  void begin(const char* nodeName) {
+    strncpy(_nodeName, nodeName, sizeof(_nodeName) - 1);
+    _nodeName[sizeof(_nodeName) - 1] = '\0';
+    _ddp.begin(INGEST_DDP_PORT);
+    _artnet.begin(INGEST_ARTNET_PORT);
+    joinE131();
+    _started = true;
+  }
+
+  void onColumn(ColumnCallback cb) { _onColumn = cb; }
+  void onStreamStart(StreamCallback cb) { _onStreamStart = cb; }
+
+  void setEnabled(bool enabled) {
+    _enabled = enabled;
+    if (!enabled) endStream();
+  }
+  bool enabled() const { return _enabled; }
+
+  // Art-Net universe 0-32767, E1.31 universe 1-63999, DMX address 1-417
+  void setUniverses(uint16_t artnetUniverse, uint16_t e131Universe) {
+    _artnetUniverse = artnetUniverse & 0x7FFF;
+    bool rejoin = e131Universe != _e131Universe;
+    _e131Universe = e131Universe;
+    if (rejoin && _started) {
+      _e131.stop();
+      joinE131();
+    }
+  }
+  void setAddress(uint16_t address) {
+    if (address < 1) address = 1;
+    if (address > 512 - INGEST_FRAME_BYTES + 1) address = 512 - INGEST_FRAME_BYTES + 1;
+    _address = address;
+  }
+  void setJitter(uint16_t jitterMs, uint8_t depth) {
+    _jitterUs = (uint32_t)jitterMs * 1000;
+    if (depth < 1) depth = 1;
+    if (depth > INGEST_SLOTS - 1) depth = INGEST_SLOTS - 1;
+    _depth = depth;
+  }
+
+  uint16_t artnetUniverse() const { return _artnetUniverse; }
+  uint16_t e131Universe() const { return _e131Universe; }
+  uint16_t address() const { return _address; }
+  uint16_t jitterMs() const { return _jitterUs / 1000; }
+  uint8_t depth() const { return _depth; }
+  IngestSource source() const { return _source; }
+  const IngestStats& stats() const { return _stats; }
+  void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+  // Reads waiting datagrams and plays out due frames; call every few ms
+  void loop() {
+    if (!_started) return;
+    for (int i = 0; i < INGEST_MAX_PACKETS_PER_LOOP; i++) {
+      bool any = false;
+      if (_ddp.parsePacket() > 0) { readDdp(); any = true; }
+      if (_artnet.parsePacket() > 0) { readArtnet(); any = true; }
+      if (_e131.parsePacket() > 0) { readE131(); any = true; }
+      if (!any) break;
+    }
+
+    uint32_t nowUs = micros();
+    for (int i = 0; i < INGEST_MAX_PLAYOUT_PER_LOOP && _count > 0; i++) {
+      int oldest = oldestSlot();
+      if (_count <= _depth && nowUs - _slots[oldest].arrivedUs < _jitterUs) break;
+      playOut(oldest);
+    }
+
+    uint32_t nowMs = millis();
+    if (nowMs - _rateWindowMs >= 1000) {
+      _stats.fps = _framesInWindow;
+      _stats.rxFps = _rxInWindow;
+      _framesInWindow = _rxInWindow = 0;
+      _rateWindowMs = nowMs;
+    }
+    if (_source != INGEST_NONE && nowMs - _lastFrameMs > INGEST_STREAM_TIMEOUT_MS) {
+      endStream();
+    }
+  }
+
+private:
+  struct Slot {
+    uint8_t rgb[INGEST_FRAME_BYTES];
+    int32_t seq;
+    uint32_t arrivedUs;
+    bool full;
+  };
+
+  WiFiUDP _ddp;
+  WiFiUDP _artnet;
+  WiFiUDP _e131;
+  bool _started = false;
+  bool _enabled = true;
+  char _nodeName[18] = "POV Poi";
+  uint16_t _artnetUniverse = 0;
+  uint16_t _e131Universe = 1;
+  uint16_t _address = 1;
+  uint32_t _jitterUs = 20000;
+  uint8_t _depth = 2;
+  ColumnCallback _onColumn = nullptr;
+  StreamCallback _onStreamStart = nullptr;
+
+  Slot _slots[INGEST_SLOTS] = {};
+  uint8_t _count = 0;
+  int _ddpOpen = -1;            // Slot a multi-packet DDP frame is filling
+  IngestSource _source = INGEST_NONE;
+  bool _haveSeq = false;
+  uint16_t _lastRawSeq = 0;
+  int32_t _lastSeq = 0;         // Unwrapped sequence of the newest frame
+  bool _havePlayed = false;
+  int32_t _playedSeq = 0;       // Unwrapped sequence of the last frame played
+  uint32_t _lastFrameMs = 0;
+  uint32_t _rateWindowMs = 0;
+  uint16_t _framesInWindow = 0;
+  uint16_t _rxInWindow = 0;
+  IngestStats _stats = {};
+
+  void joinE131() {
+    IPAddress group(239, 255, _e131Universe >> 8, _e131Universe & 0xFF);
+    _e131.beginMulticast(group, INGEST_E131_PORT);  // Also receives unicast
+  }
+
+  void endStream() {
+    for (int i = 0; i < INGEST_SLOTS; i++) _slots[i].full = false;
+    _count = 0;
+    _ddpOpen = -1;
+    _source = INGEST_NONE;
+    _haveSeq = false;
+    _havePlayed = false;
+  }
+
+  static void skip(WiFiUDP& udp, int bytes) {
+    uint8_t scratch[64];
+    while (bytes > 0) {
+      int n = udp.read(scratch, bytes < (int)sizeof(scratch) ? bytes : (int)sizeof(scratch));
+      if (n <= 0) return;
+      bytes -= n;
+    }
+  }
+
+  // Claims the stream for `source`; false while another source owns it
+  bool claim(IngestSource source) {
+    if (!_enabled) return false;
+    if (_source == source) return true;
+    if (_source != INGEST_NONE) {
+      _stats.ignored++;
+      return false;
+    }
+    _source = source;
+    if (_onStreamStart) _onStreamStart(source);
+    return true;
+  }
+
+  // Maps a protocol sequence number with period `modulus` onto a running
+  // counter; older numbers unwrap backwards. With zeroUnused, 0 means the
+  // sender does not number its packets and arrival order is used. Gaps are
+  // counted as lost and taken back when the missing packet arrives.
+  int32_t unwrapSeq(uint16_t raw, uint16_t modulus, bool zeroUnused) {
+    if (zeroUnused) {
+      if (raw == 0) {
+        _haveSeq = true;
+        return ++_lastSeq;
+      }
+      raw -= 1;
+    }
+    _stats.streamPackets++;
+    if (!_haveSeq) {
+      _haveSeq = true;
+      _lastRawSeq = raw;
+      return ++_lastSeq;
+    }
+    int32_t diff = (int32_t)((raw + modulus - _lastRawSeq) % modulus);
+    if (diff >= modulus / 2) diff -= modulus;
+    int32_t seq = _lastSeq + diff;
+    if (diff > 1) {
+      _stats.lost += diff - 1;
+    } else if (diff < 0 && _stats.lost > 0) {
+      _stats.lost--;
+    }
+    if (diff > 0) {
+      _lastRawSeq = raw;
+      _lastSeq = seq;
+    }
+    return seq;
+  }
+
+  int oldestSlot() const {
+    int oldest = -1;
+    for (int i = 0; i < INGEST_SLOTS; i++) {
+      if (_slots[i].full && (oldest < 0 || _slots[i].seq < _slots[oldest].seq)) oldest = i;
+    }
+    return oldest;
+  }
+
+  // Slot for a new frame, or -1 if the frame is late or a duplicate
+  int acceptFrame(int32_t seq) {
+    if (_havePlayed && seq <= _playedSeq) {
+      _stats.late++;
+      return -1;
+    }
+    int freeSlot = -1;
+    for (int i = 0; i < INGEST_SLOTS; i++) {
+      if (_slots[i].full && _slots[i].seq == seq) {
+        _stats.duplicates++;
+        return -1;
+      }
+      if (!_slots[i].full && i != _ddpOpen && freeSlot < 0) freeSlot = i;
+    }
+    if (freeSlot < 0) {
+      freeSlot = oldestSlot();
+      _stats.overflows++;
+      playOut(freeSlot);
+      if (seq <= _playedSeq) {
+        _stats.late++;
+        return -1;
+      }
+    }
+    return freeSlot;
+  }
+
+  void commit(int slot, int32_t seq) {
+    Slot& s = _slots[slot];
+    s.seq = seq;
+    s.arrivedUs = micros();
+    s.full = true;
+    _count++;
+    if (_count > _stats.depthPeak) _stats.depthPeak = _count;
+    _rxInWindow++;
+    _lastFrameMs = millis();
+  }
+
+  void playOut(int slot) {
+    Slot& s = _slots[slot];
+    _havePlayed = true;
+    _playedSeq = s.seq;
+    uint32_t heldUs = micros() - s.arrivedUs;
+    if (heldUs > _stats.worstHoldUs) _stats.worstHoldUs = heldUs;
+    if (_onColumn) _onColumn(s.rgb, INGEST_FRAME_BYTES);
+    s.full = false;
+    _count--;
+    _stats.frames++;
+    _framesInWindow++;
+  }
+
+  // Reads `len` channel bytes starting at channel `first` (0-based) of the
+  // packet's remaining data into a slot
+  void readChannels(WiFiUDP& udp, int slot, uint32_t first, uint32_t len) {
+    uint8_t* rgb = _slots[slot].rgb;
+    if (first >= INGEST_FRAME_BYTES) return;
+    uint32_t n = len < INGEST_FRAME_BYTES - first ? len : INGEST_FRAME_BYTES - first;
+    udp.read(&rgb[first], n);
+  }
+
+  void readDdp() {
+    _stats.packets++;
+    uint8_t h[DDP_HEADER_BYTES + 4];
+    if (_ddp.read(h, DDP_HEADER_BYTES) != DDP_HEADER_BYTES ||
+        (h[0] & DDP_FLAG_VERSION_MASK) != DDP_FLAG_VERSION_1) {
+      _stats.malformed++;
+      return;
+    }
+    if ((h[0] & DDP_FLAG_QUERY) || h[3] >= DDP_ID_STATUS_FIRST) return;  // No status replies
+    if ((h[0] & DDP_FLAG_TIMECODE) && _ddp.read(&h[DDP_HEADER_BYTES], 4) != 4) {
+      _stats.malformed++;
+      return;
+    }
+    if (!claim(INGEST_DDP)) return;
+
+    // Every packet is numbered (1-15), so loss counts packets, not frames
+    int32_t seq = unwrapSeq(h[1] & 0x0F, 15, true);
+    uint32_t offset = ((uint32_t)h[4] << 24) | ((uint32_t)h[5] << 16) | ((uint32_t)h[6] << 8) | h[7];
+    uint16_t length = ((uint16_t)h[8] << 8) | h[9];
+    bool push = h[0] & DDP_FLAG_PUSH;
+    bool ends = offset + length >= INGEST_FRAME_BYTES;
+
+    // A frame takes a slot at its first packet and is committed, numbered
+    // by its last one, at PUSH or once it covers all our pixels. Packets
+    // past our pixels then only finish the sender's frame.
+    if (_ddpOpen < 0) {
+      if (offset >= INGEST_FRAME_BYTES) return;
+      _ddpOpen = acceptFrame(seq);
+      if (_ddpOpen < 0) return;
+      memset(_slots[_ddpOpen].rgb, 0, INGEST_FRAME_BYTES);
+    }
+    readChannels(_ddp, _ddpOpen, offset, length);
+    if (!push && !ends) return;
+
+    int slot = _ddpOpen;
+    _ddpOpen = -1;
+    commit(slot, seq);
+  }
+
+  void readArtnet() {
+    _stats.packets++;
+    uint8_t h[ARTNET_DMX_HEADER_BYTES];
+    int got = _artnet.read(h, sizeof(h));
+    if (got < 10 || memcmp(h, "Art-Net", 8) != 0) {
+      _stats.malformed++;
+      return;
+    }
+    uint16_t op = h[8] | (h[9] << 8);
+    if (op == ARTNET_OP_POLL) {
+      sendArtPollReply();
+      return;
+    }
+    if (op != ARTNET_OP_DMX) return;
+    if (got < ARTNET_DMX_HEADER_BYTES) {
+      _stats.malformed++;
+      return;
+    }
+    uint16_t universe = ((h[15] & 0x7F) << 8) | h[14];
+    uint16_t length = ((uint16_t)h[16] << 8) | h[17];
+    if (universe != _artnetUniverse || length < _address - 1 + INGEST_FRAME_BYTES) {
+      _stats.ignored++;
+      return;
+    }
+    if (!claim(INGEST_ARTNET)) return;
+
+    // Sequence 1-255, 0 = sender does not number its packets
+    int32_t seq = unwrapSeq(h[12], 255, true);
+    int slot = acceptFrame(seq);
+    if (slot < 0) return;
+    skip(_artnet, _address - 1);
+    readChannels(_artnet, slot, 0, INGEST_FRAME_BYTES);
+    commit(slot, seq);
+  }
+
+  void readE131() {
+    _stats.packets++;
+    uint8_t h[E131_HEADER_BYTES];
+    if (_e131.read(h, sizeof(h)) != E131_HEADER_BYTES ||
+        memcmp(&h[4], "ASC-E1.17\0\0\0", 12) != 0 ||
+        h[21] != 0x04 || h[43] != 0x02 || h[117] != 0x02) {
+      _stats.malformed++;
+      return;
+    }
+    uint8_t options = h[112];
+    uint16_t universe = ((uint16_t)h[113] << 8) | h[114];
+    uint16_t values = ((uint16_t)h[123] << 8) | h[124];  // Start code + channels
+    if (universe != _e131Universe || h[125] != 0x00 || (options & E131_OPTION_PREVIEW)) {
+      _stats.ignored++;
+      return;
+    }
+    if (options & E131_OPTION_TERMINATED) {
+      if (_source == INGEST_E131) endStream();
+      return;
+    }
+    if (values < _address + INGEST_FRAME_BYTES) {
+      _stats.ignored++;
+      return;
+    }
+    if (!claim(INGEST_E131)) return;
+
+    int32_t seq = unwrapSeq(h[111], 256, false);
+    int slot = acceptFrame(seq);
+    if (slot < 0) return;
+    skip(_e131, _address - 1);
+    readChannels(_e131, slot, 0, INGEST_FRAME_BYTES);
+    commit(slot, seq);
+  }
+
+  // Minimal ArtPollReply: one DMX output port on the configured universe
+  void sendArtPollReply() {
+    uint8_t r[ARTNET_POLL_REPLY_BYTES];
+    memset(r, 0, sizeof(r));
+    IPAddress remote = _artnet.remoteIP();
+    IPAddress ap = WiFi.softAPIP();
+    bool viaAp = remote[0] == ap[0] && remote[1] == ap[1] && remote[2] == ap[2];
+    IPAddress ip = viaAp ? ap : WiFi.localIP();
+
+    memcpy(r, "Art-Net", 8);
+    r[8] = ARTNET_OP_POLL_REPLY & 0xFF;
+    r[9] = ARTNET_OP_POLL_REPLY >> 8;
+    for (int i = 0; i < 4; i++) r[10 + i] = ip[i];
+    r[14] = INGEST_ARTNET_PORT & 0xFF;
+    r[15] = INGEST_ARTNET_PORT >> 8;
+    r[18] = (_artnetUniverse >> 8) & 0x7F;       // Net
+    r[19] = (_artnetUniverse >> 4) & 0x0F;       // Sub-net
+    r[23] = 0xD0;                                // Status1: indicators normal, network configured
+    strncpy((char*)&r[26], _nodeName, 17);       // Short name
+    strncpy((char*)&r[44], _nodeName, 63);       // Long name
+    r[173] = 1;                                  // One port
+    r[174] = 0x80;                               // Output, DMX512
+    r[182] = 0x80;                               // Data being output
+    r[190] = _artnetUniverse & 0x0F;             // SwOut
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    memcpy(&r[201], mac, 6);
+    for (int i = 0; i < 4; i++) r[207 + i] = ip[i];
+    r[211] = 1;                                  // Bind index
+    r[212] = 0x08;                               // Status2: 15-bit port addresses
+
+    _artnet.beginPacket(remote, INGEST_ARTNET_PORT);
+    _artnet.write(r, sizeof(r));
+    _artnet.endPacket();
+  }
+};
+
+#endif // PIXEL_INGEST_H
@@ -33,6 +33,7 @@ const DISPLAY_MODES = [
   { id: 2, label: 'Pattern', icon: Sparkles },
   { id: 3, label: 'Sequence', icon: Layers },
   { id: 4, label: 'Live', icon: Activity },
+  { id: 5, label: 'SD', icon: HardDrive },
 ];
 
 const PATTERNS = [
@@ -54,6 +55,9 @@ const PATTERNS = [
   { id: 15, label: 'Audio Sparkle', group: 'audio' },
   { id: 16, label: 'Split Spin',    group: 'advanced' },
   { id: 17, label: 'Theater Chase', group: 'advanced' },
+  { id: 18, label: 'Fireworks',     group: 'advanced' },
+  { id: 19, label: 'Rain',          group: 'advanced' },
+  { id: 20, label: 'Sparks',        group: 'advanced' },
 ];
 
 const SD_API_TIMEOUT_MS = 3000;
@@ -80,6 +84,8 @@ const Dashboard: React.FC<DashboardProps> = ({ previewUrl }) => {
   const [contentIndex, setContentIndex] = useState<number>(0);
   const [currentPattern, setCurrentPattern] = useState<number>(0);
   const [localFrameRate, setLocalFrameRate] = useState<number>(60);
+  const [localDuty, setLocalDuty] = useState<number>(100);
+  const [dutyPowerText, setDutyPowerText] = useState<string>('');
   const [powerMode, setPowerModeState] = useState<PowerMode>('balanced');
   const [maxContentIndex, setMaxContentIndex] = useState<number>(49);
 
@@ -93,6 +99,7 @@ const Dashboard: React.FC<DashboardProps> = ({ previewUrl }) => {
   const fileInputRef = useRef<HTMLInputElement>(null);
   const lastBrightnessInteraction = useRef<number>(0);
   const lastFrameRateInteraction = useRef<number>(0);
+  const lastDutyInteraction = useRef<number>(0);
   const lastModeInteraction = useRef<number>(0);
 
   const activeDevice = devices.find(d => d.id === selectedDeviceId) || devices[0];
@@ -133,6 +140,7 @@ const Dashboard: React.FC<DashboardProps> = ({ previewUrl }) => {
           if (typeof data.mode === 'number' && now - lastModeInteraction.current > 1000) setCurrentMode(data.mode);
           if (typeof data.brightness === 'number' && now - lastBrightnessInteraction.current > 1000) setLocalBrightness(data.brightness);
           if (typeof data.framerate === 'number' && now - lastFrameRateInteraction.current > 1000) setLocalFrameRate(data.framerate);
+          if (typeof data.duty === 'number' && now - lastDutyInteraction.current > 1000) setLocalDuty(data.duty);
           if (typeof data.count === 'number' && data.count > 0) setMaxContentIndex(data.count - 1);
           if (typeof data.sdCardPresent === 'boolean') setSdPresent(data.sdCardPresent);
           if (typeof data.index === 'number' && now - lastModeInteraction.current > 1000) setContentIndex(data.index);
@@ -193,12 +201,22 @@ const Dashboard: React.FC<DashboardProps> = ({ previewUrl }) => {
       const res = await fetch(`${base}/api/sd/load`, {
         method: 'POST',
         headers: { 'Content-Type': 'application/json' },
-        body: JSON.stringify({ filename: file }),
+        body: JSON.stringify({ filename: file, slot: 0, show: true }),
       });
       if (res.ok) {
-        addLog(`[SD] Loaded "${file}" from SD card`, 'text-green-400');
-        setCurrentMode(1);
-        setContentIndex(0);
+        // The Teensy loads in the background; poll for the completion event
+        let result = { state: 'loading' } as { state: string; totalUs?: number };
+        for (let i = 0; i < 20 && result.state === 'loading'; i++) {
+          await new Promise(resolve => setTimeout(resolve, 250));
+          result = await (await fetch(`${base}/api/sd/load`)).json();
+        }
+        if (result.state === 'done') {
+          addLog(`[SD] Loaded "${file}" from SD card in ${Math.round((result.totalUs ?? 0) / 1000)} ms`, 'text-green-400');
+          setCurrentMode(1);
+          setContentIndex(0);
+        } else {
+          addLog(`[SD] Failed to load "${file}": ${result.state}`, 'text-red-400');
+        }
       } else {
         addLog(`[SD] Failed to load "${file}": ${res.status}`, 'text-red-400');
       }
@@ -286,6 +304,62 @@ const Dashboard: React.FC<DashboardProps> = ({ previewUrl }) => {
     300
   );
 
+  const debouncedDutyUpdate = useDebounce(
+    useCallback(async (duty: number) => {
+      const targets = isSyncModeRef.current ? devicesRef.current : [activeDeviceRef.current];
+      for (const dev of targets) {
+        try {
+          const base = getDeviceBase(dev.ip);
+          const res = await fetch(`${base}/api/duty`, {
+            method: 'POST',
+            headers: { 'Content-Type': 'application/json' },
+            body: JSON.stringify({ duty }),
+          });
+          if (res.ok) {
+            addLog(`[OK] Column duty set to ${duty}% on ${dev.name}`, 'text-green-400');
+          } else {
+            const errText = await res.text();
+            addLog(`[Error] Column duty set failed on ${dev.name}: ${res.status} ${errText}`, 'text-red-400');
+          }
+        } catch {
+          addLog(`[Error] Failed to set column duty on ${dev.name}`, 'text-red-400');
+        }
+      }
+    }, []),
+    300
+  );
+
+  const handleDutyChange = (value: number) => {
+    lastDutyInteraction.current = Date.now();
+    setLocalDuty(value);
+    debouncedDutyUpdate(value);
+  };
+
+  // A/B current measurement on the Teensy: ~1.5 s at 100% duty, then ~1.5 s at the set duty
+  const measureDutyPower = async () => {
+    const base = getDeviceBase(activeDevice.ip);
+    try {
+      let data = await (await fetch(`${base}/api/duty/power`, { method: 'POST' })).json();
+      if (data.state === 'unavailable') {
+        setDutyPowerText('INA219 not detected');
+        return;
+      }
+      setDutyPowerText('Measuring...');
+      for (let i = 0; i < 10 && data.state !== 'done'; i++) {
+        await new Promise(resolve => setTimeout(resolve, 500));
+        data = await (await fetch(`${base}/api/duty/power`)).json();
+      }
+      if (data.state !== 'done') {
+        setDutyPowerText('Measurement timed out');
+        return;
+      }
+      setDutyPowerText(`100%: ${data.fullDutyMa} mA · ${data.duty}%: ${data.dutyMa} mA (−${data.savedPercent ?? 0}%)`);
+      addLog(`[OK] Duty ${data.duty}% saves ${data.savedMa ?? 0} mA on ${activeDevice.name}`, 'text-green-400');
+    } catch {
+      setDutyPowerText('Measurement failed');
+    }
+  };
+
   const handleBrightnessChange = (value: number) => {
     lastBrightnessInteraction.current = Date.now();
     setLocalBrightness(value);
@@ -330,25 +404,21 @@ const Dashboard: React.FC<DashboardProps> = ({ previewUrl }) => {
     for (const dev of targets) {
       try {
         const base = getDeviceBase(dev.ip);
-        const resPattern = await fetch(`${base}/api/pattern`, {
-          method: 'POST',
-          headers: { 'Content-Type': 'application/json' },
-          // Keep pattern storage index aligned with selected pattern ID.
-          // Teensy displays `patterns[currentIndex]`, so missing index causes dark slots.
-          body: JSON.stringify({ index: patternId, type: patternId, speed: 50 }),
-        });
-        if (!resPattern.ok) {
-          const errText = await resPattern.text();
-          throw new Error(`HTTP ${resPattern.status} ${errText}`);
-        }
-        const resMode = await fetch(`${base}/api/mode`, {
+        // Pattern config and mode switch go to the Teensy as one batch frame.
+        // Keep pattern storage index aligned with selected pattern ID.
+        // Teensy displays `patterns[currentIndex]`, so missing index causes dark slots.
+        const res = await fetch(`${base}/api/batch`, {
           method: 'POST',
           headers: { 'Content-Type': 'application/json' },
-          body: JSON.stringify({ mode: 2, index: patternId }),
+          body: JSON.stringify({
+            pattern: { index: patternId, type: patternId, speed: 50 },
+            mode: 2,
+            index: patternId,
+          }),
         });
-        if (!resMode.ok) {
-          const errText = await resMode.text();
-          throw new Error(`HTTP ${resMode.status} ${errText}`);
+        if (!res.ok) {
+          const errText = await res.text();
+          throw new Error(`HTTP ${res.status} ${errText}`);
         }
         addLog(`[OK] Pattern → ${PATTERNS[patternId]?.label} on ${dev.name}`, 'text-purple-400');
       } catch (err) {
@@ -849,6 +919,30 @@ const Dashboard: React.FC<DashboardProps> = ({ previewUrl }) => {
                   />
                 </div>
 
+                {/* Column Duty */}
+                <div className="bg-slate-950/50 p-5 rounded-2xl border border-slate-800">
+                  <div className="flex justify-between items-center mb-3">
+                    <label className="text-[10px] font-black text-slate-500 uppercase tracking-widest flex items-center gap-2">
+                      <Activity size={14} className="text-purple-400" /> Column Duty
+                    </label>
+                    <span className="text-cyan-400 font-mono text-sm">{localDuty}%</span>
+                  </div>
+                  <input
+                    type="range" min="5" max="100" value={localDuty}
+                    onChange={(e) => { const v = parseInt(e.target.value); if (!isNaN(v)) handleDutyChange(Math.max(5, Math.min(100, v))); }}
+                    className="w-full h-2 bg-slate-800 rounded-lg appearance-none cursor-pointer accent-purple-500"
+                  />
+                  <div className="flex items-center gap-3 mt-3">
+                    <button
+                      onClick={measureDutyPower}
+                      className="px-3 py-1.5 bg-slate-800 hover:bg-slate-700 text-slate-300 rounded-lg text-[10px] font-bold uppercase"
+                    >
+                      Measure
+                    </button>
+                    <span className="text-[10px] text-slate-500 font-mono truncate">{dutyPowerText || 'Lower duty = sharper columns'}</span>
+                  </div>
+                </div>
+
                 {/* Upload */}
                 <div className="bg-slate-950/50 p-4 rounded-2xl border border-slate-800 flex items-center gap-4">
                   <div className="flex-1">
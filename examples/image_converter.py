@@ -23,15 +23,36 @@ except ImportError:
 import sys
 import os
 import struct
+import zlib
 
 # POV binary file format constants (matches Teensy SD storage)
 POV_MAGIC = 0x504F5631  # "POV1" in hex
 POV_VERSION = 1
 SD_MAX_DIMENSION = 1024  # Max width/height allowed by SD storage validation
 
+# .pov v2 (matches teensy_firmware/PovCodec.h): compressed, blocked, CRC-checked
+POV2_MAGIC = b"POV2"
+POV2_VERSION = 2
+POV2_HEADER_BYTES = 20
+POV2_CODEC_RAW = 0
+POV2_CODEC_QOI = 1
+POV2_BLOCK_COLUMNS = 16
+
 # The number of display LEDs determines the fixed HEIGHT of POV images
 POV_HEIGHT = 32  # All 32 LEDs are used for display (hardware level shifter)
 
+# Show bundle format (matches the Teensy 0x28 loader, /poi_shows/<name>.show)
+SHOW_MAGIC = b"SHW1"
+SHOW_VERSION = 1
+SHOW_HEADER_BYTES = 16
+SHOW_INDEX_ENTRY_BYTES = 12
+SHOW_MAX_ASSETS = 256
+SHOW_RECORDS_MAX = 1024
+SHOW_ASSET_IMAGE = 1
+SHOW_ASSET_PATTERN = 2
+SHOW_ASSET_SEQUENCE = 3
+SHOW_ASSET_SETTINGS = 4
+
 def convert_image_for_pov(input_path, output_path=None, height=32, max_width=200, 
                          enhance_contrast=True, flip_horizontal=False):
     """
@@ -153,10 +174,12 @@ def convert_image_to_pov_data(input_path, height=32, max_width=400, enhance_cont
 
 
 def save_as_pov(input_path, output_path=None, height=32, max_width=400,
-                enhance_contrast=True, flip_horizontal=False, flip_vertical=False):
+                enhance_contrast=True, flip_horizontal=False, flip_vertical=False,
+                v2=False):
     """
     Convert an image to .pov format for direct SD card upload.
-    Output format matches Teensy SD storage (header + RGB data).
+    Output format matches Teensy SD storage (header + RGB data), or the
+    compressed Teensy v2 layout when v2 is set.
     """
     result = convert_image_to_pov_data(
         input_path, height=height, max_width=max_width,
@@ -172,6 +195,12 @@ def save_as_pov(input_path, output_path=None, height=32, max_width=400,
     if not output_path.lower().endswith('.pov'):
         output_path += '.pov'
     try:
+        if v2:
+            data = encode_pov_v2(width, height, rgb_data)
+            with open(output_path, 'wb') as f:
+                f.write(data)
+            print(f"Saved .pov v2 file: {output_path} ({width}x{height}, {len(data)} bytes)")
+            return True
         data_size = width * height * 3
         header = struct.pack('<IIHHII',
             POV_MAGIC, POV_VERSION, width, height, data_size, 0)
@@ -185,6 +214,228 @@ def save_as_pov(input_path, output_path=None, height=32, max_width=400,
         return False
 
 
+def rgb_rows_to_pov_body(width, height, rgb_rows):
+    """Teensy .pov body: width, height (16-bit LE), then RGB column by column."""
+    body = bytearray(struct.pack('<HH', width, height))
+    for x in range(width):
+        for y in range(height):
+            i = (y * width + x) * 3
+            body += rgb_rows[i:i + 3]
+    return bytes(body)
+
+
+def _qoi_hash(r, g, b):
+    return (r * 3 + g * 5 + b * 7) & 63
+
+
+def _qoi_encode(pixels):
+    """QOI RGB operations for a list of (r, g, b), as in PovCodec.h."""
+    out = bytearray()
+    index = [(0, 0, 0)] * 64
+    prev = (0, 0, 0)
+    run = 0
+    for px in pixels:
+        if px == prev:
+            run += 1
+            if run == 62:
+                out.append(0xC0 | (run - 1))
+                run = 0
+            continue
+        if run:
+            out.append(0xC0 | (run - 1))
+            run = 0
+        h = _qoi_hash(*px)
+        if index[h] == px:
+            out.append(h)
+        else:
+            index[h] = px
+            dr, dg, db = [((a - b + 128) & 0xFF) - 128 for a, b in zip(px, prev)]
+            drdg, dbdg = dr - dg, db - dg
+            if -2 <= dr <= 1 and -2 <= dg <= 1 and -2 <= db <= 1:
+                out.append(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2))
+            elif -32 <= dg <= 31 and -8 <= drdg <= 7 and -8 <= dbdg <= 7:
+                out += bytes([0x80 | (dg + 32), ((drdg + 8) << 4) | (dbdg + 8)])
+            else:
+                out += bytes([0xFE, *px])
+        prev = px
+    if run:
+        out.append(0xC0 | (run - 1))
+    return bytes(out)
+
+
+def _qoi_decode(data, count):
+    pixels = []
+    index = [(0, 0, 0)] * 64
+    r = g = b = 0
+    pos = 0
+    while len(pixels) < count:
+        op = data[pos]
+        pos += 1
+        if op == 0xFE:
+            r, g, b = data[pos:pos + 3]
+            pos += 3
+        elif op >> 6 == 0:
+            r, g, b = index[op]
+        elif op >> 6 == 1:
+            r = (r + ((op >> 4) & 3) - 2) & 0xFF
+            g = (g + ((op >> 2) & 3) - 2) & 0xFF
+            b = (b + (op & 3) - 2) & 0xFF
+        elif op >> 6 == 2:
+            dg = (op & 0x3F) - 32
+            nxt = data[pos]
+            pos += 1
+            r = (r + dg + (nxt >> 4) - 8) & 0xFF
+            g = (g + dg) & 0xFF
+            b = (b + dg + (nxt & 0x0F) - 8) & 0xFF
+        else:
+            pixels.extend([(r, g, b)] * ((op & 0x3F) + 1))
+            continue
+        index[_qoi_hash(r, g, b)] = (r, g, b)
+        pixels.append((r, g, b))
+    if len(pixels) != count or pos != len(data):
+        raise ValueError("QOI block does not match its size")
+    return pixels
+
+
+def encode_pov_v2(width, height, rgb_rows, codec=POV2_CODEC_QOI):
+    """
+    Teensy .pov v2 file from row-major RGB.
+
+    Columns are grouped into 16-column blocks that each decode on their own;
+    the block table lets the Teensy page cache read a single block. Falls
+    back to raw blocks when QOI would not be smaller, as the firmware does.
+    """
+    columns = rgb_rows_to_pov_body(width, height, rgb_rows)[4:]
+    column_bytes = height * 3
+    blocks = []
+    for start in range(0, width, POV2_BLOCK_COLUMNS):
+        raw = columns[start * column_bytes:(start + POV2_BLOCK_COLUMNS) * column_bytes]
+        if codec == POV2_CODEC_QOI:
+            pixels = [tuple(raw[i:i + 3]) for i in range(0, len(raw), 3)]
+            blocks.append(_qoi_encode(pixels))
+        else:
+            blocks.append(raw)
+    if codec == POV2_CODEC_QOI and sum(map(len, blocks)) >= len(columns):
+        return encode_pov_v2(width, height, rgb_rows, POV2_CODEC_RAW)
+
+    offsets = []
+    position = 0
+    for block in blocks:
+        offsets.append(position)
+        position += len(block)
+    header = POV2_MAGIC + struct.pack('<BBHHHII', POV2_VERSION, codec, width, height,
+                                      POV2_BLOCK_COLUMNS, position, zlib.crc32(columns))
+    return header + struct.pack(f'<{len(offsets)}I', *offsets) + b"".join(blocks)
+
+
+def decode_pov_v2(data):
+    """(width, height, rgb_rows) from a .pov v2 file; ValueError if it is bad."""
+    if data[:4] != POV2_MAGIC or data[4] != POV2_VERSION:
+        raise ValueError("Not a .pov v2 file")
+    codec, width, height, block_columns, data_bytes, crc = struct.unpack(
+        '<BHHHII', data[5:POV2_HEADER_BYTES])
+    count = (width + block_columns - 1) // block_columns
+    offsets = struct.unpack(f'<{count}I', data[POV2_HEADER_BYTES:POV2_HEADER_BYTES + count * 4])
+    start = POV2_HEADER_BYTES + count * 4
+    ends = list(offsets[1:]) + [data_bytes]
+    columns = bytearray()
+    for b, (offset, end) in enumerate(zip(offsets, ends)):
+        block = data[start + offset:start + end]
+        pixels = min(block_columns, width - b * block_columns) * height
+        if codec == POV2_CODEC_RAW:
+            columns += block
+        else:
+            columns += bytes(c for px in _qoi_decode(block, pixels) for c in px)
+    if zlib.crc32(columns) != crc:
+        raise ValueError("CRC mismatch")
+    rows = bytearray(width * height * 3)
+    for x in range(width):
+        for y in range(height):
+            i = (x * height + y) * 3
+            j = (y * width + x) * 3
+            rows[j:j + 3] = columns[i:i + 3]
+    return width, height, bytes(rows)
+
+
+def _record(cmd, data):
+    return bytes([cmd, len(data)]) + bytes(data)
+
+
+def pack_show_bundle(images=(), patterns=(), sequences=(), settings=None):
+    """
+    Build a show bundle for the Teensy.
+
+    images:    (slot, width, height, rgb_rows) tuples
+    patterns:  dicts with index, type, color1, color2 (RGB tuples), speed
+    sequences: dicts with index, loop, items [(item, duration_ms), ...]
+    settings:  dict with any of brightness, fps, mode, mode_index
+
+    Assets are laid out in index order so the Teensy reads the file once,
+    front to back. Settings go last so the mode switch sees every asset.
+    """
+    assets = []
+    for slot, width, height, rgb_rows in images:
+        assets.append((SHOW_ASSET_IMAGE, slot, rgb_rows_to_pov_body(width, height, rgb_rows)))
+    for pat in patterns:
+        data = [pat['index'], pat['type'], *pat['color1'], *pat['color2'], pat['speed']]
+        assets.append((SHOW_ASSET_PATTERN, 0, _record(0x03, data)))
+    for seq in sequences:
+        items = seq['items'][:10]
+        data = [seq['index'], len(items), 1 if seq.get('loop', True) else 0]
+        for item, duration in items:
+            data += [item, (duration >> 8) & 0xFF, duration & 0xFF]
+        assets.append((SHOW_ASSET_SEQUENCE, 0, _record(0x04, data)))
+    if settings:
+        records = b""
+        if 'brightness' in settings:
+            records += _record(0x06, [settings['brightness']])
+        if 'fps' in settings:
+            records += _record(0x07, [(settings['fps'] >> 8) & 0xFF, settings['fps'] & 0xFF])
+        if 'mode' in settings:
+            records += _record(0x01, [settings['mode'], settings.get('mode_index', 0)])
+        assets.append((SHOW_ASSET_SETTINGS, 0, records))
+
+    if len(assets) > SHOW_MAX_ASSETS:
+        raise ValueError(f"Too many assets ({len(assets)} > {SHOW_MAX_ASSETS})")
+    data_offset = SHOW_HEADER_BYTES + len(assets) * SHOW_INDEX_ENTRY_BYTES
+    index = b""
+    offset = data_offset
+    for asset_type, slot, payload in assets:
+        if asset_type != SHOW_ASSET_IMAGE and len(payload) > SHOW_RECORDS_MAX:
+            raise ValueError("Record asset too large")
+        index += struct.pack('<BBHII', asset_type, slot, 0, offset, len(payload))
+        offset += len(payload)
+    header = SHOW_MAGIC + struct.pack('<BBHII', SHOW_VERSION, 0, len(assets),
+                                      data_offset, offset - data_offset)
+    return header + index + b"".join(payload for _, _, payload in assets)
+
+
+def save_show_bundle(input_paths, output_path, height=32, max_width=400, settings=None):
+    """Convert images into slots 0.. and write them as one show bundle."""
+    images = []
+    for slot, path in enumerate(input_paths):
+        result = convert_image_to_pov_data(path, height=height, max_width=max_width)
+        if result is None:
+            print(f"Skipping unreadable image: {path}")
+            continue
+        images.append((slot, *result))
+    if not images:
+        return False
+    if not output_path.lower().endswith('.show'):
+        output_path += '.show'
+    if settings is None:
+        settings = {'mode': 1, 'mode_index': images[0][0]}
+    try:
+        bundle = pack_show_bundle(images=images, settings=settings)
+        with open(output_path, 'wb') as f:
+            f.write(bundle)
+        print(f"Saved show bundle: {output_path} ({len(images)} images, {len(bundle)} bytes)")
+        return True
+    except Exception as e:
+        print(f"Error writing show bundle: {e}")
+        return False
+
+
 def print_usage():
     """Print usage information"""
     print("POV Image Converter")
@@ -194,10 +445,13 @@ def print_usage():
     print("  python image_converter.py <input_image> [output_file]")
     print("  python image_converter.py --pov <input_image> [output.pov]")
     print("  python image_converter.py --pov --batch <input_dir> <output_dir>")
+    print("  python image_converter.py --bundle <input_dir> <output.show>")
     print()
     print("Options:")
     print("  --pov         Output .pov format for SD card (default: PNG for web upload)")
+    print("  --v2          With --pov: write the compressed Teensy .pov v2 layout")
     print("  --batch       Batch convert all images in directory")
+    print("  --bundle      Pack all images in a directory into one show bundle")
     print("  --height N    Target height in pixels (default: 32)")
     print("  --max-width N Max width in pixels (default: 400, max 1024 for .pov)")
     print()
@@ -220,7 +474,9 @@ def main():
 
     pov_mode = '--pov' in args
     batch_mode = '--batch' in args
-    for opt in ['--pov', '--batch']:
+    bundle_mode = '--bundle' in args
+    v2 = '--v2' in args
+    for opt in ['--pov', '--batch', '--bundle', '--v2']:
         if opt in args:
             args.remove(opt)
 
@@ -240,6 +496,18 @@ def main():
             continue
         i += 1
 
+    if bundle_mode:
+        if len(args) < 2 or not os.path.isdir(args[0]):
+            print("Bundle mode requires: <input_dir> <output.show>")
+            sys.exit(1)
+        exts = ('.jpg', '.jpeg', '.png', '.gif', '.bmp')
+        inputs = [os.path.join(args[0], f) for f in sorted(os.listdir(args[0]))
+                  if f.lower().endswith(exts)]
+        success = save_show_bundle(inputs, args[1], height=height, max_width=max_width)
+        if success:
+            print("Copy the .show file to your SD card /poi_shows/ folder.")
+        sys.exit(0 if success else 1)
+
     if batch_mode:
         if len(args) < 2:
             print("Batch mode requires: <input_dir> <output_dir>")
@@ -256,7 +524,7 @@ def main():
                 inp = os.path.join(input_dir, f)
                 base = os.path.splitext(f)[0]
                 out = os.path.join(output_dir, f"{base}.pov")
-                if save_as_pov(inp, out, height=height, max_width=max_width):
+                if save_as_pov(inp, out, height=height, max_width=max_width, v2=v2):
                     count += 1
         print(f"\nConverted {count} images to {output_dir}")
         print("Copy the .pov files to your SD card /images/ folder.")
@@ -266,7 +534,7 @@ def main():
     output_path = args[1] if len(args) > 1 else None
 
     if pov_mode:
-        success = save_as_pov(input_path, output_path, height=height, max_width=max_width)
+        success = save_as_pov(input_path, output_path, height=height, max_width=max_width, v2=v2)
         if success:
             print("\nCopy this .pov file to your SD card /images/ folder.")
             print("Then load it via the web interface (SD Card Storage section).")
@@ -16,7 +16,8 @@ import shutil
 
 # Import the image converter module from current directory
 try:
-    from image_converter import convert_image_for_pov
+    from image_converter import (convert_image_for_pov, pack_show_bundle,
+                                 encode_pov_v2, decode_pov_v2)
 except ImportError:
     print("Error: Could not import image_converter module")
     print("Make sure image_converter.py is in the same directory")
@@ -267,6 +268,101 @@ def test_default_output_naming():
         os.remove(expected_output)
         return True
 
+def test_show_bundle():
+    """Test a 100-asset show bundle: header, index order and image layout"""
+    print("\n=== Test 9: Show Bundle ===")
+    import struct
+
+    width, height = 20, 32
+    rgb = bytes((x * 5 + y * 7 + c) & 0xFF
+                for y in range(height) for x in range(width) for c in range(3))
+    images = [(slot, width, height, rgb) for slot in range(80)]
+    patterns = [{'index': i, 'type': i, 'color1': (255, 0, 0), 'color2': (0, 0, 255), 'speed': 50}
+                for i in range(15)]
+    sequences = [{'index': i, 'loop': True, 'items': [(0, 1000), (1, 2000)]} for i in range(4)]
+    bundle = pack_show_bundle(images, patterns, sequences,
+                              settings={'brightness': 128, 'fps': 50, 'mode': 1})
+
+    magic = bundle[:4]
+    version, _, count, data_offset, data_bytes = struct.unpack('<BBHII', bundle[4:16])
+    if magic != b"SHW1" or version != 1 or count != 100:
+        print(f"❌ FAILED: Bad header (magic={magic}, version={version}, count={count})")
+        return False
+    if data_offset != 16 + count * 12 or data_offset + data_bytes != len(bundle):
+        print("❌ FAILED: Data offset/size do not match the file")
+        return False
+
+    # Assets must follow each other so the Teensy reads the file front to back
+    expected = data_offset
+    for i in range(count):
+        asset_type, slot, _, offset, length = struct.unpack('<BBHII', bundle[16 + i * 12:28 + i * 12])
+        if offset != expected:
+            print(f"❌ FAILED: Asset {i} at {offset}, expected {expected}")
+            return False
+        expected += length
+    first_type = bundle[16]
+    last_type = bundle[16 + (count - 1) * 12]
+    if first_type != 1 or last_type != 4:
+        print("❌ FAILED: Images should come first and settings last")
+        return False
+
+    # Image bodies are column-major: column 1 starts with pixel (1, 0)
+    body = bundle[data_offset:data_offset + 4 + width * height * 3]
+    if struct.unpack('<HH', body[:4]) != (width, height) or body[4 + height * 3:7 + height * 3] != rgb[3:6]:
+        print("❌ FAILED: Image body is not in .pov column order")
+        return False
+
+    print(f"✓ PASSED: {count} assets, {len(bundle)} bytes, sequential layout")
+    return True
+
+def test_pov_v2():
+    """Test .pov v2: lossless roundtrip, compression, CRC and corruption check"""
+    print("\n=== Test 10: .pov v2 Codec ===")
+    import struct
+    import zlib
+
+    # Bands with gradients, solid runs and noise across block boundaries
+    width, height = 50, 32
+    rgb = bytes(((x // 10) * 40 + y * 3 + c * 70) & 0xFF if x % 25 < 20 else (x * y * 37 + c * 11) & 0xFF
+                for y in range(height) for x in range(width) for c in range(3))
+    data = encode_pov_v2(width, height, rgb)
+    if data[:4] != b"POV2" or data[5] != 1:
+        print(f"❌ FAILED: Expected a QOI-coded v2 file, got {data[:6]}")
+        return False
+    if len(data) >= width * height * 3:
+        print(f"❌ FAILED: No compression ({len(data)} bytes)")
+        return False
+    if decode_pov_v2(data) != (width, height, rgb):
+        print("❌ FAILED: Roundtrip does not match")
+        return False
+
+    # CRC covers the decoded columns, as the Teensy computes it
+    columns = bytes(rgb[(y * width + x) * 3 + c] for x in range(width) for y in range(height) for c in range(3))
+    if struct.unpack('<I', data[16:20])[0] != zlib.crc32(columns):
+        print("❌ FAILED: CRC is not over the decoded columns")
+        return False
+
+    # Noise does not compress: raw fallback
+    import random
+    rng = random.Random(1)
+    noise = bytes(rng.randrange(256) for _ in range(20 * height * 3))
+    raw = encode_pov_v2(20, height, noise)
+    if raw[5] != 0 or decode_pov_v2(raw) != (20, height, noise):
+        print("❌ FAILED: Raw fallback")
+        return False
+
+    corrupt = bytearray(data)
+    corrupt[-3] ^= 0x01
+    try:
+        decode_pov_v2(bytes(corrupt))
+        print("❌ FAILED: Corrupt file decoded")
+        return False
+    except (ValueError, IndexError):
+        pass
+
+    print(f"✓ PASSED: {width * height * 3} bytes -> {len(data)} bytes, roundtrip and CRC OK")
+    return True
+
 def run_all_tests():
     """Run all tests and report results"""
     print("=" * 60)
@@ -282,6 +378,8 @@ def run_all_tests():
         ("Invalid File", test_invalid_file),
         ("Format Support", test_different_formats),
         ("Default Naming", test_default_output_naming),
+        ("Show Bundle", test_show_bundle),
+        (".pov v2 Codec", test_pov_v2),
     ]
     
     results = []
@@ -25,15 +25,53 @@ class Cmd(IntEnum):
     LIVE_FRAME     = 0x05
     SET_BRIGHTNESS = 0x06
     SET_FRAMERATE  = 0x07
+    SET_DUTY       = 0x09
+    SET_ROTATION   = 0x0A
+    SET_GOVERNOR   = 0x0D
     STATUS_REQ     = 0x10
+    POWER_REPORT   = 0x11
+    ROTATION_REQ   = 0x12
+    LINK_STATS_REQ = 0x13
+    GOVERNOR_REQ   = 0x14
+    STORAGE_REQ    = 0x15
+    CAPABILITIES_REQ = 0x16
+    BATCH          = 0x17
+    READBACK       = 0x18
+    PARTICLE_BENCH = 0x19
+    SLOT_MAP       = 0x1A
     SD_SAVE        = 0x20
     SD_LOAD        = 0x21
     SD_LIST        = 0x22
     SD_DELETE      = 0x23
+    SD_LOAD_IMAGE  = 0x24
+    LIVE_RECORD    = 0x25
+    SD_WRITER_REQ  = 0x26
+    SD_LOAD_REPORT = 0x27
+    SHOW           = 0x28
+    SD_CACHE       = 0x29
+    UPLOAD_IMAGE_SLOT = 0x40
+    PATCH_IMAGE    = 0x41
+    PROGRESSIVE    = 0x42
 
 class Resp(IntEnum):
     ACK    = 0xAA
     STATUS = 0xBB
+    POWER  = 0xBC
+    ROTATION = 0xBD
+    LIVE_RECORDER = 0xBE
+    LINK_STATS = 0xBF
+    GOVERNOR = 0xC0
+    STORAGE = 0xC1
+    CAPABILITIES = 0xC2
+    READBACK     = 0xC3
+    SD_LOAD_EVENT = 0xC4
+    SD_WRITER    = 0xC5
+    SHOW_LOAD_EVENT = 0xC6
+    SD_CACHE     = 0xC7
+    PARTICLE_BENCH = 0xC8
+    PATCH  = 0xC9
+    PROGRESSIVE = 0xCA
+    SLOT_MAP = 0xCB
     LIST   = 0xCC
 
 class Mode(IntEnum):
@@ -42,6 +80,7 @@ class Mode(IntEnum):
     PATTERN  = 2
     SEQUENCE = 3
     LIVE     = 4
+    SD_STREAM = 5
 
 
 @dataclass
@@ -54,8 +93,10 @@ class StatusResponse:
 def build_packet(cmd: int, data: bytes = b"") -> bytes:
     """Build an internal-protocol packet: FF CMD LEN DATA... FE"""
     length = len(data)
-    if cmd == Cmd.UPLOAD_IMAGE:
-        # Image upload uses 16-bit length
+    if cmd == Cmd.UPLOAD_IMAGE or 0x40 <= cmd <= 0x4F:
+        # Image upload and the 0x40-0x4F bulk commands use a 16-bit length
+        if length > 0xFFFF:
+            raise ValueError(f"Payload too large for 16-bit length field: {length} bytes")
         return bytes([INTERNAL_START, cmd, (length >> 8) & 0xFF, length & 0xFF]) + data + bytes([INTERNAL_END])
     if length > 0xFF:
         raise ValueError(
@@ -82,6 +123,21 @@ def set_framerate_legacy(delay_ms: int) -> bytes:
     return build_packet(Cmd.SET_FRAMERATE, bytes([delay_ms & 0xFF]))
 
 
+def set_duty(percent: int) -> bytes:
+    """Build a column duty-cycle command (percent on-time, 5-100)."""
+    return build_packet(Cmd.SET_DUTY, bytes([percent & 0xFF]))
+
+
+def batch(*packets: bytes) -> bytes:
+    """Pack simple (8-bit length) command packets into one 0x17 batch frame."""
+    records = b""
+    for pkt in packets:
+        if pkt[0] != INTERNAL_START or pkt[-1] != INTERNAL_END or len(pkt) != pkt[2] + 4:
+            raise ValueError("batch() takes simple command packets only")
+        records += pkt[1:-1]
+    return build_packet(Cmd.BATCH, records)
+
+
 def request_status() -> bytes:
     return build_packet(Cmd.STATUS_REQ)
 
@@ -105,6 +161,270 @@ def live_frame(pixels: list[tuple[int, int, int]]) -> bytes:
     return build_packet(Cmd.LIVE_FRAME, data)
 
 
+def upload_image_slot(slot: int, width: int, height: int, rgb: bytes) -> bytes:
+    """Build a slot-addressed image upload (0x40); rgb is row-major, width*height*3 bytes."""
+    header = bytes([slot & 0xFF, width & 0xFF, (width >> 8) & 0xFF,
+                    height & 0xFF, (height >> 8) & 0xFF])
+    return build_packet(Cmd.UPLOAD_IMAGE_SLOT, header + rgb)
+
+
+def column_hash(rgb: bytes, width: int, height: int, x: int) -> int:
+    """FNV-1a over column x of a row-major image, top row first."""
+    h = 2166136261
+    for y in range(height):
+        for b in rgb[(y * width + x) * 3:(y * width + x) * 3 + 3]:
+            h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def image_digest(rgb: bytes, width: int, height: int) -> int:
+    """The base digest a patch names: FNV-1a over every little-endian column hash."""
+    h = 2166136261
+    for x in range(width):
+        for b in struct.pack("<I", column_hash(rgb, width, height, x)):
+            h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def patch_image(slot: int, width: int, height: int, base_digest: int,
+                ranges: list[tuple[int, int]], rgb: bytes) -> bytes:
+    """Build a column patch (0x41) carrying columns [x, x+count) of the new row-major image."""
+    data = bytearray(struct.pack("<BHHI", slot, width, height, base_digest))
+    for x, count in ranges:
+        data += struct.pack("<HH", x, count)
+        for col in range(x, x + count):
+            for y in range(height):
+                data += rgb[(y * width + col) * 3:(y * width + col) * 3 + 3]
+    return build_packet(Cmd.PATCH_IMAGE, bytes(data))
+
+
+PATCH_OK, PATCH_NO_IMAGE, PATCH_BASE_CHANGED, PATCH_BAD_FRAME, PATCH_NO_SPACE = range(5)
+
+
+def parse_patch_result(data: bytes) -> Optional[tuple[int, int]]:
+    """Parse a patch result (0xC9) frame into (status, columns patched)."""
+    start = data.find(bytes([INTERNAL_START, Resp.PATCH]))
+    if start == -1 or len(data) < start + 6 or data[start + 5] != INTERNAL_END:
+        return None
+    return struct.unpack(">BH", data[start + 2:start + 5])
+
+
+PROGRESSIVE_PASSES = ((0, 8), (4, 8), (2, 4), (1, 2))  # (first column, step)
+
+
+def progressive_upload(slot: int, width: int, height: int, rgb: bytes,
+                       frame_columns: int = 16, show: bool = True) -> list[bytes]:
+    """Frames of a progressive upload (0x42) of a row-major image: begin,
+    column batches in interleaved passes (every 8th column first), end."""
+    frames = [build_packet(Cmd.PROGRESSIVE, struct.pack("<BBHHB", 1, slot, width, height, int(show)))]
+    for first, step in PROGRESSIVE_PASSES:
+        xs = list(range(first, width, step))
+        for i in range(0, len(xs), frame_columns):
+            batch_xs = xs[i:i + frame_columns]
+            data = bytearray(struct.pack("<BHHH", 2, batch_xs[0], step, len(batch_xs)))
+            for x in batch_xs:
+                for y in range(height):
+                    data += rgb[(y * width + x) * 3:(y * width + x) * 3 + 3]
+            frames.append(build_packet(Cmd.PROGRESSIVE, bytes(data)))
+    frames.append(build_packet(Cmd.PROGRESSIVE, bytes([3])))
+    return frames
+
+
+@dataclass
+class ProgressiveResult:
+    status: int          # 0=committed, 1=no upload in progress, 2=columns missing, 3=no pool space
+    received: int        # Distinct columns received
+    coarse_us: int       # Begin until every column was within 7 of a received one
+    total_us: int        # Begin until the commit
+
+
+def parse_progressive_result(data: bytes) -> Optional[ProgressiveResult]:
+    """Parse a progressive upload result (0xCA) frame; fixed length, values may contain 0xFE."""
+    start = data.find(bytes([INTERNAL_START, Resp.PROGRESSIVE]))
+    if start == -1 or len(data) < start + 14 or data[start + 13] != INTERNAL_END:
+        return None
+    return ProgressiveResult(*struct.unpack(">BHII", data[start + 2:start + 13]))
+
+
+def request_slot_map() -> bytes:
+    return build_packet(Cmd.SLOT_MAP)
+
+
+def parse_slot_map(data: bytes) -> Optional[set[int]]:
+    """Parse a slot map (0xCB) frame into the set of slots holding an image."""
+    start = data.find(bytes([INTERNAL_START, Resp.SLOT_MAP]))
+    if start == -1 or len(data) < start + 37 or data[start + 36] != INTERNAL_END:
+        return None
+    slots = (data[start + 2] << 8) | data[start + 3]
+    bits = data[start + 4:start + 36]
+    return {n for n in range(min(slots, 256)) if bits[n // 8] & (1 << (n % 8))}
+
+
+def request_link_stats() -> bytes:
+    return build_packet(Cmd.LINK_STATS_REQ)
+
+
+LINK_STATS_FRAME_LEN = 52  # FF BF count + 2 ports x 24 bytes + FE
+
+
+@dataclass
+class LinkStats:
+    rx_bytes: int
+    frames: int
+    errors: int
+    bytes_per_sec: int
+    overruns: int
+    rx_peak: int
+
+
+def parse_link_stats(data: bytes) -> Optional[dict[str, LinkStats]]:
+    """Parse a fixed-length link statistics (0xBF) frame into {"esp32", "usb"}."""
+    start = data.find(bytes([INTERNAL_START, Resp.LINK_STATS]))
+    if start == -1 or len(data) < start + LINK_STATS_FRAME_LEN:
+        return None
+    frame = data[start:start + LINK_STATS_FRAME_LEN]
+    if frame[-1] != INTERNAL_END or frame[2] != 2:
+        return None
+    ports = {}
+    for i, name in enumerate(("esp32", "usb")):
+        ports[name] = LinkStats(*struct.unpack(">IIIIII", frame[3 + i * 24:27 + i * 24]))
+    return ports
+
+
+READBACK_CHUNK_MAX = 512
+
+
+def request_readback(offset: int, max_len: int = READBACK_CHUNK_MAX,
+                     slot: int = 0, name: str = "") -> bytes:
+    """Request one read-back chunk (0x18) of a slot, or of an SD file if name is set."""
+    ident = bytes([len(name)]) + name.encode() if name else bytes([slot & 0xFF])
+    data = bytes([1 if name else 0]) + struct.pack(">IH", offset, max_len) + ident
+    return build_packet(Cmd.READBACK, data)
+
+
+@dataclass
+class ReadbackChunk:
+    status: int
+    total: int
+    offset: int
+    data: bytes
+
+
+def parse_readback(data: bytes) -> Optional[ReadbackChunk]:
+    """Parse a read-back (0xC3) frame; the payload is binary, so it is length-delimited."""
+    start = data.find(bytes([INTERNAL_START, Resp.READBACK]))
+    if start == -1 or len(data) < start + 13:
+        return None
+    status, total, offset, length = struct.unpack(">BIIH", data[start + 2:start + 13])
+    end = start + 13 + length
+    if len(data) < end + 1 or data[end] != INTERNAL_END:
+        return None
+    return ReadbackChunk(status, total, offset, data[start + 13:end])
+
+
+def sd_save(name: str, slot: int, fmt: int = 2) -> bytes:
+    """Queue a save of an image slot to /poi_images/<name>.pov (2 = v2, 1 = v1)."""
+    return build_packet(Cmd.SD_SAVE, bytes([len(name)]) + name.encode() + bytes([slot, fmt]))
+
+
+def sd_load(name: str, slot: int, show: bool = False) -> bytes:
+    """Load /poi_images/<name>.pov into a slot; an 0xC4 event follows the ACK."""
+    return build_packet(Cmd.SD_LOAD_IMAGE,
+                        bytes([len(name)]) + name.encode() + bytes([slot, 1 if show else 0]))
+
+
+def request_sd_writer() -> bytes:
+    return build_packet(Cmd.SD_WRITER_REQ)
+
+
+def parse_sd_writer_queued(data: bytes) -> Optional[int]:
+    """Jobs still queued, from an SD writer (0xC5) report."""
+    start = data.find(bytes([INTERNAL_START, Resp.SD_WRITER]))
+    if start == -1 or len(data) < start + 43 or data[start + 42] != INTERNAL_END:
+        return None
+    return data[start + 2]
+
+
+@dataclass
+class SdLoadEvent:
+    status: int          # 1 loading, 2 done, 3 not found, 4 bad file, 5 no space
+    slot: int
+    shown: int
+    width: int
+    height: int
+    read_us: int
+    commit_us: int
+    total_us: int
+    passes: int
+    format: int          # .pov version read
+    decode_us: int
+    file_bytes: int
+
+
+def parse_sd_load_event(data: bytes) -> Optional[SdLoadEvent]:
+    """Parse an SD load (0xC4) event; fixed length, values may contain 0xFE."""
+    start = data.find(bytes([INTERNAL_START, Resp.SD_LOAD_EVENT]))
+    if start == -1 or len(data) < start + 33 or data[start + 32] != INTERNAL_END:
+        return None
+    return SdLoadEvent(*struct.unpack(">BBBHHIIIHBII", data[start + 2:start + 32]))
+
+
+def load_show(name: str) -> bytes:
+    """Load /poi_shows/<name>.show (0x28 op 1); an 0xC6 event follows the ACK."""
+    return build_packet(Cmd.SHOW, bytes([0x01, len(name)]) + name.encode())
+
+
+def request_show_report() -> bytes:
+    """Repeat the last show load event (0x28 op 2)."""
+    return build_packet(Cmd.SHOW, bytes([0x02]))
+
+
+@dataclass
+class ShowLoadEvent:
+    status: int          # 1 loading, 2 done, 3 not found, 4 bad file, 5 no space
+    assets_done: int
+    asset_count: int
+    images: int
+    bytes: int
+    read_us: int
+    apply_us: int
+    total_us: int
+    passes: int
+
+
+def parse_show_event(data: bytes) -> Optional[ShowLoadEvent]:
+    """Parse a show load (0xC6) event; fixed length, values may contain 0xFE."""
+    start = data.find(bytes([INTERNAL_START, Resp.SHOW_LOAD_EVENT]))
+    if start == -1 or len(data) < start + 28 or data[start + 27] != INTERNAL_END:
+        return None
+    return ShowLoadEvent(*struct.unpack(">BHHHIIIIH", data[start + 2:start + 27]))
+
+
+def particle_bench(count: int, columns: int = 1000) -> bytes:
+    """Time step + draw of `count` particles over `columns` columns (0x19)."""
+    return build_packet(Cmd.PARTICLE_BENCH, struct.pack(">HH", count, columns))
+
+
+@dataclass
+class ParticleBench:
+    particles: int
+    columns: int
+    avg_ns: int          # Step + draw per column
+    worst_us: int
+    period_us: int       # Column period in effect
+    live_count: int      # Live particle pattern pool
+    live_peak: int
+    dropped: int
+
+
+def parse_particle_bench(data: bytes) -> Optional[ParticleBench]:
+    """Parse a particle benchmark (0xC8) frame; fixed length, values may contain 0xFE."""
+    start = data.find(bytes([INTERNAL_START, Resp.PARTICLE_BENCH]))
+    if start == -1 or len(data) < start + 27 or data[start + 26] != INTERNAL_END:
+        return None
+    return ParticleBench(*struct.unpack(">HHIIIHHI", data[start + 2:start + 26]))
+
+
 def parse_response(data: bytes) -> Optional[tuple[int, bytes]]:
     """
     Extract the first complete response frame from *data*.
@@ -7,6 +7,7 @@ values, then restore the original state.
 """
 
 import json
+import socket
 import time
 import urllib.parse
 import urllib.request
@@ -18,6 +19,8 @@ from .result import TestResult, TestReport, Verdict
 
 DEFAULT_BASE_URL = "http://192.168.4.1"
 REQUEST_TIMEOUT = 5  # seconds
+ARTNET_PORT = 6454
+OSC_PORT = 8000
 
 
 def _get(url: str, timeout: float = REQUEST_TIMEOUT) -> tuple[int, str]:
@@ -48,6 +51,26 @@ def _post_json(url: str, data: dict, timeout: float = REQUEST_TIMEOUT) -> tuple[
         return e.code, e.read().decode("utf-8", errors="replace")
 
 
+def _post_image(url: str, width: int, height: int, rgb: bytes,
+                timeout: float = 15) -> tuple[int, str]:
+    """Multipart image upload as the web UI sends it (image_WxH.rgb), returns (status_code, body)."""
+    parsed = urllib.parse.urlparse(url)
+    if parsed.scheme not in ("http", "https"):
+        raise ValueError(f"Unsafe URL scheme: {parsed.scheme!r}; only http/https are allowed")
+    boundary = "----povpoi-test"
+    body = (f"--{boundary}\r\n"
+            f'Content-Disposition: form-data; name="image"; filename="image_{width}x{height}.rgb"\r\n'
+            "Content-Type: application/octet-stream\r\n\r\n").encode() + rgb + \
+           f"\r\n--{boundary}--\r\n".encode()
+    req = urllib.request.Request(url, data=body, method="POST")
+    req.add_header("Content-Type", f"multipart/form-data; boundary={boundary}")
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as resp:
+            return resp.status, resp.read().decode("utf-8", errors="replace")
+    except urllib.error.HTTPError as e:
+        return e.code, e.read().decode("utf-8", errors="replace")
+
+
 # ---------------------------------------------------------------------------
 # Individual tests
 # ---------------------------------------------------------------------------
@@ -172,6 +195,154 @@ def test_live_mode(base: str) -> TestResult:
         return TestResult("POST /api/live (31 green)", Verdict.FAIL, elapsed, str(e))
 
 
+def _osc_message(address: str, *ints: int) -> bytes:
+    """OSC message with int32 arguments."""
+    def pad(b: bytes) -> bytes:
+        return b + b"\x00" * (4 - len(b) % 4)
+    tags = "," + "i" * len(ints)
+    return (pad(address.encode()) + pad(tags.encode())
+            + b"".join(v.to_bytes(4, "big", signed=True) for v in ints))
+
+
+def _osc_bundle(*messages: bytes) -> bytes:
+    """OSC bundle with the 'immediately' time tag."""
+    return (b"#bundle\x00" + (1).to_bytes(8, "big")
+            + b"".join(len(m).to_bytes(4, "big") + m for m in messages))
+
+
+def test_osc_latency(base: str, restore_brightness: int, rounds: int = 20) -> TestResult:
+    """Brightness changes over HTTP and over OSC, timed from both ends.
+
+    HTTP: POST /api/brightness round trips. OSC: a bundle of
+    /poi/brightness and /poi/ping, timed until /poi/pong comes back (sent
+    after the change went to the Teensy). GET /api/osc then gives the
+    device-side request-to-UART latency of each path.
+    """
+    name = "OSC vs HTTP control latency"
+    start = time.time()
+    host = urllib.parse.urlparse(base).hostname
+    try:
+        code, body = _post_json(f"{base}/api/osc", {"enabled": True, "reset": True})
+        if code != 200:
+            return TestResult(name, Verdict.FAIL, (time.time() - start) * 1000,
+                              f"HTTP {code}: {body}")
+        port = json.loads(body).get("port", OSC_PORT)
+
+        http_ms = []
+        for i in range(rounds):
+            t0 = time.perf_counter()
+            code, _ = _post_json(f"{base}/api/brightness", {"brightness": 100 + i})
+            if code == 200:
+                http_ms.append((time.perf_counter() - t0) * 1000)
+            time.sleep(0.05)  # Let each change flush on its own
+
+        osc_ms = []
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.settimeout(0.5)
+        try:
+            for i in range(rounds):
+                t0 = time.perf_counter()
+                sock.sendto(_osc_bundle(_osc_message("/poi/brightness", 150 + i),
+                                        _osc_message("/poi/ping", i)), (host, port))
+                try:
+                    while True:
+                        reply, _ = sock.recvfrom(64)
+                        if reply.startswith(b"/poi/pong") and reply[-4:] == i.to_bytes(4, "big"):
+                            osc_ms.append((time.perf_counter() - t0) * 1000)
+                            break
+                except socket.timeout:
+                    pass
+                time.sleep(0.05)
+        finally:
+            sock.close()
+        _post_json(f"{base}/api/brightness", {"brightness": restore_brightness})
+
+        code, body = _get(f"{base}/api/osc")
+        elapsed = (time.time() - start) * 1000
+        if code != 200:
+            return TestResult(name, Verdict.FAIL, elapsed, f"HTTP {code}")
+        latency = json.loads(body).get("latency", {})
+        dev_http = latency.get("http", {}).get("avgUs", 0) / 1000
+        dev_osc = latency.get("osc", {}).get("avgUs", 0) / 1000
+        if not http_ms or not osc_ms:
+            return TestResult(name, Verdict.FAIL, elapsed,
+                              f"{len(http_ms)}/{rounds} HTTP and {len(osc_ms)}/{rounds} OSC "
+                              f"round trips completed")
+        summary = (f"round trip HTTP {sum(http_ms) / len(http_ms):.1f} ms, "
+                   f"OSC {sum(osc_ms) / len(osc_ms):.1f} ms; on device HTTP "
+                   f"{dev_http:.1f} ms, OSC {dev_osc:.1f} ms")
+        if len(osc_ms) < rounds:
+            return TestResult(name, Verdict.WARN, elapsed,
+                              f"{rounds - len(osc_ms)} pongs lost", summary)
+        if dev_osc >= dev_http:
+            return TestResult(name, Verdict.WARN, elapsed,
+                              "OSC path not faster than HTTP on the device", summary)
+        return TestResult(name, Verdict.PASS, elapsed, summary)
+    except Exception as e:
+        elapsed = (time.time() - start) * 1000
+        return TestResult(name, Verdict.FAIL, elapsed, str(e))
+
+
+def _artdmx(seq: int, universe: int, rgb: bytes) -> bytes:
+    """ArtDmx packet carrying rgb from channel 1."""
+    return (b"Art-Net\x00" + bytes([0x00, 0x50, 0, 14, seq, 0,
+                                     universe & 0xFF, universe >> 8,
+                                     len(rgb) >> 8, len(rgb) & 0xFF]) + rgb)
+
+
+def test_udp_ingest(base: str) -> TestResult:
+    """Art-Net stream at 60 fps with reordered and missing packets.
+
+    Sends 120 ArtDmx frames to universe 0 with two swapped pairs and one
+    sequence number skipped, then checks GET /api/ingest: the swaps must
+    be put back in order (not late) and exactly one frame counted lost.
+    """
+    name = "UDP ingest (Art-Net, 60 fps)"
+    start = time.time()
+    host = urllib.parse.urlparse(base).hostname
+    try:
+        code, body = _post_json(f"{base}/api/ingest",
+                                {"enabled": True, "artnetUniverse": 0, "address": 1,
+                                 "reset": True})
+        if code != 200:
+            return TestResult(name, Verdict.FAIL, (time.time() - start) * 1000,
+                              f"HTTP {code}: {body}")
+
+        seqs = [s for s in range(1, 122) if s != 60]
+        for i in (30, 80):
+            seqs[i], seqs[i + 1] = seqs[i + 1], seqs[i]
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        try:
+            for n, seq in enumerate(seqs):
+                level = (seq * 2) & 0xFF
+                sock.sendto(_artdmx(seq, 0, bytes([level, 0, 255 - level]) * 32),
+                            (host, ARTNET_PORT))
+                time.sleep(max(0.0, start + (n + 1) / 60 - time.time()))
+        finally:
+            sock.close()
+        time.sleep(0.2)
+
+        code, body = _get(f"{base}/api/ingest")
+        elapsed = (time.time() - start) * 1000
+        if code != 200:
+            return TestResult(name, Verdict.FAIL, elapsed, f"HTTP {code}")
+        stats = json.loads(body).get("stats", {})
+        summary = (f"{stats.get('frames')} frames, {stats.get('lost')} lost, "
+                   f"{stats.get('late')} late, {stats.get('overflows')} overflows, "
+                   f"peak depth {stats.get('depthPeak')}, "
+                   f"worst hold {stats.get('worstHoldUs', 0) / 1000:.1f} ms")
+        if stats.get("frames", 0) == 0:
+            return TestResult(name, Verdict.FAIL, elapsed, "No frames forwarded", summary)
+        if stats.get("lost") != 1 or stats.get("late", 0) > 0:
+            # WiFi can lose or delay packets of its own; worth a look, not a failure
+            return TestResult(name, Verdict.WARN, elapsed,
+                              "Expected 1 lost and 0 late", summary)
+        return TestResult(name, Verdict.PASS, elapsed, summary)
+    except Exception as e:
+        elapsed = (time.time() - start) * 1000
+        return TestResult(name, Verdict.FAIL, elapsed, str(e))
+
+
 def test_sync_data(base: str) -> TestResult:
     """GET /api/sync/data and verify it returns image/pattern listings."""
     start = time.time()
@@ -262,6 +433,135 @@ def test_sd_info(base: str) -> TestResult:
         return TestResult("GET /api/sd/info", Verdict.FAIL, elapsed, str(e))
 
 
+def test_assets(base: str) -> TestResult:
+    """GET /api/assets, then push the newest stored image back to its slot."""
+    start = time.time()
+    try:
+        code, body = _get(f"{base}/api/assets")
+        if code != 200:
+            return TestResult("Flash asset store", Verdict.FAIL,
+                              (time.time() - start) * 1000, f"HTTP {code}")
+        data = json.loads(body)
+        if not data.get("mounted"):
+            return TestResult("Flash asset store", Verdict.FAIL, (time.time() - start) * 1000,
+                              "Assets partition not mounted (flash partitions.csv)")
+        stats, restore = data["stats"], data["restore"]
+        msg = (f"{len(data['assets'])} images, {data['assetBytes']} bytes; "
+               f"{stats['writes']} writes, {stats['dedupHits']} dedup hits; "
+               f"restore {restore['state']} {restore['sent']}/{restore['assets']} "
+               f"in {restore['transferMs']} ms, {restore['bootToRestoredMs']} ms after boot")
+        if not data["assets"]:
+            return TestResult("Flash asset store", Verdict.WARN, (time.time() - start) * 1000,
+                              msg + " (upload an image to test a re-push)")
+
+        newest = max(data["assets"], key=lambda a: a["lastUsed"])
+        push_start = time.time()
+        code, body = _post_json(f"{base}/api/assets", {"push": newest["hash"]}, timeout=15)
+        push_ms = (time.time() - push_start) * 1000
+        elapsed = (time.time() - start) * 1000
+        if code != 200:
+            return TestResult("Flash asset store", Verdict.FAIL, elapsed,
+                              f"Re-push HTTP {code}", body[:200])
+        return TestResult("Flash asset store", Verdict.PASS, elapsed,
+                          msg + f"; re-pushed {newest['bytes']} bytes to slot "
+                          f"{newest['slot']} in {push_ms:.0f} ms")
+    except Exception as e:
+        elapsed = (time.time() - start) * 1000
+        return TestResult("Flash asset store", Verdict.FAIL, elapsed, str(e))
+
+
+def test_upload_progressive(base: str) -> TestResult:
+    """Upload a new image; it should go column-major and show long before it is complete."""
+    start = time.time()
+    width, height = 300, 32
+    rgb = bytes((x * 17 + y * 7 + c * 50 + int(start)) & 0xFF
+                for y in range(height) for x in range(width) for c in range(3))
+    try:
+        code, body = _post_image(f"{base}/api/image", width, height, rgb)
+        elapsed = (time.time() - start) * 1000
+        if code != 200:
+            return TestResult("Progressive upload", Verdict.FAIL, elapsed, f"HTTP {code}", body[:200])
+        data = json.loads(body)
+        if data.get("transfer") != "progressive":
+            _, body = _get(f"{base}/api/upload")
+            supported = json.loads(body)["progressive"]["supported"]
+            return TestResult("Progressive upload", Verdict.FAIL if supported else Verdict.WARN,
+                              elapsed, f"Sent as {data.get('transfer')}" +
+                              ("" if supported else " (Teensy firmware has no progressive uploads)"))
+        coarse, total = data["coarseMs"], data["totalMs"]
+        msg = (f"{data['bytesSent']} bytes; every 8th column shown after {coarse} ms "
+               f"of {total} ms ({coarse / max(1, total) * 100:.0f}%)")
+        ok = total > 0 and coarse * 4 <= total
+        return TestResult("Progressive upload", Verdict.PASS if ok else Verdict.FAIL, elapsed, msg)
+    except Exception as e:
+        elapsed = (time.time() - start) * 1000
+        return TestResult("Progressive upload", Verdict.FAIL, elapsed, str(e))
+
+
+def test_upload_delta(base: str) -> TestResult:
+    """Upload an image, then an edit of it; the edit should go as a column patch."""
+    start = time.time()
+    width, height = 200, 32
+    rgb = bytearray((x * 3 + y * 11 + c * 70) & 0xFF
+                    for y in range(height) for x in range(width) for c in range(3))
+    try:
+        code, body = _post_image(f"{base}/api/image", width, height, bytes(rgb))
+        if code != 200:
+            return TestResult("Delta re-upload", Verdict.FAIL,
+                              (time.time() - start) * 1000, f"Base upload HTTP {code}", body[:200])
+        for y in range(height):
+            for x in range(40, 48):
+                rgb[(y * width + x) * 3:(y * width + x) * 3 + 3] = bytes([0, 255, y * 8])
+        edit_start = time.time()
+        code, body = _post_image(f"{base}/api/image", width, height, bytes(rgb))
+        edit_ms = (time.time() - edit_start) * 1000
+        if code != 200:
+            return TestResult("Delta re-upload", Verdict.FAIL,
+                              (time.time() - start) * 1000, f"Edit upload HTTP {code}", body[:200])
+        edit = json.loads(body)
+        _, body = _get(f"{base}/api/upload")
+        stats = json.loads(body)
+        elapsed = (time.time() - start) * 1000
+        msg = (f"edit sent as {edit.get('transfer')}: {edit.get('bytesSent')} bytes, "
+               f"{edit.get('bytesSaved')} saved, {edit_ms:.0f} ms; totals {stats['patches']} "
+               f"patches, {stats['fullUploads']} full, {stats['bytesSaved']} bytes saved")
+        if not stats["patchSupported"]:
+            return TestResult("Delta re-upload", Verdict.WARN, elapsed,
+                              msg + " (Teensy firmware has no column patches)")
+        ok = edit.get("transfer") == "patch" and edit.get("columns") == 8
+        return TestResult("Delta re-upload", Verdict.PASS if ok else Verdict.FAIL, elapsed, msg)
+    except Exception as e:
+        elapsed = (time.time() - start) * 1000
+        return TestResult("Delta re-upload", Verdict.FAIL, elapsed, str(e))
+
+
+def test_tasks(base: str) -> TestResult:
+    """GET /api/tasks - CPU share and worst latencies over the suite so far."""
+    start = time.time()
+    try:
+        code, body = _get(f"{base}/api/tasks")
+        elapsed = (time.time() - start) * 1000
+        if code != 200:
+            return TestResult("GET /api/tasks", Verdict.FAIL, elapsed, f"HTTP {code}")
+        data = json.loads(body)
+        tasks = {t["name"]: t for t in data.get("tasks", [])}
+        if set(tasks) != {"link", "http", "sync", "house"}:
+            return TestResult("GET /api/tasks", Verdict.FAIL, elapsed,
+                              f"Unexpected tasks: {sorted(tasks)}")
+        summary = ", ".join(f"{name} {t['cpuPercent']}% worst {t['worstRunUs'] / 1000:.1f}/"
+                            f"{t['worstLateUs'] / 1000:.1f} ms"
+                            for name, t in tasks.items())
+        # The link task must keep up while the web server and sync work
+        if tasks["link"]["worstLateUs"] > 50000:
+            return TestResult("GET /api/tasks", Verdict.WARN, elapsed,
+                              f"Link task started up to {tasks['link']['worstLateUs'] / 1000:.0f} ms late",
+                              summary)
+        return TestResult("GET /api/tasks", Verdict.PASS, elapsed, summary)
+    except Exception as e:
+        elapsed = (time.time() - start) * 1000
+        return TestResult("GET /api/tasks", Verdict.FAIL, elapsed, str(e))
+
+
 # ---------------------------------------------------------------------------
 # Suite runner
 # ---------------------------------------------------------------------------
@@ -292,6 +592,9 @@ def run(base_url: str = DEFAULT_BASE_URL) -> TestReport:
     report.add(test_set_brightness(base_url, 255))
     report.add(test_set_brightness(base_url, origBrightness))
 
+    # 3b. OSC control path against HTTP
+    report.add(test_osc_latency(base_url, origBrightness))
+
     # 4. Frame rate control
     report.add(test_set_framerate(base_url, 60))
     report.add(test_set_framerate(base_url, origFramerate))
@@ -315,6 +618,7 @@ def run(base_url: str = DEFAULT_BASE_URL) -> TestReport:
     # 7. Live mode
     report.add(test_set_mode(base_url, 4, 0, "Live mode"))
     report.add(test_live_mode(base_url))
+    report.add(test_udp_ingest(base_url))
 
     # 8. Sync endpoints
     report.add(test_sync_data(base_url))
@@ -327,6 +631,18 @@ def run(base_url: str = DEFAULT_BASE_URL) -> TestReport:
     report.add(test_sd_list(base_url))
     report.add(test_sd_info(base_url))
 
+    # 10a. Flash asset store and re-push
+    report.add(test_assets(base_url))
+
+    # 10b. New image sent column-major, shown while it arrives
+    report.add(test_upload_progressive(base_url))
+
+    # 10c. Edited image re-uploaded as a column patch
+    report.add(test_upload_delta(base_url))
+
+    # 10d. Task runtime statistics over the suite
+    report.add(test_tasks(base_url))
+
     # 11. Cleanup - return to idle
     report.add(test_set_mode(base_url, 0, 0, "Idle (cleanup)"))
 
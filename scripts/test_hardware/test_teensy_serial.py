@@ -12,9 +12,15 @@ from typing import Optional
 
 from .protocol import (
     Cmd, Resp, Mode,
-    set_mode, set_brightness, set_framerate, set_framerate_legacy,
+    set_mode, set_brightness, set_framerate, set_framerate_legacy, set_duty, batch,
     request_status,
     upload_pattern, live_frame, build_packet,
+    upload_image_slot, request_link_stats, parse_link_stats,
+    request_readback, parse_readback, load_show, parse_show_event,
+    sd_save, sd_load, request_sd_writer, parse_sd_writer_queued, parse_sd_load_event,
+    particle_bench, parse_particle_bench,
+    image_digest, patch_image, parse_patch_result, PATCH_OK, PATCH_BASE_CHANGED,
+    progressive_upload, parse_progressive_result, request_slot_map, parse_slot_map,
     parse_response, parse_status, is_ack, StatusResponse,
 )
 from .result import TestResult, TestReport, Verdict
@@ -119,6 +125,16 @@ def test_framerate(ser: serial.Serial) -> list[TestResult]:
     return results
 
 
+def test_duty(ser: serial.Serial) -> list[TestResult]:
+    """Test column duty-cycle blanking, ending back at 100% (no blanking)."""
+    results = []
+    for val, label in [(5, "min"), (50, "50%"), (100, "off")]:
+        pkt = set_duty(val)
+        results.append(_send_and_expect_ack(ser, pkt, f"Column duty {label} ({val})"))
+        time.sleep(0.15)
+    return results
+
+
 def test_modes(ser: serial.Serial) -> list[TestResult]:
     """Cycle through every display mode and verify via status."""
     results = []
@@ -146,6 +162,9 @@ def test_modes(ser: serial.Serial) -> list[TestResult]:
         (Mode.PATTERN, 15, "Pattern 15 (Music Sparkle)"),
         (Mode.PATTERN, 16, "Pattern 16 (Split Spin)"),
         (Mode.PATTERN, 17, "Pattern 17 (Theater Chase)"),
+        (Mode.PATTERN, 18, "Pattern 18 (Fireworks)"),
+        (Mode.PATTERN, 19, "Pattern 19 (Rain)"),
+        (Mode.PATTERN, 20, "Pattern 20 (Sparks)"),
         (Mode.SEQUENCE, 0, "Sequence 0 (Demo)"),
     ]
 
@@ -178,6 +197,24 @@ def test_pattern_upload(ser: serial.Serial) -> TestResult:
     return _send_and_expect_ack(ser, pkt, "Upload custom pattern config")
 
 
+def test_batch(ser: serial.Serial) -> list[TestResult]:
+    """Pattern config, mode and brightness in one 0x17 frame; one ACK, mode applied."""
+    pkt = batch(upload_pattern(index=3, ptype=3), set_mode(Mode.PATTERN, 3),
+                set_brightness(128))
+    results = [_send_and_expect_ack(ser, pkt, "Batch (pattern + mode + brightness)")]
+    time.sleep(0.15)
+
+    stat_result, status = _send_and_expect_status(ser)
+    stat_result.name = "Verify batch mode"
+    if status and (status.mode != Mode.PATTERN or status.index != 3):
+        stat_result = TestResult(
+            "Verify batch mode", Verdict.FAIL, stat_result.duration_ms,
+            f"Expected mode={Mode.PATTERN} index=3, "
+            f"got mode={status.mode} index={status.index}")
+    results.append(stat_result)
+    return results
+
+
 def test_live_frame(ser: serial.Serial) -> TestResult:
     """Send a live frame of all-red pixels after switching to live mode."""
     pixels = [(255, 0, 0)] * 31
@@ -205,6 +242,332 @@ def test_live_frame(ser: serial.Serial) -> TestResult:
                       "Frame sent (visual check recommended)")
 
 
+def _read_back(ser: serial.Serial, slot: int = 0, name: str = "") -> tuple[bytes, Optional[int]]:
+    """Read a slot, or an SD file if name is set, back in chunks; (bytes, total or None)."""
+    received = b""
+    total = None
+    while total is None or len(received) < total:
+        ser.reset_input_buffer()
+        ser.write(request_readback(len(received), slot=slot, name=name))
+        deadline = time.time() + RESPONSE_TIMEOUT
+        raw = b""
+        chunk = None
+        while time.time() < deadline and chunk is None:
+            raw += ser.read(ser.in_waiting or 1)
+            chunk = parse_readback(raw)
+        if chunk is None or chunk.status != 0 or not chunk.data:
+            break
+        total = chunk.total
+        received += chunk.data
+    return received, total
+
+
+def _wait_sd_writer(ser: serial.Serial, timeout: float = 10.0) -> Optional[int]:
+    """Poll the SD writer until its queue is empty; jobs left, or None without a report."""
+    deadline = time.time() + timeout
+    queued = None
+    while time.time() < deadline and queued != 0:
+        ser.reset_input_buffer()
+        ser.write(request_sd_writer())
+        end = time.time() + RESPONSE_TIMEOUT
+        raw = b""
+        queued = None
+        while time.time() < end and queued is None:
+            raw += ser.read(ser.in_waiting or 1)
+            queued = parse_sd_writer_queued(raw)
+        if queued is None:
+            return None
+    return queued
+
+
+def test_bulk_upload(ser: serial.Serial) -> list[TestResult]:
+    """Upload full-size images to spare slots over USB and report throughput."""
+    results = []
+    width, height, count = 400, 32, 5
+    rgb = bytes((x * 7 + y * 3 + c * 85) & 0xFF
+                for y in range(height) for x in range(width) for c in range(3))
+    acked = 0
+    start = time.time()
+    for slot in range(190, 190 + count):
+        ser.reset_input_buffer()
+        ser.write(upload_image_slot(slot, width, height, rgb))
+        if is_ack(_read_response(ser, timeout=2.0)):
+            acked += 1
+    elapsed = (time.time() - start) * 1000
+    total = count * (len(rgb) + 10)
+    rate = total / max(elapsed / 1000, 1e-6) / 1e6
+    verdict = Verdict.PASS if acked == count else Verdict.FAIL
+    results.append(TestResult(f"Bulk upload ({count}x {width}x{height} to slots 190+)",
+                              verdict, elapsed,
+                              f"{acked}/{count} ACKed, {rate:.2f} MB/s"))
+
+    # Read the last slot back in chunks; the .pov form is header + RGB
+    start = time.time()
+    received, total = _read_back(ser, slot=190 + count - 1)
+    elapsed = (time.time() - start) * 1000
+    expected = 4 + width * height * 3
+    if total == expected and len(received) == expected:
+        results.append(TestResult("Slot read-back", Verdict.PASS, elapsed,
+                                  f"{len(received)} bytes in {elapsed:.0f} ms"))
+    else:
+        results.append(TestResult("Slot read-back", Verdict.FAIL, elapsed,
+                                  f"Got {len(received)} of {total} bytes, expected {expected}"))
+
+    # Save the same slot as .pov v1 and read the file back; it holds the same bytes
+    ser.reset_input_buffer()
+    ser.write(sd_save("bench_rb", 190 + count - 1, 1))
+    _read_response(ser)
+    start = time.time()
+    if _wait_sd_writer(ser) != 0:
+        results.append(TestResult("SD file read-back", Verdict.SKIP, 0, "No SD card or save not finished"))
+    else:
+        file_data, file_total = _read_back(ser, name="bench_rb")
+        elapsed = (time.time() - start) * 1000
+        if file_total is None:
+            results.append(TestResult("SD file read-back", Verdict.FAIL, elapsed, "File not found"))
+        elif file_data == received and file_total == len(received):
+            results.append(TestResult("SD file read-back", Verdict.PASS, elapsed,
+                                      f"{len(file_data)} bytes in {elapsed:.0f} ms"))
+        else:
+            results.append(TestResult("SD file read-back", Verdict.FAIL, elapsed,
+                                      f"Got {len(file_data)} of {file_total} bytes, "
+                                      f"expected the slot's {len(received)}"))
+
+    # Link statistics (fixed-length frame, payload may contain 0xFE)
+    start = time.time()
+    ser.reset_input_buffer()
+    ser.write(request_link_stats())
+    deadline = time.time() + RESPONSE_TIMEOUT
+    raw = b""
+    stats = None
+    while time.time() < deadline and stats is None:
+        raw += ser.read(ser.in_waiting or 1)
+        stats = parse_link_stats(raw)
+    elapsed = (time.time() - start) * 1000
+    if stats and stats["usb"].frames > 0:
+        usb = stats["usb"]
+        results.append(TestResult("Link statistics", Verdict.PASS, elapsed,
+                                  f"usb frames={usb.frames} errors={usb.errors} "
+                                  f"rate={usb.bytes_per_sec} B/s"))
+    else:
+        results.append(TestResult("Link statistics", Verdict.FAIL, elapsed,
+                                  "No valid link statistics response",
+                                  f"Raw: {raw.hex().upper()}"))
+    return results
+
+
+def test_show_bundle(ser: serial.Serial, name: str = "bench100") -> TestResult:
+    """Load a show bundle from SD and report the load time.
+
+    Build one with: python examples/image_converter.py --bundle <dir> bench100.show
+    and copy it to /poi_shows/ on the Teensy's card.
+    """
+    test = f"Show bundle load ({name})"
+    start = time.time()
+    ser.reset_input_buffer()
+    ser.write(load_show(name))
+    deadline = time.time() + 30.0
+    raw = b""
+    event = None
+    while time.time() < deadline and event is None:
+        raw += ser.read(ser.in_waiting or 1)
+        event = parse_show_event(raw)
+    elapsed = (time.time() - start) * 1000
+    if event is None:
+        return TestResult(test, Verdict.FAIL, elapsed, "No 0xC6 event",
+                          f"Raw: {raw[-64:].hex().upper()}")
+    if event.status == 3:
+        return TestResult(test, Verdict.SKIP, elapsed, "Bundle not on SD card")
+    msg = (f"{event.assets_done}/{event.asset_count} assets ({event.images} images), "
+           f"{event.bytes} bytes in {event.total_us / 1000:.1f} ms "
+           f"(read {event.read_us / 1000:.1f} ms, apply {event.apply_us / 1000:.1f} ms, "
+           f"{event.passes} passes)")
+    verdict = Verdict.PASS if event.status == 2 else Verdict.FAIL
+    return TestResult(test, verdict, elapsed, msg)
+
+
+def test_sd_formats(ser: serial.Serial, slot: int = 189) -> list[TestResult]:
+    """Save one image as .pov v1 and v2, load both back and compare the times."""
+    results = []
+    width, height = 200, 32
+    # Bands with a gradient: typical POV art, compresses but not trivially
+    rgb = bytes(((x // 20) * 50 + y * 2 + c * 60) & 0xFF if (x // 10) % 3 else 0
+                for y in range(height) for x in range(width) for c in range(3))
+    ser.reset_input_buffer()
+    ser.write(upload_image_slot(slot, width, height, rgb))
+    if not is_ack(_read_response(ser, timeout=2.0)):
+        return [TestResult("SD format load times", Verdict.FAIL, 0, "Upload not ACKed")]
+
+    for fmt in (1, 2):
+        ser.reset_input_buffer()
+        ser.write(sd_save(f"bench_v{fmt}", slot, fmt))
+        _read_response(ser)
+    if _wait_sd_writer(ser) is None:
+        return [TestResult("SD format load times", Verdict.SKIP, 0, "No SD writer report")]
+
+    for fmt in (1, 2):
+        test = f"SD load .pov v{fmt}"
+        start = time.time()
+        ser.reset_input_buffer()
+        ser.write(sd_load(f"bench_v{fmt}", slot))
+        deadline = time.time() + 5.0
+        raw = b""
+        event = None
+        while time.time() < deadline and (event is None or event.status == 1):
+            raw += ser.read(ser.in_waiting or 1)
+            event = parse_sd_load_event(raw)
+            if event is not None and event.status == 1:
+                raw = b""
+        elapsed = (time.time() - start) * 1000
+        if event is None:
+            results.append(TestResult(test, Verdict.FAIL, elapsed, "No 0xC4 event"))
+        elif event.status == 3:
+            results.append(TestResult(test, Verdict.SKIP, elapsed, "No SD card or file not saved"))
+        else:
+            msg = (f"{event.file_bytes} bytes, total {event.total_us / 1000:.1f} ms "
+                   f"(read {event.read_us / 1000:.1f} ms, decode {event.decode_us / 1000:.1f} ms, "
+                   f"{event.passes} passes)")
+            ok = event.status == 2 and event.format == fmt
+            results.append(TestResult(test, Verdict.PASS if ok else Verdict.FAIL, elapsed, msg))
+    return results
+
+
+def test_particles(ser: serial.Serial) -> list[TestResult]:
+    """Play each particle pattern, then time the engine at growing pool sizes."""
+    results = []
+    for ptype, name in ((18, "fireworks"), (19, "rain"), (20, "sparks")):
+        pkt = batch(upload_pattern(index=ptype, ptype=ptype, color1=(255, 160, 0),
+                                   color2=(0, 80, 255), speed=80),
+                    set_mode(Mode.PATTERN, ptype))
+        results.append(_send_and_expect_ack(ser, pkt, f"Particle pattern ({name})"))
+        time.sleep(0.5)
+
+    for count in (64, 256, 512):
+        test = f"Particle bench ({count})"
+        start = time.time()
+        ser.reset_input_buffer()
+        ser.write(particle_bench(count, 1000))
+        raw = _read_response(ser, timeout=2.0)
+        elapsed = (time.time() - start) * 1000
+        bench = parse_particle_bench(raw)
+        if bench is None:
+            results.append(TestResult(test, Verdict.FAIL, elapsed, "No 0xC8 report",
+                                      f"Raw: {raw.hex().upper()}"))
+            continue
+        # Step + draw must leave most of the column period for output and the link
+        share = bench.avg_ns / 10 / max(1, bench.period_us)
+        msg = (f"{bench.avg_ns} ns/column avg, {bench.worst_us} us worst, "
+               f"{share:.1f}% of {bench.period_us} us; live pool {bench.live_count} "
+               f"(peak {bench.live_peak}, dropped {bench.dropped})")
+        ok = bench.particles == count and share < 50
+        results.append(TestResult(test, Verdict.PASS if ok else Verdict.FAIL, elapsed, msg))
+    return results
+
+
+def test_column_patch(ser: serial.Serial, slot: int = 188) -> list[TestResult]:
+    """Patch a few columns of a stored image and check a stale base is refused."""
+    results = []
+    width, height = 400, 32
+    old = bytes((x * 5 + y * 9 + c * 60) & 0xFF
+                for y in range(height) for x in range(width) for c in range(3))
+    new = bytearray(old)
+    for y in range(height):
+        for x in range(100, 110):
+            new[(y * width + x) * 3:(y * width + x) * 3 + 3] = bytes([255, y * 8, 0])
+    new = bytes(new)
+
+    ser.reset_input_buffer()
+    ser.write(upload_image_slot(slot, width, height, old))
+    if not is_ack(_read_response(ser, timeout=2.0)):
+        return [TestResult(f"Column patch (slot {slot})", Verdict.FAIL, 0, "Base upload not ACKed")]
+
+    # The second patch names the image the first one replaced, so it must be refused
+    cases = (("Column patch", image_digest(old, width, height), PATCH_OK, 10),
+             ("Column patch, stale base", image_digest(old, width, height), PATCH_BASE_CHANGED, 0),
+             ("Column patch, patched base", image_digest(new, width, height), PATCH_OK, 10))
+    for test, digest, want, columns in cases:
+        packet = patch_image(slot, width, height, digest, [(100, 10)], new)
+        start = time.time()
+        ser.reset_input_buffer()
+        ser.write(packet)
+        raw = _read_response(ser, timeout=2.0)
+        elapsed = (time.time() - start) * 1000
+        result = parse_patch_result(raw)
+        if result is None:
+            results.append(TestResult(test, Verdict.FAIL, elapsed, "No 0xC9 result",
+                                      f"Raw: {raw.hex().upper()}"))
+            continue
+        status, patched = result
+        msg = (f"status {status}, {patched} columns, {len(packet)} of "
+               f"{width * height * 3 + 10} bytes in {elapsed:.0f} ms")
+        ok = status == want and patched == columns
+        results.append(TestResult(test, Verdict.PASS if ok else Verdict.FAIL, elapsed, msg))
+    return results
+
+
+def _read_progressive_result(ser: serial.Serial, timeout: float = 2.0):
+    """Read until a whole 0xCA frame is in; its timings may contain 0xFE."""
+    deadline = time.time() + timeout
+    raw = b""
+    result = None
+    while time.time() < deadline and result is None:
+        raw += ser.read(ser.in_waiting or 1)
+        result = parse_progressive_result(raw)
+    return raw, result
+
+
+def test_progressive_upload(ser: serial.Serial, slot: int = 187) -> list[TestResult]:
+    """Upload an image column-major in interleaved passes and check it is committed."""
+    results = []
+    width, height = 400, 32
+    rgb = bytes((x * 13 + y * 5 + c * 90) & 0xFF
+                for y in range(height) for x in range(width) for c in range(3))
+    frames = progressive_upload(slot, width, height, rgb, show=False)
+    start = time.time()
+    ser.reset_input_buffer()
+    for frame in frames:
+        ser.write(frame)
+    raw, result = _read_progressive_result(ser)
+    elapsed = (time.time() - start) * 1000
+    if result is None:
+        return [TestResult("Progressive upload", Verdict.FAIL, elapsed, "No 0xCA result",
+                           f"Raw: {raw.hex().upper()}")]
+    share = result.coarse_us / max(1, result.total_us) * 100
+    msg = (f"status {result.status}, {result.received}/{width} columns in {len(frames)} frames; "
+           f"coarse after {result.coarse_us} us of {result.total_us} us ({share:.0f}%)")
+    ok = result.status == 0 and result.received == width and 0 < result.coarse_us <= result.total_us
+    results.append(TestResult("Progressive upload", Verdict.PASS if ok else Verdict.FAIL, elapsed, msg))
+
+    # Without the gap passes the image is incomplete and the slot keeps the one just stored
+    ser.reset_input_buffer()
+    for frame in frames[:5] + frames[-1:]:
+        ser.write(frame)
+    _, result = _read_progressive_result(ser)
+    ok = result is not None and result.status == 2
+    results.append(TestResult("Progressive upload, incomplete", Verdict.PASS if ok else Verdict.FAIL, 0,
+                              f"status {result.status if result else None}"))
+    return results
+
+
+def test_slot_map(ser: serial.Serial, slots: tuple[int, ...] = (187, 188)) -> TestResult:
+    """Check the slot map lists the slots the upload tests filled."""
+    start = time.time()
+    ser.reset_input_buffer()
+    ser.write(request_slot_map())
+    deadline = start + 1.0
+    raw = b""
+    active = None
+    while time.time() < deadline and active is None:
+        raw += ser.read(ser.in_waiting or 1)
+        active = parse_slot_map(raw)
+    elapsed = (time.time() - start) * 1000
+    if active is None:
+        return TestResult("Slot map", Verdict.FAIL, elapsed, "No 0xCB map", f"Raw: {raw.hex().upper()}")
+    ok = all(s in active for s in slots)
+    return TestResult("Slot map", Verdict.PASS if ok else Verdict.FAIL, elapsed,
+                      f"{len(active)} slots hold an image")
+
+
 def test_idle_cleanup(ser: serial.Serial) -> TestResult:
     """Return to idle mode at end of tests."""
     return _send_and_expect_ack(ser, set_mode(Mode.IDLE, 0), "Return to idle")
@@ -229,6 +592,10 @@ def run(ser: serial.Serial) -> TestReport:
     for r in test_framerate(ser):
         report.add(r)
 
+    # 3b. Column duty cycle
+    for r in test_duty(ser):
+        report.add(r)
+
     # 4. All modes + verification
     for r in test_modes(ser):
         report.add(r)
@@ -236,9 +603,39 @@ def run(ser: serial.Serial) -> TestReport:
     # 5. Pattern upload
     report.add(test_pattern_upload(ser))
 
+    # 5b. Batched commands
+    for r in test_batch(ser):
+        report.add(r)
+
     # 6. Live frame
     report.add(test_live_frame(ser))
 
+    # 6b. Bulk upload throughput over USB
+    for r in test_bulk_upload(ser):
+        report.add(r)
+
+    # 6c. Show bundle from SD
+    report.add(test_show_bundle(ser))
+
+    # 6d. .pov v1 vs v2 load times
+    for r in test_sd_formats(ser):
+        report.add(r)
+
+    # 6e. Particle patterns and engine cost
+    for r in test_particles(ser):
+        report.add(r)
+
+    # 6f. Column patches of a stored image
+    for r in test_column_patch(ser):
+        report.add(r)
+
+    # 6g. Progressive column-major upload
+    for r in test_progressive_upload(ser):
+        report.add(r)
+
+    # 6h. Slot map (what the ESP32 asks before restoring stored images)
+    report.add(test_slot_map(ser))
+
     # 7. Cleanup
     report.add(test_idle_cleanup(ser))
 
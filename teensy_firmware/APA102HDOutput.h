@@ -0,0 +1,238 @@
+/*
+ * High-Dynamic-Range APA102 Output for POV Poi
+ *
+ * FastLED dims by scaling the 8-bit RGB values and always sends the APA102
+ * per-LED 5-bit global current field at full scale, so at the low
+ * brightness used to save battery most of the colour depth is lost and
+ * gradients band. This output stage instead treats every channel as a
+ * 16-bit linear intensity and splits it across both hardware controls:
+ *
+ *   intensity = (global / 31) * (pwm / 255)
+ *
+ * The 5-bit global current is chosen per LED from its brightest channel
+ * and the 8-bit PWM values then use their full range at that current, so a
+ * dim pixel keeps ~8 bits of precision instead of the 2-3 left after
+ * scaling. Lowering the global current reduces the drive current itself,
+ * so a dim show draws no more than the FastLED path.
+ *
+ * All per-channel work goes through precomputed tables:
+ * - _level[256]:          8-bit value -> gamma-corrected 16-bit intensity,
+ *                         pre-scaled by the master brightness
+ * - _globalForPeak[256]:  high byte of the brightest channel -> global current
+ * - _pwmScale[32]:        16.16 factor from intensity to 8.8 PWM per global
+ *
+ * Optional temporal dithering carries each channel's PWM remainder into
+ * the next frame (the next POV column), so sub-LSB levels average out
+ * instead of being truncated.
+ *
+ * Hardware: drives the strip's hardware SPI pins (MOSI 11 / SCK 13 on
+ * Teensy 4.1) directly, using the same SPI object as FastLED. The wire
+ * order after the header byte is B, G, R (COLOR_ORDER BGR).
+ */
+
+#ifndef APA102_HD_OUTPUT_H
+#define APA102_HD_OUTPUT_H
+
+#if defined(__INTELLISENSE__) || defined(__clangd__)
+  // Shims for editor/indexer environments (IntelliSense, clangd).
+  // Checked first so that editors defining ARDUINO still get stubs instead of
+  // trying to resolve unavailable Arduino core headers.
+  #include <cstdint>
+  #include <cstddef>
+  #include <cmath>
+
+  #define MSBFIRST 1
+  #define SPI_MODE0 0
+
+  struct CRGB { uint8_t r, g, b; };
+
+  struct SPISettings {
+    SPISettings(uint32_t, uint8_t, uint8_t) {}
+  };
+
+  struct APA102HDSPIShim {
+    void begin() {}
+    void beginTransaction(const SPISettings&) {}
+    void transfer(const void*, void*, size_t) {}
+    void endTransaction() {}
+  };
+
+  static APA102HDSPIShim SPI;
+#elif __has_include(<Arduino.h>)
+  #include <Arduino.h>
+  #include <SPI.h>
+  #include <FastLED.h>
+#elif __has_include(<WProgram.h>)
+  // Fallback for older Arduino cores that ship WProgram.h instead of Arduino.h.
+  #include <WProgram.h>
+  #include <SPI.h>
+  #include <FastLED.h>
+#else
+  // Reached only when neither Arduino.h nor WProgram.h is available and we are
+  // not inside an editor/indexer session.  This produces a clear compile-time
+  // error instead of a cryptic "file not found" message.
+  #error "Arduino.h not found. Ensure the Arduino core is installed and your board is correctly configured."
+#endif
+
+#define APA102_HD_DEFAULT_GAMMA 2.2f
+#define APA102_HD_MAX_GLOBAL 31
+
+template <uint16_t NUM_LEDS_T>
+class APA102HDOutput {
+public:
+  explicit APA102HDOutput(uint32_t spiClockHz) : _spiClockHz(spiClockHz) {}
+
+  // Builds the lookup tables; call once before show()
+  void begin(float gamma = APA102_HD_DEFAULT_GAMMA);
+
+  // Rebuilds the gamma table (exponent 1.0-3.0)
+  void setGamma(float gamma);
+  float gamma() const { return _gamma; }
+
+  // Temporal dithering of the PWM remainder across frames
+  void setDither(bool enabled);
+  bool dither() const { return _dither; }
+
+  // Sends one frame; brightness is the 8-bit master level (FastLED scale)
+  void show(const CRGB* leds, uint8_t brightness);
+
+  // Sends an all-off frame (column blanking); dither state is kept
+  void showBlack();
+
+private:
+  void buildLevelTable(uint8_t brightness);
+  void sendFrame();
+
+  static const uint16_t kStartBytes = 4;
+  static const uint16_t kEndBytes = 4 + (NUM_LEDS_T + 15) / 16;
+  static const uint16_t kFrameBytes = kStartBytes + NUM_LEDS_T * 4 + kEndBytes;
+
+  uint32_t _spiClockHz;
+  float _gamma = APA102_HD_DEFAULT_GAMMA;
+  bool _dither = true;
+  int16_t _levelBrightness = -1;     // Brightness _level was built for
+
+  uint16_t _gamma16[256];            // 8-bit value -> 16-bit linear intensity
+  uint16_t _level[256];              // _gamma16 scaled by the master brightness
+  uint8_t _globalForPeak[256];       // Peak intensity >> 8 -> 5-bit global current
+  uint32_t _pwmScale[APA102_HD_MAX_GLOBAL + 1];  // Intensity -> 8.8 PWM (16.16)
+  uint8_t _error[NUM_LEDS_T][3];     // Dither remainders (fraction of one PWM step)
+  uint8_t _frame[kFrameBytes];
+};
+
+// Implementation
+template <uint16_t NUM_LEDS_T>
+inline void APA102HDOutput<NUM_LEDS_T>::begin(float gamma) {
+  SPI.begin();
+
+  // Smallest global current whose full-scale PWM still reaches the top of
+  // each 256-wide intensity bucket
+  for (uint16_t i = 0; i < 256; i++) {
+    uint32_t bucketTop = ((uint32_t)i << 8) | 0xFF;
+    uint32_t global = (bucketTop * APA102_HD_MAX_GLOBAL + 65534) / 65535;
+    if (global < 1) global = 1;
+    if (global > APA102_HD_MAX_GLOBAL) global = APA102_HD_MAX_GLOBAL;
+    _globalForPeak[i] = (uint8_t)global;
+  }
+
+  // pwm = intensity / 65535 * (31 / global) * 255, kept as 8.8 fixed point
+  _pwmScale[0] = 0;
+  for (uint8_t g = 1; g <= APA102_HD_MAX_GLOBAL; g++) {
+    _pwmScale[g] = (uint32_t)((255.0 * 256.0 * APA102_HD_MAX_GLOBAL * 65536.0) /
+                              (65535.0 * g) + 0.5);
+  }
+
+  memset(_error, 0, sizeof(_error));
+  memset(_frame, 0, sizeof(_frame));
+  setGamma(gamma);
+}
+
+template <uint16_t NUM_LEDS_T>
+inline void APA102HDOutput<NUM_LEDS_T>::setGamma(float gamma) {
+  if (gamma < 1.0f) gamma = 1.0f;
+  if (gamma > 3.0f) gamma = 3.0f;
+  _gamma = gamma;
+  for (uint16_t v = 0; v < 256; v++) {
+    float linear = powf(v / 255.0f, gamma);
+    uint32_t level = (uint32_t)(linear * 65535.0f + 0.5f);
+    // Keep every non-zero input visible at full brightness
+    if (v > 0 && level == 0) level = 1;
+    _gamma16[v] = (uint16_t)level;
+  }
+  _levelBrightness = -1;
+}
+
+template <uint16_t NUM_LEDS_T>
+inline void APA102HDOutput<NUM_LEDS_T>::setDither(bool enabled) {
+  _dither = enabled;
+  if (!enabled) memset(_error, 0, sizeof(_error));
+}
+
+template <uint16_t NUM_LEDS_T>
+inline void APA102HDOutput<NUM_LEDS_T>::buildLevelTable(uint8_t brightness) {
+  for (uint16_t v = 0; v < 256; v++) {
+    _level[v] = (uint16_t)(((uint32_t)_gamma16[v] * brightness + 127) / 255);
+  }
+  _levelBrightness = brightness;
+}
+
+template <uint16_t NUM_LEDS_T>
+inline void APA102HDOutput<NUM_LEDS_T>::show(const CRGB* leds, uint8_t brightness) {
+  if (_levelBrightness != brightness) buildLevelTable(brightness);
+
+  uint8_t* out = &_frame[kStartBytes];
+  for (uint16_t i = 0; i < NUM_LEDS_T; i++) {
+    // Wire order B, G, R
+    uint16_t level[3] = { _level[leds[i].b], _level[leds[i].g], _level[leds[i].r] };
+    uint16_t peak = level[0];
+    if (level[1] > peak) peak = level[1];
+    if (level[2] > peak) peak = level[2];
+
+    if (peak == 0) {
+      out[0] = 0xE0;
+      out[1] = out[2] = out[3] = 0;
+      out += 4;
+      continue;
+    }
+
+    uint8_t global = _globalForPeak[peak >> 8];
+    uint32_t scale = _pwmScale[global];
+    out[0] = 0xE0 | global;
+    for (uint8_t c = 0; c < 3; c++) {
+      uint32_t pwm88 = (uint32_t)(((uint64_t)level[c] * scale) >> 16);
+      uint32_t pwm;
+      if (_dither) {
+        pwm88 += _error[i][c];
+        pwm = pwm88 >> 8;
+        _error[i][c] = (pwm < 255) ? (uint8_t)(pwm88 & 0xFF) : 0;
+      } else {
+        pwm = (pwm88 + 128) >> 8;
+      }
+      out[1 + c] = (uint8_t)(pwm > 255 ? 255 : pwm);
+    }
+    out += 4;
+  }
+
+  sendFrame();
+}
+
+template <uint16_t NUM_LEDS_T>
+inline void APA102HDOutput<NUM_LEDS_T>::showBlack() {
+  uint8_t* out = &_frame[kStartBytes];
+  for (uint16_t i = 0; i < NUM_LEDS_T; i++) {
+    out[0] = 0xE0;
+    out[1] = out[2] = out[3] = 0;
+    out += 4;
+  }
+  sendFrame();
+}
+
+template <uint16_t NUM_LEDS_T>
+inline void APA102HDOutput<NUM_LEDS_T>::sendFrame() {
+  // Start frame (32 zero bits) and end frame bytes stay zero from begin()
+  SPI.beginTransaction(SPISettings(_spiClockHz, MSBFIRST, SPI_MODE0));
+  SPI.transfer(_frame, nullptr, kFrameBytes);
+  SPI.endTransaction();
+}
+
+#endif // APA102_HD_OUTPUT_H
@@ -0,0 +1,207 @@
+/*
+ * Particle System for POV Poi Patterns
+ *
+ * A fixed pool of particles moving along the strip, stepped and drawn once
+ * per column. The pool is a structure of arrays (position, velocity, life,
+ * decay, colour) holding the live particles densely at [0, count): a
+ * particle that dies is replaced by the last one, so a step is one pass
+ * over contiguous arrays with no free list and no allocation.
+ *
+ * Units:
+ *   position  1/256 pixel from the hub end of the strip
+ *   velocity  1/256 pixel per column
+ *   life      brightness, 255 at birth; `decay` is lost every column
+ *
+ * A ParticleRule says where, how often and how particles are born (a
+ * steady rate, random bursts from one point, or both) and how they move
+ * (gravity along the strip, drag). Patterns build their rule from their
+ * colours and speed.
+ *
+ * Rendering is additive: each particle is split between the two pixels
+ * around its position by the fractional part, the contributions are
+ * summed, and the sum is added to the previous column faded by the rule's
+ * trail amount, saturating at full brightness.
+ */
+
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PARTICLE_CAPACITY 512
+#define PARTICLE_MAX_PIXELS 32
+#define PARTICLE_SUBPIXELS 256
+
+struct ParticleRule {
+  uint8_t spawnRate;      // Particles born per column, in 1/16
+  uint8_t burstChance;    // Chance per column of a burst, of 256
+  uint8_t burstSize;      // Particles per burst, all from one point
+  int16_t originMin;      // Birth position range
+  int16_t originMax;
+  int16_t velocityMin;    // Birth velocity range
+  int16_t velocityMax;
+  int16_t gravity;        // Added to every velocity each column
+  uint8_t drag;           // Velocity lost per column, in 1/256
+  uint8_t decayMin;       // Life lost per column (0 = never fades)
+  uint8_t decayMax;
+  uint8_t trail;          // How much the previous column fades, of 256 (255 = cleared)
+  uint8_t color1[3];      // Each particle gets a random mix of the two
+  uint8_t color2[3];
+};
+
+struct ParticleStats {
+  uint32_t spawned;
+  uint32_t expired;       // Faded out or left the strip
+  uint32_t dropped;       // Not born because the pool was full
+  uint16_t peak;          // Most particles alive at once
+};
+
+class ParticleSystem {
+public:
+  void clear() {
+    _count = 0;
+    _spawnCarry = 0;
+  }
+
+  uint16_t count() const { return _count; }
+  const ParticleStats& stats() const { return _stats; }
+  void resetStats() {
+    memset(&_stats, 0, sizeof(_stats));
+    _stats.peak = _count;
+  }
+
+  // Ages and moves every particle, then births new ones
+  void step(const ParticleRule& rule, uint16_t pixels) {
+    if (pixels > PARTICLE_MAX_PIXELS) pixels = PARTICLE_MAX_PIXELS;
+    int32_t limit = (int32_t)pixels * PARTICLE_SUBPIXELS;
+    uint16_t i = 0;
+    while (i < _count) {
+      int32_t v = _velocity[i] + rule.gravity;
+      v -= (v * rule.drag) >> 8;
+      int32_t p = _position[i] + v;
+      if (p < 0 || p >= limit || _life[i] <= _decay[i]) {
+        remove(i);  // The last particle moves here and is stepped next
+        continue;
+      }
+      _position[i] = (int16_t)p;
+      _velocity[i] = (int16_t)v;
+      _life[i] -= _decay[i];
+      i++;
+    }
+
+    _spawnCarry += rule.spawnRate;
+    while (_spawnCarry >= 16) {
+      _spawnCarry -= 16;
+      emit(rule, range(rule.originMin, rule.originMax));
+    }
+    if (rule.burstSize > 0 && random8() < rule.burstChance) {
+      int16_t origin = range(rule.originMin, rule.originMax);
+      for (uint8_t n = 0; n < rule.burstSize; n++) emit(rule, origin);
+    }
+    if (_count > _stats.peak) _stats.peak = _count;
+  }
+
+  // Fades `rgb` (pixels x 3 bytes) by the rule's trail and adds the particles
+  void render(const ParticleRule& rule, uint8_t* rgb, uint16_t pixels) const {
+    uint32_t sum[PARTICLE_MAX_PIXELS][3];
+    memset(sum, 0, sizeof(sum));
+    if (pixels > PARTICLE_MAX_PIXELS) pixels = PARTICLE_MAX_PIXELS;
+
+    for (uint16_t i = 0; i < _count; i++) {
+      uint16_t px = (uint16_t)_position[i] >> 8;
+      if (px >= pixels) continue;
+      uint32_t frac = (uint16_t)_position[i] & 0xFF;
+      uint32_t life = _life[i];
+      uint32_t upper = (life * frac) >> 8;  // Share of the next pixel out
+      uint32_t lower = life - upper;
+      uint32_t* s = sum[px];
+      s[0] += _r[i] * lower;
+      s[1] += _g[i] * lower;
+      s[2] += _b[i] * lower;
+      if (upper > 0 && px + 1 < pixels) {
+        s = sum[px + 1];
+        s[0] += _r[i] * upper;
+        s[1] += _g[i] * upper;
+        s[2] += _b[i] * upper;
+      }
+    }
+
+    uint32_t keep = 255 - rule.trail;
+    for (uint16_t px = 0; px < pixels; px++) {
+      for (int c = 0; c < 3; c++) {
+        uint32_t v = ((rgb[c] * keep) >> 8) + (sum[px][c] >> 8);
+        rgb[c] = v > 255 ? 255 : (uint8_t)v;
+      }
+      rgb += 3;
+    }
+  }
+
+  // Fills the pool with `n` particles from the rule; for benchmarks
+  void seed(const ParticleRule& rule, uint16_t n) {
+    clear();
+    while (_count < n && _count < PARTICLE_CAPACITY) {
+      emit(rule, range(rule.originMin, rule.originMax));
+    }
+  }
+
+private:
+  // Structure of arrays; live particles are [0, _count)
+  int16_t _position[PARTICLE_CAPACITY];
+  int16_t _velocity[PARTICLE_CAPACITY];
+  uint8_t _life[PARTICLE_CAPACITY];
+  uint8_t _decay[PARTICLE_CAPACITY];
+  uint8_t _r[PARTICLE_CAPACITY];
+  uint8_t _g[PARTICLE_CAPACITY];
+  uint8_t _b[PARTICLE_CAPACITY];
+  uint16_t _count = 0;
+  uint16_t _spawnCarry = 0;
+  uint32_t _rng = 0x9E3779B9;
+  ParticleStats _stats = {};
+
+  uint8_t random8() {
+    // xorshift32: cheap and deterministic, so benchmarks repeat
+    _rng ^= _rng << 13;
+    _rng ^= _rng >> 17;
+    _rng ^= _rng << 5;
+    return (uint8_t)(_rng >> 24);
+  }
+
+  int16_t range(int16_t lo, int16_t hi) {
+    if (hi <= lo) return lo;
+    uint32_t span = (uint32_t)(hi - lo) + 1;
+    random8();
+    return (int16_t)(lo + (int32_t)((_rng >> 8) % span));
+  }
+
+  void emit(const ParticleRule& rule, int16_t origin) {
+    if (_count >= PARTICLE_CAPACITY) {
+      _stats.dropped++;
+      return;
+    }
+    uint16_t i = _count++;
+    _position[i] = origin;
+    _velocity[i] = range(rule.velocityMin, rule.velocityMax);
+    _life[i] = 255;
+    _decay[i] = (uint8_t)range(rule.decayMin, rule.decayMax);
+    uint8_t mix = random8();
+    _r[i] = rule.color1[0] + (((rule.color2[0] - rule.color1[0]) * mix) >> 8);
+    _g[i] = rule.color1[1] + (((rule.color2[1] - rule.color1[1]) * mix) >> 8);
+    _b[i] = rule.color1[2] + (((rule.color2[2] - rule.color1[2]) * mix) >> 8);
+    _stats.spawned++;
+  }
+
+  void remove(uint16_t i) {
+    uint16_t last = --_count;
+    _position[i] = _position[last];
+    _velocity[i] = _velocity[last];
+    _life[i] = _life[last];
+    _decay[i] = _decay[last];
+    _r[i] = _r[last];
+    _g[i] = _g[last];
+    _b[i] = _b[last];
+    _stats.expired++;
+  }
+};
+
+#endif // PARTICLE_SYSTEM_H
@@ -0,0 +1,262 @@
+/*
+ * .pov v2 Image Codec for POV Poi
+ *
+ * The v1 .pov file is a 4-byte header (width, height, 16-bit LE) followed
+ * by raw RGB, column by column. v2 adds a magic, a version, a CRC and a
+ * lossless codec, and splits the columns into independently decodable
+ * blocks so a reader can start at any block:
+ *
+ *   header (20):  "POV2" version(=2) codec width(2) height(2)
+ *                 block_columns(2) data_bytes(4) crc32(4)
+ *   block table:  offset(4) per block, from the start of the data
+ *   data:         encoded blocks, in column order
+ *
+ * All fields are little-endian. The CRC is the standard CRC-32 (as zlib)
+ * of the decoded RGB in column order, so it checks the codec end to end.
+ * v1 files never start with "POV2": that would be a width of 20304.
+ *
+ * Codecs:
+ * - POV2_CODEC_RAW: blocks hold the v1 column bytes
+ * - POV2_CODEC_QOI: the QOI operations for RGB over the pixels of a block
+ *   in column order (top to bottom, then the next column), so runs continue
+ *   across column boundaries. Each block starts from a black previous
+ *   pixel and an all-black 64-entry index.
+ *     0b00iiiiii          index      pixel = index[i]
+ *     0b01rrggbb          diff       -2..1 per channel from the previous pixel
+ *     0b10gggggg rrrrbbbb luma       dg -32..31, dr-dg and db-dg -8..7
+ *     0b11rrrrrr          run        1..62 repeats of the previous pixel
+ *     0xFE r g b          rgb        literal pixel
+ *   Decoding is a table lookup and a few adds per pixel, so a load is
+ *   bound by the decoder rather than by SD bandwidth.
+ */
+
+#ifndef POV_CODEC_H
+#define POV_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define POV2_MAGIC 0x32564F50        // "POV2"
+#define POV2_VERSION 2
+#define POV2_HEADER_BYTES 20
+#define POV2_CODEC_RAW 0
+#define POV2_CODEC_QOI 1
+#define POV2_MAX_RUN 62
+
+struct Pov2Header {
+  uint8_t codec;
+  uint16_t width;
+  uint16_t height;
+  uint16_t blockColumns;
+  uint32_t dataBytes;
+  uint32_t crc;
+};
+
+// Worst-case encoded size of `pixels` pixels (a literal per pixel)
+inline size_t pov2MaxEncodedBytes(uint32_t pixels) {
+  return (size_t)pixels * 4;
+}
+
+inline uint32_t pov2ReadLE32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline void pov2WriteLE32(uint8_t* p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = (v >> 24) & 0xFF;
+}
+
+// Parses a v2 header; false for v1 files and unknown versions or codecs
+inline bool pov2ParseHeader(const uint8_t* in, Pov2Header& h) {
+  if (pov2ReadLE32(in) != POV2_MAGIC || in[4] != POV2_VERSION) return false;
+  h.codec = in[5];
+  h.width = in[6] | (in[7] << 8);
+  h.height = in[8] | (in[9] << 8);
+  h.blockColumns = in[10] | (in[11] << 8);
+  h.dataBytes = pov2ReadLE32(&in[12]);
+  h.crc = pov2ReadLE32(&in[16]);
+  return h.codec <= POV2_CODEC_QOI && h.blockColumns > 0;
+}
+
+inline void pov2WriteHeader(uint8_t* out, const Pov2Header& h) {
+  pov2WriteLE32(out, POV2_MAGIC);
+  out[4] = POV2_VERSION;
+  out[5] = h.codec;
+  out[6] = h.width & 0xFF;
+  out[7] = h.width >> 8;
+  out[8] = h.height & 0xFF;
+  out[9] = h.height >> 8;
+  out[10] = h.blockColumns & 0xFF;
+  out[11] = h.blockColumns >> 8;
+  pov2WriteLE32(&out[12], h.dataBytes);
+  pov2WriteLE32(&out[16], h.crc);
+}
+
+inline uint16_t pov2BlockCount(const Pov2Header& h) {
+  return (h.width + h.blockColumns - 1) / h.blockColumns;
+}
+
+// CRC-32 (reflected 0xEDB88320), continued from `crc`; start with 0
+inline uint32_t pov2Crc32(uint32_t crc, const uint8_t* data, size_t len) {
+  static uint32_t table[256];
+  static bool built = false;
+  if (!built) {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+      table[i] = c;
+    }
+    built = true;
+  }
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+inline uint8_t pov2Hash(uint8_t r, uint8_t g, uint8_t b) {
+  return (r * 3 + g * 5 + b * 7) & 63;
+}
+
+// Encodes `count` columns of `height` RGB pixels; column c starts at
+// columns + c * stride. Returns the encoded size, or 0 if it would not fit
+// in outMax bytes.
+inline size_t pov2EncodeBlock(const uint8_t* columns, size_t stride, uint16_t count,
+                              uint16_t height, uint8_t* out, size_t outMax) {
+  uint8_t index[64][3];
+  memset(index, 0, sizeof(index));
+  uint8_t pr = 0, pg = 0, pb = 0;
+  size_t pos = 0;
+  uint8_t run = 0;
+
+  for (uint16_t c = 0; c < count; c++) {
+    const uint8_t* px = columns + c * stride;
+    for (uint16_t y = 0; y < height; y++, px += 3) {
+      uint8_t r = px[0], g = px[1], b = px[2];
+      if (r == pr && g == pg && b == pb) {
+        if (++run == POV2_MAX_RUN) {
+          if (pos + 1 > outMax) return 0;
+          out[pos++] = 0xC0 | (run - 1);
+          run = 0;
+        }
+        continue;
+      }
+      uint8_t op[4];
+      uint8_t opLen;
+      uint8_t h = pov2Hash(r, g, b);
+      if (index[h][0] == r && index[h][1] == g && index[h][2] == b) {
+        op[0] = h;
+        opLen = 1;
+      } else {
+        index[h][0] = r;
+        index[h][1] = g;
+        index[h][2] = b;
+        int8_t dr = (int8_t)(r - pr);
+        int8_t dg = (int8_t)(g - pg);
+        int8_t db = (int8_t)(b - pb);
+        int8_t drdg = (int8_t)(dr - dg);
+        int8_t dbdg = (int8_t)(db - dg);
+        if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+          op[0] = 0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+          opLen = 1;
+        } else if (dg >= -32 && dg <= 31 && drdg >= -8 && drdg <= 7 && dbdg >= -8 && dbdg <= 7) {
+          op[0] = 0x80 | (dg + 32);
+          op[1] = ((drdg + 8) << 4) | (dbdg + 8);
+          opLen = 2;
+        } else {
+          op[0] = 0xFE;
+          op[1] = r;
+          op[2] = g;
+          op[3] = b;
+          opLen = 4;
+        }
+      }
+
+      // Pending run plus this pixel's op, so a block fits exactly when it can
+      if (pos + (run > 0 ? 1 : 0) + opLen > outMax) return 0;
+      if (run > 0) {
+        out[pos++] = 0xC0 | (run - 1);
+        run = 0;
+      }
+      memcpy(&out[pos], op, opLen);
+      pos += opLen;
+      pr = r;
+      pg = g;
+      pb = b;
+    }
+  }
+  if (run > 0) {
+    if (pos + 1 > outMax) return 0;
+    out[pos++] = 0xC0 | (run - 1);
+  }
+  return pos;
+}
+
+// Decodes one block into `count` columns of `height` pixels at the given
+// stride. False if the data is short, runs past the block or is corrupt.
+inline bool pov2DecodeBlock(const uint8_t* in, size_t inLen, uint8_t* columns, size_t stride,
+                            uint16_t count, uint16_t height) {
+  uint8_t index[64][3];
+  memset(index, 0, sizeof(index));
+  uint8_t r = 0, g = 0, b = 0;
+  size_t pos = 0;
+  uint8_t run = 0;
+
+  for (uint16_t c = 0; c < count; c++) {
+    uint8_t* px = columns + c * stride;
+    for (uint16_t y = 0; y < height; y++, px += 3) {
+      if (run > 0) {
+        run--;
+      } else {
+        if (pos >= inLen) return false;
+        uint8_t op = in[pos++];
+        if (op == 0xFE) {
+          if (pos + 3 > inLen) return false;
+          r = in[pos];
+          g = in[pos + 1];
+          b = in[pos + 2];
+          pos += 3;
+          uint8_t h = pov2Hash(r, g, b);
+          index[h][0] = r;
+          index[h][1] = g;
+          index[h][2] = b;
+        } else if ((op & 0xC0) == 0x00) {
+          r = index[op][0];
+          g = index[op][1];
+          b = index[op][2];
+        } else if ((op & 0xC0) == 0x40) {
+          r += ((op >> 4) & 0x03) - 2;
+          g += ((op >> 2) & 0x03) - 2;
+          b += (op & 0x03) - 2;
+          uint8_t h = pov2Hash(r, g, b);
+          index[h][0] = r;
+          index[h][1] = g;
+          index[h][2] = b;
+        } else if ((op & 0xC0) == 0x80) {
+          if (pos >= inLen) return false;
+          int8_t dg = (op & 0x3F) - 32;
+          uint8_t next = in[pos++];
+          r += dg + ((next >> 4) & 0x0F) - 8;
+          g += dg;
+          b += dg + (next & 0x0F) - 8;
+          uint8_t h = pov2Hash(r, g, b);
+          index[h][0] = r;
+          index[h][1] = g;
+          index[h][2] = b;
+        } else if (op == 0xFF) {
+          return false;  // RGBA literal: never written for RGB images
+        } else {
+          run = op & 0x3F;  // This pixel plus `run` more
+        }
+      }
+      px[0] = r;
+      px[1] = g;
+      px[2] = b;
+    }
+  }
+  return run == 0 && pos == inLen;
+}
+
+#endif // POV_CODEC_H
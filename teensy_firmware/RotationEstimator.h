@@ -0,0 +1,383 @@
+/*
+ * Rotation Rate Estimator for POV Poi
+ *
+ * Estimates how fast the poi is spinning from a pluggable sensor source and
+ * derives the column period that makes an image span a constant arc, so the
+ * image no longer stretches or squashes when the spinner speeds up or slows
+ * down.
+ *
+ * Sources (all implement RotationSource):
+ * - HallRotationSource:   hall sensor + magnet, N pulses per revolution
+ *                         (default pin 2, active-low, internal pull-up)
+ * - GyroRotationSource:   MPU-6050/6500 compatible IMU on I2C0 (pins 18/19),
+ *                         angular rate around the spin axis
+ * - ReplayRotationSource: revolution periods replayed from a text file, one
+ *                         period in microseconds per line. Works with any
+ *                         File-compatible object so the estimator can be
+ *                         exercised on a host or bench without spinning.
+ *
+ * Estimation:
+ *   Each source delivers revolution-period measurements. The estimator
+ *   smooths them with an exponential filter, tracks the variance of the
+ *   residuals (reported as a 1-sigma RPM error), and rejects single-sample
+ *   glitches such as a missed or doubled hall pulse.
+ */
+
+#ifndef ROTATION_ESTIMATOR_H
+#define ROTATION_ESTIMATOR_H
+
+#if defined(__INTELLISENSE__) || defined(__clangd__)
+  // Shims for editor/indexer environments (IntelliSense, clangd).
+  // Checked first so that editors defining ARDUINO still get stubs instead of
+  // trying to resolve unavailable Arduino core headers.
+  #include <cstdint>
+  #include <cmath>
+
+  #define INPUT_PULLUP 2
+  #define FALLING 2
+
+  struct RotationEstimatorWireShim {
+    void begin() {}
+    void beginTransmission(uint8_t) {}
+    uint8_t endTransmission(bool = true) { return 0; }
+    void write(uint8_t) {}
+    void requestFrom(uint8_t, uint8_t) {}
+    int available() { return 0; }
+    int read() { return 0; }
+  };
+
+  static RotationEstimatorWireShim Wire;
+
+  inline uint32_t micros() { return 0; }
+  inline void pinMode(int, int) {}
+  inline int digitalPinToInterrupt(int p) { return p; }
+  inline void attachInterrupt(int, void (*)(), int) {}
+  inline void detachInterrupt(int) {}
+  inline void noInterrupts() {}
+  inline void interrupts() {}
+#elif __has_include(<Arduino.h>)
+  #include <Arduino.h>
+  #include <Wire.h>
+#elif __has_include(<WProgram.h>)
+  // Fallback for older Arduino cores that ship WProgram.h instead of Arduino.h.
+  #include <WProgram.h>
+  #include <Wire.h>
+#else
+  // Reached only when neither Arduino.h nor WProgram.h is available and we are
+  // not inside an editor/indexer session.  This produces a clear compile-time
+  // error instead of a cryptic "file not found" message.
+  #error "Arduino.h not found. Ensure the Arduino core is installed and your board is correctly configured."
+#endif
+
+// Plausible spin range for poi: 30-1200 RPM
+#define ROTATION_MIN_PERIOD_US 50000UL     // 1200 RPM
+#define ROTATION_MAX_PERIOD_US 2000000UL   // 30 RPM
+
+// Source type identifiers (used on the serial protocol)
+#define ROTATION_SOURCE_NONE   0
+#define ROTATION_SOURCE_HALL   1
+#define ROTATION_SOURCE_GYRO   2
+#define ROTATION_SOURCE_REPLAY 3
+
+// ==================== SOURCES ====================
+
+class RotationSource {
+public:
+  virtual ~RotationSource() {}
+
+  virtual void begin() {}
+  virtual void end() {}
+
+  // Returns true and sets periodUs when a new revolution-period
+  // measurement is available.
+  virtual bool poll(uint32_t nowUs, uint32_t& periodUs) = 0;
+
+  virtual uint8_t type() const = 0;
+};
+
+// Hall sensor: the ISR timestamps each pulse, poll() turns the interval
+// between pulses into a revolution period. Only one instance may be active.
+static volatile uint32_t hallLastPulseUs = 0;
+static volatile uint32_t hallPulseIntervalUs = 0;
+static volatile bool hallPending = false;
+
+class HallRotationSource : public RotationSource {
+public:
+  HallRotationSource(uint8_t pin, uint8_t pulsesPerRev = 1)
+    : _pin(pin), _pulsesPerRev(pulsesPerRev ? pulsesPerRev : 1) {}
+
+  void begin() override {
+    hallLastPulseUs = 0;
+    hallPulseIntervalUs = 0;
+    hallPending = false;
+    pinMode(_pin, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(_pin), onPulse, FALLING);
+  }
+
+  void end() override {
+    detachInterrupt(digitalPinToInterrupt(_pin));
+  }
+
+  bool poll(uint32_t nowUs, uint32_t& periodUs) override {
+    (void)nowUs;
+    if (!hallPending) return false;
+    noInterrupts();
+    uint32_t interval = hallPulseIntervalUs;
+    hallPending = false;
+    interrupts();
+    periodUs = interval * _pulsesPerRev;
+    return true;
+  }
+
+  uint8_t type() const override { return ROTATION_SOURCE_HALL; }
+
+private:
+  static void onPulse() {
+    uint32_t now = micros();
+    uint32_t interval = now - hallLastPulseUs;
+    // Debounce: ignore edges closer than the fastest plausible pulse
+    if (interval < ROTATION_MIN_PERIOD_US / 8) return;
+    hallLastPulseUs = now;
+    hallPulseIntervalUs = interval;
+    hallPending = true;
+  }
+
+  uint8_t _pin;
+  uint8_t _pulsesPerRev;
+};
+
+// IMU gyro: samples the angular rate around one axis and converts it to a
+// revolution period. Uses the +/-2000 dps range (16.4 LSB per deg/s).
+#define GYRO_I2C_ADDRESS      0x68
+#define GYRO_REG_PWR_MGMT_1   0x6B
+#define GYRO_REG_GYRO_CONFIG  0x1B
+#define GYRO_REG_GYRO_XOUT_H  0x43
+#define GYRO_LSB_PER_DPS      16.4f
+#define GYRO_MIN_DPS          180.0f   // Below 30 RPM the poi is not spinning
+
+class GyroRotationSource : public RotationSource {
+public:
+  // axis: 0=X, 1=Y, 2=Z (the axis perpendicular to the spin plane)
+  GyroRotationSource(uint8_t axis = 2, uint32_t sampleIntervalUs = 5000)
+    : _axis(axis > 2 ? 2 : axis), _sampleIntervalUs(sampleIntervalUs) {}
+
+  void begin() override {
+    Wire.begin();
+    writeRegister(GYRO_REG_PWR_MGMT_1, 0x00);   // Wake up
+    writeRegister(GYRO_REG_GYRO_CONFIG, 0x18);  // +/-2000 dps
+    _lastSampleUs = 0;
+  }
+
+  bool poll(uint32_t nowUs, uint32_t& periodUs) override {
+    if (nowUs - _lastSampleUs < _sampleIntervalUs) return false;
+    _lastSampleUs = nowUs;
+
+    float dps = fabsf(readRateDps());
+    if (dps < GYRO_MIN_DPS) return false;
+    periodUs = (uint32_t)(360.0f * 1000000.0f / dps);
+    return true;
+  }
+
+  uint8_t type() const override { return ROTATION_SOURCE_GYRO; }
+
+private:
+  float readRateDps() {
+    Wire.beginTransmission(GYRO_I2C_ADDRESS);
+    Wire.write(GYRO_REG_GYRO_XOUT_H + _axis * 2);
+    Wire.endTransmission(false);
+    Wire.requestFrom(GYRO_I2C_ADDRESS, 2);
+    if (Wire.available() < 2) return 0.0f;
+    uint8_t hi = Wire.read();
+    uint8_t lo = Wire.read();
+    int16_t raw = (int16_t)((hi << 8) | lo);
+    return raw / GYRO_LSB_PER_DPS;
+  }
+
+  void writeRegister(uint8_t reg, uint8_t value) {
+    Wire.beginTransmission(GYRO_I2C_ADDRESS);
+    Wire.write(reg);
+    Wire.write(value);
+    Wire.endTransmission();
+  }
+
+  uint8_t _axis;
+  uint32_t _sampleIntervalUs;
+  uint32_t _lastSampleUs = 0;
+};
+
+// Replay: reads one revolution period (microseconds, decimal) per line and
+// delivers each one after that period has elapsed, as a hall sensor would.
+// Blank lines and lines starting with '#' are skipped; wraps at end of file.
+// FileT needs available(), read() and seek(0).
+template <typename FileT>
+class ReplayRotationSource : public RotationSource {
+public:
+  explicit ReplayRotationSource(FileT& file) : _file(file) {}
+
+  void begin() override {
+    _file.seek(0);
+    _nextDueUs = 0;
+    _nextPeriodUs = 0;
+    _started = false;
+  }
+
+  bool poll(uint32_t nowUs, uint32_t& periodUs) override {
+    if (!_started) {
+      if (!readNextPeriod(_nextPeriodUs)) return false;
+      _nextDueUs = nowUs + _nextPeriodUs;
+      _started = true;
+      return false;
+    }
+    if ((int32_t)(nowUs - _nextDueUs) < 0) return false;
+
+    periodUs = _nextPeriodUs;
+    if (!readNextPeriod(_nextPeriodUs)) {
+      _started = false;
+      return true;
+    }
+    _nextDueUs += _nextPeriodUs;
+    return true;
+  }
+
+  uint8_t type() const override { return ROTATION_SOURCE_REPLAY; }
+
+private:
+  bool readNextPeriod(uint32_t& periodUs) {
+    for (uint8_t wraps = 0; wraps < 2; ) {
+      if (!_file.available()) {
+        _file.seek(0);
+        wraps++;
+        continue;
+      }
+      uint32_t value = 0;
+      bool digits = false;
+      bool comment = false;
+      while (_file.available()) {
+        int c = _file.read();
+        if (c == '\n') break;
+        if (c == '#' && !digits) comment = true;
+        if (!comment && c >= '0' && c <= '9') {
+          value = value * 10 + (c - '0');
+          digits = true;
+        }
+      }
+      if (digits && !comment) {
+        periodUs = value;
+        return true;
+      }
+    }
+    return false;  // Empty file
+  }
+
+  FileT& _file;
+  uint32_t _nextDueUs = 0;
+  uint32_t _nextPeriodUs = 0;
+  bool _started = false;
+};
+
+// ==================== ESTIMATOR ====================
+
+class RotationEstimator {
+public:
+  void setSource(RotationSource* source);
+  RotationSource* source() const { return _source; }
+
+  // Poll the source and update the estimate; call every loop().
+  void update(uint32_t nowUs);
+
+  // True while measurements keep arriving at a plausible rate
+  bool isLocked(uint32_t nowUs) const;
+
+  uint32_t periodUs() const { return (uint32_t)_periodUs; }
+  float rpm() const;
+  float rpmError() const;  // 1-sigma error of the estimate in RPM
+  uint32_t glitchCount() const { return _glitches; }
+
+  // Column period that spreads `columns` columns across `arcDeg` degrees
+  uint32_t columnPeriodUs(uint16_t columns, uint16_t arcDeg) const;
+
+private:
+  static constexpr float kAlpha = 0.25f;       // Period smoothing factor
+  static constexpr float kGlitchRatio = 0.35f; // Max relative jump per sample
+  static constexpr uint8_t kGlitchRun = 3;     // Consecutive jumps = real change
+
+  RotationSource* _source = nullptr;
+  float _periodUs = 0;
+  float _residualVar = 0;
+  uint32_t _lastMeasurementUs = 0;
+  uint32_t _glitches = 0;
+  uint8_t _glitchRun = 0;
+  bool _valid = false;
+};
+
+// Implementation
+inline void RotationEstimator::setSource(RotationSource* source) {
+  if (_source) _source->end();
+  _source = source;
+  _valid = false;
+  _periodUs = 0;
+  _residualVar = 0;
+  _glitchRun = 0;
+  if (_source) _source->begin();
+}
+
+inline void RotationEstimator::update(uint32_t nowUs) {
+  if (!_source) return;
+
+  uint32_t measured;
+  if (!_source->poll(nowUs, measured)) return;
+  if (measured < ROTATION_MIN_PERIOD_US || measured > ROTATION_MAX_PERIOD_US) return;
+
+  if (!_valid || !isLocked(nowUs)) {
+    // (Re)acquire: take the first plausible measurement as-is
+    _periodUs = measured;
+    _residualVar = 0;
+    _glitchRun = 0;
+    _valid = true;
+    _lastMeasurementUs = nowUs;
+    return;
+  }
+
+  float residual = (float)measured - _periodUs;
+  if (fabsf(residual) > _periodUs * kGlitchRatio) {
+    // Missed/doubled pulse or a sudden change; only follow if it persists
+    _glitches++;
+    if (++_glitchRun < kGlitchRun) return;
+    _periodUs = measured;
+    _residualVar = 0;
+    _glitchRun = 0;
+    _lastMeasurementUs = nowUs;
+    return;
+  }
+
+  _glitchRun = 0;
+  _periodUs += kAlpha * residual;
+  _residualVar = (1.0f - kAlpha) * _residualVar + kAlpha * residual * residual;
+  _lastMeasurementUs = nowUs;
+}
+
+inline bool RotationEstimator::isLocked(uint32_t nowUs) const {
+  if (!_valid) return false;
+  // Allow a couple of missed revolutions before declaring the lock lost
+  uint32_t timeout = (uint32_t)_periodUs * 3;
+  if (timeout > ROTATION_MAX_PERIOD_US) timeout = ROTATION_MAX_PERIOD_US;
+  return nowUs - _lastMeasurementUs <= timeout;
+}
+
+inline float RotationEstimator::rpm() const {
+  if (!_valid || _periodUs <= 0) return 0.0f;
+  return 60000000.0f / _periodUs;
+}
+
+inline float RotationEstimator::rpmError() const {
+  if (!_valid || _periodUs <= 0) return 0.0f;
+  // First-order propagation: dRPM / RPM = dT / T
+  return rpm() * sqrtf(_residualVar) / _periodUs;
+}
+
+inline uint32_t RotationEstimator::columnPeriodUs(uint16_t columns, uint16_t arcDeg) const {
+  if (!_valid || columns == 0) return 0;
+  return (uint32_t)(_periodUs * arcDeg / 360.0f / columns);
+}
+
+#endif // ROTATION_ESTIMATOR_H
@@ -16,6 +16,11 @@
  */
 
 #include <FastLED.h>
+#include "BatteryMonitor.h"
+#include "RotationEstimator.h"
+#include "APA102HDOutput.h"
+#include "PovCodec.h"
+#include "ParticleSystem.h"
 
 // Teensy 4.1 PSRAM support - declare external_psram_size if not already declared
 #ifdef ARDUINO_TEENSY41
@@ -44,6 +49,7 @@ static_assert(NUM_LEDS == 32, "NUM_LEDS must be 32 - hardware uses MOSFET level
 #define COLOR_ORDER BGR
 #define DISPLAY_LEDS 32       // All 32 LEDs used for display (hardware level shifter)
 #define DISPLAY_LED_START 0   // First LED index used for display content
+#define HD_SPI_CLOCK_HZ 12000000  // SPI clock for the HDR output stage (APA102HDOutput.h)
 
 // Audio Input Configuration (MAX9814 Microphone Amplifier Module)
 // MAX9814 output connects through level shifter to Teensy analog input.
@@ -66,18 +72,29 @@ static_assert(SERIAL_RX_PIN == 1, "SERIAL_RX_PIN must remain 1 for ESP32-S3 seri
 //       IMAGE_MAX_WIDTH = variable (calculated from aspect ratio)
 // PSRAM: 2x 8MB chips installed = 16MB PSRAM on Teensy 4.1
 #ifdef ARDUINO_TEENSY41
-  // With 16MB PSRAM: 200 images at 32x400 (~7.3MB, ~46% of PSRAM)
-  // Without PSRAM: 10 images at 32x200 (~60KB internal RAM)
+  // With 16MB PSRAM: 200 image slots of up to 32x400, sharing a pool of
+  // 40000 unique columns (~3.7MB, ~23% of PSRAM)
+  // Without PSRAM: 10 slots of up to 32x200 sharing 1200 columns (~113KB)
   #define MAX_IMAGES 200
   #define IMAGE_MAX_WIDTH 400     // Maximum width for stored images (with PSRAM)
+  #define IMAGE_POOL_COLUMNS 40000u
 #else
   #define MAX_IMAGES 10
   #define IMAGE_MAX_WIDTH 200     // Conservative limit without PSRAM
+  #define IMAGE_POOL_COLUMNS 1200u
 #endif
 #define IMAGE_WIDTH 32          // Fixed width for POV display (matches DISPLAY_LEDS)
 #define IMAGE_HEIGHT 32         // Fixed: matches DISPLAY_LEDS (one pixel per LED)
-#define MAX_PATTERNS 18  // Total pattern slots (indexed 0-17)
+#define MAX_PATTERNS 21  // Total pattern slots (indexed 0-20)
 #define MAX_SEQUENCES 5
+
+// Rotation tracking (see RotationEstimator.h)
+#define HALL_SENSOR_PIN 2         // Hall sensor output (active-low, open drain)
+#define HALL_PULSES_PER_REV 1     // Magnets passing the sensor per revolution
+#define GYRO_SPIN_AXIS 2          // IMU axis perpendicular to the spin plane (0=X, 1=Y, 2=Z)
+#define ROTATION_REPLAY_FILE "/rotation_replay.txt"
+#define DEFAULT_IMAGE_ARC_DEG 360 // Arc one pass of an image should fill
+#define MIN_COLUMN_PERIOD_US 100  // APA102 frame for 32 LEDs takes ~50us
 const uint8_t kPatternSpeedDivisor = 20;  // Used for split-spin/theater chase speed scaling.
 
 #ifdef SD_SUPPORT
@@ -86,28 +103,46 @@ const uint8_t kPatternSpeedDivisor = 20;  // Used for split-spin/theater chase s
   #define MAX_FILENAME_LEN 32
   #define MAX_SD_FILES 100   // 64GB card can hold thousands; 100 files visible in UI
   #define MAX_FILEPATH_LEN 64
+  // .pov v2 (see PovCodec.h): saves are QOI-coded in 16-column blocks, the
+  // page cache block size, so the cache can read any block on its own
+  #define POV2_BLOCK_COLUMNS 16
+  #define POV2_MAX_BLOCKS 64                               // Widest v2 file loaded into a slot
+  #define POV2_BLOCK_BUFFER (32 * IMAGE_HEIGHT * 4)        // Largest encoded block read
 #endif
 
 // LED Array
 CRGB leds[NUM_LEDS];
 
 // Image storage structure
-// Note: With PSRAM, pixels array can be much larger (IMAGE_MAX_WIDTH x IMAGE_HEIGHT)
+// Images are stored column-deduplicated: each image keeps a dictionary of
+// its unique columns in the shared imageColumns pool and a run-length
+// encoded list of references into that dictionary in imageRuns. Blank gaps,
+// solid bars and repeated motifs then cost one column each. Writers fill
+// imageStaging and call commitImage(); displayImage() walks the runs
+// directly, so playback needs no decompression step.
+struct ColumnRun {
+  uint16_t column;  // Dictionary index within the image
+  uint16_t count;   // Consecutive image columns using it
+};
 struct POVImage {
-  uint16_t width;   // Changed to uint16_t to support IMAGE_MAX_WIDTH up to 400
-  uint16_t height;  // Changed to uint16_t for consistency
-  CRGB pixels[IMAGE_MAX_WIDTH][IMAGE_HEIGHT];  // Max size based on PSRAM availability
+  uint16_t width;         // Changed to uint16_t to support IMAGE_MAX_WIDTH up to 400
+  uint16_t height;        // Changed to uint16_t for consistency
+  uint32_t columnOffset;  // First dictionary column in imageColumns
+  uint16_t columnCount;   // Unique columns
+  uint32_t runOffset;     // First run in imageRuns
+  uint16_t runCount;
   bool active;
 };
 
 // Pattern structure
-// Pattern types (0-17):
+// Pattern types (0-20):
 //   Basic:  0=rainbow, 1=wave, 2=gradient, 3=sparkle, 4=fire, 5=comet
 //           6=breathing, 7=strobe, 8=meteor, 9=wipe, 10=plasma
 //   Audio (MAX9814): 11=VU meter, 12=pulse, 13=rainbow, 14=center burst, 15=sparkle
 //   Extra:  16=split spin, 17=theater chase
+//   Particles: 18=fireworks, 19=rain, 20=sparks
 struct Pattern {
-  uint8_t type;   // Pattern type (0-17), see types above
+  uint8_t type;   // Pattern type (0-20), see types above
   CRGB color1;    // Primary color for pattern
   CRGB color2;    // Secondary color for pattern
   uint8_t speed;  // Animation speed (1-255): higher = faster animation
@@ -129,22 +164,212 @@ struct Sequence {
 // Storage arrays
 // EXTMEM places these large arrays in external PSRAM (if installed)
 // Without PSRAM, they will be in regular RAM (may cause issues if too large)
+// The column pool (IMAGE_POOL_COLUMNS, above) is half of what every slot at
+// full width with no repeated columns would need: the library fits as long
+// as deduplication and narrower images make up the rest, and the PSRAM this
+// saves is free for the SD and live buffers. Runs are 4 bytes, so their
+// pool does cover the worst case.
+#define IMAGE_POOL_RUNS ((uint32_t)MAX_IMAGES * IMAGE_MAX_WIDTH)
+#define COLUMN_HASH_SLOTS 1024  // Open-addressing table for dictionary lookup (> 2x IMAGE_MAX_WIDTH)
+POVImage images[MAX_IMAGES];
 #ifdef ARDUINO_TEENSY41
-EXTMEM POVImage images[MAX_IMAGES];
+EXTMEM CRGB imageColumns[IMAGE_POOL_COLUMNS][IMAGE_HEIGHT];
+EXTMEM ColumnRun imageRuns[IMAGE_POOL_RUNS];
+EXTMEM CRGB imageStaging[IMAGE_MAX_WIDTH][IMAGE_HEIGHT];  // Expanded image being written or read back
 #else
-POVImage images[MAX_IMAGES];
+CRGB imageColumns[IMAGE_POOL_COLUMNS][IMAGE_HEIGHT];
+ColumnRun imageRuns[IMAGE_POOL_RUNS];
+CRGB imageStaging[IMAGE_MAX_WIDTH][IMAGE_HEIGHT];
+#endif
+uint32_t imageColumnsUsed = 0;   // End of the used part of each pool
+uint32_t imageRunsUsed = 0;
+uint32_t imageColumnsStale = 0;  // Left behind by replaced images until compacted
+uint32_t imageRunsStale = 0;
+
+// Progressive upload (0x42): columns arrive column-major in any order (the
+// ESP32 sends every 8th column first, then the gaps) into their own staging
+// buffer. While it runs, the slot shows the partial image with each missing
+// column filled from the nearest received one; the finished image is then
+// committed to the slot in one step.
+#define PROGRESSIVE_NONE 0xFFFF
+#define PROGRESSIVE_COARSE_GAP 8        // "Coarse" once every column is nearer than this to a received one
+#define PROGRESSIVE_TIMEOUT_MS 2000     // Abandoned when no frame arrives for this long
+#ifdef ARDUINO_TEENSY41
+EXTMEM CRGB progressiveStaging[IMAGE_MAX_WIDTH][IMAGE_HEIGHT];
+#else
+CRGB progressiveStaging[IMAGE_MAX_WIDTH][IMAGE_HEIGHT];
 #endif
+uint16_t progressiveSource[IMAGE_MAX_WIDTH];  // Received column shown in place of each column
+bool progressiveActive = false;
+uint8_t progressiveSlot = 0;
+uint16_t progressiveWidth = 0;
+uint16_t progressiveHeight = 0;
+uint16_t progressiveReceived = 0;     // Distinct columns received
+uint32_t progressiveStartUs = 0;
+uint32_t progressiveCoarseUs = 0;     // Begin to coarse coverage (0 = not yet)
+uint32_t progressiveLastMs = 0;       // Last frame, for the timeout
 Pattern patterns[MAX_PATTERNS];
 Sequence sequences[MAX_SEQUENCES];
 
+// Multi-resolution image variants
+// Each image can keep narrower copies (1/2, 1/4, 1/8 width) generated at
+// ingest with an area-weighted filter. While the spin rate is known, the
+// renderer picks the copy whose column count best fits the target arc at
+// the configured column rate, so slow spins are not stretched and fast
+// spins are not cramped. Variant columns live in one compacted PSRAM pool.
+#define MAX_IMAGE_VARIANTS 3
+#define MIN_VARIANT_WIDTH 16
+#ifdef ARDUINO_TEENSY41
+  #define VARIANT_POOL_COLUMNS 24000  // ~2.3MB PSRAM
+#else
+  #define VARIANT_POOL_COLUMNS 256
+#endif
+struct ImageVariant {
+  uint32_t offset;  // First column in variantPool
+  uint16_t width;
+};
+struct ImageVariantSet {
+  uint8_t count;
+  ImageVariant variants[MAX_IMAGE_VARIANTS];  // Widest first
+};
+#ifdef ARDUINO_TEENSY41
+EXTMEM CRGB variantPool[VARIANT_POOL_COLUMNS][IMAGE_HEIGHT];
+#else
+CRGB variantPool[VARIANT_POOL_COLUMNS][IMAGE_HEIGHT];
+#endif
+ImageVariantSet imageVariants[MAX_IMAGES];
+uint32_t variantPoolUsed = 0;
+uint32_t variantPoolStale = 0;
+
+// Baked patterns
+// Periodic patterns (rainbow, wave, gradient, breathing, plasma, split spin,
+// theater chase) are pure functions of a phase that repeats after a fixed
+// number of steps for a given speed. The active one is rendered once per
+// phase into a cyclic column buffer and then played back by copying the
+// column for the current phase. Baking is spread over several columns
+// (rendering live meanwhile) and restarts whenever the pattern slot, type,
+// colours or speed change.
+#ifdef ARDUINO_TEENSY41
+  #define PATTERN_BAKE_COLUMNS 15360  // Longest cycle (plasma, odd speed); ~1.4MB PSRAM
+#else
+  #define PATTERN_BAKE_COLUMNS 256
+#endif
+#define PATTERN_BAKE_SLICE_PCT 25     // Share of a column period spent baking
+#ifdef ARDUINO_TEENSY41
+EXTMEM CRGB bakedColumns[PATTERN_BAKE_COLUMNS][NUM_LEDS];
+#else
+CRGB bakedColumns[PATTERN_BAKE_COLUMNS][NUM_LEDS];
+#endif
+Pattern bakedPattern;              // Parameters the buffer was baked for
+uint8_t bakedSlot = 0xFF;          // 0xFF = nothing baked
+uint32_t bakedPeriod = 0;          // Phases in the cycle
+uint32_t bakedCount = 0;           // Phases baked so far
+uint32_t bakeStartMs = 0;
+
+// Particle patterns
+// Fireworks, rain and sparks share one particle pool (ParticleSystem.h),
+// stepped and drawn once per column. The pool is emptied when a different
+// particle pattern takes over so it never starts with another one's sparks.
+ParticleSystem particles;
+uint8_t particleSlot = 0xFF;       // Pattern slot the pool belongs to
+
 // Display state
 uint8_t currentMode = 0;  // 0=idle, 1=image, 2=pattern, 3=sequence, 4=live
 uint8_t currentIndex = 0;
-uint32_t lastUpdate = 0;
+uint32_t lastColumnUs = 0;
 uint32_t frameDelay = 20;  // 50 FPS default
-uint8_t currentColumn = 0;
+uint32_t activeColumnPeriodUs = 20000;  // frameDelay, or derived from the spin rate
+uint16_t currentColumn = 0;
+uint8_t displayImageSlot = 0xFF;     // Image the column state belongs to
+int8_t displayVariant = -1;          // Variant being shown (-1 = full width)
+uint16_t displayImageWidth = 0;      // Column count of the image being shown
+uint16_t displayRun = 0;             // Run cursor into the image being shown
+uint16_t displayRunPos = 0;          // Column within that run
 bool displaying = false;
 
+// Column duty cycle (percent of each column period the LEDs are lit)
+// Below 100% the strip is blanked for the remainder of the column period,
+// which narrows the arc each column smears across and sharpens the image
+// at the cost of perceived brightness.
+#define MIN_COLUMN_DUTY 5
+uint8_t columnDutyPercent = 100;
+uint32_t columnShownAtUs = 0;  // micros() when the current column was latched
+bool columnBlanked = true;     // True once the current column has been blanked
+
+// HDR output: when enabled, frames go out through APA102HDOutput, which
+// dims with the APA102 5-bit global current instead of scaling RGB values.
+// FastLED's brightness setting is still the master level.
+APA102HDOutput<NUM_LEDS> hdOutput(HD_SPI_CLOCK_HZ);
+bool hdrOutput = false;
+
+// Rotation tracking: when a source is locked, image columns are paced from
+// the measured spin rate so every image fills imageArcDeg regardless of speed.
+RotationEstimator rotation;
+HallRotationSource hallSource(HALL_SENSOR_PIN, HALL_PULSES_PER_REV);
+GyroRotationSource gyroSource(GYRO_SPIN_AXIS);
+uint16_t imageArcDeg = DEFAULT_IMAGE_ARC_DEG;
+#ifdef SD_SUPPORT
+File replayFile;
+ReplayRotationSource<File> replaySource(replayFile);
+#endif
+
+// INA219 current sensing (optional, see BatteryMonitor.h)
+// Used to A/B measure the current saved by a reduced column duty cycle or
+// by the power governor: the reference phase runs with the feature
+// bypassed, the second phase with it in effect.
+#define POWER_SAMPLE_INTERVAL_MS 20
+#define DUTY_MEASURE_PHASE_MS 1500
+#define DUTY_MEASURE_SETTLE_MS 200
+enum DutyMeasureState : uint8_t {
+  DUTY_MEASURE_IDLE = 0,
+  DUTY_MEASURE_FULL = 1,      // Sampling the reference (100% duty / governor bypassed)
+  DUTY_MEASURE_REDUCED = 2,   // Sampling with the configured duty / governor
+  DUTY_MEASURE_DONE = 3,
+  DUTY_MEASURE_NO_SENSOR = 4
+};
+enum PowerMeasureTarget : uint8_t {
+  POWER_TARGET_DUTY = 0,
+  POWER_TARGET_GOVERNOR = 1
+};
+BatteryMonitor battery;
+bool batteryPresent = false;
+uint8_t dutyMeasureState = DUTY_MEASURE_IDLE;
+uint8_t powerMeasureTarget = POWER_TARGET_DUTY;
+uint32_t dutyMeasurePhaseStart = 0;
+uint32_t lastPowerSample = 0;
+float dutyMeasureSumMa = 0;
+uint16_t dutyMeasureSamples = 0;
+uint16_t fullDutyCurrentMa = 0;     // Result: average draw at 100% duty
+uint16_t reducedDutyCurrentMa = 0;  // Result: average draw at configured duty
+uint16_t lastCurrentMa = 0;         // Most recent raw sample
+
+// Power governor: lowers the ARM clock while the measured render load
+// leaves headroom and sleeps the core (WFI) until the next column is due
+// or a serial interrupt arrives. Clock changes also lower the core voltage
+// (set_arm_clock), which is where most of the saving comes from.
+#define GOVERNOR_DEFAULT_ENABLED true
+#define GOVERNOR_EVAL_MS 500
+#define GOVERNOR_TARGET_LOAD_PCT 40   // Max projected render load at a lower clock
+#define GOVERNOR_PANIC_LOAD_PCT 75    // Render load that restores full clock at once
+#define GOVERNOR_WAKE_MARGIN_US 20    // Wake this early before a column is due
+#define GOVERNOR_MIN_SLEEP_US 40
+#define GOVERNOR_CLOCK_LEVELS 4
+const uint32_t kGovernorClocksHz[GOVERNOR_CLOCK_LEVELS] = {
+  600000000, 396000000, 150000000, 24000000
+};
+bool governorEnabled = GOVERNOR_DEFAULT_ENABLED;
+uint8_t governorLevel = 0;            // Index into kGovernorClocksHz
+uint32_t governorWindowStartMs = 0;
+uint32_t governorPeakRenderUs = 0;    // Slowest column render this window
+uint32_t governorSleptUs = 0;         // Time in WFI this window
+uint8_t governorLoadPct = 0;          // Last window: peak render / column period
+uint8_t governorSleepPct = 0;         // Last window: share of time asleep
+bool stripDark = false;               // Idle mode has latched its dark frame
+#ifdef ARDUINO_TEENSY41
+extern "C" uint32_t set_arm_clock(uint32_t frequency);
+IntervalTimer governorWakeTimer;
+#endif
+
 // Multi-poi sync time offset (in milliseconds)
 // When synced with a peer, this offset adjusts pattern timing so both poi
 // animate in phase. Positive means peer clock is ahead of ours.
@@ -163,6 +388,257 @@ bool sdInitialized = false;
 // Live mode buffer
 CRGB liveBuffer[DISPLAY_LEDS];
 
+// Live recording: live columns are captured with their arrival time into a
+// PSRAM ring and drained to SD a chunk at a time from loop(), so SD write
+// stalls are absorbed by the ring instead of the serial stream. Replay
+// reads ahead into the same ring and shows every recorded column at its own
+// (optionally time-scaled) timestamp instead of at the frame cadence.
+#ifdef SD_SUPPORT
+  #define SD_LIVE_DIR "/poi_live"
+  #define LIVE_REC_MAGIC 0x31524C50  // "PLR1" in hex
+  #define LIVE_REC_HEADER_SIZE 8     // magic(4) leds(1) record_size(1) reserved(2)
+  #define LIVE_REC_RECORD_SIZE (4 + DISPLAY_LEDS * 3)  // offset_us(4) + RGB
+  #define LIVE_REC_CHUNK 4096        // Max SD transfer per loop() pass
+  #ifdef ARDUINO_TEENSY41
+    #define LIVE_REC_RING_SIZE 262144  // ~2600 columns of SD latency headroom
+    EXTMEM uint8_t liveRecRing[LIVE_REC_RING_SIZE];
+  #else
+    #define LIVE_REC_RING_SIZE 8192
+    uint8_t liveRecRing[LIVE_REC_RING_SIZE];
+  #endif
+  static_assert((LIVE_REC_RING_SIZE & (LIVE_REC_RING_SIZE - 1)) == 0,
+                "LIVE_REC_RING_SIZE must be a power of two");
+  enum LiveRecState : uint8_t {
+    LIVE_REC_IDLE = 0,
+    LIVE_REC_RECORDING = 1,
+    LIVE_REC_REPLAYING = 2,
+    LIVE_REC_FINISHING = 3   // Stopped; the rest of the ring is still going to SD
+  };
+  uint8_t liveRecState = LIVE_REC_IDLE;
+  File liveRecFile;
+  uint32_t liveRecHead = 0;          // Bytes put into the ring (free-running)
+  uint32_t liveRecTail = 0;          // Bytes taken out of the ring (free-running)
+  uint32_t liveRecPeak = 0;          // Highest ring fill seen, in bytes
+  uint32_t liveRecStartUs = 0;       // micros() at timestamp zero
+  uint32_t liveRecColumns = 0;       // Columns recorded or replayed
+  uint32_t liveRecDropped = 0;       // Columns lost to a full ring while recording
+  uint32_t liveRecUnderruns = 0;     // Times replay ran ahead of SD reads
+  uint32_t liveRecMaxLateUs = 0;     // Worst replay lag behind recorded timing
+  uint16_t liveReplaySpeed = 100;    // Percent of recorded speed
+  bool liveReplayLoop = false;
+  bool liveReplayEof = false;
+  bool liveReplayStarved = false;
+#endif
+
+// Background SD image load (0x24): the file is read a chunk per loop() pass
+// into its own staging buffer while the current content keeps playing, then
+// committed to the slot between two columns and, if asked, shown from the
+// next column on. The result and its timing go out as an 0xC4 event to the
+// port that asked; 0x27 repeats the last one.
+#ifdef SD_SUPPORT
+  #define SD_LOAD_CHUNK_BYTES 4096   // Max SD read per loop() pass
+  enum SdLoadStatus : uint8_t {
+    SD_LOAD_IDLE = 0,        // Nothing loaded since boot
+    SD_LOAD_BUSY = 1,
+    SD_LOAD_DONE = 2,
+    SD_LOAD_NOT_FOUND = 3,
+    SD_LOAD_BAD_FILE = 4,    // Bad header, too large or truncated
+    SD_LOAD_NO_SPACE = 5     // Image pools full
+  };
+  #ifdef ARDUINO_TEENSY41
+    EXTMEM CRGB sdLoadStaging[IMAGE_MAX_WIDTH][IMAGE_HEIGHT];
+  #else
+    CRGB sdLoadStaging[IMAGE_MAX_WIDTH][IMAGE_HEIGHT];
+  #endif
+  File sdLoadFile;
+  uint8_t sdLoadStatus = SD_LOAD_IDLE;
+  uint8_t sdLoadSlot = 0;
+  bool sdLoadShow = false;
+  Stream* sdLoadPort = nullptr;      // Where the completion event goes
+  uint16_t sdLoadWidth = 0;
+  uint16_t sdLoadHeight = 0;
+  uint16_t sdLoadColumn = 0;         // Columns read so far
+  uint16_t sdLoadPasses = 0;         // loop() passes the read took
+  uint32_t sdLoadStartUs = 0;
+  uint32_t sdLoadReadUs = 0;         // Request to last byte read
+  uint32_t sdLoadCommitUs = 0;       // Dictionary commit and variants
+  uint32_t sdLoadTotalUs = 0;        // Request to completion
+  uint8_t sdLoadFormat = 1;          // .pov version of the file
+  Pov2Header sdLoadPov2;
+  uint32_t sdLoadBlockOffsets[POV2_MAX_BLOCKS];
+  uint16_t sdLoadBlock = 0;          // v2 blocks read so far
+  uint32_t sdLoadCrc = 0;            // Over the decoded columns
+  uint32_t sdLoadDecodeUs = 0;       // Part of the read time spent decoding
+  uint32_t sdLoadFileBytes = 0;
+  uint8_t povBlockBuffer[POV2_BLOCK_BUFFER];  // Encoded block being read or written
+#endif
+
+// Show bundles (0x28): one .show file holds a whole show - images, pattern
+// and sequence uploads and settings - behind an index table at the front:
+//
+//   header (16): magic "SHW1", version, reserved, asset_count(2),
+//                data_offset(4), data_bytes(4)           (little-endian)
+//   index (12 per asset): type, slot, reserved(2), offset(4), length(4)
+//   assets, in index order
+//
+// Image assets are .pov bodies (width(2) height(2) RGB column by column)
+// committed to `slot`; pattern, sequence and settings assets are
+// [cmd len data...] records applied like a 0x17 batch. Assets sit in file
+// order, so loading is a single sequential read, a chunk per loop() pass,
+// with the current content playing until each piece is committed.
+#ifdef SD_SUPPORT
+  #define SD_SHOW_DIR "/poi_shows"
+  #define SHOW_MAGIC 0x31574853      // "SHW1"
+  #define SHOW_VERSION 1
+  #define SHOW_HEADER_BYTES 16
+  #define SHOW_INDEX_ENTRY_BYTES 12
+  #define SHOW_MAX_ASSETS 256
+  #define SHOW_RECORDS_MAX 1024      // Largest pattern/sequence/settings asset
+  enum ShowAssetType : uint8_t {
+    SHOW_ASSET_IMAGE = 1,
+    SHOW_ASSET_PATTERN = 2,
+    SHOW_ASSET_SEQUENCE = 3,
+    SHOW_ASSET_SETTINGS = 4
+  };
+  struct ShowAsset {
+    uint8_t type;
+    uint8_t slot;          // Image slot (image assets only)
+    uint32_t offset;       // From the start of the file
+    uint32_t length;
+  };
+  ShowAsset showIndex[SHOW_MAX_ASSETS];
+  #ifdef ARDUINO_TEENSY41
+    EXTMEM CRGB showLoadStaging[IMAGE_MAX_WIDTH][IMAGE_HEIGHT];
+  #else
+    CRGB showLoadStaging[IMAGE_MAX_WIDTH][IMAGE_HEIGHT];
+  #endif
+  uint8_t showRecords[SHOW_RECORDS_MAX];
+  File showLoadFile;
+  uint8_t showLoadStatus = SD_LOAD_IDLE;  // Same codes as an 0x24 load
+  Stream* showLoadPort = nullptr;
+  uint16_t showAssetCount = 0;
+  uint16_t showAssetsDone = 0;
+  uint16_t showImagesDone = 0;
+  uint32_t showFilePos = 0;          // Bytes read from the file so far
+  uint16_t showImageWidth = 0;       // Image asset being read
+  uint16_t showImageHeight = 0;
+  uint16_t showImageColumn = 0;
+  uint16_t showLoadPasses = 0;
+  uint32_t showLoadStartUs = 0;
+  uint32_t showLoadReadUs = 0;       // Time spent in SD reads
+  uint32_t showLoadApplyUs = 0;      // Image commits and record batches
+  uint32_t showLoadTotalUs = 0;
+#endif
+
+// SD page cache (0x29): .pov files on the card play by name in mode 5
+// without a slot. Each file is split into blocks of SD_CACHE_BLOCK_COLUMNS
+// columns kept in a PSRAM pool. A miss in the render path reads its block
+// at once; loop() reads ahead of the playing column in the slack between
+// columns so that stays rare. With the pool (or the runtime budget) full
+// the least recently used block is evicted.
+#ifdef SD_SUPPORT
+  #define SD_CACHE_BLOCK_COLUMNS 16
+  #ifdef ARDUINO_TEENSY41
+    #define SD_CACHE_BLOCKS 512          // 16 x 96 bytes each: 768 KB PSRAM
+    EXTMEM CRGB sdCachePool[SD_CACHE_BLOCKS][SD_CACHE_BLOCK_COLUMNS][IMAGE_HEIGHT];
+  #else
+    #define SD_CACHE_BLOCKS 8
+    CRGB sdCachePool[SD_CACHE_BLOCKS][SD_CACHE_BLOCK_COLUMNS][IMAGE_HEIGHT];
+  #endif
+  #define SD_CACHE_FILES 8               // Files with blocks in the pool
+  #define SD_CACHE_MAX_WIDTH 1024        // Widest file the cache can play
+  #define SD_CACHE_FILE_BLOCKS (SD_CACHE_MAX_WIDTH / SD_CACHE_BLOCK_COLUMNS)
+  #define SD_CACHE_READAHEAD 2           // Blocks kept ahead of the playing column
+  #define SD_CACHE_FIRST_ESTIMATE_US 1000
+  struct SdCacheFile {
+    char path[MAX_FILEPATH_LEN];
+    uint16_t width;
+    uint16_t height;
+    uint32_t lastUsed;                   // LRU tick of its newest access
+    int16_t blocks[SD_CACHE_FILE_BLOCKS];  // Pool block per file block, -1 if not cached
+    uint8_t format;                      // .pov version
+    Pov2Header pov2;                     // v2 only
+    uint32_t dataStart;                  // First data byte in the file
+    uint32_t blockOffsets[SD_CACHE_FILE_BLOCKS];  // v2 only, from dataStart
+    bool active;
+  };
+  struct SdCacheBlock {
+    int8_t file;                         // -1 when free
+    uint8_t index;                       // Block within the file
+    uint32_t lastUsed;
+  };
+  SdCacheFile sdCacheFiles[SD_CACHE_FILES];
+  SdCacheBlock sdCacheBlocks[SD_CACHE_BLOCKS];
+  File sdCacheFile;                      // Kept open for the file last read
+  int8_t sdCacheOpenIndex = -1;
+  uint16_t sdCacheBudget = SD_CACHE_BLOCKS;  // Runtime limit on blocks in use
+  uint16_t sdCacheBlocksUsed = 0;
+  uint32_t sdCacheTick = 0;
+  uint32_t sdCacheFetchEstimateUs = SD_CACHE_FIRST_ESTIMATE_US;  // Decaying worst read
+  uint32_t sdCacheHits = 0;
+  uint32_t sdCacheMisses = 0;            // Columns whose block had to be read in the render path
+  uint32_t sdCacheReadaheads = 0;
+  uint32_t sdCacheEvictions = 0;
+  uint32_t sdCacheMissMaxUs = 0;         // Longest render-path read
+#endif
+
+// Background SD writer: image and preset saves are snapshotted into a job
+// queue and written from loop() one bounded step at a time (prepare, open
+// and preallocate a contiguous file, one sector, truncate and close). A
+// step only starts when the slack before the next column exceeds the
+// recent worst step of its kind, so writes fit between columns; the
+// occasional slow open or close does not hold back the sector writes. Step
+// latencies go into a histogram; delayed columns count steps that overran a
+// column start.
+#ifdef SD_SUPPORT
+  // A full-width .pov v2 file (QOI falls back to raw blocks when it does not shrink)
+  #define SD_WRITE_JOB_MAX (POV2_HEADER_BYTES + 4 * POV2_MAX_BLOCKS + IMAGE_MAX_WIDTH * IMAGE_HEIGHT * 3)
+  #ifdef ARDUINO_TEENSY41
+    #define SD_WRITE_QUEUE 4
+    EXTMEM uint8_t sdWriteData[SD_WRITE_QUEUE][SD_WRITE_JOB_MAX];
+  #else
+    #define SD_WRITE_QUEUE 1
+    uint8_t sdWriteData[SD_WRITE_QUEUE][SD_WRITE_JOB_MAX];
+  #endif
+  #define SD_WRITE_SECTOR 512          // Bytes written per step
+  #define SD_WRITE_GUARD_US 100        // Slack kept on top of the step estimate
+  #define SD_WRITE_FIRST_ESTIMATE_US 2000
+  #define SD_WRITE_MAX_DEFER_MS 500    // Run a step anyway after this long without one
+  #define SD_WRITE_STEP_KINDS 4
+  #define SD_WRITE_HIST_BUCKETS 64
+  #define SD_WRITE_HIST_US 32          // Bucket width; the last bucket is open-ended
+  enum SdWriteStep : uint8_t {
+    SD_WRITE_PREPARE = 0,    // Parent directory
+    SD_WRITE_OPEN = 1,       // Create/truncate and preallocate
+    SD_WRITE_DATA = 2,
+    SD_WRITE_CLOSE = 3       // Trim to length, update the directory entry
+  };
+  struct SdWriteJob {
+    char path[MAX_FILEPATH_LEN];
+    uint32_t length;
+    uint32_t written;
+    uint8_t step;
+  };
+  SdWriteJob sdWriteJobs[SD_WRITE_QUEUE];
+  uint8_t sdWriteHead = 0;
+  uint8_t sdWriteCount = 0;
+  FsFile sdWriteFile;
+  // Decaying worst step, per SdWriteStep
+  uint32_t sdWriteEstimateUs[SD_WRITE_STEP_KINDS] = {
+    SD_WRITE_FIRST_ESTIMATE_US, SD_WRITE_FIRST_ESTIMATE_US,
+    SD_WRITE_FIRST_ESTIMATE_US, SD_WRITE_FIRST_ESTIMATE_US
+  };
+  uint32_t sdWriteLastStepMs = 0;
+  uint32_t sdWriteHist[SD_WRITE_HIST_BUCKETS];
+  uint32_t sdWriteSteps = 0;
+  uint32_t sdWriteMaxUs = 0;
+  uint32_t sdWriteBytes = 0;
+  uint32_t sdWriteDone = 0;
+  uint32_t sdWriteFailed = 0;        // Write errors and saves refused with the queue full
+  uint32_t sdWriteDelayedColumns = 0;
+  uint32_t sdWriteDeferrals = 0;     // Checks that waited for more slack
+#endif
+
 // Serial command buffer
 // Buffer size calculation for larger images:
 //   Max image: IMAGE_MAX_WIDTH (400) × IMAGE_HEIGHT*2 (64, max accepted) × 3 (RGB) = 76,800 bytes
@@ -171,12 +647,101 @@ CRGB liveBuffer[DISPLAY_LEDS];
 // With PSRAM (16MB installed): buffer placed in EXTMEM; without PSRAM: reduced buffer
 #ifdef ARDUINO_TEENSY41
   #define CMD_BUFFER_SIZE 80000
-  EXTMEM uint8_t cmdBuffer[CMD_BUFFER_SIZE];
+  EXTMEM uint8_t esp32CmdBuffer[CMD_BUFFER_SIZE];
+  EXTMEM uint8_t usbCmdBuffer[CMD_BUFFER_SIZE];
 #else
   #define CMD_BUFFER_SIZE 6400
-  uint8_t cmdBuffer[CMD_BUFFER_SIZE];
+  uint8_t esp32CmdBuffer[CMD_BUFFER_SIZE];
+  uint8_t usbCmdBuffer[CMD_BUFFER_SIZE];
+#endif
+
+// Command ports
+// The framed protocol is accepted from the ESP32 link and from the native
+// USB port (480 Mbit/s, for desktop bulk sync and full-rate live streaming).
+// Each port assembles frames into its own buffer; while a frame is parsed,
+// cmdBuffer points at it and responses go back out through replyPort.
+// Frames are length-delimited (see commandFrameLength()), so binary payloads
+// may contain 0xFE. USB also carries the debug log, which is plain ASCII and
+// never contains the 0xFF/0xFE markers.
+#define SERIAL_POLL_BUDGET 16384  // Max bytes taken from one port per loop() pass
+#define LINK_RATE_WINDOW_MS 1000
+
+// ESP32 link receive ring
+// The UART ISR moves bytes from the 4-byte hardware FIFO into the core's
+// 64-byte ring, which overflows after ~5 ms at 115200 baud while loop() is
+// inside a show(), an image commit or an SD transfer (BUG-004). This ring
+// is added behind it with addMemoryForRead(), so the ISR keeps accepting
+// bytes for ~2.8 s at 115200 or ~160 ms at 2 Mbaud. It lives in RAM1 so the
+// ISR never waits on PSRAM.
+#define ESP32_RX_RING_SIZE 32768
+#define SERIAL1_CORE_RX_SIZE 64     // Core's own Serial1 receive buffer
+uint8_t esp32RxRing[ESP32_RX_RING_SIZE];
+
+struct CommandPort {
+  Stream* stream;
+  uint8_t* buffer;
+  uint32_t ringCapacity;     // Bytes the receive ring holds (0 = flow-controlled, e.g. USB)
+  volatile uint32_t* uartStat;  // LPUART status register, for FIFO overruns (nullptr if none)
+  uint32_t index;            // Bytes assembled so far
+  uint32_t expected;         // Full frame length once the header is in (0 = unknown)
+  uint32_t rxBytes;          // Link statistics (since boot)
+  uint32_t frames;
+  uint32_t errors;           // Framing errors and oversize frames
+  uint32_t overruns;         // Hardware FIFO overruns + polls that found the ring full
+  uint32_t rxPeak;           // Most bytes seen waiting in the receive ring
+  uint32_t windowStartMs;
+  uint32_t windowBytes;
+  uint32_t bytesPerSec;      // Receive rate over the last full window
+};
+#ifdef ARDUINO_TEENSY41
+  #define ESP32_UART_STAT (&LPUART6_STAT)  // Serial1 is LPUART6
+#else
+  #define ESP32_UART_STAT nullptr
 #endif
-uint32_t cmdBufferIndex = 0;
+CommandPort esp32Port = { &ESP32_SERIAL, esp32CmdBuffer,
+                          ESP32_RX_RING_SIZE + SERIAL1_CORE_RX_SIZE - 1, ESP32_UART_STAT,
+                          0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+CommandPort usbPort = { &Serial, usbCmdBuffer, 0, nullptr, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+// Capability handshake (0x16 -> 0xC2)
+// Sent to the ESP32 when the link comes up so it can size uploads to what
+// this build actually stores. Encoding bits name the upload formats the
+// parser accepts; later formats add bits rather than bumping the version.
+#define PROTOCOL_VERSION 1
+#define ENCODING_RAW_RGB      0x01  // 0x02 upload to slot 0
+#define ENCODING_SLOT_RGB     0x02  // 0x40 upload to any slot (16-bit length)
+#define ENCODING_COLUMN_DICT  0x04  // Images are stored column-deduplicated
+#define ENCODING_COLUMN_PATCH 0x08  // 0x41 changed column ranges of a stored image
+#define ENCODING_PROGRESSIVE  0x10  // 0x42 column-major upload shown while it arrives
+#define SUPPORTED_ENCODINGS (ENCODING_RAW_RGB | ENCODING_SLOT_RGB | ENCODING_COLUMN_DICT | \
+                             ENCODING_COLUMN_PATCH | ENCODING_PROGRESSIVE)
+
+uint8_t* cmdBuffer = esp32CmdBuffer;  // Frame being parsed
+uint32_t cmdFrameLength = 0;          // Its length including markers
+Stream* replyPort = &ESP32_SERIAL;    // Where responses to it are sent
+
+// Command batches (0x17)
+// One frame carrying several simple commands as [cmd][len][data...] records,
+// so a dashboard action (pattern + mode, or coalesced slider values) costs
+// one frame. Each record is copied into batchFrame and parsed as a frame of
+// its own; the per-record ACKs are withheld and the batch is ACKed once.
+uint8_t batchFrame[3 + 255 + 1];
+bool batchInProgress = false;
+
+// Read-back (0x18 -> 0xC3)
+// Streams a stored slot or SD file back in chunks that the requester pulls
+// one at a time, so neither side holds more than one chunk however large
+// the asset is. A slot is sent in the .pov file layout (width, height, then
+// RGB column by column), so either source downloads as a loadable file.
+#define READBACK_SOURCE_SLOT 0
+#define READBACK_SOURCE_FILE 1
+#define READBACK_OK          0
+#define READBACK_NOT_FOUND   1
+#define READBACK_BAD_OFFSET  2
+#define READBACK_CHUNK_MAX   512
+uint8_t readbackChunk[READBACK_CHUNK_MAX];
+// Serial1 transmit ring, so a whole chunk is queued without stalling loop()
+// for the ~45 ms it takes to send at 115200 baud
+uint8_t esp32TxRing[READBACK_CHUNK_MAX + 64];
 
 void setup() {
   // Initialize Serial for debugging
@@ -207,16 +772,22 @@ void setup() {
   
   // Initialize ESP32 Serial
   ESP32_SERIAL.begin(SERIAL_BAUD);
+  ESP32_SERIAL.addMemoryForRead(esp32RxRing, sizeof(esp32RxRing));
+  ESP32_SERIAL.addMemoryForWrite(esp32TxRing, sizeof(esp32TxRing));
   
   // Initialize FastLED
   FastLED.addLeds<LED_TYPE, DATA_PIN, CLOCK_PIN, COLOR_ORDER>(leds, NUM_LEDS);
   FastLED.setBrightness(128);
   FastLED.clear();
   FastLED.show();
+  hdOutput.begin();
   
   // Initialize storage
   initStorage();
-  
+
+  // Initialize INA219 current sensor (optional)
+  batteryPresent = battery.begin();
+
   // Initialize SD card (if enabled)
   #ifdef SD_SUPPORT
     initSDCard();
@@ -238,11 +809,38 @@ void loop() {
   // Process serial commands from ESP32
   processSerialCommands();
   
-  // Update display based on current mode
-  if (millis() - lastUpdate >= frameDelay) {
-    lastUpdate = millis();
+  // Track the spin rate (no-op without a rotation source)
+  rotation.update(micros());
+
+  // Update display based on current mode (a live replay paces its own columns)
+  if (!liveReplayActive() && micros() - lastColumnUs >= activeColumnPeriodUs) {
+    lastColumnUs = micros();
     updateDisplay();
+    noteRenderTime(micros() - lastColumnUs);
+    activeColumnPeriodUs = currentColumnPeriodUs();
   }
+
+  // Blank the strip once the column on-time has elapsed
+  serviceColumnBlanking();
+
+  // Duty-cycle current measurement (no-op unless one is running)
+  serviceDutyMeasurement();
+
+  // Drop a progressive upload whose frames stopped coming
+  serviceProgressiveUpload();
+
+  // Background SD transfers: live recording/replay, image and show loads, saves
+  #ifdef SD_SUPPORT
+    serviceLiveRecorder();
+    serviceSdLoad();
+    serviceShowLoad();
+    serviceSdCache();
+    serviceSdWriter();
+  #endif
+
+  // Pick the ARM clock for the current load, then sleep until there is work
+  serviceGovernor();
+  governorSleep();
 }
 
 void initStorage() {
@@ -251,7 +849,16 @@ void initStorage() {
     images[i].active = false;
     images[i].width = 0;
     images[i].height = 0;
+    images[i].columnCount = 0;
+    images[i].runCount = 0;
+    imageVariants[i].count = 0;
   }
+  imageColumnsUsed = 0;
+  imageRunsUsed = 0;
+  imageColumnsStale = 0;
+  imageRunsStale = 0;
+  variantPoolUsed = 0;
+  variantPoolStale = 0;
   
   for (int i = 0; i < MAX_PATTERNS; i++) {
     patterns[i].active = false;
@@ -259,6 +866,10 @@ void initStorage() {
     patterns[i].speed = 50;
   }
   
+  #ifdef SD_SUPPORT
+  sdCacheFlush();
+  #endif
+
   for (int i = 0; i < MAX_SEQUENCES; i++) {
     sequences[i].active = false;
     sequences[i].count = 0;
@@ -328,12 +939,9 @@ void createDemoImages() {
   const int H  = IMAGE_HEIGHT;  // 32
 
   // ── Image 0: Smiley Face (64×32) ──────────────────────────
-  images[0].active = true;
-  images[0].width  = W0;
-  images[0].height = H;
   for (int x = 0; x < W0; x++)
     for (int y = 0; y < H; y++)
-      images[0].pixels[x][y] = CRGB::Black;
+      imageStaging[x][y] = CRGB::Black;
 
   float cx0 = W0 / 2.0;
   float cy0 = H / 2.0;
@@ -345,11 +953,11 @@ void createDemoImages() {
       float d  = sqrt(dx * dx + dy * dy);
       // Filled yellow circle
       if (d <= r0) {
-        images[0].pixels[x][y] = CRGB(255, 200, 0);  // warm yellow
+        imageStaging[x][y] = CRGB(255, 200, 0);  // warm yellow
       }
       // Dark outline
       if (d > r0 - 1.2 && d <= r0) {
-        images[0].pixels[x][y] = CRGB(180, 140, 0);
+        imageStaging[x][y] = CRGB(180, 140, 0);
       }
     }
   }
@@ -362,7 +970,7 @@ void createDemoImages() {
       float dl = sqrt((x - leyX) * (x - leyX) + (y - leyY) * (y - leyY));
       float dr = sqrt((x - reyX) * (x - reyX) + (y - reyY) * (y - reyY));
       if (dl <= eyeR || dr <= eyeR)
-        images[0].pixels[x][y] = CRGB(60, 40, 0);
+        imageStaging[x][y] = CRGB(60, 40, 0);
     }
   }
   // Smile arc
@@ -372,33 +980,29 @@ void createDemoImages() {
     int y = (int)(cy0 + 4 + 4.0 * t * t);
     for (int dy = 0; dy <= 1; dy++) {
       if (y + dy >= 0 && y + dy < H)
-        images[0].pixels[x][y + dy] = CRGB(60, 40, 0);
+        imageStaging[x][y + dy] = CRGB(60, 40, 0);
     }
   }
+  commitImage(0, W0, H);
   Serial.println("Default image 0: Smiley Face (64x32)");
 
   // ── Image 1: Full Rainbow Spectrum (100×32) ──────────────
-  images[1].active = true;
-  images[1].width  = W1;
-  images[1].height = H;
   for (int x = 0; x < W1; x++) {
     uint8_t hue = (uint8_t)(x * 255L / W1);
     for (int y = 0; y < H; y++) {
       // Smooth vertical brightness fade: full at centre, dimmer at edges
       uint8_t val = 255 - abs(y - (int)(H / 2.0)) * 8;
       if (val < 80) val = 80;
-      images[1].pixels[x][y] = CHSV(hue, 240, val);
+      imageStaging[x][y] = CHSV(hue, 240, val);
     }
   }
+  commitImage(1, W1, H);
   Serial.println("Default image 1: Rainbow Spectrum (100x32)");
 
   // ── Image 2: Heart (64×32) ───────────────────────────────
-  images[2].active = true;
-  images[2].width  = W2;
-  images[2].height = H;
   for (int x = 0; x < W2; x++)
     for (int y = 0; y < H; y++)
-      images[2].pixels[x][y] = CRGB::Black;
+      imageStaging[x][y] = CRGB::Black;
 
   float cxH = W2 / 2.0;
   float cyH = H / 2.0;
@@ -415,16 +1019,14 @@ void createDemoImages() {
         uint8_t r = 255;
         uint8_t g = (uint8_t)max(0.0, 40.0 - d * 40.0);
         uint8_t b = (uint8_t)max(0.0, 60.0 - d * 50.0);
-        images[2].pixels[x][y] = CRGB(r, g, b);
+        imageStaging[x][y] = CRGB(r, g, b);
       }
     }
   }
+  commitImage(2, W2, H);
   Serial.println("Default image 2: Heart (64x32)");
 
   // ── Image 3: Starburst (80×32) ──────────────────────────
-  images[3].active = true;
-  images[3].width  = W3;
-  images[3].height = H;
   float cx3 = W3 / 2.0;
   float cy3 = H / 2.0;
   for (int x = 0; x < W3; x++) {
@@ -438,15 +1040,13 @@ void createDemoImages() {
       float brightness = ray * max(0.0, 1.0 - dist / 18.0);
       uint8_t hue = (uint8_t)((angle / 6.2832 + 0.5) * 255);
       uint8_t val = (uint8_t)(brightness * 255);
-      images[3].pixels[x][y] = CHSV(hue, 200, val);
+      imageStaging[x][y] = CHSV(hue, 200, val);
     }
   }
+  commitImage(3, W3, H);
   Serial.println("Default image 3: Starburst (80x32)");
 
   // ── Image 4: Nebula Spiral (100×32) ─────────────────────
-  images[4].active = true;
-  images[4].width  = W4;
-  images[4].height = H;
   float cx4 = W4 / 2.0;
   float cy4 = H / 2.0;
   for (int x = 0; x < W4; x++) {
@@ -462,10 +1062,12 @@ void createDemoImages() {
       uint8_t hue = (uint8_t)(180 + angle * 20 + dist * 3);
       uint8_t sat = 180 + (uint8_t)(glow * 75);
       uint8_t val = (uint8_t)(v * 255);
-      images[4].pixels[x][y] = CHSV(hue, sat, val);
+      imageStaging[x][y] = CHSV(hue, sat, val);
     }
   }
+  commitImage(4, W4, H);
   Serial.println("Default image 4: Nebula Spiral (100x32)");
+  sendStorageStats(false);
 }
 
 // Create demo sequence
@@ -520,30 +1122,111 @@ void startupAnimation() {
 }
 
 void processSerialCommands() {
-  while (ESP32_SERIAL.available()) {
-    uint8_t byte = ESP32_SERIAL.read();
-    
-    // Start of command marker
-    if (byte == 0xFF && cmdBufferIndex == 0) {
-      cmdBuffer[cmdBufferIndex++] = byte;
+  pollCommandPort(esp32Port);
+  pollCommandPort(usbPort);
+}
+
+// Full frame length implied by the header assembled so far, or 0 if more
+// header bytes are needed:
+//   0x02        0xFF cmd len(2) width(2) height(2) [width*height*3] 0xFE
+//               (sized from the dimensions; senders disagree on len)
+//   0x40-0x4F   0xFF cmd len_hi len_lo [len] 0xFE
+//   others      0xFF cmd len [len] 0xFE
+uint32_t commandFrameLength(const uint8_t* frame, uint32_t received) {
+  uint8_t cmd = frame[1];
+  if (cmd == 0x02) {
+    if (received < 8) return 0;
+    uint32_t width = frame[4] | ((uint16_t)frame[5] << 8);
+    uint32_t height = frame[6] | ((uint16_t)frame[7] << 8);
+    return 8 + width * height * 3 + 1;
+  }
+  if (cmd >= 0x40 && cmd <= 0x4F) {
+    if (received < 4) return 0;
+    return 4 + (((uint32_t)frame[2] << 8) | frame[3]) + 1;
+  }
+  if (received < 3) return 0;
+  return 3 + frame[2] + 1;
+}
+
+void feedCommandByte(CommandPort& port, uint8_t byte) {
+  if (port.index == 0) {
+    // Anything between frames (line noise, a truncated frame) is skipped
+    if (byte == 0xFF) port.buffer[port.index++] = byte;
+    return;
+  }
+
+  port.buffer[port.index++] = byte;
+  if (port.expected == 0) {
+    port.expected = commandFrameLength(port.buffer, port.index);
+    if (port.expected > CMD_BUFFER_SIZE) {
+      Serial.println("WARNING: Command frame too large, discarding");
+      port.errors++;
+      port.index = 0;
+      port.expected = 0;
+      return;
     }
-    // Continue building command
-    else if (cmdBufferIndex > 0) {
-      cmdBuffer[cmdBufferIndex++] = byte;
-      
-      // Prevent buffer overflow
-      if (cmdBufferIndex >= CMD_BUFFER_SIZE) {
-        Serial.println("WARNING: Command buffer overflow, resetting");
-        cmdBufferIndex = 0;
-        continue;
-      }
-      
-      // Check if we have end marker (commands vary in length)
-      if (byte == 0xFE && cmdBufferIndex >= 4) {
-        parseCommand();
-        cmdBufferIndex = 0;
-      }
+  }
+  if (port.expected == 0 || port.index < port.expected) return;
+
+  if (byte == 0xFE) {
+    cmdBuffer = port.buffer;
+    cmdFrameLength = port.index;
+    replyPort = port.stream;
+    parseCommand();
+    replyPort = &ESP32_SERIAL;
+    port.frames++;
+  } else {
+    Serial.println("WARNING: Command frame missing end marker, discarding");
+    port.errors++;
+  }
+  port.index = 0;
+  port.expected = 0;
+}
+
+// Counts receive losses since the last poll: a full ring means the ISR has
+// been discarding bytes, a set OR flag means the hardware FIFO overflowed
+// before the ISR ran.
+void checkPortOverruns(CommandPort& port) {
+  uint32_t waiting = (uint32_t)max(port.stream->available(), 0);
+  if (waiting > port.rxPeak) port.rxPeak = waiting;
+  if (port.ringCapacity > 0 && waiting >= port.ringCapacity) {
+    port.overruns++;
+  }
+  #ifdef ARDUINO_TEENSY41
+  if (port.uartStat && (*port.uartStat & LPUART_STAT_OR)) {
+    *port.uartStat = LPUART_STAT_OR;  // W1C: write only OR, or other set flags clear too
+    port.overruns++;
+  }
+  #endif
+}
+
+void pollCommandPort(CommandPort& port) {
+  checkPortOverruns(port);
+
+  uint32_t budget = SERIAL_POLL_BUDGET;
+  int available;
+  while (budget > 0 && (available = port.stream->available()) > 0) {
+    uint32_t n;
+    if (port.expected > 0 && port.index + 1 < port.expected) {
+      // Inside a payload: copy straight into the frame, up to the end marker
+      n = min((uint32_t)available, min(budget, port.expected - 1 - port.index));
+      n = port.stream->readBytes((char*)&port.buffer[port.index], n);
+      port.index += n;
+    } else {
+      feedCommandByte(port, (uint8_t)port.stream->read());
+      n = 1;
     }
+    if (n == 0) break;
+    port.rxBytes += n;
+    port.windowBytes += n;
+    budget -= n;
+  }
+
+  uint32_t now = millis();
+  if (now - port.windowStartMs >= LINK_RATE_WINDOW_MS) {
+    port.bytesPerSec = (uint32_t)((uint64_t)port.windowBytes * 1000 / (now - port.windowStartMs));
+    port.windowBytes = 0;
+    port.windowStartMs = now;
   }
 }
 
@@ -560,20 +1243,7 @@ void parseCommand() {
   switch (cmd) {
     case 0x01:  // Set mode
       if (dataLen >= 2) {
-        uint8_t newMode = cmdBuffer[3];
-        uint8_t newIndex = cmdBuffer[4];
-        
-        // Reset sequence state when changing modes
-        if (newMode != currentMode || newIndex != currentIndex) {
-          sequencePlaying = false;
-          currentSequenceItem = 0;
-          sequenceStartTime = 0;
-        }
-        
-        currentMode = newMode;
-        currentIndex = newIndex;
-        Serial.print("Mode set to: ");
-        Serial.println(currentMode);
+        setDisplayMode(cmdBuffer[3], cmdBuffer[4]);
       }
       sendAck(cmd);
       break;
@@ -595,6 +1265,13 @@ void parseCommand() {
       
     case 0x05:  // Live frame data
       receiveLiveFrame();
+      // Latch immediately so a host streaming at column rate sets the pace
+      if (currentMode == 4 && !liveReplayActive()) {
+        displayLive();
+        showLeds();
+        lastColumnUs = columnShownAtUs = micros();
+        columnBlanked = false;
+      }
       break;
       
     case 0x06:  // Set brightness
@@ -615,6 +1292,7 @@ void parseCommand() {
           if (frameDelay == 0) frameDelay = 1;  // Cap at 1ms minimum
         }
         Serial.print("Frame rate set to: ");
+        activeColumnPeriodUs = currentColumnPeriodUs();
         Serial.print(fps);
         Serial.print(" FPS (delay=");
         Serial.print(frameDelay);
@@ -622,6 +1300,7 @@ void parseCommand() {
       } else if (dataLen == 1) {
         // Legacy 1-byte protocol: raw delay in ms (backward compat)
         frameDelay = cmdBuffer[3];
+        activeColumnPeriodUs = currentColumnPeriodUs();
         Serial.print("Frame delay set to: ");
         Serial.println(frameDelay);
       }
@@ -641,9 +1320,117 @@ void parseCommand() {
       sendAck(cmd);
       break;
 
+    case 0x09:  // Set column duty cycle (percent on-time per column)
+      if (dataLen >= 1) {
+        columnDutyPercent = constrain(cmdBuffer[3], MIN_COLUMN_DUTY, 100);
+        Serial.print("Column duty set to: ");
+        Serial.print(columnDutyPercent);
+        Serial.println("%");
+      }
+      sendAck(cmd);
+      break;
+
+    case 0x0A:  // Set rotation tracking (source, image arc in degrees)
+      if (dataLen >= 3) {
+        uint16_t arc = ((uint16_t)cmdBuffer[4] << 8) | cmdBuffer[5];
+        if (arc >= 10 && arc <= 360) imageArcDeg = arc;
+        setRotationSource(cmdBuffer[3]);
+      }
+      sendAck(cmd);
+      break;
+
+    case 0x0C:  // Output stage (hdr, dither, optional gamma x10)
+      if (dataLen >= 2) {
+        hdrOutput = cmdBuffer[3] != 0;
+        hdOutput.setDither(cmdBuffer[4] != 0);
+        if (dataLen >= 3 && cmdBuffer[5] >= 10 && cmdBuffer[5] <= 30) {
+          hdOutput.setGamma(cmdBuffer[5] / 10.0f);
+        }
+        Serial.print("HDR output: ");
+        Serial.print(hdrOutput ? "on" : "off");
+        Serial.print(", dither ");
+        Serial.print(hdOutput.dither() ? "on" : "off");
+        Serial.print(", gamma ");
+        Serial.println(hdOutput.gamma());
+      }
+      sendAck(cmd);
+      break;
+
+    case 0x0D:  // Power governor on/off
+      if (dataLen >= 1) {
+        governorEnabled = cmdBuffer[3] != 0;
+        Serial.print("Power governor: ");
+        Serial.println(governorEnabled ? "on" : "off");
+      }
+      sendAck(cmd);
+      break;
+
     case 0x10:  // Status request
       sendStatus();
       break;
+
+    case 0x11:  // Power measurement (op 0=report, 1=start duty A/B, 2=start governor A/B)
+      if (dataLen >= 1 && cmdBuffer[3] == 1) {
+        startPowerMeasurement(POWER_TARGET_DUTY);
+      } else if (dataLen >= 1 && cmdBuffer[3] == 2) {
+        startPowerMeasurement(POWER_TARGET_GOVERNOR);
+      }
+      sendPowerReport();
+      break;
+
+    case 0x14:  // Power governor report
+      sendGovernorReport();
+      break;
+
+    case 0x15:  // Image storage report
+      sendStorageStats(true);
+      break;
+
+    case 0x16:  // Capability handshake
+      sendCapabilities();
+      break;
+
+    case 0x17:  // Batch of simple commands
+      if (!batchInProgress) {
+        applyCommandBatch();
+      }
+      sendAck(cmd);
+      break;
+
+    case 0x18:  // Read back a slot or SD file chunk
+      sendReadbackChunk();
+      break;
+
+    case 0x19:  // Particle engine benchmark
+      sendParticleBench();
+      break;
+
+    case 0x1A:  // Which image slots hold an image
+      sendSlotMap();
+      break;
+
+    case 0x12:  // Rotation report request
+      sendRotationReport();
+      break;
+
+    case 0x13:  // Link statistics request
+      sendLinkStats();
+      break;
+
+    case 0x40:  // Upload image to a slot (16-bit length)
+      if (cmdFrameLength >= 10) {
+        storeUploadedImage(cmdBuffer[4], 5);
+      }
+      sendAck(cmd);
+      break;
+
+    case 0x41:  // Patch changed columns of a stored image (16-bit length)
+      applyImagePatch();
+      break;
+
+    case 0x42:  // Progressive column-major upload (16-bit length)
+      receiveProgressive();
+      break;
       
     #ifdef SD_SUPPORT
     case 0x20:  // Save image to SD
@@ -665,6 +1452,26 @@ void parseCommand() {
     case 0x24:  // Load image from SD
       loadImageFromSD();
       break;
+
+    case 0x25:  // Live recording (record/stop/replay/report)
+      handleLiveRecorderCommand();
+      break;
+
+    case 0x26:  // SD writer report
+      sendSdWriterReport();
+      break;
+
+    case 0x27:  // Last SD load result
+      sendSdLoadEvent(replyPort);
+      break;
+
+    case 0x28:  // Show bundle
+      handleShowCommand();
+      break;
+
+    case 0x29:  // SD page cache (play by name, stats, budget)
+      handleSdCacheCommand();
+      break;
       
     case 0x30:  // Pattern preset commands (save/load/list/delete)
       handlePatternSDCommand();
@@ -677,41 +1484,102 @@ void parseCommand() {
   }
 }
 
+// Runs each [cmd][len][data...] record of a 0x17 frame in order.
+void applyCommandBatch() {
+  applyCommandRecords(&cmdBuffer[3], cmdBuffer[2]);
+}
+
+// Runs [cmd][len][data...] records (0x17 batches, show bundle assets).
+// Commands with a 16-bit length (image uploads), nested batches and show
+// loads are skipped; a truncated record ends the list.
+void applyCommandRecords(const uint8_t* records, uint32_t length) {
+  uint8_t* frame = cmdBuffer;
+  uint32_t frameLength = cmdFrameLength;
+  uint32_t pos = 0;
+
+  batchInProgress = true;
+  while (pos + 2 <= length) {
+    uint8_t subCmd = records[pos];
+    uint8_t subLen = records[pos + 1];
+    if (pos + 2 + subLen > length) break;
+
+    if (subCmd != 0x02 && subCmd != 0x17 && subCmd != 0x28 && (subCmd < 0x40 || subCmd > 0x4F)) {
+      batchFrame[0] = 0xFF;
+      memcpy(&batchFrame[1], &records[pos], 2 + subLen);
+      batchFrame[3 + subLen] = 0xFE;
+      cmdBuffer = batchFrame;
+      cmdFrameLength = 4 + subLen;
+      parseCommand();
+    }
+    pos += 2 + subLen;
+  }
+  batchInProgress = false;
+
+  cmdBuffer = frame;
+  cmdFrameLength = frameLength;
+}
+
+void setDisplayMode(uint8_t newMode, uint8_t newIndex) {
+  // Reset sequence state when changing modes
+  if (newMode != currentMode || newIndex != currentIndex) {
+    sequencePlaying = false;
+    currentSequenceItem = 0;
+    sequenceStartTime = 0;
+  }
+
+  // An explicit mode change takes the display back from a live replay
+  #ifdef SD_SUPPORT
+  if (liveRecState == LIVE_REC_REPLAYING) {
+    stopLiveRecorder();
+  }
+  #endif
+
+  currentMode = newMode;
+  currentIndex = newIndex;
+  Serial.print("Mode set to: ");
+  Serial.println(currentMode);
+}
+
 void receiveImage() {
-  // Parse image header from command buffer
   // Protocol: 0xFF 0x02 dataLen_high dataLen_low width_low width_high height_low height_high [RGB data...] 0xFE
-  // Updated to support 16-bit width/height values
-  uint16_t dataLen = (cmdBuffer[2] << 8) | cmdBuffer[3];
-  uint16_t srcWidth = cmdBuffer[4] | (cmdBuffer[5] << 8);   // 16-bit width
-  uint16_t srcHeight = cmdBuffer[6] | (cmdBuffer[7] << 8);  // 16-bit height
-  
   // Always store uploaded images in slot 0 (most recent upload)
   // This simplifies the web/app interface - they don't need to manage slots
-  uint8_t imgIndex = 0;
+  storeUploadedImage(0, 4);
+}
+
+// Stores an uploaded image from the current frame. headerPos is the offset
+// of the width_low width_high height_low height_high header; RGB data follows
+// it. Used by 0x02 (slot 0) and 0x40 (explicit slot, for bulk sync).
+void storeUploadedImage(uint8_t imgIndex, uint32_t headerPos) {
+  uint16_t srcWidth = cmdBuffer[headerPos] | (cmdBuffer[headerPos + 1] << 8);       // 16-bit width
+  uint16_t srcHeight = cmdBuffer[headerPos + 2] | (cmdBuffer[headerPos + 3] << 8);  // 16-bit height
+  uint32_t pixelStart = headerPos + 4;
   
   // Calculate expected data size
   // Cast to uint32_t to prevent overflow: max is 400*64*3 = 76,800 bytes
-  uint32_t expectedBytes = 8 + ((uint32_t)srcWidth * (uint32_t)srcHeight * 3) + 1; // header + pixels + end marker
+  uint32_t expectedBytes = pixelStart + ((uint32_t)srcWidth * (uint32_t)srcHeight * 3) + 1; // header + pixels + end marker
   
   if (imgIndex >= MAX_IMAGES) {
     Serial.println("Error: Invalid image index");
     return;
   }
   
-  if (cmdBufferIndex < expectedBytes) {
+  if (cmdFrameLength < expectedBytes) {
     Serial.print("Warning: Incomplete image data. Expected ");
     Serial.print(expectedBytes);
     Serial.print(", got ");
-    Serial.println(cmdBufferIndex);
+    Serial.println(cmdFrameLength);
     // Continue anyway with what we have
   }
   
-  Serial.print("Receiving image, source size: ");
+  Serial.print("Receiving image for slot ");
+  Serial.print(imgIndex);
+  Serial.print(", source size: ");
   Serial.print(srcWidth);
   Serial.print("x");
   Serial.print(srcHeight);
   Serial.print(" (buffer has ");
-  Serial.print(cmdBufferIndex);
+  Serial.print(cmdFrameLength);
   Serial.println(" bytes)");
   
   // Check if image fits within limits
@@ -746,20 +1614,16 @@ void receiveImage() {
   Serial.print("x");
   Serial.println(srcHeight);
   
-  images[imgIndex].width = srcWidth;
-  images[imgIndex].height = srcHeight;
-  images[imgIndex].active = true;
-  
-  // Read pixel data directly
+  // Read pixel data into the staging columns
   uint32_t pixelCount = (uint32_t)srcWidth * srcHeight;
   for (uint32_t i = 0; i < pixelCount; i++) {
-    uint32_t bufferPos = 8 + i * 3;  // 8-byte header
+    uint32_t bufferPos = pixelStart + i * 3;
     // Ensure we have all 3 bytes for this pixel
-    if (bufferPos + 2 < (uint32_t)(cmdBufferIndex - 1)) { // -1 for end marker
+    if (bufferPos + 2 < (uint32_t)(cmdFrameLength - 1)) { // -1 for end marker
       uint16_t x = i % srcWidth;
       uint16_t y = i / srcWidth;
-      if (x < IMAGE_MAX_WIDTH && y < IMAGE_HEIGHT * 2) {  // Safety bounds check
-        images[imgIndex].pixels[x][y] = CRGB(
+      if (x < IMAGE_MAX_WIDTH && y < IMAGE_HEIGHT) {  // Safety bounds check (imageStaging is IMAGE_HEIGHT tall)
+        imageStaging[x][y] = CRGB(
           cmdBuffer[bufferPos],
           cmdBuffer[bufferPos + 1],
           cmdBuffer[bufferPos + 2]
@@ -769,12 +1633,14 @@ void receiveImage() {
       // Fill remaining with black if data is incomplete
       uint16_t x = i % srcWidth;
       uint16_t y = i / srcWidth;
-      if (x < IMAGE_MAX_WIDTH && y < IMAGE_HEIGHT * 2) {
-        images[imgIndex].pixels[x][y] = CRGB::Black;
+      if (x < IMAGE_MAX_WIDTH && y < IMAGE_HEIGHT) {
+        imageStaging[x][y] = CRGB::Black;
       }
     }
   }
   
+  // Rows beyond the strip are not stored
+  if (!commitImage(imgIndex, srcWidth, min(srcHeight, (uint16_t)IMAGE_HEIGHT))) return;
   Serial.println("Image received and processed successfully");
 }
 
@@ -819,15 +1685,28 @@ void receiveLiveFrame() {
   for (int i = 0; i < DISPLAY_LEDS && (3 + (i + 1) * 3 - 1) < CMD_BUFFER_SIZE; i++) {
     liveBuffer[i] = CRGB(cmdBuffer[3 + i * 3], cmdBuffer[4 + i * 3], cmdBuffer[5 + i * 3]);
   }
+
+  #ifdef SD_SUPPORT
+  if (liveRecState == LIVE_REC_RECORDING) {
+    recordLiveColumn();
+  }
+  #endif
 }
 
 void updateDisplay() {
-  
-  switch (currentMode) {
-    case 0:  // Idle - off
+  if (currentMode == 0) {
+    // Idle: latch one dark frame, then stop refreshing the strip
+    if (!stripDark) {
       FastLED.clear();
-      break;
-      
+      showLeds();
+      stripDark = true;
+    }
+    columnBlanked = true;
+    return;
+  }
+  stripDark = false;
+
+  switch (currentMode) {
     case 1:  // Display image
       displayImage();
       break;
@@ -843,31 +1722,160 @@ void updateDisplay() {
     case 4:  // Live mode
       displayLive();
       break;
+
+    #ifdef SD_SUPPORT
+    case 5:  // SD image through the page cache
+      displaySdImage();
+      break;
+    #endif
   }
-  
-  FastLED.show();
+
+  showLeds();
+  columnShownAtUs = micros();
+  columnBlanked = false;
 }
 
-void displayImage() {
-  if (currentIndex >= MAX_IMAGES || !images[currentIndex].active) {
-    FastLED.clear();
-    return;
+// Latches leds[] through the active output stage
+void showLeds() {
+  if (hdrOutput) {
+    hdOutput.show(leds, FastLED.getBrightness());
+  } else {
+    FastLED.show();
   }
-  
-  POVImage& img = images[currentIndex];
-  
-  // Display current column of the image (all 32 LEDs are display LEDs)
-  for (int i = 0; i < DISPLAY_LEDS && i < img.height; i++) {
-    leds[i + DISPLAY_LED_START] = img.pixels[currentColumn][i];
+}
+
+// Clocks out an all-black frame without touching leds[]
+void blankLeds() {
+  if (hdrOutput) {
+    hdOutput.showBlack();
+  } else {
+    FastLED.show(0);
   }
-  
-  currentColumn = (currentColumn + 1) % img.width;
 }
 
-void displayPattern() {
-  if (currentIndex >= MAX_PATTERNS || !patterns[currentIndex].active) {
-    FastLED.clear();
-    return;
+// Effective duty for this column; the A/B measurement forces 100% during
+// its reference phase so both phases render identical content.
+uint8_t effectiveColumnDuty() {
+  if (dutyMeasureState == DUTY_MEASURE_FULL && powerMeasureTarget == POWER_TARGET_DUTY) return 100;
+  return columnDutyPercent;
+}
+
+// A progressive upload shows in place of its slot in image mode only;
+// sequences keep the slot's committed image until the upload ends
+bool showsProgressive(uint8_t imgIndex) {
+  return progressiveActive && currentMode == 1 && imgIndex == progressiveSlot;
+}
+
+// Width of the image currently on screen, or 0 when not showing an image
+uint16_t activeImageWidth() {
+  uint8_t imgIndex;
+  if (currentMode == 1) {
+    imgIndex = currentIndex;
+  } else if (currentMode == 3 && currentIndex < MAX_SEQUENCES && sequences[currentIndex].active) {
+    uint8_t item = sequences[currentIndex].items[currentSequenceItem];
+    if (item & 0x80) return 0;  // Pattern item
+    imgIndex = item & 0x7F;
+  #ifdef SD_SUPPORT
+  } else if (currentMode == 5) {
+    return currentIndex < SD_CACHE_FILES && sdCacheFiles[currentIndex].active
+      ? sdCacheFiles[currentIndex].width : 0;
+  #endif
+  } else {
+    return 0;
+  }
+  if (showsProgressive(imgIndex)) return progressiveWidth;
+  if (imgIndex >= MAX_IMAGES || !images[imgIndex].active) return 0;
+  return (displayImageSlot == imgIndex) ? displayImageWidth : images[imgIndex].width;
+}
+
+// Column period for the next column: paced from the measured spin rate when
+// an image is showing and the estimator is locked, otherwise frameDelay.
+uint32_t currentColumnPeriodUs() {
+  uint32_t fixedUs = frameDelay * 1000UL;
+  if (!rotation.source() || !rotation.isLocked(micros())) return fixedUs;
+
+  uint16_t width = activeImageWidth();
+  if (width == 0) return fixedUs;
+
+  uint32_t periodUs = rotation.columnPeriodUs(width, imageArcDeg);
+  return max(periodUs, (uint32_t)MIN_COLUMN_PERIOD_US);
+}
+
+void serviceColumnBlanking() {
+  if (columnBlanked) return;
+  uint8_t duty = effectiveColumnDuty();
+  if (duty >= 100) return;
+
+  uint32_t onTimeUs = activeColumnPeriodUs * duty / 100;
+  if (micros() - columnShownAtUs >= onTimeUs) {
+    // Blank without touching leds[], so patterns that fade from the
+    // previous frame keep their state.
+    blankLeds();
+    columnBlanked = true;
+  }
+}
+
+void displayImage() {
+  if (showsProgressive(currentIndex)) {
+    displayProgressiveColumn();
+    return;
+  }
+  if (currentIndex >= MAX_IMAGES || !images[currentIndex].active) {
+    FastLED.clear();
+    return;
+  }
+  
+  POVImage& img = images[currentIndex];
+
+  // Only change resolution at an image boundary so a pass is never mixed
+  if (currentColumn == 0 || currentColumn >= displayImageWidth || displayImageSlot != currentIndex) {
+    currentColumn = 0;
+    displayImageSlot = currentIndex;
+    displayVariant = selectImageVariant(currentIndex);
+    displayImageWidth = displayVariant < 0
+      ? img.width
+      : imageVariants[currentIndex].variants[displayVariant].width;
+    displayRun = 0;
+    displayRunPos = 0;
+  }
+
+  const CRGB* column;
+  if (displayVariant < 0) {
+    // Follow the run cursor into the image's column dictionary
+    const ColumnRun& run = imageRuns[img.runOffset + displayRun];
+    column = imageColumns[img.columnOffset + run.column];
+    if (++displayRunPos >= run.count) {
+      displayRun++;
+      displayRunPos = 0;
+    }
+  } else {
+    column = variantPool[imageVariants[currentIndex].variants[displayVariant].offset + currentColumn];
+  }
+
+  // Display current column of the image (all 32 LEDs are display LEDs)
+  for (int i = 0; i < DISPLAY_LEDS && i < img.height; i++) {
+    leds[i + DISPLAY_LED_START] = column[i];
+  }
+
+  currentColumn = (currentColumn + 1) % displayImageWidth;
+}
+
+// Column of a progressive upload in progress: a missing column shows the
+// nearest received one, and the strip stays dark until the first arrives
+void displayProgressiveColumn() {
+  displayImageSlot = 0xFF;  // The slot's run cursor is re-selected once the upload ends
+  if (currentColumn >= progressiveWidth) currentColumn = 0;
+  uint16_t source = progressiveSource[currentColumn];
+  for (int i = 0; i < DISPLAY_LEDS && i < progressiveHeight; i++) {
+    leds[i + DISPLAY_LED_START] = source == PROGRESSIVE_NONE ? CRGB(CRGB::Black) : progressiveStaging[source][i];
+  }
+  currentColumn = (currentColumn + 1) % progressiveWidth;
+}
+
+void displayPattern() {
+  if (currentIndex >= MAX_PATTERNS || !patterns[currentIndex].active) {
+    FastLED.clear();
+    return;
   }
 
   Pattern& pat = patterns[currentIndex];
@@ -875,36 +1883,21 @@ void displayPattern() {
   // Dividing by frameDelay approximates the old frame-counter behavior
   // while being clock-aligned across devices.
   uint32_t patternTime = (uint32_t)((int32_t)millis() + syncTimeOffset) / max((uint32_t)1, frameDelay);
-  
+
+  // Periodic patterns play back from the baked cycle once it is complete
+  uint32_t period = patternPhasePeriod(pat);
+  if (period > 0) {
+    uint32_t phase = patternPhase(pat, patternTime) % period;
+    if (servicePatternBake(currentIndex, period)) {
+      memcpy(&leds[DISPLAY_LED_START], &bakedColumns[phase][DISPLAY_LED_START],
+             DISPLAY_LEDS * sizeof(CRGB));
+    } else {
+      renderPatternPhase(pat, phase, leds);
+    }
+    return;
+  }
+
   switch (pat.type) {
-    case 0:  // Rainbow
-      for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
-        uint8_t hue = (patternTime * pat.speed / 10 + i * 255 / DISPLAY_LEDS) % 256;
-        leds[i] = CHSV(hue, 255, 255);
-      }
-      break;
-      
-    case 1:  // Wave
-      for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
-        uint8_t brightness = (sin8(patternTime * pat.speed / 10 + i * 255 / DISPLAY_LEDS));
-        leds[i] = pat.color1;
-        leds[i].nscale8(brightness);
-      }
-      break;
-      
-    case 2:  // Gradient - scrolling blend between two colors
-      {
-        uint32_t gradMillis = (uint32_t)((int32_t)millis() + syncTimeOffset);
-        // Use 8-bit math so the phase wraps naturally and avoids 32-bit overflow
-        uint8_t timeOffset = (uint8_t)((uint8_t)(gradMillis / 500u) * pat.speed);
-        for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
-          // sin8 gives a smooth 0-255 wave that wraps naturally (no hard snap)
-          uint8_t phase = (uint8_t)((i - DISPLAY_LED_START) * 255 / DISPLAY_LEDS) + timeOffset;
-          leds[i] = blend(pat.color1, pat.color2, sin8(phase));
-        }
-      }
-      break;
-      
     case 3:  // Sparkle
       if (random8() < pat.speed) {
         leds[random8(DISPLAY_LED_START, NUM_LEDS)] = pat.color1;
@@ -953,16 +1946,6 @@ void displayPattern() {
       }
       break;
       
-    case 6:  // Breathing - smooth pulse on/off
-      {
-        uint8_t breath = beatsin8(pat.speed / 4, 20, 255);
-        for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
-          leds[i] = pat.color1;
-          leds[i].nscale8(breath);
-        }
-      }
-      break;
-      
     case 7:  // Strobe - quick flashes using wall-clock time
       {
         static bool strobeOn = false;
@@ -1017,15 +2000,6 @@ void displayPattern() {
       }
       break;
       
-    case 10:  // Plasma - organic color mixing
-      for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
-        uint8_t hue = sin8(i * 10 + patternTime * pat.speed / 20) + 
-                      sin8(i * 15 - patternTime * pat.speed / 15) +
-                      sin8(patternTime * pat.speed / 10);
-        leds[i] = CHSV(hue, 255, 255);
-      }
-      break;
-      
     case 11:  // Music Reactive - VU meter style with beat detection (MAX9814)
       {
         static uint16_t audioSamples[AUDIO_SAMPLES];
@@ -1242,33 +2216,313 @@ void displayPattern() {
       }
       break;
 
+    case 18:  // Fireworks - bursts that spread and fall back
+    case 19:  // Rain - drops from the tip falling toward the hub
+    case 20:  // Sparks - showers thrown out from the hub
+      renderParticles(pat);
+      break;
+
+    default:
+      FastLED.clear();
+      break;
+  }
+}
+
+// ==================== PARTICLE PATTERNS ====================
+
+// Spawn and motion rule for a particle pattern. Particles take a random mix
+// of the two colours; speed scales the launch velocity and how often they
+// are born.
+void particleRuleFor(const Pattern& pat, ParticleRule& rule) {
+  const int16_t strip = DISPLAY_LEDS * PARTICLE_SUBPIXELS;
+  int16_t speed = max((int16_t)1, (int16_t)pat.speed);
+  memset(&rule, 0, sizeof(rule));
+  rule.color1[0] = pat.color1.r;
+  rule.color1[1] = pat.color1.g;
+  rule.color1[2] = pat.color1.b;
+  rule.color2[0] = pat.color2.r;
+  rule.color2[1] = pat.color2.g;
+  rule.color2[2] = pat.color2.b;
+
+  switch (pat.type) {
+    case 18:  // Fireworks: bursts around the middle, slowed by drag
+      rule.burstChance = (uint8_t)min(255, speed / 8 + 2);
+      rule.burstSize = 28;
+      rule.originMin = strip / 4;
+      rule.originMax = strip * 3 / 4;
+      rule.velocityMin = -speed * 2;
+      rule.velocityMax = speed * 2;
+      rule.gravity = -1;
+      rule.drag = 8;
+      rule.decayMin = 4;
+      rule.decayMax = 8;
+      rule.trail = 160;
+      break;
+
+    case 19:  // Rain: steady drops from the tip, accelerating inward
+      rule.spawnRate = (uint8_t)min(255, speed / 8 + 1);
+      rule.originMin = strip - PARTICLE_SUBPIXELS;
+      rule.originMax = strip - 1;
+      rule.velocityMin = -speed;
+      rule.velocityMax = -speed / 4;
+      rule.gravity = -2;
+      rule.decayMin = 1;
+      rule.decayMax = 2;
+      rule.trail = 64;
+      break;
+
+    case 20:  // Sparks: thrown outward from the hub, short-lived
+      rule.spawnRate = (uint8_t)min(255, speed / 4 + 1);
+      rule.originMin = 0;
+      rule.originMax = PARTICLE_SUBPIXELS - 1;
+      rule.velocityMin = speed;
+      rule.velocityMax = speed * 3;
+      rule.gravity = -4;
+      rule.drag = 8;
+      rule.decayMin = 6;
+      rule.decayMax = 12;
+      rule.trail = 128;
+      break;
+  }
+}
+
+void renderParticles(const Pattern& pat) {
+  if (particleSlot != currentIndex) {
+    particles.clear();
+    particleSlot = currentIndex;
+  }
+  ParticleRule rule;
+  particleRuleFor(pat, rule);
+  particles.step(rule, DISPLAY_LEDS);
+  particles.render(rule, (uint8_t*)&leds[DISPLAY_LED_START], DISPLAY_LEDS);
+}
+
+void sendParticleBench() {
+  // Request:  0xFF 0x19 len count(2) columns(2) 0xFE
+  // Steps and draws a separate pool of `count` particles that never die for
+  // `columns` columns, so the cost per column can be compared with the
+  // column period. The live pool is left alone.
+  // Response (27 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xC8 particles(2) columns(2) avg_ns(4) worst_us(4) period_us(4)
+  //   live_count(2) live_peak(2) dropped(4) 0xFE
+  static ParticleSystem benchPool;
+  static CRGB benchColumn[DISPLAY_LEDS];
+  uint8_t dataLen = cmdBuffer[2];
+  uint16_t count = PARTICLE_CAPACITY;
+  uint16_t columns = 1000;
+  if (dataLen >= 4) {
+    count = ((uint16_t)cmdBuffer[3] << 8) | cmdBuffer[4];
+    columns = ((uint16_t)cmdBuffer[5] << 8) | cmdBuffer[6];
+  }
+  if (count > PARTICLE_CAPACITY) count = PARTICLE_CAPACITY;
+  if (columns == 0) columns = 1;
+  if (columns > 10000) columns = 10000;
+
+  ParticleRule rule;
+  memset(&rule, 0, sizeof(rule));
+  rule.originMax = DISPLAY_LEDS * PARTICLE_SUBPIXELS - 1;
+  rule.trail = 64;
+  rule.color1[0] = 255;
+  rule.color2[2] = 255;
+  benchPool.seed(rule, count);
+  for (int i = 0; i < DISPLAY_LEDS; i++) benchColumn[i] = CRGB::Black;
+
+  uint32_t worstUs = 0;
+  uint32_t startUs = micros();
+  for (uint16_t c = 0; c < columns; c++) {
+    uint32_t columnStartUs = micros();
+    benchPool.step(rule, DISPLAY_LEDS);
+    benchPool.render(rule, (uint8_t*)benchColumn, DISPLAY_LEDS);
+    uint32_t us = micros() - columnStartUs;
+    if (us > worstUs) worstUs = us;
+  }
+  uint32_t avgNs = (uint32_t)((uint64_t)(micros() - startUs) * 1000 / columns);
+
+  Serial.print("Particle bench: ");
+  Serial.print(count);
+  Serial.print(" particles, ");
+  Serial.print(avgNs);
+  Serial.print(" ns/column avg, ");
+  Serial.print(worstUs);
+  Serial.println(" us worst");
+
+  const ParticleStats& live = particles.stats();
+  uint32_t longs[3] = { avgNs, worstUs, activeColumnPeriodUs };
+  replyPort->write(0xFF);
+  replyPort->write(0xC8);  // Particle benchmark
+  replyPort->write((uint8_t)(count >> 8));
+  replyPort->write((uint8_t)(count & 0xFF));
+  replyPort->write((uint8_t)(columns >> 8));
+  replyPort->write((uint8_t)(columns & 0xFF));
+  for (int i = 0; i < 3; i++) {
+    for (int b = 3; b >= 0; b--) {
+      replyPort->write((uint8_t)((longs[i] >> (b * 8)) & 0xFF));
+    }
+  }
+  replyPort->write((uint8_t)(particles.count() >> 8));
+  replyPort->write((uint8_t)(particles.count() & 0xFF));
+  replyPort->write((uint8_t)(live.peak >> 8));
+  replyPort->write((uint8_t)(live.peak & 0xFF));
+  for (int b = 3; b >= 0; b--) {
+    replyPort->write((uint8_t)((live.dropped >> (b * 8)) & 0xFF));
+  }
+  replyPort->write(0xFE);
+}
+
+// ==================== PATTERN BAKING ====================
+
+// Steps after which (step * speed / divisor) advances by a multiple of modulus
+uint32_t phaseCycle(uint8_t speed, uint32_t divisor, uint32_t modulus) {
+  uint32_t span = divisor * modulus;
+  uint32_t a = span, b = speed;
+  while (b != 0) {
+    uint32_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return span / a;
+}
+
+// Length of the phase cycle of a periodic pattern, 0 if it is not periodic
+// (random, stateful or audio-driven patterns always render live)
+uint32_t patternPhasePeriod(const Pattern& pat) {
+  switch (pat.type) {
+    case 0:   // Rainbow: hue = t * speed / 10
+    case 1:   // Wave
+      return phaseCycle(pat.speed, 10, 256);
+    case 2:   // Gradient: offset = step * speed, step = 500 ms
+      return phaseCycle(pat.speed, 1, 256);
+    case 6:   // Breathing: one beat8() cycle
+      return 256;
+    case 10:  // Plasma: t * speed / 20, / 15 and / 10 must all wrap
+      return phaseCycle(pat.speed, 60, 256);
+    case 16:  // Split Spin: offset = t * speed / 20 % DISPLAY_LEDS
+      return phaseCycle(pat.speed, kPatternSpeedDivisor, DISPLAY_LEDS);
+    case 17:  // Theater Chase: offset = t * speed / 20 % 3
+      return phaseCycle(pat.speed, kPatternSpeedDivisor, 3);
+    default:
+      return 0;
+  }
+}
+
+// Current phase of a periodic pattern (reduced modulo the period by the caller)
+uint32_t patternPhase(const Pattern& pat, uint32_t patternTime) {
+  switch (pat.type) {
+    case 2:
+      return (uint32_t)((int32_t)millis() + syncTimeOffset) / 500u;
+    case 6:
+      return beat8(pat.speed / 4);
+    default:
+      return patternTime;
+  }
+}
+
+// Renders one phase of a periodic pattern into out[DISPLAY_LED_START..NUM_LEDS)
+void renderPatternPhase(const Pattern& pat, uint32_t phase, CRGB* out) {
+  switch (pat.type) {
+    case 0:  // Rainbow
+      for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
+        uint8_t hue = (phase * pat.speed / 10 + i * 255 / DISPLAY_LEDS) % 256;
+        out[i] = CHSV(hue, 255, 255);
+      }
+      break;
+
+    case 1:  // Wave
+      for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
+        uint8_t brightness = (sin8(phase * pat.speed / 10 + i * 255 / DISPLAY_LEDS));
+        out[i] = pat.color1;
+        out[i].nscale8(brightness);
+      }
+      break;
+
+    case 2:  // Gradient - scrolling blend between two colors
+      {
+        // Use 8-bit math so the phase wraps naturally and avoids 32-bit overflow
+        uint8_t timeOffset = (uint8_t)((uint8_t)phase * pat.speed);
+        for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
+          // sin8 gives a smooth 0-255 wave that wraps naturally (no hard snap)
+          uint8_t wave = (uint8_t)((i - DISPLAY_LED_START) * 255 / DISPLAY_LEDS) + timeOffset;
+          out[i] = blend(pat.color1, pat.color2, sin8(wave));
+        }
+      }
+      break;
+
+    case 6:  // Breathing - smooth pulse on/off (beatsin8(speed / 4, 20, 255))
+      {
+        uint8_t breath = 20 + scale8(sin8((uint8_t)phase), 255 - 20);
+        for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
+          out[i] = pat.color1;
+          out[i].nscale8(breath);
+        }
+      }
+      break;
+
+    case 10:  // Plasma - organic color mixing
+      for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
+        uint8_t hue = sin8(i * 10 + phase * pat.speed / 20) +
+                      sin8(i * 15 - phase * pat.speed / 15) +
+                      sin8(phase * pat.speed / 10);
+        out[i] = CHSV(hue, 255, 255);
+      }
+      break;
+
     case 16:  // Split Spin - rotating two-color halves
       {
-        uint8_t offset = (patternTime * pat.speed / kPatternSpeedDivisor) % DISPLAY_LEDS;
+        uint8_t offset = (phase * pat.speed / kPatternSpeedDivisor) % DISPLAY_LEDS;
         uint8_t splitPoint = DISPLAY_LEDS / 2;
         for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
           uint8_t pos = (i - 1 + offset) % DISPLAY_LEDS;
-          leds[i] = (pos < splitPoint) ? pat.color1 : pat.color2;
+          out[i] = (pos < splitPoint) ? pat.color1 : pat.color2;
         }
       }
       break;
 
     case 17:  // Theater Chase - dotted chase with background
       {
-        uint8_t chaseOffset = (patternTime * pat.speed / kPatternSpeedDivisor) % 3;
+        uint8_t chaseOffset = (phase * pat.speed / kPatternSpeedDivisor) % 3;
         for (int i = DISPLAY_LED_START; i < NUM_LEDS; i++) {
-          uint8_t phase = (i - 1 + chaseOffset) % 3;
-          leds[i] = (phase == 0) ? pat.color1 : pat.color2;
+          uint8_t dot = (i - 1 + chaseOffset) % 3;
+          out[i] = (dot == 0) ? pat.color1 : pat.color2;
         }
       }
       break;
-      
-    default:
-      FastLED.clear();
-      break;
   }
 }
 
+// Bakes the next slice of the cycle for patterns[slot], restarting when its
+// parameters changed. Returns true once the whole cycle is baked.
+bool servicePatternBake(uint8_t slot, uint32_t period) {
+  const Pattern& pat = patterns[slot];
+  if (period > PATTERN_BAKE_COLUMNS) return false;  // Cycle too long: stay live
+
+  if (bakedSlot != slot || bakedPattern.type != pat.type || bakedPattern.speed != pat.speed ||
+      bakedPattern.color1 != pat.color1 || bakedPattern.color2 != pat.color2) {
+    bakedPattern = pat;
+    bakedSlot = slot;
+    bakedPeriod = period;
+    bakedCount = 0;
+    bakeStartMs = millis();
+  }
+  if (bakedCount >= bakedPeriod) return true;
+
+  uint32_t sliceStart = micros();
+  uint32_t sliceUs = activeColumnPeriodUs * PATTERN_BAKE_SLICE_PCT / 100;
+  do {
+    renderPatternPhase(bakedPattern, bakedCount, bakedColumns[bakedCount]);
+    bakedCount++;
+  } while (bakedCount < bakedPeriod && micros() - sliceStart < sliceUs);
+
+  if (bakedCount < bakedPeriod) return false;
+  Serial.print("Baked pattern ");
+  Serial.print(slot);
+  Serial.print(": ");
+  Serial.print(bakedPeriod);
+  Serial.print(" columns in ");
+  Serial.print(millis() - bakeStartMs);
+  Serial.println("ms");
+  return true;
+}
+
 void displaySequence() {
   // Get current sequence
   if (currentIndex >= MAX_SEQUENCES || !sequences[currentIndex].active) {
@@ -1363,187 +2617,2182 @@ void displayLive() {
   }
 }
 
+// True while a live recording is being replayed; the replay then owns the
+// display and latches each recorded column at its recorded time.
+bool liveReplayActive() {
+  #ifdef SD_SUPPORT
+    return liveRecState == LIVE_REC_REPLAYING;
+  #else
+    return false;
+  #endif
+}
+
 void sendAck(uint8_t cmd) {
-  ESP32_SERIAL.write(0xFF);
-  ESP32_SERIAL.write(0xAA);  // ACK
-  ESP32_SERIAL.write(cmd);
-  ESP32_SERIAL.write(0xFE);
+  if (batchInProgress) return;  // The batch is ACKed as a whole
+  replyPort->write(0xFF);
+  replyPort->write(0xAA);  // ACK
+  replyPort->write(cmd);
+  replyPort->write(0xFE);
 }
 
 void sendStatus() {
   // Response frame (6 bytes total):
   //   0xFF 0xBB mode index sd_present 0xFE
   // ESP32 checkTeensyConnection() must read and validate the trailing 0xFE.
-  ESP32_SERIAL.write(0xFF);
-  ESP32_SERIAL.write(0xBB);  // Status response
-  ESP32_SERIAL.write(currentMode);
-  ESP32_SERIAL.write(currentIndex);
+  replyPort->write(0xFF);
+  replyPort->write(0xBB);  // Status response
+  replyPort->write(currentMode);
+  replyPort->write(currentIndex);
   #ifdef SD_SUPPORT
-  ESP32_SERIAL.write(sdInitialized ? (uint8_t)1 : (uint8_t)0);
+  replyPort->write(sdInitialized ? (uint8_t)1 : (uint8_t)0);
   #else
-  ESP32_SERIAL.write((uint8_t)0);
+  replyPort->write((uint8_t)0);
   #endif
-  ESP32_SERIAL.write(0xFE);
+  replyPort->write(0xFE);
 }
 
-// ==================== SD CARD FUNCTIONS ====================
-#ifdef SD_SUPPORT
+// ==================== IMAGE STORAGE ====================
 
-void initSDCard() {
-  Serial.print("Initializing SD card...");
-  
-  if (!SD.begin(BUILTIN_SDCARD)) {
-    Serial.println("Failed!");
-    Serial.println("Check that SD card is inserted");
-    sdInitialized = false;
-    return;
+// FNV-1a over one column, used to find repeated columns
+uint32_t hashColumn(const CRGB* column) {
+  const uint8_t* bytes = (const uint8_t*)column;
+  uint32_t hash = 2166136261u;
+  for (uint16_t i = 0; i < IMAGE_HEIGHT * sizeof(CRGB); i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
   }
-  
-  Serial.println("OK");
-  sdInitialized = true;
-  
-  // Create image directory if it doesn't exist
-  if (!SD.exists(SD_IMAGE_DIR)) {
-    Serial.print("Creating directory: ");
-    Serial.println(SD_IMAGE_DIR);
-    SD.mkdir(SD_IMAGE_DIR);
+  return hash;
+}
+
+// FNV-1a over the first `rows` pixels of a column. Matches the per-column
+// hashes the ESP32 keeps of what it sent, so a patch can name the image it
+// was made against.
+uint32_t hashColumnRows(const CRGB* column, uint16_t rows) {
+  uint32_t hash = 2166136261u;
+  for (uint16_t y = 0; y < rows; y++) {
+    hash = (hash ^ column[y].r) * 16777619u;
+    hash = (hash ^ column[y].g) * 16777619u;
+    hash = (hash ^ column[y].b) * 16777619u;
   }
-  
-  Serial.println("SD Card: Ready");
+  return hash;
 }
 
-void saveImageToSD() {
-  // Protocol: 0xFF 0x20 len filename_len [filename] img_index 0xFE
-  // Save the specified image slot to SD card with given filename
-  
-  uint8_t filenameLen = cmdBuffer[3];
-  if (filenameLen == 0 || filenameLen > MAX_FILENAME_LEN) {
-    Serial.println("Invalid filename length");
-    sendAck(0x20);
-    return;
+// Releases a slot's dictionary and runs. The space is only marked stale;
+// it is reused once compactImagePool() runs.
+void releaseImageColumns(uint8_t slot) {
+  POVImage& img = images[slot];
+  imageColumnsStale += img.columnCount;
+  imageRunsStale += img.runCount;
+  img.columnCount = 0;
+  img.runCount = 0;
+}
+
+// Slides every image's columns and runs down over stale space. Only runs
+// when a commit finds no room at the end of the pools, so uploads and
+// replacements normally never move PSRAM while columns are being shown.
+void compactImagePool() {
+  uint32_t columnEnd = 0;
+  uint32_t runEnd = 0;
+  int32_t last = -1;
+  uint32_t startUs = micros();
+  for (;;) {
+    // Next image in pool order; images keep their order, so each moves once
+    int next = -1;
+    for (int i = 0; i < MAX_IMAGES; i++) {
+      if (images[i].columnCount == 0 || (int32_t)images[i].columnOffset <= last) continue;
+      if (next < 0 || images[i].columnOffset < images[next].columnOffset) next = i;
+    }
+    if (next < 0) break;
+    POVImage& img = images[next];
+    last = img.columnOffset;
+    if (img.columnOffset != columnEnd) {
+      memmove(imageColumns[columnEnd], imageColumns[img.columnOffset], img.columnCount * sizeof(imageColumns[0]));
+      img.columnOffset = columnEnd;
+    }
+    if (img.runOffset != runEnd) {
+      memmove(&imageRuns[runEnd], &imageRuns[img.runOffset], img.runCount * sizeof(ColumnRun));
+      img.runOffset = runEnd;
+    }
+    columnEnd += img.columnCount;
+    runEnd += img.runCount;
   }
-  
-  // Extract filename
-  char filename[MAX_FILENAME_LEN + 1];
-  memcpy(filename, &cmdBuffer[4], filenameLen);
-  filename[filenameLen] = '\0';
-  
-  // Get image index
-  uint8_t imgIndex = cmdBuffer[4 + filenameLen];
-  
-  if (imgIndex >= MAX_IMAGES || !images[imgIndex].active) {
-    Serial.println("Invalid image index");
-    sendAck(0x20);
-    return;
+  Serial.print("Image pool compacted: ");
+  Serial.print(imageColumnsStale);
+  Serial.print(" columns freed in ");
+  Serial.print(micros() - startUs);
+  Serial.println(" us");
+  imageColumnsUsed = columnEnd;
+  imageRunsUsed = runEnd;
+  imageColumnsStale = 0;
+  imageRunsStale = 0;
+  displayImageSlot = 0xFF;  // Pool moved; re-select at the next column
+}
+
+// Stores the image held in imageStaging[0..width) into a slot as a column
+// dictionary plus runs, then rebuilds its variants. The dictionary is built
+// before the pools are touched: if the image does not fit even in place of
+// the slot's current one, false is returned and that image stays. Only the
+// image's unique columns have to fit.
+bool commitImage(uint8_t slot, uint16_t width, uint16_t height) {
+  if (slot >= MAX_IMAGES || width == 0 || width > IMAGE_MAX_WIDTH) return false;
+
+  // Rows past the image height take part in the comparison, so clear them
+  if (height < IMAGE_HEIGHT) {
+    for (uint16_t x = 0; x < width; x++) {
+      for (uint16_t y = height; y < IMAGE_HEIGHT; y++) imageStaging[x][y] = CRGB::Black;
+    }
   }
-  
-  // Build full path
-  char filepath[MAX_FILEPATH_LEN];
-  snprintf(filepath, sizeof(filepath), "%s/%s.pov", SD_IMAGE_DIR, filename);
-  
-  Serial.print("Saving image to: ");
-  Serial.println(filepath);
-  
-  // Open file for writing
-  File file = SD.open(filepath, FILE_WRITE);
-  if (!file) {
-    Serial.println("Failed to create file");
-    sendAck(0x20);
-    return;
+
+  // Dictionary lookup: hash -> first staging column with that content
+  static uint16_t hashSlots[COLUMN_HASH_SLOTS];
+  static uint16_t dictIndex[IMAGE_MAX_WIDTH];   // Staging column -> dictionary index
+  static uint16_t dictSource[IMAGE_MAX_WIDTH];  // Dictionary index -> staging column
+  static ColumnRun runList[IMAGE_MAX_WIDTH];
+  memset(hashSlots, 0xFF, sizeof(hashSlots));
+  uint16_t columns = 0;
+  uint16_t runs = 0;
+
+  for (uint16_t x = 0; x < width; x++) {
+    uint32_t h = hashColumn(imageStaging[x]) & (COLUMN_HASH_SLOTS - 1);
+    uint16_t match = 0xFFFF;
+    while (hashSlots[h] != 0xFFFF) {
+      uint16_t candidate = hashSlots[h];
+      if (memcmp(imageStaging[candidate], imageStaging[x], sizeof(imageStaging[0])) == 0) {
+        match = dictIndex[candidate];
+        break;
+      }
+      h = (h + 1) & (COLUMN_HASH_SLOTS - 1);
+    }
+    if (match == 0xFFFF) {
+      match = columns++;
+      hashSlots[h] = x;
+      dictSource[match] = x;
+    }
+    dictIndex[x] = match;
+
+    if (runs > 0 && runList[runs - 1].column == match) {
+      runList[runs - 1].count++;
+    } else {
+      runList[runs++] = { match, 1 };
+    }
   }
-  
-  POVImage& img = images[imgIndex];
-  
-  // Write header: width (2 bytes), height (2 bytes) for supporting larger images
-  // Note: This changes the file format. Old files (1 byte width/height) won't be compatible.
-  file.write((uint8_t)(img.width & 0xFF));        // Low byte
-  file.write((uint8_t)((img.width >> 8) & 0xFF)); // High byte
-  file.write((uint8_t)(img.height & 0xFF));       // Low byte
-  file.write((uint8_t)((img.height >> 8) & 0xFF));// High byte
-  
-  // Write pixel data (RGB, row by row)
-  for (int x = 0; x < img.width; x++) {
-    for (int y = 0; y < img.height; y++) {
-      file.write(img.pixels[x][y].r);
-      file.write(img.pixels[x][y].g);
-      file.write(img.pixels[x][y].b);
+
+  // Capacity first, counting the slot's current image as free
+  POVImage& img = images[slot];
+  uint32_t liveColumns = imageColumnsUsed - imageColumnsStale - img.columnCount;
+  uint32_t liveRuns = imageRunsUsed - imageRunsStale - img.runCount;
+  if (liveColumns + columns > IMAGE_POOL_COLUMNS || liveRuns + runs > IMAGE_POOL_RUNS) {
+    Serial.println("Error: Image storage full");
+    return false;
+  }
+
+  // Room at the end of the pools keeps the current image showing until the
+  // switch. Without it, compact; the current image is released before that
+  // only when the new one needs its space too (it is known to fit by now).
+  if (imageColumnsUsed + columns > IMAGE_POOL_COLUMNS || imageRunsUsed + runs > IMAGE_POOL_RUNS) {
+    if (imageColumnsUsed - imageColumnsStale + columns > IMAGE_POOL_COLUMNS ||
+        imageRunsUsed - imageRunsStale + runs > IMAGE_POOL_RUNS) {
+      releaseImageColumns(slot);
+      img.active = false;
     }
+    compactImagePool();
   }
-  
-  file.close();
-  Serial.println("Image saved successfully");
-  sendAck(0x20);
-}
 
-void loadImageFromSD() {
-  // Protocol: 0xFF 0x24 dataLen [filenameLen] [filename] [imgIndex] 0xFE
-  // Load image from SD card into the specified slot
-  // cmdBuffer[3] = filenameLen, cmdBuffer[4..] = filename bytes
+  uint32_t columnOffset = imageColumnsUsed;
+  uint32_t runOffset = imageRunsUsed;
+  for (uint16_t d = 0; d < columns; d++) {
+    memcpy(imageColumns[columnOffset + d], imageStaging[dictSource[d]], sizeof(imageStaging[0]));
+  }
+  memcpy(&imageRuns[runOffset], runList, runs * sizeof(ColumnRun));
+  imageColumnsUsed += columns;
+  imageRunsUsed += runs;
+
+  releaseImageColumns(slot);
+  img.width = width;
+  img.height = height;
+  img.columnOffset = columnOffset;
+  img.columnCount = columns;
+  img.runOffset = runOffset;
+  img.runCount = runs;
+  img.active = true;
+  if (slot == displayImageSlot) displayImageSlot = 0xFF;
+
+  Serial.print("Image ");
+  Serial.print(slot);
+  Serial.print(": ");
+  Serial.print(width);
+  Serial.print(" columns -> ");
+  Serial.print(columns);
+  Serial.print(" unique, ");
+  Serial.print(runs);
+  Serial.println(" runs");
+
+  buildImageVariants(slot);
+  return true;
+}
+
+// Expands a stored image back into imageStaging (for resampling / SD save)
+void expandImage(uint8_t slot) {
+  const POVImage& img = images[slot];
+  uint16_t x = 0;
+  for (uint16_t r = 0; r < img.runCount; r++) {
+    const ColumnRun& run = imageRuns[img.runOffset + r];
+    for (uint16_t n = 0; n < run.count && x < IMAGE_MAX_WIDTH; n++, x++) {
+      memcpy(imageStaging[x], imageColumns[img.columnOffset + run.column], sizeof(imageStaging[0]));
+    }
+  }
+}
+
+// Patch results (0xC9 status)
+#define PATCH_OK          0
+#define PATCH_NO_IMAGE    1  // Slot empty or a different size
+#define PATCH_BASE_CHANGED 2 // Slot no longer holds the image the patch was made against
+#define PATCH_BAD_FRAME   3
+#define PATCH_NO_SPACE    4
+
+// Replaces changed column ranges of a stored image. The frame is checked in
+// full (slot, size, base digest, every range) before the slot is touched,
+// and the patched image is committed in one step between two columns, so
+// the display shows either the old image or the new one.
+void applyImagePatch() {
+  // Request:  0xFF 0x41 len_hi len_lo slot width(2) height(2) base_digest(4)
+  //           [x(2) count(2) count*height*RGB, column by column]... 0xFE
+  //           (little-endian; base_digest is FNV-1a over the little-endian
+  //           hashColumnRows() of every column of the image being replaced)
+  // Response: 0xFF 0xC9 status columns(2) 0xFE
+  uint8_t status = PATCH_OK;
+  uint16_t patched = 0;
+  uint32_t end = cmdFrameLength - 1;  // Index of the end marker
+  uint8_t slot = cmdBuffer[4];
+
+  if (cmdFrameLength < 15) {
+    status = PATCH_BAD_FRAME;
+  } else if (slot >= MAX_IMAGES || !images[slot].active ||
+             images[slot].width != (cmdBuffer[5] | (cmdBuffer[6] << 8)) ||
+             images[slot].height != (cmdBuffer[7] | (cmdBuffer[8] << 8))) {
+    status = PATCH_NO_IMAGE;
+  }
+
+  const POVImage& img = images[slot < MAX_IMAGES ? slot : 0];
+  uint32_t columnBytes = (uint32_t)img.height * 3;
+  if (status == PATCH_OK) {
+    // Every range must lie inside the image and the data must fill the frame
+    uint32_t pos = 13;
+    while (pos < end && status == PATCH_OK) {
+      if (pos + 4 > end) {
+        status = PATCH_BAD_FRAME;
+        break;
+      }
+      uint16_t x = cmdBuffer[pos] | (cmdBuffer[pos + 1] << 8);
+      uint16_t count = cmdBuffer[pos + 2] | (cmdBuffer[pos + 3] << 8);
+      pos += 4 + count * columnBytes;
+      if (count == 0 || x + count > img.width || pos > end) status = PATCH_BAD_FRAME;
+    }
+  }
+  if (status == PATCH_OK) {
+    expandImage(slot);
+    uint32_t digest = 2166136261u;
+    for (uint16_t x = 0; x < img.width; x++) {
+      uint32_t h = hashColumnRows(imageStaging[x], img.height);
+      for (int b = 0; b < 32; b += 8) digest = (digest ^ ((h >> b) & 0xFF)) * 16777619u;
+    }
+    uint32_t base = (uint32_t)cmdBuffer[9] | ((uint32_t)cmdBuffer[10] << 8) |
+                    ((uint32_t)cmdBuffer[11] << 16) | ((uint32_t)cmdBuffer[12] << 24);
+    if (digest != base) status = PATCH_BASE_CHANGED;
+  }
+
+  if (status == PATCH_OK) {
+    uint32_t pos = 13;
+    while (pos < end) {
+      uint16_t x = cmdBuffer[pos] | (cmdBuffer[pos + 1] << 8);
+      uint16_t count = cmdBuffer[pos + 2] | (cmdBuffer[pos + 3] << 8);
+      pos += 4;
+      for (uint16_t c = 0; c < count; c++, x++) {
+        for (uint16_t y = 0; y < img.height; y++, pos += 3) {
+          imageStaging[x][y] = CRGB(cmdBuffer[pos], cmdBuffer[pos + 1], cmdBuffer[pos + 2]);
+        }
+        patched++;
+      }
+    }
+    if (!commitImage(slot, img.width, img.height)) status = PATCH_NO_SPACE;
+  }
+
+  Serial.print("Patch slot ");
+  Serial.print(slot);
+  Serial.print(": status ");
+  Serial.print(status);
+  Serial.print(", ");
+  Serial.print(patched);
+  Serial.println(" columns");
+
+  replyPort->write(0xFF);
+  replyPort->write(0xC9);  // Patch result
+  replyPort->write(status);
+  replyPort->write((uint8_t)(patched >> 8));
+  replyPort->write((uint8_t)(patched & 0xFF));
+  replyPort->write(0xFE);
+}
+
+// Progressive upload results (0xCA status)
+#define PROGRESSIVE_OK         0
+#define PROGRESSIVE_NOT_ACTIVE 1  // No upload in progress (bad begin, or abandoned)
+#define PROGRESSIVE_INCOMPLETE 2  // Columns missing; the slot keeps its image
+#define PROGRESSIVE_NO_SPACE   3
+
+// Points every column that has not arrived at the nearest one that has
+// (the left one on a tie) and returns the largest distance
+uint16_t fillProgressiveGaps() {
+  // Received columns point at themselves; left to right, the rest take the
+  // nearest received column on their left
+  uint16_t left = PROGRESSIVE_NONE;
+  for (uint16_t x = 0; x < progressiveWidth; x++) {
+    if (progressiveSource[x] == x) {
+      left = x;
+    } else {
+      progressiveSource[x] = left;
+    }
+  }
+  // Right to left, the one on the right wins where it is nearer
+  uint16_t right = PROGRESSIVE_NONE;
+  uint16_t worst = 0;
+  for (int x = progressiveWidth - 1; x >= 0; x--) {
+    uint16_t source = progressiveSource[x];
+    if (source == x) {
+      right = x;
+      continue;
+    }
+    if (right != PROGRESSIVE_NONE && (source == PROGRESSIVE_NONE || right - x < x - source)) {
+      source = right;
+      progressiveSource[x] = right;
+    }
+    if (source == PROGRESSIVE_NONE) return PROGRESSIVE_NONE;
+    uint16_t distance = source > x ? source - x : x - source;
+    if (distance > worst) worst = distance;
+  }
+  return worst;
+}
+
+void receiveProgressive() {
+  // Request:  0xFF 0x42 len_hi len_lo op ... 0xFE (little-endian values)
+  //   op 1, begin:   slot width(2) height(2) show
+  //   op 2, columns: x(2) step(2) count(2) [count*height*RGB, column by column]
+  //                  carrying columns x, x+step, x+2*step...
+  //   op 3, end:     commits the image
+  // Response to end: 0xFF 0xCA status received(2) coarse_us(4) total_us(4) 0xFE
+  uint32_t end = cmdFrameLength - 1;  // Index of the end marker
+  uint8_t op = end > 4 ? cmdBuffer[4] : 0;
+
+  if (op == 1) {
+    uint8_t slot = cmdBuffer[5];
+    uint16_t width = cmdBuffer[6] | (cmdBuffer[7] << 8);
+    uint16_t height = cmdBuffer[8] | (cmdBuffer[9] << 8);
+    progressiveActive = end >= 11 && slot < MAX_IMAGES && width > 0 && width <= IMAGE_MAX_WIDTH &&
+                        height > 0 && height <= IMAGE_HEIGHT;
+    if (!progressiveActive) {
+      Serial.println("Progressive upload: bad slot or size");
+      return;
+    }
+    progressiveSlot = slot;
+    progressiveWidth = width;
+    progressiveHeight = height;
+    progressiveReceived = 0;
+    progressiveCoarseUs = 0;
+    progressiveStartUs = micros();
+    progressiveLastMs = millis();
+    for (uint16_t x = 0; x < width; x++) progressiveSource[x] = PROGRESSIVE_NONE;
+    displayImageSlot = 0xFF;
+    if (cmdBuffer[10]) setDisplayMode(1, slot);
+    return;
+  }
+
+  if (op == 2) {
+    if (!progressiveActive || end < 11) return;
+    uint32_t x = cmdBuffer[5] | (cmdBuffer[6] << 8);
+    uint16_t step = max(1, cmdBuffer[7] | (cmdBuffer[8] << 8));
+    uint16_t count = cmdBuffer[9] | (cmdBuffer[10] << 8);
+    uint32_t columnBytes = (uint32_t)progressiveHeight * 3;
+    uint32_t pos = 11;
+    for (uint16_t c = 0; c < count && x < progressiveWidth && pos + columnBytes <= end; c++) {
+      // Columns are sent top to bottom as RGB, the same layout as CRGB
+      memcpy(progressiveStaging[x], &cmdBuffer[pos], columnBytes);
+      if (progressiveSource[x] != x) progressiveReceived++;
+      progressiveSource[x] = x;
+      x += step;
+      pos += columnBytes;
+    }
+    uint16_t worst = fillProgressiveGaps();
+    if (progressiveCoarseUs == 0 && worst < PROGRESSIVE_COARSE_GAP) {
+      progressiveCoarseUs = max((uint32_t)1, micros() - progressiveStartUs);
+    }
+    progressiveLastMs = millis();
+    return;
+  }
+
+  if (op != 3) return;
+  uint8_t status;
+  uint32_t totalUs = progressiveActive ? micros() - progressiveStartUs : 0;
+  if (!progressiveActive) {
+    status = PROGRESSIVE_NOT_ACTIVE;
+  } else if (progressiveReceived < progressiveWidth) {
+    status = PROGRESSIVE_INCOMPLETE;
+  } else {
+    memcpy(imageStaging, progressiveStaging, sizeof(imageStaging[0]) * progressiveWidth);
+    status = commitImage(progressiveSlot, progressiveWidth, progressiveHeight)
+      ? PROGRESSIVE_OK : PROGRESSIVE_NO_SPACE;
+  }
+  progressiveActive = false;
+  displayImageSlot = 0xFF;  // Back to the slot from the next column
+
+  Serial.print("Progressive upload to slot ");
+  Serial.print(progressiveSlot);
+  Serial.print(": status ");
+  Serial.print(status);
+  Serial.print(", ");
+  Serial.print(progressiveReceived);
+  Serial.print(" columns, coarse after ");
+  Serial.print(progressiveCoarseUs);
+  Serial.print(" us of ");
+  Serial.print(totalUs);
+  Serial.println(" us");
+
+  replyPort->write(0xFF);
+  replyPort->write(0xCA);  // Progressive upload result
+  replyPort->write(status);
+  replyPort->write((uint8_t)(progressiveReceived >> 8));
+  replyPort->write((uint8_t)(progressiveReceived & 0xFF));
+  for (int b = 3; b >= 0; b--) replyPort->write((uint8_t)(progressiveCoarseUs >> (b * 8)));
+  for (int b = 3; b >= 0; b--) replyPort->write((uint8_t)(totalUs >> (b * 8)));
+  replyPort->write(0xFE);
+}
+
+// Abandons a progressive upload whose frames stopped coming (link lost), so
+// the slot goes back to showing the image it holds
+void serviceProgressiveUpload() {
+  if (progressiveActive && millis() - progressiveLastMs > PROGRESSIVE_TIMEOUT_MS) {
+    Serial.println("Progressive upload abandoned");
+    progressiveActive = false;
+    displayImageSlot = 0xFF;
+  }
+}
+
+// Storage totals across the library. raw_bytes is what the images would
+// take as plain columns; stored_bytes is their dictionaries plus runs.
+// With reply set, sends the report frame; otherwise only logs it.
+void sendStorageStats(bool reply) {
+  uint16_t count = 0;
+  uint32_t rawBytes = 0;
+  for (int i = 0; i < MAX_IMAGES; i++) {
+    if (!images[i].active) continue;
+    count++;
+    rawBytes += (uint32_t)images[i].width * sizeof(imageColumns[0]);
+  }
+  uint32_t liveColumns = imageColumnsUsed - imageColumnsStale;
+  uint32_t storedBytes = liveColumns * sizeof(imageColumns[0]) + (imageRunsUsed - imageRunsStale) * sizeof(ColumnRun);
+  uint32_t freeColumns = IMAGE_POOL_COLUMNS - liveColumns;
+
+  Serial.print("Image storage: ");
+  Serial.print(count);
+  Serial.print(" images, ");
+  Serial.print(rawBytes);
+  Serial.print(" bytes raw, ");
+  Serial.print(storedBytes);
+  Serial.print(" bytes stored");
+  if (storedBytes > 0) {
+    Serial.print(" (");
+    Serial.print((float)rawBytes / storedBytes, 2);
+    Serial.print("x)");
+  }
+  Serial.println();
+  if (!reply) return;
+
+  // Response frame (20 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xC1 count(2) raw_bytes(4) stored_bytes(4) pool_columns(4) free_columns(4) 0xFE
+  uint32_t values[4] = { rawBytes, storedBytes, IMAGE_POOL_COLUMNS, freeColumns };
+  replyPort->write(0xFF);
+  replyPort->write(0xC1);  // Storage report
+  replyPort->write((uint8_t)(count >> 8));
+  replyPort->write((uint8_t)(count & 0xFF));
+  for (uint8_t i = 0; i < 4; i++) {
+    replyPort->write((uint8_t)(values[i] >> 24));
+    replyPort->write((uint8_t)(values[i] >> 16));
+    replyPort->write((uint8_t)(values[i] >> 8));
+    replyPort->write((uint8_t)(values[i] & 0xFF));
+  }
+  replyPort->write(0xFE);
+}
+
+// ==================== IMAGE VARIANTS ====================
+
+// Area-weighted (box) resampling of a column-major image to fewer columns.
+// Each destination column averages the source columns it covers, weighted
+// by overlap, so fine detail fades out instead of aliasing. Both buffers use
+// a stride of IMAGE_HEIGHT pixels per column.
+void resampleColumns(const CRGB* src, uint16_t srcWidth, CRGB* dst, uint16_t dstWidth, uint16_t height) {
+  // Work in units where one source column is dstWidth wide and one
+  // destination column is srcWidth wide, so all overlaps are integers.
+  uint32_t acc[IMAGE_HEIGHT][3];
+  for (uint16_t d = 0; d < dstWidth; d++) {
+    memset(acc, 0, sizeof(acc));
+    uint32_t spanStart = (uint32_t)d * srcWidth;
+    uint32_t spanEnd = spanStart + srcWidth;
+    for (uint16_t s = spanStart / dstWidth; s < srcWidth && (uint32_t)s * dstWidth < spanEnd; s++) {
+      uint32_t colStart = max((uint32_t)s * dstWidth, spanStart);
+      uint32_t colEnd = min((uint32_t)(s + 1) * dstWidth, spanEnd);
+      uint32_t weight = colEnd - colStart;
+      const CRGB* srcCol = src + (uint32_t)s * IMAGE_HEIGHT;
+      for (uint16_t y = 0; y < height; y++) {
+        acc[y][0] += srcCol[y].r * weight;
+        acc[y][1] += srcCol[y].g * weight;
+        acc[y][2] += srcCol[y].b * weight;
+      }
+    }
+    CRGB* dstCol = dst + (uint32_t)d * IMAGE_HEIGHT;
+    uint32_t half = srcWidth / 2;  // Round to nearest
+    for (uint16_t y = 0; y < height; y++) {
+      dstCol[y] = CRGB((acc[y][0] + half) / srcWidth,
+                       (acc[y][1] + half) / srcWidth,
+                       (acc[y][2] + half) / srcWidth);
+    }
+  }
+}
+
+// Releases a slot's variants; the space is reused once compactVariantPool() runs
+void removeImageVariants(uint8_t slot) {
+  ImageVariantSet& set = imageVariants[slot];
+  for (uint8_t v = 0; v < set.count; v++) variantPoolStale += set.variants[v].width;
+  set.count = 0;
+}
+
+// Slides every slot's variants down over stale space, in pool order. Only
+// runs when a rebuild finds no room at the end of the pool.
+void compactVariantPool() {
+  uint32_t end = 0;
+  int32_t last = -1;
+  for (;;) {
+    int next = -1;
+    for (int i = 0; i < MAX_IMAGES; i++) {
+      const ImageVariantSet& set = imageVariants[i];
+      if (set.count == 0 || (int32_t)set.variants[0].offset <= last) continue;
+      if (next < 0 || set.variants[0].offset < imageVariants[next].variants[0].offset) next = i;
+    }
+    if (next < 0) break;
+    ImageVariantSet& set = imageVariants[next];
+    last = set.variants[0].offset;
+    for (uint8_t v = 0; v < set.count; v++) {
+      if (set.variants[v].offset != end) {
+        memmove(variantPool[end], variantPool[set.variants[v].offset],
+                set.variants[v].width * sizeof(variantPool[0]));
+        set.variants[v].offset = end;
+      }
+      end += set.variants[v].width;
+    }
+  }
+  variantPoolUsed = end;
+  variantPoolStale = 0;
+  displayImageSlot = 0xFF;  // Pool moved; re-select at the next column
+}
+
+// (Re)generate the narrower copies of an image after it was stored
+void buildImageVariants(uint8_t slot) {
+  if (slot >= MAX_IMAGES) return;
+  removeImageVariants(slot);
+  if (slot == displayImageSlot) displayImageSlot = 0xFF;
+
+  POVImage& img = images[slot];
+  if (!img.active) return;
+
+  expandImage(slot);
+  ImageVariantSet& set = imageVariants[slot];
+  uint32_t needed = 0;
+  for (uint16_t w = img.width / 2, n = 0; n < MAX_IMAGE_VARIANTS && w >= MIN_VARIANT_WIDTH; w /= 2, n++) {
+    needed += w;
+  }
+  if (variantPoolUsed + needed > VARIANT_POOL_COLUMNS && variantPoolStale > 0) compactVariantPool();
+  uint16_t width = img.width / 2;
+  while (set.count < MAX_IMAGE_VARIANTS && width >= MIN_VARIANT_WIDTH) {
+    if (variantPoolUsed + width > VARIANT_POOL_COLUMNS) {
+      Serial.println("Variant pool full, skipping narrower variants");
+      break;
+    }
+    ImageVariant& v = set.variants[set.count++];
+    v.offset = variantPoolUsed;
+    v.width = width;
+    variantPoolUsed += width;
+    resampleColumns(&imageStaging[0][0], img.width, variantPool[v.offset], width, min(img.height, (uint16_t)IMAGE_HEIGHT));
+    width /= 2;
+  }
+}
+
+// Column count that fills imageArcDeg at the configured column rate, or 0
+// when the spin rate is unknown (then the full-width image is shown).
+uint16_t preferredImageColumns() {
+  if (!rotation.source() || !rotation.isLocked(micros())) return 0;
+  uint32_t arcUs = rotation.periodUs() / 360 * imageArcDeg;
+  uint32_t targetColumnUs = max((uint32_t)(frameDelay * 1000UL), (uint32_t)MIN_COLUMN_PERIOD_US);
+  return (uint16_t)min(arcUs / targetColumnUs, (uint32_t)0xFFFF);
+}
+
+// Variant whose width is closest (by ratio) to the preferred column count
+int8_t selectImageVariant(uint8_t slot) {
+  uint16_t preferred = preferredImageColumns();
+  const ImageVariantSet& set = imageVariants[slot];
+  if (preferred == 0 || set.count == 0) return -1;
+
+  int8_t best = -1;
+  float bestRatio = max((float)images[slot].width / preferred, (float)preferred / images[slot].width);
+  for (uint8_t v = 0; v < set.count; v++) {
+    float w = set.variants[v].width;
+    float ratio = max(w / preferred, preferred / w);
+    if (ratio < bestRatio) {
+      bestRatio = ratio;
+      best = v;
+    }
+  }
+  return best;
+}
+
+// ==================== POWER MEASUREMENT ====================
+// A/B measurement of the current saved by column blanking or by the power
+// governor: the same content is rendered for one phase with the feature
+// bypassed (100% duty / full clock, no sleep) and one phase with it in
+// effect, and the INA219 readings of each phase are averaged.
+
+void startPowerMeasurement(uint8_t target) {
+  powerMeasureTarget = target;
+  if (!batteryPresent) {
+    dutyMeasureState = DUTY_MEASURE_NO_SENSOR;
+    Serial.println("Power measurement: INA219 not present");
+    return;
+  }
+  dutyMeasureState = DUTY_MEASURE_FULL;
+  dutyMeasurePhaseStart = millis();
+  dutyMeasureSumMa = 0;
+  dutyMeasureSamples = 0;
+  Serial.println(target == POWER_TARGET_GOVERNOR
+                 ? "Power measurement: sampling with governor bypassed"
+                 : "Power measurement: sampling at 100% duty");
+}
+
+void serviceDutyMeasurement() {
+  if (dutyMeasureState != DUTY_MEASURE_FULL && dutyMeasureState != DUTY_MEASURE_REDUCED) return;
+  if (millis() - lastPowerSample < POWER_SAMPLE_INTERVAL_MS) return;
+  lastPowerSample = millis();
+
+  uint32_t phaseElapsed = millis() - dutyMeasurePhaseStart;
+  if (phaseElapsed >= DUTY_MEASURE_SETTLE_MS) {
+    float currentMa = battery.getCurrent() * 1000.0f;
+    lastCurrentMa = (uint16_t)constrain(currentMa, 0.0f, 65535.0f);
+    dutyMeasureSumMa += currentMa;
+    dutyMeasureSamples++;
+  }
+  if (phaseElapsed < DUTY_MEASURE_PHASE_MS) return;
+
+  uint16_t avgMa = dutyMeasureSamples > 0
+    ? (uint16_t)constrain(dutyMeasureSumMa / dutyMeasureSamples, 0.0f, 65535.0f)
+    : 0;
+  dutyMeasureSumMa = 0;
+  dutyMeasureSamples = 0;
+  dutyMeasurePhaseStart = millis();
+
+  if (dutyMeasureState == DUTY_MEASURE_FULL) {
+    fullDutyCurrentMa = avgMa;
+    dutyMeasureState = DUTY_MEASURE_REDUCED;
+    return;
+  }
+
+  reducedDutyCurrentMa = avgMa;
+  dutyMeasureState = DUTY_MEASURE_DONE;
+  if (powerMeasureTarget == POWER_TARGET_GOVERNOR) {
+    Serial.print("Governor measurement: bypassed = ");
+    Serial.print(fullDutyCurrentMa);
+    Serial.print("mA, governed = ");
+  } else {
+    Serial.print("Duty measurement: 100% = ");
+    Serial.print(fullDutyCurrentMa);
+    Serial.print("mA, ");
+    Serial.print(columnDutyPercent);
+    Serial.print("% = ");
+  }
+  Serial.print(reducedDutyCurrentMa);
+  Serial.println("mA");
+}
+
+void sendPowerReport() {
+  // Response frame (12 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xBC duty state full_mA(2) duty_mA(2) last_mA(2) target 0xFE
+  // full_mA/duty_mA are the reference and measured phases; target says
+  // whether they compare duty (0) or the power governor (1).
+  replyPort->write(0xFF);
+  replyPort->write(0xBC);  // Power report
+  replyPort->write(columnDutyPercent);
+  replyPort->write(batteryPresent ? dutyMeasureState : (uint8_t)DUTY_MEASURE_NO_SENSOR);
+  replyPort->write((uint8_t)(fullDutyCurrentMa >> 8));
+  replyPort->write((uint8_t)(fullDutyCurrentMa & 0xFF));
+  replyPort->write((uint8_t)(reducedDutyCurrentMa >> 8));
+  replyPort->write((uint8_t)(reducedDutyCurrentMa & 0xFF));
+  replyPort->write((uint8_t)(lastCurrentMa >> 8));
+  replyPort->write((uint8_t)(lastCurrentMa & 0xFF));
+  replyPort->write(powerMeasureTarget);
+  replyPort->write(0xFE);
+}
+
+// ==================== POWER GOVERNOR ====================
+
+// Governor is bypassed while it is itself the reference phase of an A/B run
+bool governorActive() {
+  if (!governorEnabled) return false;
+  return !(dutyMeasureState == DUTY_MEASURE_FULL && powerMeasureTarget == POWER_TARGET_GOVERNOR);
+}
+
+// Work that must not be slowed: USB bulk transfers and SD streaming
+bool governorNeedsFullClock() {
+  if (usbPort.index > 0 || usbPort.bytesPerSec > 0) return true;
+  #ifdef SD_SUPPORT
+  if (liveRecState != LIVE_REC_IDLE || sdLoadStatus == SD_LOAD_BUSY ||
+      showLoadStatus == SD_LOAD_BUSY || sdWriteCount > 0) return true;
+  #endif
+  return false;
+}
+
+void setGovernorLevel(uint8_t level) {
+  if (level >= GOVERNOR_CLOCK_LEVELS || level == governorLevel) return;
+  #ifdef ARDUINO_TEENSY41
+  set_arm_clock(kGovernorClocksHz[level]);
+  #endif
+  governorLevel = level;
+}
+
+void noteRenderTime(uint32_t renderUs) {
+  if (renderUs > governorPeakRenderUs) governorPeakRenderUs = renderUs;
+  // Rendering is eating most of the column at this clock: restore it now
+  if (governorLevel != 0 &&
+      (uint64_t)renderUs * 100 > (uint64_t)activeColumnPeriodUs * GOVERNOR_PANIC_LOAD_PCT) {
+    setGovernorLevel(0);
+  }
+}
+
+void serviceGovernor() {
+  if (!governorActive() || governorNeedsFullClock()) {
+    setGovernorLevel(0);
+  }
+
+  uint32_t now = millis();
+  uint32_t windowMs = now - governorWindowStartMs;
+  if (windowMs < GOVERNOR_EVAL_MS) return;
+
+  uint32_t periodUs = max(activeColumnPeriodUs, (uint32_t)1);
+  governorLoadPct = (uint8_t)min((uint64_t)governorPeakRenderUs * 100 / periodUs, (uint64_t)255);
+  governorSleepPct = (uint8_t)min((uint64_t)governorSleptUs / 10 / windowMs, (uint64_t)100);
+
+  if (governorActive() && !governorNeedsFullClock()) {
+    uint8_t level = 0;
+    if (currentMode == 0 && stripDark) {
+      level = GOVERNOR_CLOCK_LEVELS - 1;
+    } else {
+      // Lowest clock at which the slowest render still fits the target load
+      for (uint8_t l = GOVERNOR_CLOCK_LEVELS - 1; l > 0; l--) {
+        uint64_t projectedUs = (uint64_t)governorPeakRenderUs *
+                               kGovernorClocksHz[governorLevel] / kGovernorClocksHz[l];
+        if (projectedUs * 100 <= (uint64_t)periodUs * GOVERNOR_TARGET_LOAD_PCT) {
+          level = l;
+          break;
+        }
+      }
+    }
+    setGovernorLevel(level);
+  }
+
+  governorWindowStartMs = now;
+  governorPeakRenderUs = 0;
+  governorSleptUs = 0;
+}
+
+#ifdef ARDUINO_TEENSY41
+void governorWake() {
+  governorWakeTimer.end();
+}
+#endif
+
+// Sleeps the core until the next scheduled column or blanking edge; any
+// interrupt (serial RX, USB, SysTick, hall sensor) wakes it earlier.
+void governorSleep() {
+  if (!governorActive()) return;
+  if (ESP32_SERIAL.available() || Serial.available()) return;
+  #ifdef SD_SUPPORT
+  if (liveRecState != LIVE_REC_IDLE || sdLoadStatus == SD_LOAD_BUSY ||
+      showLoadStatus == SD_LOAD_BUSY || sdWriteCount > 0) return;
+  #endif
+
+  uint32_t now = micros();
+  int32_t untilUs = INT32_MAX;
+  if (!(currentMode == 0 && stripDark)) {
+    untilUs = (int32_t)(lastColumnUs + activeColumnPeriodUs - now);
+  }
+  uint8_t duty = effectiveColumnDuty();
+  if (!columnBlanked && duty < 100) {
+    int32_t blankUs = (int32_t)(columnShownAtUs + activeColumnPeriodUs * duty / 100 - now);
+    if (blankUs < untilUs) untilUs = blankUs;
+  }
+  if (untilUs != INT32_MAX) {
+    untilUs -= GOVERNOR_WAKE_MARGIN_US;
+    if (untilUs < GOVERNOR_MIN_SLEEP_US) return;
+  }
+
+  #ifdef ARDUINO_TEENSY41
+  if (untilUs != INT32_MAX) governorWakeTimer.begin(governorWake, (unsigned int)untilUs);
+  asm volatile("wfi");
+  governorWakeTimer.end();
+  #endif
+  governorSleptUs += micros() - now;
+}
+
+void sendGovernorReport() {
+  // Response frame (10 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xC0 enabled active clock_mhz(2) load_pct sleep_pct strip_dark 0xFE
+  // load_pct is the slowest column render as a share of the column period
+  // over the last evaluation window, at the clock in effect then.
+  uint16_t clockMhz = (uint16_t)(kGovernorClocksHz[governorLevel] / 1000000);
+  replyPort->write(0xFF);
+  replyPort->write(0xC0);  // Governor report
+  replyPort->write(governorEnabled ? (uint8_t)1 : (uint8_t)0);
+  replyPort->write(governorActive() ? (uint8_t)1 : (uint8_t)0);
+  replyPort->write((uint8_t)(clockMhz >> 8));
+  replyPort->write((uint8_t)(clockMhz & 0xFF));
+  replyPort->write(governorLoadPct);
+  replyPort->write(governorSleepPct);
+  replyPort->write(stripDark ? (uint8_t)1 : (uint8_t)0);
+  replyPort->write(0xFE);
+}
+
+// ==================== ROTATION TRACKING ====================
+
+void setRotationSource(uint8_t type) {
+  RotationSource* source = nullptr;
+  switch (type) {
+    case ROTATION_SOURCE_HALL:
+      source = &hallSource;
+      break;
+    case ROTATION_SOURCE_GYRO:
+      source = &gyroSource;
+      break;
+    #ifdef SD_SUPPORT
+    case ROTATION_SOURCE_REPLAY:
+      if (replayFile) replayFile.close();
+      replayFile = sdInitialized ? SD.open(ROTATION_REPLAY_FILE, FILE_READ) : File();
+      if (replayFile) {
+        source = &replaySource;
+      } else {
+        Serial.print("Rotation replay file not found: ");
+        Serial.println(ROTATION_REPLAY_FILE);
+      }
+      break;
+    #endif
+    default:
+      break;
+  }
+
+  rotation.setSource(source);
+  activeColumnPeriodUs = currentColumnPeriodUs();
+
+  Serial.print("Rotation source: ");
+  Serial.print(source ? source->type() : (uint8_t)ROTATION_SOURCE_NONE);
+  Serial.print(", image arc: ");
+  Serial.print(imageArcDeg);
+  Serial.println(" deg");
+}
+
+void sendRotationReport() {
+  // Response frame (17 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xBD source locked rpm_x10(2) rpm_err_x10(2) column_period_us(4) arc_deg(2)
+  //   image_columns(2) 0xFE
+  // image_columns is the width of the image variant currently shown (0 = no image).
+  uint32_t nowUs = micros();
+  uint8_t source = rotation.source() ? rotation.source()->type() : (uint8_t)ROTATION_SOURCE_NONE;
+  bool locked = rotation.source() && rotation.isLocked(nowUs);
+  uint16_t rpmX10 = (uint16_t)constrain(rotation.rpm() * 10.0f, 0.0f, 65535.0f);
+  uint16_t errX10 = (uint16_t)constrain(rotation.rpmError() * 10.0f, 0.0f, 65535.0f);
+
+  replyPort->write(0xFF);
+  replyPort->write(0xBD);  // Rotation report
+  replyPort->write(source);
+  replyPort->write(locked ? (uint8_t)1 : (uint8_t)0);
+  replyPort->write((uint8_t)(rpmX10 >> 8));
+  replyPort->write((uint8_t)(rpmX10 & 0xFF));
+  replyPort->write((uint8_t)(errX10 >> 8));
+  replyPort->write((uint8_t)(errX10 & 0xFF));
+  for (int i = 3; i >= 0; i--) {
+    replyPort->write((uint8_t)((activeColumnPeriodUs >> (i * 8)) & 0xFF));
+  }
+  replyPort->write((uint8_t)(imageArcDeg >> 8));
+  replyPort->write((uint8_t)(imageArcDeg & 0xFF));
+  uint16_t imageColumns = activeImageWidth();
+  replyPort->write((uint8_t)(imageColumns >> 8));
+  replyPort->write((uint8_t)(imageColumns & 0xFF));
+  replyPort->write(0xFE);
+}
+
+void sendLinkStats() {
+  // Response frame (52 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xBF port_count(=2) then per port (ESP32, USB):
+  //   rx_bytes(4) frames(4) errors(4) bytes_per_sec(4) overruns(4) rx_peak(4)
+  //   0xFE
+  CommandPort* ports[2] = { &esp32Port, &usbPort };
+
+  replyPort->write(0xFF);
+  replyPort->write(0xBF);  // Link statistics
+  replyPort->write((uint8_t)2);
+  for (int p = 0; p < 2; p++) {
+    uint32_t values[6] = { ports[p]->rxBytes, ports[p]->frames,
+                           ports[p]->errors, ports[p]->bytesPerSec,
+                           ports[p]->overruns, ports[p]->rxPeak };
+    for (int v = 0; v < 6; v++) {
+      for (int i = 3; i >= 0; i--) {
+        replyPort->write((uint8_t)((values[v] >> (i * 8)) & 0xFF));
+      }
+    }
+  }
+  replyPort->write(0xFE);
+}
+
+void sendSlotMap() {
+  // Response frame (37 bytes total, fixed length - bits may contain 0xFE):
+  //   0xFF 0xCB slots(2) active(32: slot n is bit n%8 of byte n/8) 0xFE
+  // The ESP32 uses it to send stored images back only to slots a restart
+  // emptied.
+  uint8_t bits[32] = {0};
+  for (int i = 0; i < MAX_IMAGES && i < 256; i++) {
+    if (images[i].active) bits[i / 8] |= 1 << (i % 8);
+  }
+  replyPort->write(0xFF);
+  replyPort->write(0xCB);  // Slot map
+  replyPort->write((uint8_t)(MAX_IMAGES >> 8));
+  replyPort->write((uint8_t)(MAX_IMAGES & 0xFF));
+  replyPort->write(bits, sizeof(bits));
+  replyPort->write(0xFE);
+}
+
+void sendCapabilities() {
+  // Response frame (23 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xC2 version max_images(2) free_slots(2) max_width(2) max_height(2)
+  //   psram_mb encodings sd_present max_frame(4) free_columns(4) 0xFE
+  // max_height is the number of rows stored; taller uploads are truncated.
+  uint16_t freeSlots = 0;
+  for (int i = 0; i < MAX_IMAGES; i++) {
+    if (!images[i].active) freeSlots++;
+  }
+  uint8_t psramMb = 0;
+  #ifdef ARDUINO_TEENSY41
+  psramMb = (uint8_t)external_psram_size;
+  #endif
+  uint8_t sdPresent = 0;
+  #ifdef SD_SUPPORT
+  sdPresent = sdInitialized ? 1 : 0;
+  #endif
+  uint16_t words[4] = { MAX_IMAGES, freeSlots, IMAGE_MAX_WIDTH, IMAGE_HEIGHT };
+  uint32_t longs[2] = { CMD_BUFFER_SIZE, IMAGE_POOL_COLUMNS - (imageColumnsUsed - imageColumnsStale) };
+
+  replyPort->write(0xFF);
+  replyPort->write(0xC2);  // Capabilities
+  replyPort->write((uint8_t)PROTOCOL_VERSION);
+  for (int i = 0; i < 4; i++) {
+    replyPort->write((uint8_t)(words[i] >> 8));
+    replyPort->write((uint8_t)(words[i] & 0xFF));
+  }
+  replyPort->write(psramMb);
+  replyPort->write((uint8_t)SUPPORTED_ENCODINGS);
+  replyPort->write(sdPresent);
+  for (int i = 0; i < 2; i++) {
+    for (int b = 3; b >= 0; b--) {
+      replyPort->write((uint8_t)((longs[i] >> (b * 8)) & 0xFF));
+    }
+  }
+  replyPort->write(0xFE);
+}
+
+// Copies up to maxLen bytes of a slot's .pov form, starting at offset, into
+// readbackChunk. Columns are read straight from the dictionary by walking
+// the runs, so the image is never expanded.
+uint16_t readSlotBytes(uint8_t slot, uint32_t offset, uint16_t maxLen) {
+  const POVImage& img = images[slot];
+  uint32_t columnBytes = (uint32_t)img.height * 3;
+  uint32_t total = 4 + img.width * columnBytes;
+  if (offset >= total) return 0;
+  uint16_t len = (uint16_t)min((uint32_t)maxLen, total - offset);
+
+  uint8_t header[4] = { (uint8_t)(img.width & 0xFF), (uint8_t)(img.width >> 8),
+                        (uint8_t)(img.height & 0xFF), (uint8_t)(img.height >> 8) };
+  uint16_t n = 0;
+  while (n < len && offset + n < 4) {
+    readbackChunk[n] = header[offset + n];
+    n++;
+  }
+  if (n == len) return n;
+
+  // Find the run holding the first column wanted
+  uint32_t pos = offset + n - 4;
+  uint32_t x = pos / columnBytes;
+  uint32_t within = pos % columnBytes;
+  uint16_t r = 0;
+  uint32_t runStart = 0;
+  while (r < img.runCount && runStart + imageRuns[img.runOffset + r].count <= x) {
+    runStart += imageRuns[img.runOffset + r].count;
+    r++;
+  }
+
+  while (n < len && r < img.runCount) {
+    const ColumnRun& run = imageRuns[img.runOffset + r];
+    const uint8_t* column = (const uint8_t*)imageColumns[img.columnOffset + run.column];
+    uint32_t take = min((uint32_t)(len - n), columnBytes - within);
+    memcpy(&readbackChunk[n], column + within, take);
+    n += take;
+    within = 0;
+    if (++x >= runStart + run.count) {
+      runStart += run.count;
+      r++;
+    }
+  }
+  return n;
+}
+
+void sendReadbackChunk() {
+  // Request:  0xFF 0x18 len source offset(4) max_len(2) id 0xFE
+  //           id = slot (source 0) or name_len name (source 1, SD file)
+  // Response: 0xFF 0xC3 status total(4) offset(4) len(2) [len bytes] 0xFE
+  // The payload is binary; the requester reads len bytes, not up to 0xFE.
+  uint8_t dataLen = cmdBuffer[2];
+  uint8_t status = READBACK_NOT_FOUND;
+  uint32_t total = 0;
+  uint32_t offset = 0;
+  uint16_t len = 0;
+
+  if (dataLen >= 8) {
+    uint8_t source = cmdBuffer[3];
+    offset = ((uint32_t)cmdBuffer[4] << 24) | ((uint32_t)cmdBuffer[5] << 16) |
+             ((uint32_t)cmdBuffer[6] << 8) | cmdBuffer[7];
+    uint16_t maxLen = ((uint16_t)cmdBuffer[8] << 8) | cmdBuffer[9];
+    if (maxLen > READBACK_CHUNK_MAX) maxLen = READBACK_CHUNK_MAX;
+
+    if (source == READBACK_SOURCE_SLOT) {
+      uint8_t slot = cmdBuffer[10];
+      if (slot < MAX_IMAGES && images[slot].active) {
+        total = 4 + (uint32_t)images[slot].width * images[slot].height * 3;
+        status = READBACK_OK;
+        len = readSlotBytes(slot, offset, maxLen);
+      }
+    }
+    #ifdef SD_SUPPORT
+    else if (source == READBACK_SOURCE_FILE && sdInitialized) {
+      uint8_t nameLen = cmdBuffer[10];
+      if (nameLen > 0 && nameLen <= MAX_FILENAME_LEN && 8 + nameLen <= dataLen) {
+        char filename[MAX_FILENAME_LEN + 1];
+        memcpy(filename, &cmdBuffer[11], nameLen);
+        filename[nameLen] = '\0';
+        char filepath[MAX_FILEPATH_LEN];
+        snprintf(filepath, sizeof(filepath), "%s/%s.pov", SD_IMAGE_DIR, filename);
+
+        File file = SD.open(filepath, FILE_READ);
+        if (file) {
+          total = file.size();
+          status = READBACK_OK;
+          if (offset < total && file.seek(offset)) {
+            int got = file.read(readbackChunk, min((uint32_t)maxLen, total - offset));
+            len = got > 0 ? got : 0;
+          }
+          file.close();
+        }
+      }
+    }
+    #endif
+
+    if (status == READBACK_OK && offset > total) status = READBACK_BAD_OFFSET;
+  }
+
+  uint32_t header[2] = { total, offset };
+  replyPort->write(0xFF);
+  replyPort->write(0xC3);  // Read-back chunk
+  replyPort->write(status);
+  for (int i = 0; i < 2; i++) {
+    for (int b = 3; b >= 0; b--) {
+      replyPort->write((uint8_t)((header[i] >> (b * 8)) & 0xFF));
+    }
+  }
+  replyPort->write((uint8_t)(len >> 8));
+  replyPort->write((uint8_t)(len & 0xFF));
+  replyPort->write(readbackChunk, len);
+  replyPort->write(0xFE);
+}
+
+// ==================== SD CARD FUNCTIONS ====================
+#ifdef SD_SUPPORT
+
+void initSDCard() {
+  Serial.print("Initializing SD card...");
+  
+  if (!SD.begin(BUILTIN_SDCARD)) {
+    Serial.println("Failed!");
+    Serial.println("Check that SD card is inserted");
+    sdInitialized = false;
+    return;
+  }
+  
+  Serial.println("OK");
+  sdInitialized = true;
+  
+  // Create image directory if it doesn't exist
+  if (!SD.exists(SD_IMAGE_DIR)) {
+    Serial.print("Creating directory: ");
+    Serial.println(SD_IMAGE_DIR);
+    SD.mkdir(SD_IMAGE_DIR);
+  }
+  
+  Serial.println("SD Card: Ready");
+}
+
+void saveImageToSD() {
+  // Protocol: 0xFF 0x20 len filename_len [filename] img_index [format] 0xFE
+  // Snapshots the slot as a .pov file into the SD writer queue; the file
+  // itself is written in the background (see serviceSdWriter()). format 2
+  // (default) writes the compressed v2 layout, 1 the raw v1 layout.
   
   uint8_t filenameLen = cmdBuffer[3];
   if (filenameLen == 0 || filenameLen > MAX_FILENAME_LEN) {
+    Serial.println("Invalid filename length");
+    sendAck(0x20);
+    return;
+  }
+  
+  // Extract filename
+  char filename[MAX_FILENAME_LEN + 1];
+  memcpy(filename, &cmdBuffer[4], filenameLen);
+  filename[filenameLen] = '\0';
+  
+  // Get image index
+  uint8_t imgIndex = cmdBuffer[4 + filenameLen];
+  uint8_t format = cmdBuffer[2] >= 3 + filenameLen ? cmdBuffer[5 + filenameLen] : 2;
+  
+  if (imgIndex >= MAX_IMAGES || !images[imgIndex].active) {
+    Serial.println("Invalid image index");
+    sendAck(0x20);
+    return;
+  }
+  
+  // Build full path
+  char filepath[MAX_FILEPATH_LEN];
+  snprintf(filepath, sizeof(filepath), "%s/%s.pov", SD_IMAGE_DIR, filename);
+  
+  uint8_t* data = sdWriterReserve();
+  if (!data) {
+    sendAck(0x20);
+    return;
+  }
+
+  uint32_t length = format == 1 ? snapshotSlotPov1(imgIndex, data) : encodeSlotPov2(imgIndex, data);
+  sdWriterQueue(filepath, length);
+
+  Serial.print("Queued image save: ");
+  Serial.print(filepath);
+  Serial.print(" (v");
+  Serial.print(format == 1 ? 1 : 2);
+  Serial.print(", ");
+  Serial.print(length);
+  Serial.println(" bytes)");
+  sendAck(0x20);
+}
+
+// Same layout as a read-back: width, height (16-bit LE), RGB column by column
+uint32_t snapshotSlotPov1(uint8_t slot, uint8_t* out) {
+  const POVImage& img = images[slot];
+  uint32_t length = 4 + (uint32_t)img.width * img.height * 3;
+  for (uint32_t offset = 0; offset < length; ) {
+    uint16_t n = readSlotBytes(slot, offset, READBACK_CHUNK_MAX);
+    if (n == 0) break;
+    memcpy(&out[offset], readbackChunk, n);
+    offset += n;
+  }
+  return length;
+}
+
+// Encodes a slot as a .pov v2 file; returns its length. If QOI does not
+// come out smaller than the raw columns, the file is written raw instead
+// (the same rule as encode_pov_v2() in examples/image_converter.py).
+uint32_t encodeSlotPov2(uint8_t slot, uint8_t* out) {
+  static uint8_t columns[POV2_BLOCK_COLUMNS * IMAGE_HEIGHT * 3];
+  const POVImage& img = images[slot];
+  Pov2Header h = { POV2_CODEC_QOI, img.width, img.height, POV2_BLOCK_COLUMNS, 0, 0 };
+  uint16_t blocks = pov2BlockCount(h);
+  uint32_t columnBytes = (uint32_t)img.height * 3;
+  uint32_t rawBytes = (uint32_t)img.width * columnBytes;
+  uint8_t* table = out + POV2_HEADER_BYTES;
+  uint8_t* data = table + blocks * 4;
+
+  for (uint8_t codec = POV2_CODEC_QOI; ; codec = POV2_CODEC_RAW) {
+    h.codec = codec;
+    h.dataBytes = 0;
+    h.crc = 0;
+    bool fits = true;
+    for (uint16_t b = 0; b < blocks && fits; b++) {
+      // The slot's v1 bytes for this block, column by column
+      uint16_t first = b * POV2_BLOCK_COLUMNS;
+      uint16_t count = min((uint16_t)POV2_BLOCK_COLUMNS, (uint16_t)(img.width - first));
+      uint32_t blockBytes = count * columnBytes;
+      for (uint32_t got = 0; got < blockBytes; ) {
+        uint16_t n = readSlotBytes(slot, 4 + first * columnBytes + got,
+                                   min((uint32_t)READBACK_CHUNK_MAX, blockBytes - got));
+        if (n == 0) break;
+        memcpy(&columns[got], readbackChunk, n);
+        got += n;
+      }
+      h.crc = pov2Crc32(h.crc, columns, blockBytes);
+
+      pov2WriteLE32(&table[b * 4], h.dataBytes);
+      if (codec == POV2_CODEC_QOI) {
+        // At most rawBytes - 1 in total, so QOI is kept only when smaller
+        size_t n = pov2EncodeBlock(columns, columnBytes, count, img.height,
+                                   &data[h.dataBytes], rawBytes - 1 - h.dataBytes);
+        fits = n > 0;
+        h.dataBytes += n;
+      } else {
+        memcpy(&data[h.dataBytes], columns, blockBytes);
+        h.dataBytes += blockBytes;
+      }
+    }
+    if (fits || codec == POV2_CODEC_RAW) break;
+  }
+
+  pov2WriteHeader(out, h);
+  return POV2_HEADER_BYTES + blocks * 4 + h.dataBytes;
+}
+
+// Reads a .pov header - v1, or v2 with its block table - leaving the file
+// at the first data byte. Dimension limits are up to the caller.
+bool readPovHeader(File& file, Pov2Header& h, uint8_t& format, uint32_t* blockOffsets, uint16_t maxBlocks) {
+  uint8_t header[POV2_HEADER_BYTES];
+  if (file.read(header, 4) != 4) return false;
+  if (pov2ReadLE32(header) != POV2_MAGIC) {
+    format = 1;
+    h.codec = POV2_CODEC_RAW;
+    h.width = header[0] | (header[1] << 8);
+    h.height = header[2] | (header[3] << 8);
+    h.blockColumns = h.width;
+    h.dataBytes = (uint32_t)h.width * h.height * 3;
+    h.crc = 0;
+    return true;
+  }
+
+  format = 2;
+  if (file.read(&header[4], POV2_HEADER_BYTES - 4) != POV2_HEADER_BYTES - 4 ||
+      !pov2ParseHeader(header, h) || h.width == 0 || h.height == 0) {
+    return false;
+  }
+  uint16_t blocks = pov2BlockCount(h);
+  if (blocks > maxBlocks || pov2MaxEncodedBytes((uint32_t)h.blockColumns * h.height) > POV2_BLOCK_BUFFER) {
+    return false;
+  }
+  // Offsets count from the first data byte, right after the table, so the
+  // first block starts at 0 and the rest never go backwards
+  uint32_t last = 0;
+  for (uint16_t b = 0; b < blocks; b++) {
+    uint8_t entry[4];
+    if (file.read(entry, 4) != 4) return false;
+    blockOffsets[b] = pov2ReadLE32(entry);
+    if ((b == 0 && blockOffsets[b] != 0) || blockOffsets[b] < last || blockOffsets[b] > h.dataBytes) {
+      return false;
+    }
+    last = blockOffsets[b];
+  }
+  return true;
+}
+
+// Fills `count` columns (at `stride` bytes apart) from one block of a v2
+// file already read into povBlockBuffer
+bool decodePovBlock(const Pov2Header& h, uint32_t len, uint8_t* columns, size_t stride, uint16_t count) {
+  if (h.codec == POV2_CODEC_QOI) {
+    return pov2DecodeBlock(povBlockBuffer, len, columns, stride, count, h.height);
+  }
+  uint32_t columnBytes = (uint32_t)h.height * 3;
+  if (len != count * columnBytes) return false;
+  for (uint16_t c = 0; c < count; c++) {
+    memcpy(columns + c * stride, &povBlockBuffer[c * columnBytes], columnBytes);
+  }
+  return true;
+}
+
+// Returns the data buffer of the next free writer job, or nullptr if the
+// queue is full. The job is only started by sdWriterQueue().
+uint8_t* sdWriterReserve() {
+  if (!sdInitialized || sdWriteCount >= SD_WRITE_QUEUE) {
+    Serial.println("SD writer: queue full or no card, save dropped");
+    sdWriteFailed++;
+    return nullptr;
+  }
+  return sdWriteData[(sdWriteHead + sdWriteCount) % SD_WRITE_QUEUE];
+}
+
+void sdWriterQueue(const char* path, uint32_t length) {
+  SdWriteJob& job = sdWriteJobs[(sdWriteHead + sdWriteCount) % SD_WRITE_QUEUE];
+  strncpy(job.path, path, sizeof(job.path) - 1);
+  job.path[sizeof(job.path) - 1] = '\0';
+  job.length = length;
+  job.written = 0;
+  job.step = SD_WRITE_PREPARE;
+  if (sdWriteCount == 0) sdWriteLastStepMs = millis();
+  sdWriteCount++;
+}
+
+// Runs one step of the oldest job. Returns false on an SD error.
+bool sdWriterStep(SdWriteJob& job, const uint8_t* data) {
+  switch (job.step) {
+    case SD_WRITE_PREPARE: {
+      char dir[MAX_FILEPATH_LEN];
+      strncpy(dir, job.path, sizeof(dir));
+      char* slash = strrchr(dir, '/');
+      if (slash && slash != dir) {
+        *slash = '\0';
+        if (!SD.exists(dir) && !SD.mkdir(dir)) return false;
+      }
+      job.step = SD_WRITE_OPEN;
+      return true;
+    }
+    case SD_WRITE_OPEN:
+      // The page cache may hold the file open; drop it before truncating
+      sdCacheForget(job.path);
+      sdWriteFile = SD.sdfs.open(job.path, O_WRONLY | O_CREAT | O_TRUNC);
+      if (!sdWriteFile) return false;
+      // Contiguous clusters: data steps then never touch the FAT. Without
+      // them (a fragmented card) the save still works, with slower steps.
+      if (!sdWriteFile.preAllocate(job.length)) {
+        Serial.print("SD writer: no contiguous space for ");
+        Serial.println(job.path);
+      }
+      job.step = SD_WRITE_DATA;
+      return true;
+    case SD_WRITE_DATA: {
+      uint32_t len = min((uint32_t)SD_WRITE_SECTOR, job.length - job.written);
+      if (sdWriteFile.write(&data[job.written], len) != len) return false;
+      job.written += len;
+      sdWriteBytes += len;
+      if (job.written >= job.length) job.step = SD_WRITE_CLOSE;
+      return true;
+    }
+    case SD_WRITE_CLOSE:
+    default:
+      // Both write to the card (preallocation trimmed, directory entry
+      // updated); a failure leaves a preallocated, partly written file
+      if (!sdWriteFile.truncate(job.length)) return false;
+      return sdWriteFile.close();
+  }
+}
+
+void serviceSdWriter() {
+  if (sdWriteCount == 0) return;
+
+  // Nothing on the strip to delay in idle mode or during a live replay gap
+  uint32_t startUs = micros();
+  uint32_t dueUs = lastColumnUs + activeColumnPeriodUs;
+  int32_t slackUs = (int32_t)(dueUs - startUs);
+  bool columnsRunning = !(currentMode == 0 && stripDark) && !liveReplayActive();
+  SdWriteJob& job = sdWriteJobs[sdWriteHead];
+  uint8_t kind = min(job.step, (uint8_t)SD_WRITE_CLOSE);
+  bool forced = false;
+  if (columnsRunning && slackUs < (int32_t)(sdWriteEstimateUs[kind] + SD_WRITE_GUARD_US)) {
+    if (millis() - sdWriteLastStepMs < SD_WRITE_MAX_DEFER_MS) {
+      sdWriteDeferrals++;
+      return;
+    }
+    // This kind of step no longer fits a column period (usually an open or
+    // close on a slow card); run it anyway so the save finishes
+    forced = true;
+  }
+
+  bool closing = job.step == SD_WRITE_CLOSE;
+  bool ok = sdWriterStep(job, sdWriteData[sdWriteHead]);
+  uint32_t tookUs = micros() - startUs;
+
+  // Latency histogram and decaying worst-step estimate for this kind
+  sdWriteSteps++;
+  if (tookUs > sdWriteMaxUs) sdWriteMaxUs = tookUs;
+  sdWriteHist[min(tookUs / SD_WRITE_HIST_US, (uint32_t)SD_WRITE_HIST_BUCKETS - 1)]++;
+  // A forced step means the estimate kept every step of its kind waiting;
+  // let it fall faster so one slow outlier does not stall the rest
+  uint32_t decayed = sdWriteEstimateUs[kind] - sdWriteEstimateUs[kind] / (forced ? 2 : 8);
+  sdWriteEstimateUs[kind] = max(tookUs, decayed);
+  sdWriteLastStepMs = millis();
+  if (columnsRunning && slackUs >= 0 && (int32_t)(micros() - dueUs) > 0) {
+    sdWriteDelayedColumns++;
+  }
+
+  if (!ok) {
+    Serial.print("SD writer: failed writing ");
+    Serial.println(job.path);
+    sdWriteFile.close();
+    sdWriteFailed++;
+  } else if (closing) {
+    sdWriteDone++;
+  } else {
+    return;
+  }
+  sdWriteHead = (sdWriteHead + 1) % SD_WRITE_QUEUE;
+  sdWriteCount--;
+}
+
+// Upper bound of the histogram bucket holding the given percentile
+uint32_t sdWriterPercentileUs(uint8_t percent) {
+  if (sdWriteSteps == 0) return 0;
+  uint64_t target = ((uint64_t)sdWriteSteps * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (int b = 0; b < SD_WRITE_HIST_BUCKETS - 1; b++) {
+    seen += sdWriteHist[b];
+    if (seen >= target) return (b + 1) * SD_WRITE_HIST_US;
+  }
+  return sdWriteMaxUs;
+}
+
+void sendSdWriterReport() {
+  // Response frame (43 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xC5 queued done(4) failed(4) bytes(4) steps(4) p50_us(4) p90_us(4)
+  //   p99_us(4) max_us(4) delayed_columns(4) deferrals(4) 0xFE
+  uint32_t values[10] = {
+    sdWriteDone, sdWriteFailed, sdWriteBytes, sdWriteSteps,
+    sdWriterPercentileUs(50), sdWriterPercentileUs(90), sdWriterPercentileUs(99),
+    sdWriteMaxUs, sdWriteDelayedColumns, sdWriteDeferrals
+  };
+  replyPort->write(0xFF);
+  replyPort->write(0xC5);  // SD writer report
+  replyPort->write(sdWriteCount);
+  for (int i = 0; i < 10; i++) {
+    for (int b = 3; b >= 0; b--) {
+      replyPort->write((uint8_t)((values[i] >> (b * 8)) & 0xFF));
+    }
+  }
+  replyPort->write(0xFE);
+}
+
+void loadImageFromSD() {
+  // Protocol: 0xFF 0x24 dataLen [filenameLen] [filename] [imgIndex] [show] 0xFE
+  // Starts a background load into the slot (see serviceSdLoad()). The ACK
+  // only means the request was taken; the result comes as an 0xC4 event.
+  // show (optional) switches to the slot as soon as it is committed. A new
+  // request replaces one still running.
+  sdLoadPort = replyPort;
+  sdLoadStartUs = micros();
+  sdLoadReadUs = sdLoadCommitUs = sdLoadDecodeUs = 0;
+  sdLoadPasses = 0;
+  sdLoadColumn = 0;
+  sdLoadBlock = 0;
+  sdLoadCrc = 0;
+  sdLoadWidth = sdLoadHeight = 0;
+  sdLoadFileBytes = 0;
+  if (sdLoadStatus == SD_LOAD_BUSY) {
+    sdLoadFile.close();
+  }
+
+  uint8_t filenameLen = cmdBuffer[3];
+  if (filenameLen == 0 || filenameLen > MAX_FILENAME_LEN || cmdBuffer[2] < 2 + filenameLen) {
     Serial.println("Invalid filename length");
     sendAck(0x24);
+    finishSdLoad(SD_LOAD_NOT_FOUND);
+    return;
+  }
+  
+  // Extract filename from cmdBuffer[4] onwards
+  char filename[MAX_FILENAME_LEN + 1];
+  memcpy(filename, &cmdBuffer[4], filenameLen);
+  filename[filenameLen] = '\0';
+  
+  // Image slot and show flag follow filename
+  sdLoadSlot = cmdBuffer[4 + filenameLen];
+  sdLoadShow = cmdBuffer[2] >= 3 + filenameLen && cmdBuffer[5 + filenameLen] != 0;
+  sendAck(0x24);
+  if (sdLoadSlot >= MAX_IMAGES) {
+    Serial.println("Invalid image index");
+    finishSdLoad(SD_LOAD_NOT_FOUND);
+    return;
+  }
+  
+  // Build full path
+  char filepath[MAX_FILEPATH_LEN];
+  snprintf(filepath, sizeof(filepath), "%s/%s.pov", SD_IMAGE_DIR, filename);
+  
+  Serial.print("Loading image from: ");
+  Serial.println(filepath);
+  
+  sdLoadFile = SD.open(filepath, FILE_READ);
+  if (!sdLoadFile) {
+    Serial.println("Failed to open file");
+    finishSdLoad(SD_LOAD_NOT_FOUND);
+    return;
+  }
+  
+  // v1: width, height (16-bit LE); v2: versioned header and block table
+  sdLoadFileBytes = sdLoadFile.size();
+  if (!readPovHeader(sdLoadFile, sdLoadPov2, sdLoadFormat, sdLoadBlockOffsets, POV2_MAX_BLOCKS)) {
+    Serial.println("Bad .pov header");
+    sdLoadFile.close();
+    finishSdLoad(SD_LOAD_BAD_FILE);
+    return;
+  }
+  sdLoadWidth = sdLoadPov2.width;
+  sdLoadHeight = sdLoadPov2.height;
+  
+  if (sdLoadWidth == 0 || sdLoadWidth > IMAGE_MAX_WIDTH ||
+      sdLoadHeight == 0 || sdLoadHeight > IMAGE_HEIGHT) {
+    Serial.println("Image dimensions too large");
+    sdLoadFile.close();
+    finishSdLoad(SD_LOAD_BAD_FILE);
+    return;
+  }
+  sdLoadStatus = SD_LOAD_BUSY;
+}
+
+// Reads the next chunk of a background load; once the file is in, commits
+// it to the slot between two columns.
+void serviceSdLoad() {
+  if (sdLoadStatus != SD_LOAD_BUSY) return;
+
+  sdLoadPasses++;
+  if (!(sdLoadFormat == 2 ? readSdLoadBlocks() : readSdLoadColumns())) {
+    Serial.println("SD load: file truncated or corrupt");
+    sdLoadFile.close();
+    finishSdLoad(SD_LOAD_BAD_FILE);
+    return;
+  }
+  if (sdLoadColumn < sdLoadWidth) return;
+  sdLoadFile.close();
+  sdLoadReadUs = micros() - sdLoadStartUs;
+  if (sdLoadFormat == 2 && sdLoadCrc != sdLoadPov2.crc) {
+    Serial.println("SD load: checksum mismatch");
+    finishSdLoad(SD_LOAD_BAD_FILE);
+    return;
+  }
+
+  // The slot's previous content played until this point
+  uint32_t commitStart = micros();
+  memcpy(imageStaging, sdLoadStaging, sizeof(imageStaging[0]) * sdLoadWidth);
+  bool ok = commitImage(sdLoadSlot, sdLoadWidth, sdLoadHeight);
+  sdLoadCommitUs = micros() - commitStart;
+  if (ok && sdLoadShow) {
+    setDisplayMode(1, sdLoadSlot);
+  }
+  finishSdLoad(ok ? SD_LOAD_DONE : SD_LOAD_NO_SPACE);
+}
+
+// v1: raw columns, up to SD_LOAD_CHUNK_BYTES per pass
+bool readSdLoadColumns() {
+  uint32_t columnBytes = (uint32_t)sdLoadHeight * 3;
+  uint32_t columns = max((uint32_t)1, SD_LOAD_CHUNK_BYTES / columnBytes);
+  for (uint32_t i = 0; i < columns && sdLoadColumn < sdLoadWidth; i++, sdLoadColumn++) {
+    // Columns are stored top to bottom as RGB, the same layout as CRGB
+    if (sdLoadFile.read((uint8_t*)sdLoadStaging[sdLoadColumn], columnBytes) != (int)columnBytes) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// v2: whole blocks, decoded straight into the staging columns, until
+// SD_LOAD_CHUNK_BYTES of encoded data have been read this pass
+bool readSdLoadBlocks() {
+  uint16_t blocks = pov2BlockCount(sdLoadPov2);
+  uint32_t columnBytes = (uint32_t)sdLoadHeight * 3;
+  uint32_t budget = SD_LOAD_CHUNK_BYTES;
+  while (budget > 0 && sdLoadBlock < blocks) {
+    uint32_t end = sdLoadBlock + 1 < blocks ? sdLoadBlockOffsets[sdLoadBlock + 1] : sdLoadPov2.dataBytes;
+    uint32_t len = end - sdLoadBlockOffsets[sdLoadBlock];
+    if (len > POV2_BLOCK_BUFFER || sdLoadFile.read(povBlockBuffer, len) != (int)len) return false;
+
+    uint32_t decodeStart = micros();
+    uint16_t first = sdLoadBlock * sdLoadPov2.blockColumns;
+    uint16_t count = min(sdLoadPov2.blockColumns, (uint16_t)(sdLoadWidth - first));
+    if (!decodePovBlock(sdLoadPov2, len, (uint8_t*)sdLoadStaging[first], sizeof(sdLoadStaging[0]), count)) {
+      return false;
+    }
+    for (uint16_t c = 0; c < count; c++) {
+      sdLoadCrc = pov2Crc32(sdLoadCrc, (const uint8_t*)sdLoadStaging[first + c], columnBytes);
+    }
+    sdLoadDecodeUs += micros() - decodeStart;
+
+    sdLoadBlock++;
+    sdLoadColumn = first + count;
+    budget -= min(budget, len);
+  }
+  return true;
+}
+
+void finishSdLoad(uint8_t status) {
+  sdLoadStatus = status;
+  sdLoadTotalUs = micros() - sdLoadStartUs;
+  Serial.print("SD load: status ");
+  Serial.print(status);
+  Serial.print(", ");
+  Serial.print(sdLoadWidth);
+  Serial.print("x");
+  Serial.print(sdLoadHeight);
+  Serial.print(" v");
+  Serial.print(sdLoadFormat);
+  Serial.print(" in ");
+  Serial.print(sdLoadTotalUs);
+  Serial.print(" us (decode ");
+  Serial.print(sdLoadDecodeUs);
+  Serial.print(" us, ");
+  Serial.print(sdLoadPasses);
+  Serial.println(" passes)");
+  if (sdLoadPort) sendSdLoadEvent(sdLoadPort);
+}
+
+void sendSdLoadEvent(Stream* port) {
+  // Event frame (33 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xC4 status slot shown width(2) height(2) read_us(4) commit_us(4)
+  //   total_us(4) passes(2) format decode_us(4) file_bytes(4) 0xFE
+  uint32_t longs[3] = { sdLoadReadUs, sdLoadCommitUs, sdLoadTotalUs };
+  port->write(0xFF);
+  port->write(0xC4);  // SD load event
+  port->write(sdLoadStatus);
+  port->write(sdLoadSlot);
+  port->write((uint8_t)(sdLoadStatus == SD_LOAD_DONE && sdLoadShow ? 1 : 0));
+  port->write((uint8_t)(sdLoadWidth >> 8));
+  port->write((uint8_t)(sdLoadWidth & 0xFF));
+  port->write((uint8_t)(sdLoadHeight >> 8));
+  port->write((uint8_t)(sdLoadHeight & 0xFF));
+  for (int i = 0; i < 3; i++) {
+    for (int b = 3; b >= 0; b--) {
+      port->write((uint8_t)((longs[i] >> (b * 8)) & 0xFF));
+    }
+  }
+  port->write((uint8_t)(sdLoadPasses >> 8));
+  port->write((uint8_t)(sdLoadPasses & 0xFF));
+  port->write(sdLoadFormat);
+  uint32_t tail[2] = { sdLoadDecodeUs, sdLoadFileBytes };
+  for (int i = 0; i < 2; i++) {
+    for (int b = 3; b >= 0; b--) {
+      port->write((uint8_t)((tail[i] >> (b * 8)) & 0xFF));
+    }
+  }
+  port->write(0xFE);
+}
+
+void handleShowCommand() {
+  // Protocol: 0xFF 0x28 len [op] ... 0xFE
+  //   op 1: load   name_len name   (ACK, then an 0xC6 event when done)
+  //   op 2: report                 (repeat the last 0xC6 event)
+  uint8_t op = cmdBuffer[2] >= 1 ? cmdBuffer[3] : 0;
+  if (op == 0x02) {
+    sendShowLoadEvent(replyPort);
+    return;
+  }
+  if (op != 0x01) {
+    sendAck(0x28);
+    return;
+  }
+
+  sendAck(0x28);
+  if (showLoadStatus == SD_LOAD_BUSY) {
+    Serial.println("Show load: already loading");
+    return;
+  }
+  showLoadPort = replyPort;
+  showLoadStartUs = micros();
+  showAssetCount = showAssetsDone = showImagesDone = 0;
+  showLoadPasses = 0;
+  showFilePos = 0;
+  showLoadReadUs = showLoadApplyUs = 0;
+  showImageWidth = showImageHeight = showImageColumn = 0;
+
+  uint8_t nameLen = cmdBuffer[2] >= 2 ? cmdBuffer[4] : 0;
+  if (!sdInitialized || nameLen == 0 || nameLen > MAX_FILENAME_LEN || cmdBuffer[2] < 2 + nameLen) {
+    finishShowLoad(SD_LOAD_NOT_FOUND);
+    return;
+  }
+  char name[MAX_FILENAME_LEN + 1];
+  memcpy(name, &cmdBuffer[5], nameLen);
+  name[nameLen] = '\0';
+  char filepath[MAX_FILEPATH_LEN];
+  snprintf(filepath, sizeof(filepath), "%s/%s.show", SD_SHOW_DIR, name);
+
+  showLoadFile = SD.open(filepath, FILE_READ);
+  if (!showLoadFile) {
+    Serial.print("Show load: not found ");
+    Serial.println(filepath);
+    finishShowLoad(SD_LOAD_NOT_FOUND);
+    return;
+  }
+
+  // Header and index table; the assets follow in the same order
+  uint8_t header[SHOW_HEADER_BYTES];
+  uint32_t readStart = micros();
+  bool ok = showLoadFile.read(header, sizeof(header)) == (int)sizeof(header);
+  uint32_t magic = ok ? readLE32(&header[0]) : 0;
+  uint16_t count = ok ? (header[6] | (header[7] << 8)) : 0;
+  uint32_t dataOffset = ok ? readLE32(&header[8]) : 0;
+  ok = ok && magic == SHOW_MAGIC && header[4] == SHOW_VERSION &&
+       count <= SHOW_MAX_ASSETS &&
+       dataOffset >= SHOW_HEADER_BYTES + (uint32_t)count * SHOW_INDEX_ENTRY_BYTES;
+  showFilePos = SHOW_HEADER_BYTES;
+  uint32_t lastEnd = dataOffset;
+  for (uint16_t i = 0; ok && i < count; i++) {
+    uint8_t entry[SHOW_INDEX_ENTRY_BYTES];
+    ok = showLoadFile.read(entry, sizeof(entry)) == (int)sizeof(entry);
+    showFilePos += sizeof(entry);
+    ShowAsset& asset = showIndex[i];
+    asset.type = entry[0];
+    asset.slot = entry[1];
+    asset.offset = readLE32(&entry[4]);
+    asset.length = readLE32(&entry[8]);
+    // Assets must follow each other so the file is read front to back
+    ok = ok && asset.offset >= lastEnd &&
+         (asset.type == SHOW_ASSET_IMAGE ? asset.slot < MAX_IMAGES && asset.length > 4
+                                          : asset.type >= SHOW_ASSET_PATTERN &&
+                                            asset.type <= SHOW_ASSET_SETTINGS &&
+                                            asset.length <= SHOW_RECORDS_MAX);
+    lastEnd = asset.offset + asset.length;
+  }
+  showLoadReadUs += micros() - readStart;
+  if (!ok) {
+    Serial.println("Show load: bad header or index");
+    showLoadFile.close();
+    finishShowLoad(SD_LOAD_BAD_FILE);
+    return;
+  }
+  showAssetCount = count;
+  showLoadStatus = SD_LOAD_BUSY;
+  Serial.print("Show load: ");
+  Serial.print(filepath);
+  Serial.print(", ");
+  Serial.print(count);
+  Serial.println(" assets");
+}
+
+uint32_t readLE32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Reads up to SD_LOAD_CHUNK_BYTES of the bundle per pass. Image columns
+// stream into showLoadStaging and are committed once complete; record
+// assets are read whole and applied.
+void serviceShowLoad() {
+  if (showLoadStatus != SD_LOAD_BUSY) return;
+  showLoadPasses++;
+
+  uint32_t budget = SD_LOAD_CHUNK_BYTES;
+  while (budget > 0 && showAssetsDone < showAssetCount) {
+    ShowAsset& asset = showIndex[showAssetsDone];
+    uint32_t readStart = micros();
+
+    // Gaps between assets are read through, never seeked over
+    if (showFilePos < asset.offset) {
+      uint32_t skip = min(min(budget, asset.offset - showFilePos), (uint32_t)sizeof(showRecords));
+      if (showLoadFile.read(showRecords, skip) != (int)skip) break;
+      showFilePos += skip;
+      budget -= skip;
+      showLoadReadUs += micros() - readStart;
+      continue;
+    }
+
+    if (asset.type != SHOW_ASSET_IMAGE) {
+      if (showLoadFile.read(showRecords, asset.length) != (int)asset.length) break;
+      showFilePos += asset.length;
+      budget -= min(budget, asset.length);
+      uint32_t applyStart = micros();
+      showLoadReadUs += applyStart - readStart;
+      applyCommandRecords(showRecords, asset.length);
+      showLoadApplyUs += micros() - applyStart;
+      showAssetsDone++;
+      continue;
+    }
+
+    if (showImageWidth == 0) {
+      uint8_t header[4];
+      if (showLoadFile.read(header, 4) != 4) break;
+      showFilePos += 4;
+      budget -= min(budget, (uint32_t)4);
+      showImageWidth = header[0] | (header[1] << 8);
+      showImageHeight = header[2] | (header[3] << 8);
+      showImageColumn = 0;
+      if (showImageWidth == 0 || showImageWidth > IMAGE_MAX_WIDTH ||
+          showImageHeight == 0 || showImageHeight > IMAGE_HEIGHT ||
+          asset.length != 4 + (uint32_t)showImageWidth * showImageHeight * 3) {
+        Serial.println("Show load: bad image asset");
+        showLoadFile.close();
+        finishShowLoad(SD_LOAD_BAD_FILE);
+        return;
+      }
+    }
+
+    // Columns are stored top to bottom as RGB, the same layout as CRGB
+    uint32_t columnBytes = (uint32_t)showImageHeight * 3;
+    bool readFailed = false;
+    while (budget > 0 && showImageColumn < showImageWidth) {
+      if (showLoadFile.read((uint8_t*)showLoadStaging[showImageColumn], columnBytes) != (int)columnBytes) {
+        readFailed = true;
+        break;
+      }
+      showImageColumn++;
+      showFilePos += columnBytes;
+      budget -= min(budget, columnBytes);
+    }
+    showLoadReadUs += micros() - readStart;
+    if (readFailed) break;
+    if (showImageColumn < showImageWidth) return;
+
+    uint32_t applyStart = micros();
+    memcpy(imageStaging, showLoadStaging, sizeof(imageStaging[0]) * showImageWidth);
+    bool ok = commitImage(asset.slot, showImageWidth, showImageHeight);
+    showLoadApplyUs += micros() - applyStart;
+    if (!ok) {
+      showLoadFile.close();
+      finishShowLoad(SD_LOAD_NO_SPACE);
+      return;
+    }
+    showImageWidth = 0;
+    showImagesDone++;
+    showAssetsDone++;
+  }
+
+  if (showAssetsDone < showAssetCount) {
+    if (budget > 0) {
+      Serial.println("Show load: file truncated");
+      showLoadFile.close();
+      finishShowLoad(SD_LOAD_BAD_FILE);
+    }
     return;
   }
-  
-  // Extract filename from cmdBuffer[4] onwards
-  char filename[MAX_FILENAME_LEN + 1];
-  memcpy(filename, &cmdBuffer[4], filenameLen);
-  filename[filenameLen] = '\0';
-  
-  // Image slot follows filename
-  uint8_t imgIndex = cmdBuffer[4 + filenameLen];
-  
-  // Build full path
+  showLoadFile.close();
+  finishShowLoad(SD_LOAD_DONE);
+}
+
+void finishShowLoad(uint8_t status) {
+  showLoadStatus = status;
+  showLoadTotalUs = micros() - showLoadStartUs;
+  Serial.print("Show load: status ");
+  Serial.print(status);
+  Serial.print(", ");
+  Serial.print(showAssetsDone);
+  Serial.print("/");
+  Serial.print(showAssetCount);
+  Serial.print(" assets, ");
+  Serial.print(showFilePos);
+  Serial.print(" bytes in ");
+  Serial.print(showLoadTotalUs);
+  Serial.print(" us (");
+  Serial.print(showLoadPasses);
+  Serial.println(" passes)");
+  if (showLoadPort) sendShowLoadEvent(showLoadPort);
+}
+
+void sendShowLoadEvent(Stream* port) {
+  // Event frame (28 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xC6 status assets_done(2) asset_count(2) images(2) bytes(4)
+  //   read_us(4) apply_us(4) total_us(4) passes(2) 0xFE
+  uint16_t shorts[3] = { showAssetsDone, showAssetCount, showImagesDone };
+  uint32_t longs[4] = { showFilePos, showLoadReadUs, showLoadApplyUs, showLoadTotalUs };
+  port->write(0xFF);
+  port->write(0xC6);  // Show load event
+  port->write(showLoadStatus);
+  for (int i = 0; i < 3; i++) {
+    port->write((uint8_t)(shorts[i] >> 8));
+    port->write((uint8_t)(shorts[i] & 0xFF));
+  }
+  for (int i = 0; i < 4; i++) {
+    for (int b = 3; b >= 0; b--) {
+      port->write((uint8_t)((longs[i] >> (b * 8)) & 0xFF));
+    }
+  }
+  port->write((uint8_t)(showLoadPasses >> 8));
+  port->write((uint8_t)(showLoadPasses & 0xFF));
+  port->write(0xFE);
+}
+
+void handleSdCacheCommand() {
+  // Protocol: 0xFF 0x29 len [op] ... 0xFE
+  //   op 1: play   name_len name   (mode 5; ACK)
+  //   op 2: report                 (0xC7)
+  //   op 3: budget blocks(2)       (0 = whole pool; ACK)
+  //   op 4: flush                  (ACK)
+  uint8_t op = cmdBuffer[2] >= 1 ? cmdBuffer[3] : 0;
+  switch (op) {
+    case 0x01: {
+      uint8_t nameLen = cmdBuffer[2] >= 2 ? cmdBuffer[4] : 0;
+      if (nameLen == 0 || nameLen > MAX_FILENAME_LEN || cmdBuffer[2] < 2 + nameLen) break;
+      char name[MAX_FILENAME_LEN + 1];
+      memcpy(name, &cmdBuffer[5], nameLen);
+      name[nameLen] = '\0';
+      int8_t file = sdCacheOpenImage(name);
+      if (file >= 0) setDisplayMode(5, file);
+      break;
+    }
+    case 0x02:
+      sendSdCacheReport();
+      return;
+    case 0x03:
+      if (cmdBuffer[2] >= 3) {
+        uint16_t blocks = ((uint16_t)cmdBuffer[4] << 8) | cmdBuffer[5];
+        sdCacheBudget = (blocks == 0 || blocks > SD_CACHE_BLOCKS) ? SD_CACHE_BLOCKS : blocks;
+        while (sdCacheBlocksUsed > sdCacheBudget) {
+          sdCacheEvict(sdCacheLeastRecentBlock());
+        }
+      }
+      break;
+    case 0x04:
+      sdCacheFlush();
+      break;
+  }
+  sendAck(0x29);
+}
+
+// Drops every cached file and block
+void sdCacheFlush() {
+  if (sdCacheOpenIndex >= 0) sdCacheFile.close();
+  sdCacheOpenIndex = -1;
+  for (int f = 0; f < SD_CACHE_FILES; f++) sdCacheFiles[f].active = false;
+  for (int b = 0; b < SD_CACHE_BLOCKS; b++) sdCacheBlocks[b].file = -1;
+  sdCacheBlocksUsed = 0;
+  if (currentMode == 5) setDisplayMode(0, 0);
+}
+
+// Registers an SD image with the cache; returns its file index or -1.
+// Block 0 is read here so the first column does not miss.
+int8_t sdCacheOpenImage(const char* name) {
   char filepath[MAX_FILEPATH_LEN];
-  snprintf(filepath, sizeof(filepath), "%s/%s.pov", SD_IMAGE_DIR, filename);
-  
-  Serial.print("Loading image from: ");
-  Serial.println(filepath);
-  
-  // Open file for reading
+  snprintf(filepath, sizeof(filepath), "%s/%s.pov", SD_IMAGE_DIR, name);
+  for (int f = 0; f < SD_CACHE_FILES; f++) {
+    if (sdCacheFiles[f].active && strcmp(sdCacheFiles[f].path, filepath) == 0) return f;
+  }
+  // A file the SD writer has truncated is incomplete until it is closed
+  if (sdWriteCount > 0 && sdWriteJobs[sdWriteHead].step > SD_WRITE_OPEN &&
+      strcmp(sdWriteJobs[sdWriteHead].path, filepath) == 0) {
+    Serial.println("SD cache: file is being saved");
+    return -1;
+  }
+
   File file = SD.open(filepath, FILE_READ);
   if (!file) {
-    Serial.println("Failed to open file");
-    sendAck(0x24);
+    Serial.print("SD cache: not found ");
+    Serial.println(filepath);
+    return -1;
+  }
+  // v2 blocks must line up with cache blocks so each can be read on its own
+  Pov2Header pov;
+  uint8_t format;
+  static uint32_t offsets[SD_CACHE_FILE_BLOCKS];
+  bool ok = readPovHeader(file, pov, format, offsets, SD_CACHE_FILE_BLOCKS);
+  uint32_t dataStart = file.position();
+  ok = ok && pov.width > 0 && pov.width <= SD_CACHE_MAX_WIDTH && pov.height > 0 &&
+       pov.height <= IMAGE_HEIGHT && file.size() >= dataStart + (uint64_t)pov.dataBytes &&
+       (format == 1 || pov.blockColumns == SD_CACHE_BLOCK_COLUMNS);
+  file.close();
+  if (!ok) {
+    Serial.println("SD cache: bad, too large or unsupported image");
+    return -1;
+  }
+
+  // Reuse a free entry, or the one used longest ago (never the playing one)
+  int8_t slot = -1;
+  for (int f = 0; f < SD_CACHE_FILES; f++) {
+    if (!sdCacheFiles[f].active) { slot = f; break; }
+    if (currentMode == 5 && currentIndex == f) continue;
+    if (slot < 0 || sdCacheFiles[f].lastUsed < sdCacheFiles[slot].lastUsed) slot = f;
+  }
+  if (slot < 0) return -1;
+  if (sdCacheFiles[slot].active) sdCacheDropFile(slot);
+
+  SdCacheFile& entry = sdCacheFiles[slot];
+  strncpy(entry.path, filepath, sizeof(entry.path) - 1);
+  entry.path[sizeof(entry.path) - 1] = '\0';
+  entry.width = pov.width;
+  entry.height = pov.height;
+  entry.format = format;
+  entry.pov2 = pov;
+  entry.dataStart = dataStart;
+  memcpy(entry.blockOffsets, offsets, sizeof(offsets));
+  entry.lastUsed = ++sdCacheTick;
+  for (int b = 0; b < SD_CACHE_FILE_BLOCKS; b++) entry.blocks[b] = -1;
+  entry.active = true;
+  sdCacheFetch(slot, 0);
+  return slot;
+}
+
+// Forgets a file whose content changed on the card (saves, deletes)
+void sdCacheForget(const char* filepath) {
+  for (int f = 0; f < SD_CACHE_FILES; f++) {
+    if (sdCacheFiles[f].active && strcmp(sdCacheFiles[f].path, filepath) == 0) {
+      if (currentMode == 5 && currentIndex == f) setDisplayMode(0, 0);
+      sdCacheDropFile(f);
+    }
+  }
+}
+
+void sdCacheDropFile(int8_t file) {
+  for (int b = 0; b < SD_CACHE_BLOCKS; b++) {
+    if (sdCacheBlocks[b].file == file) {
+      sdCacheBlocks[b].file = -1;
+      sdCacheBlocksUsed--;
+    }
+  }
+  if (sdCacheOpenIndex == file) {
+    sdCacheFile.close();
+    sdCacheOpenIndex = -1;
+  }
+  sdCacheFiles[file].active = false;
+}
+
+int16_t sdCacheLeastRecentBlock() {
+  int16_t victim = -1;
+  for (int b = 0; b < SD_CACHE_BLOCKS; b++) {
+    if (sdCacheBlocks[b].file < 0) continue;
+    if (victim < 0 || sdCacheBlocks[b].lastUsed < sdCacheBlocks[victim].lastUsed) victim = b;
+  }
+  return victim;
+}
+
+void sdCacheEvict(int16_t block) {
+  if (block < 0) return;
+  SdCacheBlock& entry = sdCacheBlocks[block];
+  sdCacheFiles[entry.file].blocks[entry.index] = -1;
+  entry.file = -1;
+  sdCacheBlocksUsed--;
+  sdCacheEvictions++;
+}
+
+// Reads one block of a file into the pool; returns the pool block or -1
+int16_t sdCacheFetch(int8_t file, uint16_t index) {
+  SdCacheFile& entry = sdCacheFiles[file];
+  if (entry.blocks[index] >= 0) return entry.blocks[index];
+
+  int16_t block = -1;
+  if (sdCacheBlocksUsed < sdCacheBudget) {
+    for (int b = 0; b < SD_CACHE_BLOCKS; b++) {
+      if (sdCacheBlocks[b].file < 0) { block = b; break; }
+    }
+  }
+  if (block < 0) {
+    block = sdCacheLeastRecentBlock();
+    sdCacheEvict(block);
+  }
+  if (block < 0) return -1;
+
+  uint32_t startUs = micros();
+  if (sdCacheOpenIndex != file) {
+    if (sdCacheOpenIndex >= 0) sdCacheFile.close();
+    sdCacheFile = SD.open(entry.path, FILE_READ);
+    sdCacheOpenIndex = sdCacheFile ? file : -1;
+    if (sdCacheOpenIndex < 0) return -1;
+  }
+
+  // Columns are stored top to bottom as RGB, the same layout as CRGB
+  uint32_t columnBytes = (uint32_t)entry.height * 3;
+  uint16_t first = index * SD_CACHE_BLOCK_COLUMNS;
+  uint16_t columns = min((uint16_t)SD_CACHE_BLOCK_COLUMNS, (uint16_t)(entry.width - first));
+  bool ok;
+  if (entry.format == 2) {
+    uint16_t blockCount = pov2BlockCount(entry.pov2);
+    uint32_t end = index + 1 < blockCount ? entry.blockOffsets[index + 1] : entry.pov2.dataBytes;
+    uint32_t len = end - entry.blockOffsets[index];
+    ok = len <= POV2_BLOCK_BUFFER && sdCacheFile.seek(entry.dataStart + entry.blockOffsets[index]) &&
+         sdCacheFile.read(povBlockBuffer, len) == (int)len &&
+         decodePovBlock(entry.pov2, len, (uint8_t*)sdCachePool[block], sizeof(sdCachePool[0][0]), columns);
+  } else {
+    ok = sdCacheFile.seek(entry.dataStart + first * columnBytes);
+    for (uint16_t c = 0; ok && c < columns; c++) {
+      ok = sdCacheFile.read((uint8_t*)sdCachePool[block][c], columnBytes) == (int)columnBytes;
+    }
+  }
+  if (!ok) {
+    Serial.println("SD cache: read failed");
+    return -1;
+  }
+
+  uint32_t tookUs = micros() - startUs;
+  sdCacheFetchEstimateUs = max(tookUs, sdCacheFetchEstimateUs - sdCacheFetchEstimateUs / 8);
+  sdCacheBlocks[block].file = file;
+  sdCacheBlocks[block].index = index;
+  sdCacheBlocks[block].lastUsed = ++sdCacheTick;
+  sdCacheBlocksUsed++;
+  entry.blocks[index] = block;
+  return block;
+}
+
+// Column x of a cached file, read from the card on a miss
+const CRGB* sdCacheColumn(int8_t file, uint16_t x) {
+  SdCacheFile& entry = sdCacheFiles[file];
+  uint16_t index = x / SD_CACHE_BLOCK_COLUMNS;
+  int16_t block = entry.blocks[index];
+  if (block >= 0) {
+    sdCacheHits++;
+  } else {
+    uint32_t startUs = micros();
+    block = sdCacheFetch(file, index);
+    uint32_t tookUs = micros() - startUs;
+    sdCacheMisses++;
+    if (tookUs > sdCacheMissMaxUs) sdCacheMissMaxUs = tookUs;
+    if (block < 0) return nullptr;
+  }
+  sdCacheBlocks[block].lastUsed = entry.lastUsed = ++sdCacheTick;
+  return sdCachePool[block][x % SD_CACHE_BLOCK_COLUMNS];
+}
+
+void displaySdImage() {
+  displayImageSlot = 0xFF;  // Column state is ours; slots re-select on return
+  if (currentIndex >= SD_CACHE_FILES || !sdCacheFiles[currentIndex].active) {
+    FastLED.clear();
     return;
   }
-  
-  // Read header: width (2 bytes), height (2 bytes)
-  uint16_t width = file.read();           // Low byte
-  width |= (file.read() << 8);            // High byte
-  uint16_t height = file.read();          // Low byte
-  height |= (file.read() << 8);           // High byte
-  
-  if (width > IMAGE_MAX_WIDTH || height > IMAGE_HEIGHT) {
-    Serial.println("Image dimensions too large");
-    file.close();
-    sendAck(0x24);
+  SdCacheFile& entry = sdCacheFiles[currentIndex];
+  if (currentColumn >= entry.width) currentColumn = 0;
+
+  const CRGB* column = sdCacheColumn(currentIndex, currentColumn);
+  if (column) {
+    for (int i = 0; i < DISPLAY_LEDS && i < entry.height; i++) {
+      leds[i + DISPLAY_LED_START] = column[i];
+    }
+  } else {
+    FastLED.clear();
+  }
+
+  currentColumn = (currentColumn + 1) % entry.width;
+}
+
+// Reads the next missing block ahead of the playing column, one per pass,
+// when the slack before the next column covers a read. The block right
+// after the current one is fetched regardless once playback is halfway
+// through the current block, since the render path would miss on it anyway.
+void serviceSdCache() {
+  if (currentMode != 5 || currentIndex >= SD_CACHE_FILES || !sdCacheFiles[currentIndex].active) return;
+  SdCacheFile& entry = sdCacheFiles[currentIndex];
+  uint16_t blockCount = (entry.width + SD_CACHE_BLOCK_COLUMNS - 1) / SD_CACHE_BLOCK_COLUMNS;
+  uint16_t current = currentColumn / SD_CACHE_BLOCK_COLUMNS;
+
+  for (uint16_t ahead = 1; ahead <= SD_CACHE_READAHEAD && ahead < blockCount; ahead++) {
+    uint16_t index = (current + ahead) % blockCount;
+    if (entry.blocks[index] >= 0) continue;
+    bool urgent = ahead == 1 && currentColumn % SD_CACHE_BLOCK_COLUMNS >= SD_CACHE_BLOCK_COLUMNS / 2;
+    int32_t slackUs = (int32_t)(lastColumnUs + activeColumnPeriodUs - micros());
+    if (!urgent && slackUs < (int32_t)sdCacheFetchEstimateUs) return;
+    if (sdCacheFetch(currentIndex, index) >= 0) sdCacheReadaheads++;
     return;
   }
-  
-  // Set image properties
-  images[imgIndex].width = width;
-  images[imgIndex].height = height;
-  images[imgIndex].active = true;
-  
-  // Read pixel data
-  for (int x = 0; x < width; x++) {
-    for (int y = 0; y < height; y++) {
-      images[imgIndex].pixels[x][y].r = file.read();
-      images[imgIndex].pixels[x][y].g = file.read();
-      images[imgIndex].pixels[x][y].b = file.read();
+}
+
+void sendSdCacheReport() {
+  // Response frame (29 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xC7 files used(2) budget(2) block_columns hits(4) misses(4)
+  //   readaheads(4) evictions(4) miss_max_us(4) 0xFE
+  uint8_t files = 0;
+  for (int f = 0; f < SD_CACHE_FILES; f++) {
+    if (sdCacheFiles[f].active) files++;
+  }
+  uint32_t longs[5] = { sdCacheHits, sdCacheMisses, sdCacheReadaheads, sdCacheEvictions, sdCacheMissMaxUs };
+  replyPort->write(0xFF);
+  replyPort->write(0xC7);  // SD cache report
+  replyPort->write(files);
+  replyPort->write((uint8_t)(sdCacheBlocksUsed >> 8));
+  replyPort->write((uint8_t)(sdCacheBlocksUsed & 0xFF));
+  replyPort->write((uint8_t)(sdCacheBudget >> 8));
+  replyPort->write((uint8_t)(sdCacheBudget & 0xFF));
+  replyPort->write((uint8_t)SD_CACHE_BLOCK_COLUMNS);
+  for (int i = 0; i < 5; i++) {
+    for (int b = 3; b >= 0; b--) {
+      replyPort->write((uint8_t)((longs[i] >> (b * 8)) & 0xFF));
     }
   }
-  
-  file.close();
-  Serial.print("Image loaded successfully (");
-  Serial.print(width);
-  Serial.print("x");
-  Serial.print(height);
-  Serial.println(")");
-  sendAck(0x24);
+  replyPort->write(0xFE);
 }
 
 void listSDImages() {
@@ -1556,10 +4805,10 @@ void listSDImages() {
   if (!dir) {
     Serial.println("Failed to open directory");
     // Send empty list
-    ESP32_SERIAL.write(0xFF);
-    ESP32_SERIAL.write(0xCC);  // List response
-    ESP32_SERIAL.write(0);     // Count = 0
-    ESP32_SERIAL.write(0xFE);
+    replyPort->write(0xFF);
+    replyPort->write(0xCC);  // List response
+    replyPort->write(0);     // Count = 0
+    replyPort->write(0xFE);
     return;
   }
   
@@ -1591,17 +4840,17 @@ void listSDImages() {
   Serial.println(" images");
   
   // Send response
-  ESP32_SERIAL.write(0xFF);
-  ESP32_SERIAL.write(0xCC);  // List response
-  ESP32_SERIAL.write(count);
+  replyPort->write(0xFF);
+  replyPort->write(0xCC);  // List response
+  replyPort->write(count);
   
   for (int i = 0; i < count; i++) {
     uint8_t nameLen = strlen(filenames[i]);
-    ESP32_SERIAL.write(nameLen);
-    ESP32_SERIAL.write(filenames[i], nameLen);
+    replyPort->write(nameLen);
+    replyPort->write(filenames[i], nameLen);
   }
   
-  ESP32_SERIAL.write(0xFE);
+  replyPort->write(0xFE);
 }
 
 void deleteSDImage() {
@@ -1627,6 +4876,7 @@ void deleteSDImage() {
   Serial.print("Deleting image: ");
   Serial.println(filepath);
   
+  sdCacheForget(filepath);
   if (SD.remove(filepath)) {
     Serial.println("Image deleted successfully");
     sendAck(0x22);
@@ -1642,8 +4892,8 @@ void sendSDInfo() {
   
   Serial.println("Sending SD card info...");
   
-  ESP32_SERIAL.write(0xFF);
-  ESP32_SERIAL.write(0xDD);  // SD info response marker
+  replyPort->write(0xFF);
+  replyPort->write(0xDD);  // SD info response marker
   
   // Get card info using Teensy SD library methods
   uint64_t totalSpace = SD.totalSize();
@@ -1652,19 +4902,19 @@ void sendSDInfo() {
   uint64_t freeSpace = present ? (totalSpace - usedSpace) : 0;
   
   // Present flag
-  ESP32_SERIAL.write(present ? (uint8_t)1 : (uint8_t)0);
+  replyPort->write(present ? (uint8_t)1 : (uint8_t)0);
   
   // Total space (8 bytes, big-endian)
   for (int i = 7; i >= 0; i--) {
-    ESP32_SERIAL.write((uint8_t)((totalSpace >> (i * 8)) & 0xFF));
+    replyPort->write((uint8_t)((totalSpace >> (i * 8)) & 0xFF));
   }
   
   // Free space (8 bytes, big-endian)
   for (int i = 7; i >= 0; i--) {
-    ESP32_SERIAL.write((uint8_t)((freeSpace >> (i * 8)) & 0xFF));
+    replyPort->write((uint8_t)((freeSpace >> (i * 8)) & 0xFF));
   }
   
-  ESP32_SERIAL.write(0xFE);
+  replyPort->write(0xFE);
   
   Serial.print("SD Info: present=");
   Serial.print(present);
@@ -1680,50 +4930,36 @@ void sendSDInfo() {
 #define PATTERN_FILE_MAGIC 0x50415431  // "PAT1" in hex
 
 void savePatternPreset(const char* presetName) {
-  // Save all active patterns to a preset file
-  
-  // Create pattern directory if it doesn't exist
-  if (!SD.exists(SD_PATTERN_DIR)) {
-    SD.mkdir(SD_PATTERN_DIR);
-  }
+  // Snapshot all patterns into a preset file; written by the SD writer
   
   // Build full path
   char filepath[MAX_FILEPATH_LEN];
   snprintf(filepath, sizeof(filepath), "%s/%s.pat", SD_PATTERN_DIR, presetName);
   
-  Serial.print("Saving pattern preset to: ");
-  Serial.println(filepath);
-  
-  // Open file for writing
-  File file = SD.open(filepath, FILE_WRITE);
-  if (!file) {
-    Serial.println("Failed to create pattern file");
-    return;
-  }
-  
-  // Write magic number
+  uint8_t* data = sdWriterReserve();
+  if (!data) return;
+
+  // Magic number, pattern count, then 9 bytes per pattern
   uint32_t magic = PATTERN_FILE_MAGIC;
-  file.write((uint8_t*)&magic, sizeof(magic));
-  
-  // Write number of patterns
-  file.write(MAX_PATTERNS);
-  
-  // Write each pattern
+  memcpy(data, &magic, sizeof(magic));
+  uint32_t length = sizeof(magic);
+  data[length++] = MAX_PATTERNS;
   for (int i = 0; i < MAX_PATTERNS; i++) {
     Pattern& pat = patterns[i];
-    file.write(pat.active ? 1 : 0);
-    file.write(pat.type);
-    file.write(pat.color1.r);
-    file.write(pat.color1.g);
-    file.write(pat.color1.b);
-    file.write(pat.color2.r);
-    file.write(pat.color2.g);
-    file.write(pat.color2.b);
-    file.write(pat.speed);
+    data[length++] = pat.active ? 1 : 0;
+    data[length++] = pat.type;
+    data[length++] = pat.color1.r;
+    data[length++] = pat.color1.g;
+    data[length++] = pat.color1.b;
+    data[length++] = pat.color2.r;
+    data[length++] = pat.color2.g;
+    data[length++] = pat.color2.b;
+    data[length++] = pat.speed;
   }
-  
-  file.close();
-  Serial.println("Pattern preset saved successfully");
+  sdWriterQueue(filepath, length);
+
+  Serial.print("Queued pattern preset save: ");
+  Serial.println(filepath);
 }
 
 bool loadPatternPreset(const char* presetName) {
@@ -1779,9 +5015,9 @@ void listPatternPresets() {
   
   if (!SD.exists(SD_PATTERN_DIR)) {
     Serial.println("No pattern presets directory");
-    ESP32_SERIAL.write(0xCC);
-    ESP32_SERIAL.write((uint8_t)0);
-    ESP32_SERIAL.write(0xFE);
+    replyPort->write(0xCC);
+    replyPort->write((uint8_t)0);
+    replyPort->write(0xFE);
     return;
   }
   
@@ -1816,16 +5052,16 @@ void listPatternPresets() {
   Serial.println(count);
   
   // Send list to ESP32
-  ESP32_SERIAL.write(0xCD);  // Pattern list response
-  ESP32_SERIAL.write(count);
+  replyPort->write(0xCD);  // Pattern list response
+  replyPort->write(count);
   
   for (int i = 0; i < count; i++) {
     uint8_t nameLen = strlen(filenames[i]);
-    ESP32_SERIAL.write(nameLen);
-    ESP32_SERIAL.write(filenames[i], nameLen);
+    replyPort->write(nameLen);
+    replyPort->write(filenames[i], nameLen);
   }
   
-  ESP32_SERIAL.write(0xFE);
+  replyPort->write(0xFE);
 }
 
 void handlePatternSDCommand() {
@@ -1884,4 +5120,349 @@ void handlePatternSDCommand() {
   }
 }
 
+// ==================== LIVE RECORDING ====================
+// File layout (/poi_live/<name>.plr):
+//   magic "PLR1"(4) led_count(1) record_size(1) reserved(2)
+//   then one record per live column: offset_us(4, little-endian) RGB[led_count*3]
+// offset_us is the column's arrival time relative to the start of recording.
+
+uint32_t liveRecUsed() {
+  return liveRecHead - liveRecTail;
+}
+
+void liveRecPush(const uint8_t* data, uint32_t len) {
+  uint32_t pos = liveRecHead & (LIVE_REC_RING_SIZE - 1);
+  uint32_t first = min(len, (uint32_t)LIVE_REC_RING_SIZE - pos);
+  memcpy(&liveRecRing[pos], data, first);
+  memcpy(liveRecRing, data + first, len - first);
+  liveRecHead += len;
+  if (liveRecUsed() > liveRecPeak) liveRecPeak = liveRecUsed();
+}
+
+void liveRecPeek(uint8_t* out, uint32_t len) {
+  uint32_t pos = liveRecTail & (LIVE_REC_RING_SIZE - 1);
+  uint32_t first = min(len, (uint32_t)LIVE_REC_RING_SIZE - pos);
+  memcpy(out, &liveRecRing[pos], first);
+  memcpy(out + first, liveRecRing, len - first);
+}
+
+// Largest contiguous SD transfer that keeps file offsets chunk-aligned, so
+// the card sees whole-sector writes and reads after the first one.
+uint32_t liveRecTransferLen(uint32_t ringPos, uint32_t fileOffset, uint32_t avail) {
+  uint32_t len = LIVE_REC_CHUNK - (fileOffset % LIVE_REC_CHUNK);
+  len = min(len, avail);
+  return min(len, (uint32_t)LIVE_REC_RING_SIZE - ringPos);
+}
+
+void recordLiveColumn() {
+  if (LIVE_REC_RING_SIZE - liveRecUsed() < LIVE_REC_RECORD_SIZE) {
+    liveRecDropped++;
+    return;
+  }
+
+  uint8_t record[LIVE_REC_RECORD_SIZE];
+  uint32_t offsetUs = micros() - liveRecStartUs;
+  for (int i = 0; i < 4; i++) {
+    record[i] = (uint8_t)(offsetUs >> (i * 8));
+  }
+  for (int i = 0; i < DISPLAY_LEDS; i++) {
+    record[4 + i * 3] = liveBuffer[i].r;
+    record[5 + i * 3] = liveBuffer[i].g;
+    record[6 + i * 3] = liveBuffer[i].b;
+  }
+  liveRecPush(record, sizeof(record));
+  liveRecColumns++;
+}
+
+// Write at most one chunk from the ring to SD. Returns false on a write error.
+bool flushLiveRecording(bool drain) {
+  uint32_t used = liveRecUsed();
+  uint32_t pos = liveRecTail & (LIVE_REC_RING_SIZE - 1);
+  uint32_t len = liveRecTransferLen(pos, LIVE_REC_HEADER_SIZE + liveRecTail, used);
+  if (len == 0) return true;
+  // Hold partial chunks back until stop so every write lands sector-aligned
+  if (!drain && len == used && used < LIVE_REC_CHUNK) return true;
+
+  if (liveRecFile.write(&liveRecRing[pos], len) != len) {
+    return false;
+  }
+  liveRecTail += len;
+  return true;
+}
+
+// Read at most one chunk from SD into the ring
+void fillLiveReplay() {
+  uint32_t space = LIVE_REC_RING_SIZE - liveRecUsed();
+  uint32_t pos = liveRecHead & (LIVE_REC_RING_SIZE - 1);
+  uint32_t len = liveRecTransferLen(pos, LIVE_REC_HEADER_SIZE + liveRecHead, space);
+  if (len == 0) return;
+
+  int got = liveRecFile.read(&liveRecRing[pos], len);
+  if (got <= 0) {
+    liveReplayEof = true;
+    return;
+  }
+  liveRecHead += got;
+  if ((uint32_t)got < len) liveReplayEof = true;
+}
+
+void buildLiveRecPath(char* filepath, size_t size, const char* name) {
+  snprintf(filepath, size, "%s/%s.plr", SD_LIVE_DIR, name);
+}
+
+bool startLiveRecording(const char* name) {
+  stopLiveRecorder();
+  if (!sdInitialized) {
+    Serial.println("Live recording: SD card not initialized");
+    return false;
+  }
+
+  if (!SD.exists(SD_LIVE_DIR)) {
+    SD.mkdir(SD_LIVE_DIR);
+  }
+
+  char filepath[MAX_FILEPATH_LEN];
+  buildLiveRecPath(filepath, sizeof(filepath), name);
+  if (SD.exists(filepath)) {
+    SD.remove(filepath);
+  }
+
+  liveRecFile = SD.open(filepath, FILE_WRITE);
+  if (!liveRecFile) {
+    Serial.println("Live recording: failed to create file");
+    return false;
+  }
+
+  uint32_t magic = LIVE_REC_MAGIC;
+  liveRecFile.write((uint8_t*)&magic, sizeof(magic));
+  liveRecFile.write((uint8_t)DISPLAY_LEDS);
+  liveRecFile.write((uint8_t)LIVE_REC_RECORD_SIZE);
+  liveRecFile.write((uint8_t)0);
+  liveRecFile.write((uint8_t)0);
+
+  liveRecHead = liveRecTail = liveRecPeak = 0;
+  liveRecColumns = liveRecDropped = liveRecUnderruns = liveRecMaxLateUs = 0;
+  liveRecStartUs = micros();
+  liveRecState = LIVE_REC_RECORDING;
+
+  Serial.print("Live recording to: ");
+  Serial.println(filepath);
+  return true;
+}
+
+// Rewind to the first record and restart the replay clock
+void restartLiveReplay() {
+  liveRecFile.seek(LIVE_REC_HEADER_SIZE);
+  liveRecHead = liveRecTail = 0;
+  liveReplayEof = false;
+  liveReplayStarved = false;
+  while (!liveReplayEof && LIVE_REC_RING_SIZE - liveRecUsed() >= LIVE_REC_CHUNK) {
+    fillLiveReplay();
+  }
+  liveRecStartUs = micros();
+}
+
+bool startLiveReplay(const char* name, uint16_t speedPercent, bool loopReplay) {
+  stopLiveRecorder();
+  if (!sdInitialized) {
+    Serial.println("Live replay: SD card not initialized");
+    return false;
+  }
+
+  char filepath[MAX_FILEPATH_LEN];
+  buildLiveRecPath(filepath, sizeof(filepath), name);
+  liveRecFile = SD.open(filepath, FILE_READ);
+  if (!liveRecFile) {
+    Serial.print("Live replay: file not found: ");
+    Serial.println(filepath);
+    return false;
+  }
+
+  uint8_t header[LIVE_REC_HEADER_SIZE] = {0};
+  uint32_t magic = 0;
+  bool complete = liveRecFile.read(header, sizeof(header)) == sizeof(header);
+  memcpy(&magic, header, sizeof(magic));
+  if (!complete || magic != LIVE_REC_MAGIC ||
+      header[4] != DISPLAY_LEDS || header[5] != LIVE_REC_RECORD_SIZE) {
+    Serial.println("Live replay: not a compatible recording");
+    liveRecFile.close();
+    return false;
+  }
+
+  liveReplaySpeed = constrain(speedPercent, (uint16_t)10, (uint16_t)1000);
+  liveReplayLoop = loopReplay;
+  liveRecPeak = 0;
+  liveRecColumns = liveRecDropped = liveRecUnderruns = liveRecMaxLateUs = 0;
+  restartLiveReplay();
+
+  sequencePlaying = false;
+  currentMode = 4;
+  liveRecState = LIVE_REC_REPLAYING;
+
+  Serial.print("Live replay from: ");
+  Serial.print(filepath);
+  Serial.print(" at ");
+  Serial.print(liveReplaySpeed);
+  Serial.println("%");
+  return true;
+}
+
+void closeLiveRecording() {
+  liveRecState = LIVE_REC_IDLE;
+  liveRecFile.close();
+  Serial.print("Live recording stopped: ");
+  Serial.print(liveRecColumns);
+  Serial.print(" columns, ");
+  Serial.print(liveRecDropped);
+  Serial.println(" dropped");
+}
+
+// Stops taking columns; serviceLiveRecorder() writes what the ring still
+// holds one chunk per loop() pass, so the link keeps being read meanwhile
+void finishLiveRecording() {
+  if (liveRecState == LIVE_REC_RECORDING) liveRecState = LIVE_REC_FINISHING;
+}
+
+// Ends whichever of recording or replay is active, at once. A recording is
+// drained to SD before the file is closed (use finishLiveRecording() where
+// nothing needs the file straight away).
+void stopLiveRecorder() {
+  if (liveRecState == LIVE_REC_RECORDING || liveRecState == LIVE_REC_FINISHING) {
+    while (liveRecUsed() > 0 && flushLiveRecording(true)) {}
+    closeLiveRecording();
+  } else if (liveRecState == LIVE_REC_REPLAYING) {
+    liveRecState = LIVE_REC_IDLE;
+    liveRecFile.close();
+    Serial.print("Live replay stopped: ");
+    Serial.print(liveRecColumns);
+    Serial.print(" columns, max late ");
+    Serial.print(liveRecMaxLateUs);
+    Serial.println("us");
+  }
+}
+
+// Shows the next recorded column once its (scaled) timestamp is due. Late
+// columns are shown back-to-back rather than skipped, so none are lost.
+void serviceLiveReplay() {
+  if (!liveReplayEof && LIVE_REC_RING_SIZE - liveRecUsed() >= LIVE_REC_CHUNK) {
+    fillLiveReplay();
+  }
+
+  if (liveRecUsed() < LIVE_REC_RECORD_SIZE) {
+    if (!liveReplayEof) {
+      if (!liveReplayStarved) liveRecUnderruns++;
+      liveReplayStarved = true;
+    } else if (liveReplayLoop) {
+      restartLiveReplay();
+    } else {
+      stopLiveRecorder();
+    }
+    return;
+  }
+  liveReplayStarved = false;
+
+  uint8_t record[LIVE_REC_RECORD_SIZE];
+  liveRecPeek(record, 4);
+  uint32_t offsetUs = (uint32_t)record[0] | ((uint32_t)record[1] << 8) |
+                      ((uint32_t)record[2] << 16) | ((uint32_t)record[3] << 24);
+  uint32_t dueUs = (uint32_t)((uint64_t)offsetUs * 100 / liveReplaySpeed);
+  uint32_t elapsedUs = micros() - liveRecStartUs;
+  if ((int32_t)(elapsedUs - dueUs) < 0) return;
+
+  if (elapsedUs - dueUs > liveRecMaxLateUs) liveRecMaxLateUs = elapsedUs - dueUs;
+  liveRecPeek(record, LIVE_REC_RECORD_SIZE);
+  liveRecTail += LIVE_REC_RECORD_SIZE;
+  liveRecColumns++;
+
+  for (int i = 0; i < DISPLAY_LEDS; i++) {
+    liveBuffer[i] = CRGB(record[4 + i * 3], record[5 + i * 3], record[6 + i * 3]);
+  }
+  displayLive();
+  showLeds();
+  columnShownAtUs = micros();
+  columnBlanked = false;
+}
+
+void serviceLiveRecorder() {
+  if (liveRecState == LIVE_REC_RECORDING) {
+    if (!flushLiveRecording(false)) {
+      Serial.println("Live recording: SD write failed, stopping");
+      liveRecState = LIVE_REC_IDLE;
+      liveRecFile.close();
+    }
+  } else if (liveRecState == LIVE_REC_FINISHING) {
+    if (liveRecUsed() == 0 || !flushLiveRecording(true)) closeLiveRecording();
+  } else if (liveRecState == LIVE_REC_REPLAYING) {
+    serviceLiveReplay();
+  }
+}
+
+void sendLiveRecorderReport() {
+  // Response frame (20 bytes total, fixed length - values may contain 0xFE):
+  //   0xFF 0xBE state columns(4) dropped(4) underruns(4) max_late_us(4) ring_peak_pct 0xFE
+  uint32_t values[4] = { liveRecColumns, liveRecDropped, liveRecUnderruns, liveRecMaxLateUs };
+  uint8_t peakPct = (uint8_t)((uint64_t)liveRecPeak * 100 / LIVE_REC_RING_SIZE);
+
+  replyPort->write(0xFF);
+  replyPort->write(0xBE);  // Live recorder report
+  replyPort->write(liveRecState);
+  for (int v = 0; v < 4; v++) {
+    for (int i = 3; i >= 0; i--) {
+      replyPort->write((uint8_t)((values[v] >> (i * 8)) & 0xFF));
+    }
+  }
+  replyPort->write(peakPct);
+  replyPort->write(0xFE);
+}
+
+void handleLiveRecorderCommand() {
+  // Protocol for live recording commands:
+  // Record: 0xFF 0x25 len 0x01 name_len [name] 0xFE
+  // Stop:   0xFF 0x25 len 0x02 0xFE                  (recording or replay)
+  // Replay: 0xFF 0x25 len 0x03 speed_hi speed_lo loop name_len [name] 0xFE
+  // Report: 0xFF 0x25 len 0x04 0xFE                  (responds 0xBE)
+
+  uint8_t subCmd = cmdBuffer[3];
+  char name[MAX_FILENAME_LEN];
+
+  switch (subCmd) {
+    case 0x01: {  // Record
+      uint8_t nameLen = cmdBuffer[4];
+      if (nameLen > 0 && nameLen < MAX_FILENAME_LEN) {
+        memcpy(name, &cmdBuffer[5], nameLen);
+        name[nameLen] = '\0';
+        startLiveRecording(name);
+      }
+      sendAck(0x25);
+      break;
+    }
+    case 0x02:  // Stop
+      if (liveRecState == LIVE_REC_RECORDING) {
+        finishLiveRecording();
+      } else {
+        stopLiveRecorder();
+      }
+      sendAck(0x25);
+      break;
+    case 0x03: {  // Replay
+      uint16_t speed = ((uint16_t)cmdBuffer[4] << 8) | cmdBuffer[5];
+      bool loopReplay = cmdBuffer[6] != 0;
+      uint8_t nameLen = cmdBuffer[7];
+      if (nameLen > 0 && nameLen < MAX_FILENAME_LEN) {
+        memcpy(name, &cmdBuffer[8], nameLen);
+        name[nameLen] = '\0';
+        startLiveReplay(name, speed, loopReplay);
+      }
+      sendAck(0x25);
+      break;
+    }
+    case 0x04:  // Report
+      sendLiveRecorderReport();
+      break;
+    default:
+      Serial.println("Unknown live recording command");
+      sendAck(0x25);
+  }
+}
+
 #endif  // SD_SUPPORT